@@ -0,0 +1,59 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains hash functions for use with klist.h hlist buckets
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef HASH_H__6C0B1B6E_2B0F_4C55_9B0C_6F3E5A1D7E42__INCLUDED
+#define HASH_H__6C0B1B6E_2B0F_4C55_9B0C_6F3E5A1D7E42__INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* 32-bit FNV-1a */
+static inline uint32_t ladish_hash_string(const char * str)
+{
+  uint32_t hash;
+
+  hash = 2166136261u;
+  while (*str != 0)
+  {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static inline uint32_t ladish_hash_uint64(uint64_t value)
+{
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDull;
+  value ^= value >> 33;
+  return (uint32_t)value;
+}
+
+/* bucket count must be power of two */
+#define ladish_hash_bucket(hash, bucket_count) ((hash) & ((bucket_count) - 1))
+
+#endif /* #ifndef HASH_H__6C0B1B6E_2B0F_4C55_9B0C_6F3E5A1D7E42__INCLUDED */
@@ -2,7 +2,7 @@
 /*
  * LADI Session Handler (ladish)
  *
- * Copyright (C) 2008, 2009, 2010, 2012 Nedko Arnaudov <nedko@arnaudov.name>
+ * Copyright (C) 2008, 2009, 2010, 2012, 2026 Nedko Arnaudov <nedko@arnaudov.name>
  * Copyright (C) 2008 Marc-Olivier Barre
  *
  **************************************************************************
@@ -33,63 +33,726 @@
 #include <stdarg.h>
 #include <sys/stat.h>
 
+#include <sched.h>
+
+#if !defined(LOG_OUTPUT_STDOUT)
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
 #include "../common/catdup.h"
 #include "../common/dirhelpers.h"
 
-#define DEFAULT_XDG_LOG "/.log"
-#define LADISH_XDG_SUBDIR "/" BASE_NAME
-#define LADISH_XDG_LOG "/" BASE_NAME ".log"
+#define DEFAULT_XDG_LOG "/.log"
+#define LADISH_XDG_SUBDIR "/" BASE_NAME
+#define LADISH_XDG_LOG "/" BASE_NAME ".log"
+
+#define LOG_RANK_DEBUG           0
+#define LOG_RANK_INFO            1
+#define LOG_RANK_WARN            2
+#define LOG_RANK_ERROR           3
+
+#define LOG_FILTER_DEFAULT       "info"
+#define LOG_FILTER_MAX           256
+#define LOG_FILTER_MAX_RULES     32
+#define LOG_MODULE_MAX           32
+#define LOG_RATE_LIMIT_DEFAULT   50             /* debug and info lines per second per callsite, 0 means unlimited */
+
+struct ladish_log_rule
+{
+  char module[LOG_MODULE_MAX];
+  unsigned int threshold;       /* rank of the least important level that is logged */
+};
+
+static uint64_t g_log_line_count;
+
+volatile unsigned int g_ladish_log_filter_generation = 1;
+
+static struct ladish_log_rule g_log_rules[LOG_FILTER_MAX_RULES]; /* protected by g_log_filter_lock */
+static unsigned int g_log_rules_count;                          /* protected by g_log_filter_lock */
+static unsigned int g_log_default_threshold = LOG_RANK_INFO;    /* protected by g_log_filter_lock */
+static unsigned int g_log_rate_limit = LOG_RATE_LIMIT_DEFAULT;
+static char g_log_filter[LOG_FILTER_MAX] = LOG_FILTER_DEFAULT;
+static int g_log_filter_lock;
+
+static struct ladish_log_callsite * g_log_suppressed;           /* protected by g_log_suppressed_lock */
+static int g_log_suppressed_lock;
+static unsigned int g_log_suppressed_reported;                  /* second of the last report */
+
+#define VOLATILE_READ(x) (*(volatile __typeof__(x) *)&(x))
+
+static void ladish_log_report_suppressed(bool force);
+
+static uint64_t ladish_log_seconds(void)
+{
+  struct timespec ts;
+
+#if defined(CLOCK_MONOTONIC_COARSE)
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+
+  return ts.tv_sec;
+}
+
+static const char * ladish_log_color(unsigned int level)
+{
+  switch (level)
+  {
+  case CDBUS_LOG_LEVEL_WARN:
+    return ANSI_COLOR_YELLOW;
+  case CDBUS_LOG_LEVEL_ERROR:
+  case CDBUS_LOG_LEVEL_ERROR_PLAIN:
+    return ANSI_COLOR_RED;
+  }
+
+  return NULL;
+}
+
+#if !defined(LOG_OUTPUT_STDOUT)
+
+/*
+ * Logging threads format records into a lock-free ring (bounded MPMC queue
+ * with per slot sequence numbers). A writer thread writes them to the log file
+ * in batches and rotates it. When the writer thread is not running (in forked
+ * children, after a crash) records are written synchronously. Until
+ * ladish_log_init() opens the log file, lines go to stdout and stderr.
+ */
+
+#define LOG_RING_SLOTS           1024           /* power of two */
+#define LOG_RECORD_MAX           1024           /* text, including the terminating zero */
+#define LOG_LINE_EXTRA           64             /* timestamp, color and newline */
+#define LOG_LINE_MAX             (LOG_RECORD_MAX + LOG_LINE_EXTRA)
+#define LOG_BATCH_MAX            (64 * 1024)
+#define LOG_ROTATE_SIZE          (4 * 1024 * 1024)
+#define LOG_ROTATE_COUNT         3              /* ladish.log.1 ... ladish.log.3 */
+#define LOG_ROTATE_CHECK_USECS   1000000
+#define LOG_CRASH_FLUSH_SPINS    1000
+#define LOG_RING_FULL_SPINS      10000          /* wait for the writer before dropping a record */
+
+struct ladish_log_record
+{
+  uint64_t sequence;            /* position when free, position + 1 when filled */
+  uint64_t timestamp;           /* monotonic microseconds */
+  unsigned int level;
+  char * long_text;             /* malloc()ed when text does not fit, freed by the consumer */
+  char text[LOG_RECORD_MAX];    /* truncated when long_text is used */
+};
+
+static struct ladish_log_record g_log_ring[LOG_RING_SLOTS];
+static uint64_t g_log_ring_head;        /* next position to fill, advanced by producers */
+static uint64_t g_log_ring_tail;        /* next position to write, owned by the consumer */
+static uint64_t g_log_dropped;          /* records lost because the ring was full */
+static uint64_t g_log_dropped_reported;
+static int g_log_consumer_lock;         /* writer thread vs. crash flush */
+
+static int g_log_fd = -1;
+static ino_t g_log_file_ino;
+static off_t g_log_file_size;
+static char * g_log_filename;
+static uint64_t g_log_rotation_checked; /* monotonic microseconds */
+static time_t g_log_wall_base;          /* wall clock time at g_log_monotonic_base */
+static uint64_t g_log_monotonic_base;
+static char g_log_batch[LOG_BATCH_MAX]; /* owned by the consumer */
+
+static bool g_log_async;                /* writer thread is running */
+static bool g_log_writer_stop;
+static int g_log_writer_sleeping;
+static sem_t g_log_wakeup;
+static pthread_t g_log_writer;
+
+static uint64_t ladish_log_monotonic(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* returns length of the untruncated text */
+static
+size_t
+ladish_log_format_text(
+  char * buffer,
+  size_t size,
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  va_list ap)
+{
+  size_t prefix;
+  size_t len;
+  int ret;
+
+  prefix = 0;
+  len = 0;
+  if (level == CDBUS_LOG_LEVEL_DEBUG)
+  {
+    ret = snprintf(buffer, size, "%s:%d:%s ", file, line, func);
+    if (ret > 0)
+    {
+      len = ret;
+      prefix = len < size ? len : size - 1;
+    }
+  }
+
+  ret = vsnprintf(buffer + prefix, size - prefix, format, ap);
+  if (ret > 0)
+  {
+    len += ret;
+  }
+
+  return len;
+}
+
+/* returns NULL when out of memory */
+static
+char *
+ladish_log_format_long_text(
+  size_t len,
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  va_list ap)
+{
+  char * text;
+
+  text = malloc(len + 1);
+  if (text != NULL)
+  {
+    ladish_log_format_text(text, len + 1, level, file, line, func, format, ap);
+  }
+
+  return text;
+}
+
+static size_t ladish_log_format_line(char * buffer, size_t size, time_t timestamp, unsigned int level, const char * text)
+{
+  char timestamp_str[26];
+  const char * color;
+  int ret;
+
+  ctime_r(&timestamp, timestamp_str);
+  timestamp_str[24] = 0;
+
+  color = ladish_log_color(level);
+
+  ret = snprintf(
+    buffer,
+    size,
+    "%s: %s%s%s\n",
+    timestamp_str,
+    color != NULL ? color : "",
+    text,
+    color != NULL ? ANSI_RESET : "");
+  if (ret < 0)
+  {
+    return 0;
+  }
+
+  if ((size_t)ret >= size)
+  { /* truncated, keep the line terminated */
+    buffer[size - 2] = '\n';
+    return size - 1;
+  }
+
+  return ret;
+}
+
+static bool ladish_log_open(void)
+{
+  struct stat st;
+
+  g_log_fd = open(g_log_filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+  if (g_log_fd == -1)
+  {
+    fprintf(stderr, "Cannot open ladishd log file \"%s\": %d (%s)\n", g_log_filename, errno, strerror(errno));
+    return false;
+  }
+
+  if (fstat(g_log_fd, &st) != 0)
+  {
+    fprintf(stderr, "Cannot stat just opened ladishd log file \"%s\": %d (%s)\n", g_log_filename, errno, strerror(errno));
+    close(g_log_fd);
+    g_log_fd = -1;
+    return false;
+  }
+
+  g_log_file_ino = st.st_ino;
+  g_log_file_size = st.st_size;
+  return true;
+}
+
+static void ladish_log_reopen(void)
+{
+  if (g_log_fd != -1)
+  {
+    close(g_log_fd);
+    g_log_fd = -1;
+  }
+
+  ladish_log_open();
+}
+
+static void ladish_log_rotate(void)
+{
+  char old_name[PATH_MAX];
+  char new_name[PATH_MAX];
+  unsigned int i;
+
+  for (i = LOG_ROTATE_COUNT; i > 1; i--)
+  {
+    snprintf(old_name, sizeof(old_name), "%s.%u", g_log_filename, i - 1);
+    snprintf(new_name, sizeof(new_name), "%s.%u", g_log_filename, i);
+    rename(old_name, new_name);
+  }
+
+  snprintf(new_name, sizeof(new_name), "%s.1", g_log_filename);
+  if (rename(g_log_filename, new_name) != 0)
+  {
+    fprintf(stderr, "Cannot rename ladishd log file \"%s\": %d (%s)\n", g_log_filename, errno, strerror(errno));
+  }
+
+  ladish_log_reopen();
+}
+
+/* Another process may have appended to, truncated or rotated the file */
+static bool ladish_log_is_current(void)
+{
+  struct stat st;
+
+  if (g_log_fd == -1 || stat(g_log_filename, &st) != 0 || st.st_ino != g_log_file_ino)
+  {
+    return false;
+  }
+
+  if (fstat(g_log_fd, &st) == 0)
+  {
+    g_log_file_size = st.st_size;
+  }
+
+  return true;
+}
+
+/* stat() of the log file is done at most once per second and before rotating */
+static void ladish_log_check_rotation(void)
+{
+  uint64_t now;
+
+  now = ladish_log_monotonic();
+
+  if (g_log_fd != -1 && g_log_file_size >= LOG_ROTATE_SIZE)
+  {
+    g_log_rotation_checked = now;
+
+    if (!ladish_log_is_current())
+    {
+      ladish_log_reopen();
+      return;
+    }
+
+    if (g_log_file_size >= LOG_ROTATE_SIZE)
+    {
+      ladish_log_rotate();
+    }
+
+    return;
+  }
+
+  if (now - g_log_rotation_checked < LOG_ROTATE_CHECK_USECS)
+  {
+    return;
+  }
+
+  g_log_rotation_checked = now;
+
+  if (!ladish_log_is_current())
+  {
+    /* rotated or removed by someone else, or not open at all */
+    ladish_log_reopen();
+  }
+}
+
+static void ladish_log_write(const char * buffer, size_t size)
+{
+  ssize_t ret;
+  int fd;
+
+  fd = g_log_fd != -1 ? g_log_fd : STDERR_FILENO;
+
+  while (size > 0)
+  {
+    ret = write(fd, buffer, size);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      return;
+    }
+
+    buffer += ret;
+    size -= ret;
+
+    if (fd == g_log_fd)
+    {
+      g_log_file_size += ret;
+    }
+  }
+}
+
+/* for text longer than LOG_RECORD_MAX, written truncated when out of memory */
+static void ladish_log_write_long_line(time_t timestamp, unsigned int level, const char * text)
+{
+  char buffer[LOG_LINE_MAX];
+  char * line;
+  size_t size;
+
+  size = strlen(text) + LOG_LINE_EXTRA;
+  line = malloc(size);
+  if (line == NULL)
+  {
+    ladish_log_write(buffer, ladish_log_format_line(buffer, sizeof(buffer), timestamp, level, text));
+    return;
+  }
+
+  ladish_log_write(line, ladish_log_format_line(line, size, timestamp, level, text));
+  free(line);
+}
+
+static
+void
+ladish_log_write_sync(
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  va_list ap)
+{
+  char text[LOG_RECORD_MAX];
+  char * long_text;
+  char buffer[LOG_LINE_MAX];
+  size_t size;
+  size_t len;
+  va_list ap_copy;
+
+  va_copy(ap_copy, ap);
+  len = ladish_log_format_text(text, sizeof(text), level, file, line, func, format, ap_copy);
+  va_end(ap_copy);
+
+  if (len >= sizeof(text))
+  {
+    long_text = ladish_log_format_long_text(len, level, file, line, func, format, ap);
+    if (long_text != NULL)
+    {
+      ladish_log_write_long_line(time(NULL), level, long_text);
+      free(long_text);
+      return;
+    }
+  }
+
+  size = ladish_log_format_line(buffer, sizeof(buffer), time(NULL), level, text);
+  ladish_log_write(buffer, size);
+}
+
+static void ladish_log_wake_writer(void)
+{
+  if (VOLATILE_READ(g_log_writer_sleeping) && __sync_bool_compare_and_swap(&g_log_writer_sleeping, 1, 0))
+  {
+    sem_post(&g_log_wakeup);
+  }
+}
+
+static
+void
+ladish_log_ring_push(
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  va_list ap)
+{
+  struct ladish_log_record * record_ptr;
+  uint64_t position;
+  uint64_t sequence;
+  unsigned int spins;
+  size_t len;
+  va_list ap_copy;
+
+  spins = 0;
+  position = VOLATILE_READ(g_log_ring_head);
+  for (;;)
+  {
+    record_ptr = g_log_ring + (position & (LOG_RING_SLOTS - 1));
+    sequence = VOLATILE_READ(record_ptr->sequence);
+    __sync_synchronize();
+
+    if (sequence == position)
+    {
+      if (__sync_bool_compare_and_swap(&g_log_ring_head, position, position + 1))
+      {
+        break;
+      }
+    }
+    else if (sequence < position)
+    { /* full, the writer thread cannot keep up */
+      if (++spins == LOG_RING_FULL_SPINS)
+      {
+        __sync_fetch_and_add(&g_log_dropped, 1);
+        return;
+      }
+
+      ladish_log_wake_writer();
+      sched_yield();
+    }
+
+    position = VOLATILE_READ(g_log_ring_head);
+  }
+
+  record_ptr->timestamp = ladish_log_monotonic();
+  record_ptr->level = level;
+
+  va_copy(ap_copy, ap);
+  len = ladish_log_format_text(record_ptr->text, sizeof(record_ptr->text), level, file, line, func, format, ap_copy);
+  va_end(ap_copy);
+
+  record_ptr->long_text = NULL;
+  if (len >= sizeof(record_ptr->text))
+  {
+    record_ptr->long_text = ladish_log_format_long_text(len, level, file, line, func, format, ap);
+  }
+
+  __sync_synchronize();
+  record_ptr->sequence = position + 1;
+
+  ladish_log_wake_writer();
+}
+
+static struct ladish_log_record * ladish_log_ring_peek(void)
+{
+  struct ladish_log_record * record_ptr;
+
+  record_ptr = g_log_ring + (g_log_ring_tail & (LOG_RING_SLOTS - 1));
+  if (VOLATILE_READ(record_ptr->sequence) != g_log_ring_tail + 1)
+  {
+    return NULL;
+  }
+
+  __sync_synchronize();
+  return record_ptr;
+}
+
+static void ladish_log_ring_release(struct ladish_log_record * record_ptr)
+{
+  __sync_synchronize();
+  record_ptr->sequence = g_log_ring_tail + LOG_RING_SLOTS;
+  g_log_ring_tail++;
+}
+
+static bool ladish_log_consumer_lock(bool wait)
+{
+  unsigned int spins;
+
+  spins = 0;
+  while (__sync_lock_test_and_set(&g_log_consumer_lock, 1) != 0)
+  {
+    if (!wait && ++spins == LOG_CRASH_FLUSH_SPINS)
+    {
+      return false;
+    }
+
+    sched_yield();
+  }
+
+  return true;
+}
+
+static void ladish_log_consumer_unlock(void)
+{
+  __sync_lock_release(&g_log_consumer_lock);
+}
+
+static void ladish_log_flush_batch(size_t size)
+{
+  ladish_log_check_rotation();
+  ladish_log_write(g_log_batch, size);
+}
+
+/* must be called by the consumer, long records are written truncated after a crash */
+static void ladish_log_drain(bool crashed)
+{
+  struct ladish_log_record * record_ptr;
+  char text[64];
+  uint64_t dropped;
+  time_t timestamp;
+  size_t used;
+
+  used = 0;
+
+  while ((record_ptr = ladish_log_ring_peek()) != NULL)
+  {
+    if (used + LOG_LINE_MAX > sizeof(g_log_batch))
+    {
+      ladish_log_flush_batch(used);
+      used = 0;
+    }
+
+    timestamp = g_log_wall_base + (time_t)((record_ptr->timestamp - g_log_monotonic_base) / 1000000);
+
+    if (record_ptr->long_text != NULL && !crashed)
+    { /* does not fit in the batch, written on its own */
+      if (used > 0)
+      {
+        ladish_log_flush_batch(used);
+        used = 0;
+      }
+
+      ladish_log_check_rotation();
+      ladish_log_write_long_line(timestamp, record_ptr->level, record_ptr->long_text);
+      free(record_ptr->long_text);
+      record_ptr->long_text = NULL;
+    }
+    else
+    {
+      used += ladish_log_format_line(g_log_batch + used, sizeof(g_log_batch) - used, timestamp, record_ptr->level, record_ptr->text);
+    }
+
+    ladish_log_ring_release(record_ptr);
+  }
+
+  dropped = VOLATILE_READ(g_log_dropped);
+  if (dropped != g_log_dropped_reported)
+  {
+    if (used + LOG_LINE_MAX > sizeof(g_log_batch))
+    {
+      ladish_log_flush_batch(used);
+      used = 0;
+    }
+
+    snprintf(text, sizeof(text), "%" PRIu64 " log lines dropped", dropped - g_log_dropped_reported);
+    used += ladish_log_format_line(g_log_batch + used, sizeof(g_log_batch) - used, time(NULL), CDBUS_LOG_LEVEL_WARN, text);
+    g_log_dropped_reported = dropped;
+  }
+
+  if (used > 0)
+  {
+    ladish_log_flush_batch(used);
+  }
+}
+
+static void * ladish_log_writer_thread(void * UNUSED(arg))
+{
+  struct timespec deadline;
+
+  for (;;)
+  {
+    ladish_log_consumer_lock(true);
+    ladish_log_drain(false);
+    ladish_log_consumer_unlock();
+
+    /* callsites that went quiet after being rate limited are reported here */
+    ladish_log_report_suppressed(false);
+
+    if (VOLATILE_READ(g_log_writer_stop))
+    {
+      break;
+    }
+
+    g_log_writer_sleeping = 1;
+    __sync_synchronize();
+
+    if (ladish_log_ring_peek() != NULL)
+    { /* record was pushed before the producer could see the sleeping flag */
+      __sync_bool_compare_and_swap(&g_log_writer_sleeping, 1, 0);
+      continue;
+    }
+
+    /* wake up at least once per second so stop request cannot be missed */
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec++;
+    while (sem_timedwait(&g_log_wakeup, &deadline) != 0 && errno == EINTR);
+
+    g_log_writer_sleeping = 0;
+  }
+
+  return NULL;
+}
+
+static void ladish_log_atfork_child(void)
+{
+  /* there is no writer thread in the child */
+  g_log_async = false;
+}
+
+static void ladish_log_start_writer(void)
+{
+  unsigned int i;
+  int ret;
+
+  for (i = 0; i < LOG_RING_SLOTS; i++)
+  {
+    g_log_ring[i].sequence = i;
+  }
+
+  g_log_monotonic_base = ladish_log_monotonic();
+  g_log_wall_base = time(NULL);
+  g_log_rotation_checked = g_log_monotonic_base;
+
+  if (sem_init(&g_log_wakeup, 0, 0) != 0)
+  {
+    fprintf(stderr, "sem_init() failed for log writer: %d (%s)\n", errno, strerror(errno));
+    return;
+  }
 
-#if !defined(LOG_OUTPUT_STDOUT)
-static ino_t g_log_file_ino;
-static FILE * g_logfile;
-static char * g_log_filename;
+  pthread_atfork(NULL, NULL, ladish_log_atfork_child);
 
-static bool ladish_log_open(void)
+  ret = pthread_create(&g_log_writer, NULL, ladish_log_writer_thread, NULL);
+  if (ret != 0)
+  {
+    fprintf(stderr, "pthread_create() failed for log writer: %d (%s)\n", ret, strerror(ret));
+    sem_destroy(&g_log_wakeup);
+    return;
+  }
+
+  g_log_async = true;
+}
+
+void ladish_log_flush_sync(void)
 {
-    struct stat st;
-    int ret;
-    int retry;
+  bool locked;
 
-    if (g_logfile != NULL)
-    {
-        ret = stat(g_log_filename, &st);
-        if (ret != 0 || g_log_file_ino != st.st_ino)
-        {
-            fclose(g_logfile);
-        }
-        else
-        {
-            return true;
-        }
-    }
+  /* records logged from now on, like the stack trace, are written by the logging thread */
+  g_log_async = false;
+  __sync_synchronize();
 
-    for (retry = 0; retry < 10; retry++)
-    {
-        g_logfile = fopen(g_log_filename, "a");
-        if (g_logfile == NULL)
-        {
-            fprintf(stderr, "Cannot open ladishd log file \"%s\": %d (%s)\n", g_log_filename, errno, strerror(errno));
-            return false;
-        }
-
-        ret = stat(g_log_filename, &st);
-        if (ret == 0)
-        {
-            g_log_file_ino = st.st_ino;
-            return true;
-        }
-
-        fclose(g_logfile);
-        g_logfile = NULL;
-    }
+  /* the writer thread may be the crashed one, then the lock is never released */
+  locked = ladish_log_consumer_lock(false);
+  ladish_log_drain(true);
+  if (locked)
+  {
+    ladish_log_consumer_unlock();
+  }
+}
 
-    fprintf(stderr, "Cannot stat just opened ladishd log file \"%s\": %d (%s). %d retries\n", g_log_filename, errno, strerror(errno), retry);
-    return false;
+static void ladish_log_setup(void) __attribute__ ((constructor));
+static void ladish_log_setup(void)
+{
+  cdbus_log_setup(ladish_log);
 }
 
-void ladish_log_init() __attribute__ ((constructor));
-void ladish_log_init()
+void ladish_log_init(void)
 {
   char * ladish_log_dir;
   const char * home_dir;
@@ -133,8 +796,10 @@ void ladish_log_init()
     goto free_log_dir;
   }
 
-  ladish_log_open();
-  cdbus_log_setup(ladish_log);
+  if (ladish_log_open())
+  {
+    ladish_log_start_writer();
+  }
 
 free_log_dir:
   free(ladish_log_dir);
@@ -149,19 +814,50 @@ exit:
 void ladish_log_uninit()  __attribute__ ((destructor));
 void ladish_log_uninit()
 {
-  if (g_logfile != NULL)
+  ladish_log_report_suppressed(true);
+
+  /* after ladish_log_flush_sync() the writer thread is left alone */
+  if (g_log_async)
+  {
+    g_log_writer_stop = true;
+    __sync_synchronize();
+    sem_post(&g_log_wakeup);
+    pthread_join(g_log_writer, NULL);
+    g_log_async = false;
+    sem_destroy(&g_log_wakeup);
+  }
+
+  if (g_log_fd != -1)
   {
-    fclose(g_logfile);
+    close(g_log_fd);
+    g_log_fd = -1;
   }
 
   free(g_log_filename);
+  g_log_filename = NULL;
 }
 #else
-void ladish_log_init() __attribute__ ((constructor));
-void ladish_log_init()
+static void ladish_log_setup(void) __attribute__ ((constructor));
+static void ladish_log_setup(void)
 {
   cdbus_log_setup(ladish_log);
 }
+
+void ladish_log_init(void)
+{
+  /* lines are written to stdout and stderr */
+}
+
+static void ladish_log_uninit(void) __attribute__ ((destructor));
+static void ladish_log_uninit(void)
+{
+  ladish_log_report_suppressed(true);
+}
+
+void ladish_log_flush_sync(void)
+{
+  /* records are written synchronously */
+}
 #endif  /* #if !defined(LOG_OUTPUT_STDOUT) */
 
 #if 0
@@ -172,27 +868,228 @@ void ladish_log_init()
 # define log_error_plain(fmt, args...) ladish_log(CDBUS_LOG_LEVEL_ERROR_PLAIN, ANSI_COLOR_RED "ERROR: " ANSI_RESET fmt "\n", ## args)
 #endif
 
-static
-bool
-ladish_log_enabled(
-  unsigned int level,
-  const char * UNUSED(file),
-  unsigned int UNUSED(line),
-  const char * UNUSED(func))
+uint64_t ladish_log_get_line_count(void)
+{
+  return __sync_fetch_and_add(&g_log_line_count, 0);
+}
+
+static unsigned int ladish_log_level_rank(unsigned int level)
+{
+  switch (level)
+  {
+  case CDBUS_LOG_LEVEL_DEBUG:
+    return LOG_RANK_DEBUG;
+  case CDBUS_LOG_LEVEL_INFO:
+    return LOG_RANK_INFO;
+  case CDBUS_LOG_LEVEL_WARN:
+    return LOG_RANK_WARN;
+  }
+
+  return LOG_RANK_ERROR;
+}
+
+static bool ladish_log_parse_level(const char * str, unsigned int * rank_ptr)
+{
+  static const char * const names[] = {"debug", "info", "warn", "error", "off"};
+  unsigned int i;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+  {
+    if (strcmp(str, names[i]) == 0)
+    {
+      *rank_ptr = i;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* "../daemon/graph.c" -> "graph" */
+static void ladish_log_get_module(const char * file, char * module, size_t size)
+{
+  const char * start;
+  const char * end;
+  size_t len;
+
+  start = strrchr(file, '/');
+  start = start != NULL ? start + 1 : file;
+
+  end = strrchr(start, '.');
+  len = end != NULL ? (size_t)(end - start) : strlen(start);
+  if (len >= size)
+  {
+    len = size - 1;
+  }
+
+  memcpy(module, start, len);
+  module[len] = 0;
+}
+
+static void ladish_log_filter_lock(void)
+{
+  while (__sync_lock_test_and_set(&g_log_filter_lock, 1) != 0)
+  {
+    sched_yield();
+  }
+}
+
+static void ladish_log_filter_unlock(void)
+{
+  __sync_lock_release(&g_log_filter_lock);
+}
+
+static bool ladish_log_enabled(unsigned int level, const char * file)
+{
+  char module[LOG_MODULE_MAX];
+  unsigned int threshold;
+  unsigned int i;
+
+  ladish_log_get_module(file, module, sizeof(module));
+
+  ladish_log_filter_lock();
+
+  threshold = g_log_default_threshold;
+  for (i = 0; i < g_log_rules_count; i++)
+  {
+    if (strcmp(g_log_rules[i].module, module) == 0)
+    {
+      threshold = g_log_rules[i].threshold;
+      break;
+    }
+  }
+
+  ladish_log_filter_unlock();
+
+  return ladish_log_level_rank(level) >= threshold;
+}
+
+bool ladish_log_set_filter(const char * filter)
+{
+  struct ladish_log_rule rules[LOG_FILTER_MAX_RULES];
+  unsigned int rules_count;
+  unsigned int default_threshold;
+  unsigned int rate_limit;
+  unsigned int threshold;
+  char buffer[LOG_FILTER_MAX];
+  char * token;
+  char * value;
+  char * end;
+  char * save;
+
+  if (filter == NULL || *filter == 0)
+  {
+    filter = LOG_FILTER_DEFAULT;
+  }
+
+  if (strlen(filter) >= sizeof(buffer))
+  {
+    log_error("Log filter is too long");
+    return false;
+  }
+
+  strcpy(buffer, filter);
+
+  rules_count = 0;
+  default_threshold = LOG_RANK_INFO;
+  rate_limit = LOG_RATE_LIMIT_DEFAULT;
+
+  for (token = strtok_r(buffer, ", \t", &save); token != NULL; token = strtok_r(NULL, ", \t", &save))
+  {
+    value = strchr(token, '=');
+    if (value == NULL)
+    {
+      if (!ladish_log_parse_level(token, &default_threshold))
+      {
+        goto invalid;
+      }
+
+      continue;
+    }
+
+    *value++ = 0;
+
+    if (strcmp(token, "rate") == 0)
+    {
+      rate_limit = strtoul(value, &end, 10);
+      if (*value == 0 || *end != 0)
+      {
+        goto invalid;
+      }
+
+      continue;
+    }
+
+    if (!ladish_log_parse_level(value, &threshold))
+    {
+      goto invalid;
+    }
+
+    if (strcmp(token, "*") == 0)
+    {
+      default_threshold = threshold;
+      continue;
+    }
+
+    if (rules_count == LOG_FILTER_MAX_RULES || strlen(token) >= LOG_MODULE_MAX)
+    {
+      goto invalid;
+    }
+
+    strcpy(rules[rules_count].module, token);
+    rules[rules_count].threshold = threshold;
+    rules_count++;
+  }
+
+  ladish_log_filter_lock();
+  memcpy(g_log_rules, rules, rules_count * sizeof(struct ladish_log_rule));
+  g_log_rules_count = rules_count;
+  g_log_default_threshold = default_threshold;
+  g_log_rate_limit = rate_limit;
+  ladish_log_filter_unlock();
+
+  strcpy(g_log_filter, filter);
+
+  /* invalidate enabled flags cached in callsites */
+  __sync_fetch_and_add(&g_ladish_log_filter_generation, 1);
+
+  log_info("Log filter set to \"%s\"", filter);
+  return true;
+
+invalid:
+  log_error("Invalid log filter \"%s\"", filter);
+  return false;
+}
+
+const char * ladish_log_get_filter(void)
+{
+  return g_log_filter;
+}
+
+void ladish_log_callsite_update(struct ladish_log_callsite * callsite_ptr)
 {
-  return level != CDBUS_LOG_LEVEL_DEBUG;
+  unsigned int generation;
+
+  /* read generation first, a filter change after this will be noticed on next use */
+  generation = g_ladish_log_filter_generation;
+  __sync_synchronize();
+
+  callsite_ptr->enabled = ladish_log_enabled(callsite_ptr->level, callsite_ptr->file);
+
+  __sync_synchronize();
+  callsite_ptr->generation = generation;
 }
 
+static
 void
-ladish_log(
+ladish_log_va(
   unsigned int level,
   const char * file,
   unsigned int line,
   const char * func,
   const char * format,
-  ...)
+  va_list ap)
 {
-  va_list ap;
   FILE * stream;
 #if !defined(LOG_OUTPUT_STDOUT)
   time_t timestamp;
@@ -200,31 +1097,34 @@ ladish_log(
 #endif
   const char * color;
 
-  if (!ladish_log_enabled(level, file, line, func))
+  /* lines are logged from worker threads too */
+  __sync_fetch_and_add(&g_log_line_count, 1);
+
+#if !defined(LOG_OUTPUT_STDOUT)
+  if (g_log_async)
   {
+    ladish_log_ring_push(level, file, line, func, format, ap);
     return;
   }
 
-#if !defined(LOG_OUTPUT_STDOUT)
-  if (g_logfile != NULL && ladish_log_open())
+  if (g_log_fd != -1)
   {
-    stream = g_logfile;
+    ladish_log_write_sync(level, file, line, func, format, ap);
+    return;
   }
-  else
 #endif
+
+  switch (level)
   {
-    switch (level)
-    {
-    case CDBUS_LOG_LEVEL_DEBUG:
-    case CDBUS_LOG_LEVEL_INFO:
-      stream = stdout;
-      break;
-    case CDBUS_LOG_LEVEL_WARN:
-    case CDBUS_LOG_LEVEL_ERROR:
-    case CDBUS_LOG_LEVEL_ERROR_PLAIN:
-    default:
-      stream = stderr;
-    }
+  case CDBUS_LOG_LEVEL_DEBUG:
+  case CDBUS_LOG_LEVEL_INFO:
+    stream = stdout;
+    break;
+  case CDBUS_LOG_LEVEL_WARN:
+  case CDBUS_LOG_LEVEL_ERROR:
+  case CDBUS_LOG_LEVEL_ERROR_PLAIN:
+  default:
+    stream = stderr;
   }
 
 #if !defined(LOG_OUTPUT_STDOUT)
@@ -235,29 +1135,18 @@ ladish_log(
   fprintf(stream, "%s: ", timestamp_str);
 #endif
 
-  color = NULL;
-  switch (level)
+  if (level == CDBUS_LOG_LEVEL_DEBUG)
   {
-  case CDBUS_LOG_LEVEL_DEBUG:
     fprintf(stream, "%s:%d:%s ", file, line, func);
-    break;
-  case CDBUS_LOG_LEVEL_WARN:
-    color = ANSI_COLOR_YELLOW;
-    break;
-  case CDBUS_LOG_LEVEL_ERROR:
-  case CDBUS_LOG_LEVEL_ERROR_PLAIN:
-    color = ANSI_COLOR_RED;
-    break;
   }
 
+  color = ladish_log_color(level);
   if (color != NULL)
   {
     fputs(color, stream);
   }
 
-  va_start(ap, format);
   vfprintf(stream, format, ap);
-  va_end(ap);
 
   if (color != NULL)
   {
@@ -268,3 +1157,156 @@ ladish_log(
 
   fflush(stream);
 }
+
+static
+void
+ladish_log_plain(
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  ...)
+{
+  va_list ap;
+
+  va_start(ap, format);
+  ladish_log_va(level, file, line, func, format, ap);
+  va_end(ap);
+}
+
+/* Reports lines dropped by the rate limiter, at most once per second unless forced.
+   Called by the writer thread and when a callsite starts a new window. */
+static void ladish_log_report_suppressed(bool force)
+{
+  struct ladish_log_callsite * callsite_ptr;
+  struct ladish_log_callsite * next_ptr;
+  unsigned int suppressed;
+  unsigned int reported;
+  unsigned int now;
+
+  if (VOLATILE_READ(g_log_suppressed) == NULL)
+  {
+    return;
+  }
+
+  now = (unsigned int)ladish_log_seconds();
+  reported = VOLATILE_READ(g_log_suppressed_reported);
+  if (!force && (now == reported || !__sync_bool_compare_and_swap(&g_log_suppressed_reported, reported, now)))
+  {
+    return;
+  }
+
+  while (__sync_lock_test_and_set(&g_log_suppressed_lock, 1) != 0)
+  {
+    sched_yield();
+  }
+
+  callsite_ptr = g_log_suppressed;
+  g_log_suppressed = NULL;
+
+  __sync_lock_release(&g_log_suppressed_lock);
+
+  while (callsite_ptr != NULL)
+  {
+    /* once pending is cleared, the callsite may be put on the list again */
+    next_ptr = callsite_ptr->next_pending;
+    __sync_lock_release(&callsite_ptr->pending);
+    __sync_synchronize();
+
+    suppressed = __sync_fetch_and_and(&callsite_ptr->suppressed, 0);
+    if (suppressed != 0)
+    {
+      ladish_log_plain(
+        callsite_ptr->level,
+        callsite_ptr->file,
+        callsite_ptr->line,
+        callsite_ptr->func,
+        "%u similar lines suppressed",
+        suppressed);
+    }
+
+    callsite_ptr = next_ptr;
+  }
+}
+
+/* callsites are shared by all threads, the rate limiter state is updated atomically */
+static bool ladish_log_rate_limited(struct ladish_log_callsite * callsite_ptr, unsigned int rate_limit)
+{
+  unsigned int window;
+  unsigned int now;
+
+  now = (unsigned int)ladish_log_seconds();
+  window = VOLATILE_READ(callsite_ptr->window);
+  if (window != now && __sync_bool_compare_and_swap(&callsite_ptr->window, window, now))
+  {
+    __sync_fetch_and_and(&callsite_ptr->count, 0);
+    ladish_log_report_suppressed(false);
+  }
+
+  if (__sync_fetch_and_add(&callsite_ptr->count, 1) < rate_limit)
+  {
+    return false;
+  }
+
+  if (__sync_fetch_and_add(&callsite_ptr->suppressed, 1) == 0 &&
+      __sync_bool_compare_and_swap(&callsite_ptr->pending, 0, 1))
+  {
+    while (__sync_lock_test_and_set(&g_log_suppressed_lock, 1) != 0)
+    {
+      sched_yield();
+    }
+
+    callsite_ptr->next_pending = g_log_suppressed;
+    g_log_suppressed = callsite_ptr;
+
+    __sync_lock_release(&g_log_suppressed_lock);
+  }
+
+  return true;
+}
+
+void
+ladish_log_callsite(
+  struct ladish_log_callsite * callsite_ptr,
+  const char * format,
+  ...)
+{
+  va_list ap;
+  unsigned int rate_limit;
+
+  /* warnings and errors are never dropped */
+  rate_limit = g_log_rate_limit;
+  if (rate_limit != 0 &&
+      ladish_log_level_rank(callsite_ptr->level) < LOG_RANK_WARN &&
+      ladish_log_rate_limited(callsite_ptr, rate_limit))
+  {
+    return;
+  }
+
+  va_start(ap, format);
+  ladish_log_va(callsite_ptr->level, callsite_ptr->file, callsite_ptr->line, callsite_ptr->func, format, ap);
+  va_end(ap);
+}
+
+/* entry point for cdbus and other code that does not use the log macros */
+void
+ladish_log(
+  unsigned int level,
+  const char * file,
+  unsigned int line,
+  const char * func,
+  const char * format,
+  ...)
+{
+  va_list ap;
+
+  if (!ladish_log_enabled(level, file))
+  {
+    return;
+  }
+
+  va_start(ap, format);
+  ladish_log_va(level, file, line, func, format, ap);
+  va_end(ap);
+}
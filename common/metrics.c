@@ -0,0 +1,109 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the latency histograms and D-Bus call counters
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "../common.h"
+#include "metrics.h"
+#include "ladish_time.h"
+#include "../dbus_constants.h"
+
+struct ladish_metrics_peer g_ladish_metrics_peers[LADISH_METRICS_PEER_COUNT] =
+{
+  [LADISH_METRICS_PEER_JACKDBUS] = {.name = "jackdbus"},
+  [LADISH_METRICS_PEER_A2J]      = {.name = "a2j"},
+  [LADISH_METRICS_PEER_JMCORE]   = {.name = "jmcore"},
+  [LADISH_METRICS_PEER_CONF]     = {.name = "conf"},
+  [LADISH_METRICS_PEER_OTHER]    = {.name = "other"},
+};
+
+static uint64_t g_call_start;
+
+uint64_t ladish_histogram_bucket_bound(unsigned int index)
+{
+  if (index >= LADISH_HISTOGRAM_BUCKETS - 1)
+  {
+    return UINT64_MAX;
+  }
+
+  return (uint64_t)1 << index;
+}
+
+uint64_t ladish_metrics_elapsed(uint64_t start)
+{
+  uint64_t now;
+
+  now = ladish_get_current_microseconds();
+  return now > start ? now - start : 0;
+}
+
+static unsigned int ladish_metrics_lookup_peer(const char * service)
+{
+  if (service == NULL)
+  {
+    return LADISH_METRICS_PEER_OTHER;
+  }
+
+  if (strcmp(service, JACKDBUS_SERVICE_NAME) == 0)
+  {
+    return LADISH_METRICS_PEER_JACKDBUS;
+  }
+
+  if (strcmp(service, A2J_SERVICE_NAME) == 0)
+  {
+    return LADISH_METRICS_PEER_A2J;
+  }
+
+  if (strcmp(service, JMCORE_SERVICE_NAME) == 0)
+  {
+    return LADISH_METRICS_PEER_JMCORE;
+  }
+
+  if (strcmp(service, CONF_SERVICE_NAME) == 0)
+  {
+    return LADISH_METRICS_PEER_CONF;
+  }
+
+  return LADISH_METRICS_PEER_OTHER;
+}
+
+void ladish_metrics_dbus_call_begin(void)
+{
+  g_call_start = ladish_get_current_microseconds();
+}
+
+bool ladish_metrics_dbus_call_end(const char * service, bool success)
+{
+  struct ladish_metrics_peer * peer_ptr;
+
+  peer_ptr = g_ladish_metrics_peers + ladish_metrics_lookup_peer(service);
+
+  ladish_histogram_add(&peer_ptr->latency, ladish_metrics_elapsed(g_call_start));
+  if (!success)
+  {
+    peer_ptr->errors++;
+  }
+
+  return success;
+}
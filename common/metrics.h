@@ -0,0 +1,84 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the latency histograms and D-Bus call counters
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef METRICS_H__D11824A2_9B4B_4593_BC2E_1D2AD8C257C5__INCLUDED
+#define METRICS_H__D11824A2_9B4B_4593_BC2E_1D2AD8C257C5__INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Bucket i counts values up to 2^i microseconds, the last bucket counts everything above */
+#define LADISH_HISTOGRAM_BUCKETS 24
+
+struct ladish_histogram
+{
+  uint64_t count;
+  uint64_t sum;                                 /* microseconds */
+  uint64_t buckets[LADISH_HISTOGRAM_BUCKETS];   /* not cumulative */
+};
+
+static inline void ladish_histogram_add(struct ladish_histogram * histogram_ptr, uint64_t usecs)
+{
+  unsigned int index;
+
+  index = usecs <= 1 ? 0 : 64 - __builtin_clzll(usecs - 1);
+  if (index >= LADISH_HISTOGRAM_BUCKETS)
+  {
+    index = LADISH_HISTOGRAM_BUCKETS - 1;
+  }
+
+  histogram_ptr->count++;
+  histogram_ptr->sum += usecs;
+  histogram_ptr->buckets[index]++;
+}
+
+/* upper bound of bucket, UINT64_MAX for the last one */
+uint64_t ladish_histogram_bucket_bound(unsigned int index);
+
+/* microseconds since start, zero if the clock went backwards */
+uint64_t ladish_metrics_elapsed(uint64_t start);
+
+#define LADISH_METRICS_PEER_JACKDBUS    0
+#define LADISH_METRICS_PEER_A2J         1
+#define LADISH_METRICS_PEER_JMCORE      2
+#define LADISH_METRICS_PEER_CONF        3
+#define LADISH_METRICS_PEER_OTHER       4
+#define LADISH_METRICS_PEER_COUNT       5
+
+struct ladish_metrics_peer
+{
+  const char * name;
+  uint64_t errors;
+  struct ladish_histogram latency;
+};
+
+/* synchronous D-Bus calls, accounted by proxy_call() in the main thread */
+extern struct ladish_metrics_peer g_ladish_metrics_peers[LADISH_METRICS_PEER_COUNT];
+
+void ladish_metrics_dbus_call_begin(void);
+bool ladish_metrics_dbus_call_end(const char * service, bool success);
+
+#endif /* #ifndef METRICS_H__D11824A2_9B4B_4593_BC2E_1D2AD8C257C5__INCLUDED */
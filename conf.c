@@ -24,21 +24,72 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+/*
+ * Values are kept in memory and stored in a single append-only journal file.
+ * Each record in the journal carries one key and its value, later records
+ * override earlier ones. Changes made by set calls within CONF_FLUSH_DELAY_USEC
+ * are appended and synced to disk in one batch, the calls are replied after
+ * that. If storing fails, the values are restored to the stored ones and the
+ * calls get an error reply. When the journal grows much bigger than the live
+ * data, it is rewritten (compacted).
+ *
+ * Journal layout (host byte order):
+ *   header:  "LADICONF" uint32 format_version uint32 reserved
+ *   record:  uint32 magic uint32 key_len uint32 value_len uint32 checksum
+ *            key bytes, value bytes (no terminating nuls)
+ *
+ * Older versions stored each key in a separate file. Such values are
+ * migrated into the journal on startup and the old files are removed.
+ */
+
 #include "common.h"
 
 #include <unistd.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <dirent.h>
+#include <time.h>
 
 #include <cdbus/cdbus.h>
 #include "dbus_constants.h"
 #include "common/catdup.h"
 #include "common/dirhelpers.h"
+#include "common/hash.h"
+#include "common/ladish_time.h"
+
+#define STORAGE_BASE_DIR "/.ladish/conf/" /* legacy, one dir per key */
+#define STORAGE_JOURNAL_DIR "/.ladish"
+#define STORAGE_JOURNAL_FILE STORAGE_JOURNAL_DIR "/conf.journal"
+#define STORAGE_JOURNAL_TEMP_SUFFIX ".tmp"
+
+#define JOURNAL_SIGNATURE "LADICONF"
+#define JOURNAL_FORMAT_VERSION 1
+#define JOURNAL_RECORD_MAGIC 0x4C43524Bu
+
+#define CONF_FLUSH_DELAY_USEC 20000
+#define CONF_DISPATCH_TIMEOUT_MSEC 50
+#define CONF_COMPACT_MIN_SIZE 65536
 
-#define STORAGE_BASE_DIR "/.ladish/conf/"
+#define PAIRS_HASH_SIZE 256     /* must be power of two */
+
+struct journal_header
+{
+  char signature[8];
+  uint32_t format_version;
+  uint32_t reserved;
+};
+
+struct journal_record
+{
+  uint32_t magic;
+  uint32_t key_len;
+  uint32_t value_len;
+  uint32_t checksum;
+};
 
 extern const struct cdbus_interface_descriptor g_interface;
 
@@ -49,13 +100,30 @@ static bool g_quit;
 struct pair
 {
   struct list_head siblings;
+  struct hlist_node hash_siblings;
   uint64_t version;
   char * key;
   char * value;
-  bool stored;
+  char * stored_value;          /* value in the journal while value is not stored yet, NULL if none */
+  bool stored;                  /* value is in the journal */
+};
+
+/* set call that is replied after its values are stored */
+struct deferred_reply
+{
+  struct list_head siblings;
+  DBusMessage * call;
+  DBusMessage * reply;
 };
 
 struct list_head g_pairs;
+static struct list_head g_deferred_replies;
+static struct hlist_head g_pairs_hash[PAIRS_HASH_SIZE];
+
+static char * g_journal_path;
+static int g_journal_fd = -1;
+static off_t g_journal_size;
+static uint64_t g_flush_deadline; /* 0 when there is nothing to flush */
 
 static bool connect_dbus(void)
 {
@@ -147,8 +215,39 @@ bool install_term_signal_handler(int signum, bool ignore_if_already_ignored)
   return true;
 }
 
+static bool journal_open(void);
+static void journal_close(void);
+static bool flush(void);
+static void migrate_legacy(void);
+
+/* wake up in time for the scheduled flush */
+static int get_dispatch_timeout(void)
+{
+  uint64_t now;
+
+  if (g_flush_deadline == 0)
+  {
+    return CONF_DISPATCH_TIMEOUT_MSEC;
+  }
+
+  now = ladish_get_current_microseconds();
+  if (now >= g_flush_deadline)
+  {
+    return 0;
+  }
+
+  if (g_flush_deadline - now >= CONF_DISPATCH_TIMEOUT_MSEC * 1000)
+  {
+    return CONF_DISPATCH_TIMEOUT_MSEC;
+  }
+
+  return (g_flush_deadline - now + 999) / 1000;
+}
+
 int main(int UNUSED(argc), char ** UNUSED(argv))
 {
+  size_t i;
+
   if (getenv("HOME") == NULL)
   {
     log_error("Environment variable HOME not set");
@@ -156,6 +255,18 @@ int main(int UNUSED(argc), char ** UNUSED(argv))
   }
 
   INIT_LIST_HEAD(&g_pairs);
+  INIT_LIST_HEAD(&g_deferred_replies);
+  for (i = 0; i < PAIRS_HASH_SIZE; i++)
+  {
+    INIT_HLIST_HEAD(g_pairs_hash + i);
+  }
+
+  if (!journal_open())
+  {
+    return 1;
+  }
+
+  migrate_legacy();
 
   install_term_signal_handler(SIGTERM, false);
   install_term_signal_handler(SIGINT, true);
@@ -163,15 +274,27 @@ int main(int UNUSED(argc), char ** UNUSED(argv))
   if (!connect_dbus())
   {
     log_error("Failed to connect to D-Bus");
+    journal_close();
     return 1;
   }
 
   while (!g_quit)
   {
-    dbus_connection_read_write_dispatch(cdbus_g_dbus_connection, 50);
+    dbus_connection_read_write_dispatch(cdbus_g_dbus_connection, get_dispatch_timeout());
+
+    if (g_flush_deadline != 0 && ladish_get_current_microseconds() >= g_flush_deadline)
+    {
+      flush();
+    }
   }
 
+  /* store the pending values and send the replies waiting for them */
+  flush();
+  dbus_connection_flush(cdbus_g_dbus_connection);
+
   disconnect_dbus();
+  journal_close();
+
   return 0;
 }
 
@@ -212,262 +335,997 @@ static struct pair * create_pair(const char * key, const char * value)
   }
 
   pair_ptr->version = 1;
+  pair_ptr->stored_value = NULL;
   pair_ptr->stored = false;
 
   list_add_tail(&pair_ptr->siblings, &g_pairs);
+  hlist_add_head(&pair_ptr->hash_siblings, g_pairs_hash + ladish_hash_bucket(ladish_hash_string(key), PAIRS_HASH_SIZE));
 
   return pair_ptr;
 }
 
-static bool store_pair(struct pair * pair_ptr)
+static void destroy_pair(struct pair * pair_ptr)
 {
-  char * dirpath;
-  char * filepath;
-  int fd;
-  size_t len;
-  ssize_t written;
+  list_del(&pair_ptr->siblings);
+  hlist_del(&pair_ptr->hash_siblings);
+  free(pair_ptr->key);
+  free(pair_ptr->value);
+  free(pair_ptr->stored_value);
+  free(pair_ptr);
+}
 
-  dirpath = catdupv(getenv("HOME"), STORAGE_BASE_DIR, pair_ptr->key, NULL);
-  if (dirpath == NULL)
+static struct pair * find_pair(const char * key)
+{
+  struct hlist_node * node_ptr;
+  struct pair * pair_ptr;
+
+  hlist_for_each_entry(pair_ptr, node_ptr, g_pairs_hash + ladish_hash_bucket(ladish_hash_string(key), PAIRS_HASH_SIZE), hash_siblings)
   {
-    return false;
+    if (strcmp(pair_ptr->key, key) == 0)
+    {
+      return pair_ptr;
+    }
   }
 
-  if (!ensure_dir_exist(dirpath, 0700))
+  return NULL;
+}
+
+static void schedule_flush(void)
+{
+  if (g_flush_deadline == 0)
   {
-    free(dirpath);
-    return false;
+    g_flush_deadline = ladish_get_current_microseconds() + CONF_FLUSH_DELAY_USEC;
   }
+}
 
-  filepath = catdup(dirpath, "/value");
-  free(dirpath);
-  if (filepath == NULL)
+/***************************************************************************/
+/* journal */
+
+static uint32_t journal_checksum(const char * key, size_t key_len, const char * value, size_t value_len)
+{
+  uint32_t hash;
+  size_t i;
+
+  hash = 2166136261u ^ (uint32_t)key_len ^ ((uint32_t)value_len << 16);
+
+  for (i = 0; i < key_len; i++)
   {
-    return false;
+    hash = (hash ^ (uint8_t)key[i]) * 16777619u;
   }
 
-  fd = creat(filepath, 0700);
-  if (fd == -1)
+  for (i = 0; i < value_len; i++)
   {
-    log_error("Failed to create \"%s\": %d (%s)", filepath, errno, strerror(errno));
-    free(filepath);
-    return false;
+    hash = (hash ^ (uint8_t)value[i]) * 16777619u;
   }
 
-  len = strlen(pair_ptr->value);
+  return hash;
+}
 
-  written = write(fd, pair_ptr->value, len);
-  if (written < 0)
-  {
-    log_error("Failed to write() to \"%s\": %d (%s)", filepath, errno, strerror(errno));
-    free(filepath);
-    close(fd);
-    return false;
-  }
+static size_t journal_record_size(struct pair * pair_ptr)
+{
+  return sizeof(struct journal_record) + strlen(pair_ptr->key) + strlen(pair_ptr->value);
+}
+
+static char * journal_put_record(char * buffer, struct pair * pair_ptr)
+{
+  struct journal_record record;
+
+  record.magic = JOURNAL_RECORD_MAGIC;
+  record.key_len = strlen(pair_ptr->key);
+  record.value_len = strlen(pair_ptr->value);
+  record.checksum = journal_checksum(pair_ptr->key, record.key_len, pair_ptr->value, record.value_len);
 
-  if ((size_t)written != len)
+  memcpy(buffer, &record, sizeof(record));
+  buffer += sizeof(record);
+  memcpy(buffer, pair_ptr->key, record.key_len);
+  buffer += record.key_len;
+  memcpy(buffer, pair_ptr->value, record.value_len);
+  buffer += record.value_len;
+
+  return buffer;
+}
+
+static bool journal_write(int fd, const char * path, const void * buffer, size_t size)
+{
+  ssize_t written;
+
+  while (size > 0)
   {
-    log_error("write() to \"%s\" returned %zd instead of %zu", filepath, written, len);
-    free(filepath);
-    close(fd);
-    return false;
-  }
+    written = write(fd, buffer, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
 
-  close(fd);
-  free(filepath);
+      log_error("Failed to write() to \"%s\": %d (%s)", path, errno, strerror(errno));
+      return false;
+    }
+
+    buffer = (const char *)buffer + written;
+    size -= written;
+  }
 
-  pair_ptr->stored = true;
-  
   return true;
 }
 
-static struct pair * load_pair(const char * key)
+static bool journal_write_header(int fd, const char * path)
+{
+  struct journal_header header;
+
+  memcpy(header.signature, JOURNAL_SIGNATURE, sizeof(header.signature));
+  header.format_version = JOURNAL_FORMAT_VERSION;
+  header.reserved = 0;
+
+  return journal_write(fd, path, &header, sizeof(header));
+}
+
+static bool journal_apply_record(const char * key_ptr, size_t key_len, const char * value_ptr, size_t value_len)
 {
+  char * key;
+  char * value;
   struct pair * pair_ptr;
-  char * path;
-  struct stat st;
-  int fd;
-  char * buffer;
-  ssize_t bytes_read;
 
-  path = catdupv(getenv("HOME"), STORAGE_BASE_DIR, key, "/value", NULL);
-  if (path == NULL)
+  key = strndup(key_ptr, key_len);
+  value = strndup(value_ptr, value_len);
+  if (key == NULL || value == NULL)
   {
-    return NULL;
+    log_error("strndup() failed for journal record");
+    free(key);
+    free(value);
+    return false;
   }
 
-  if (stat(path, &st) != 0)
+  pair_ptr = find_pair(key);
+  if (pair_ptr == NULL)
   {
-    log_error("Failed to stat \"%s\": %d (%s)", path, errno, strerror(errno));
-    free(path);
-    return NULL;
+    pair_ptr = create_pair(key, NULL);
+    if (pair_ptr == NULL)
+    {
+      free(key);
+      free(value);
+      return false;
+    }
   }
 
-  if (!S_ISREG(st.st_mode))
-  {
-    log_error("\"%s\" is not a regular file.", path);
-    free(path);
-    return NULL;
-  }
+  free(key);
+  free(pair_ptr->value);
+  pair_ptr->value = value;
+  pair_ptr->stored = true;
 
-  fd = open(path, O_RDONLY);
-  if (fd == -1)
-  {
-    log_error("Failed to open \"%s\": %d (%s)", path, errno, strerror(errno));
-    free(path);
-    return NULL;
-  }
+  return true;
+}
 
-  buffer = malloc((size_t)st.st_size + 1);
-  if (buffer == NULL)
-  {
-    log_error("malloc() failed to allocate %zu bytes of memory for value", (size_t)st.st_size + 1);
-    close(fd);
-    free(path);
-    return NULL;
-  }
+/* whether a complete record with matching checksum starts at offset */
+static bool journal_check_record(const char * data, off_t size, off_t offset, struct journal_record * record_ptr)
+{
+  const char * key_ptr;
 
-  bytes_read = read(fd, buffer, st.st_size);
-  if (bytes_read < 0)
+  if ((size_t)(size - offset) < sizeof(struct journal_record))
   {
-    log_error("Failed to read() from \"%s\": %d (%s)", path, errno, strerror(errno));
-    free(buffer);
-    close(fd);
-    free(path);
-    return NULL;
+    return false;
   }
 
-  if (bytes_read != st.st_size)
+  memcpy(record_ptr, data + offset, sizeof(struct journal_record));
+  if (record_ptr->magic != JOURNAL_RECORD_MAGIC ||
+      (size_t)(size - offset) - sizeof(struct journal_record) < (size_t)record_ptr->key_len + record_ptr->value_len)
   {
-    log_error("read() from \"%s\" returned %zd instead of %llu", path, bytes_read, (unsigned long long)st.st_size);
-    free(buffer);
-    close(fd);
-    free(path);
-    return NULL;
+    return false;
   }
 
-  buffer[st.st_size] = 0;
+  key_ptr = data + offset + sizeof(struct journal_record);
+  return journal_checksum(key_ptr, record_ptr->key_len, key_ptr + record_ptr->key_len, record_ptr->value_len) == record_ptr->checksum;
+}
+
+/* returns offset of the next valid record or size if there is none */
+static off_t journal_find_record(const char * data, off_t size, off_t offset)
+{
+  struct journal_record record;
+  uint32_t magic;
+
+  magic = JOURNAL_RECORD_MAGIC;
 
-  pair_ptr = create_pair(key, NULL);
-  if (pair_ptr == NULL)
+  for (; (size_t)(size - offset) >= sizeof(record); offset++)
   {
-    free(buffer);
-    close(fd);
-    free(path);
-    return NULL;
+    if (memcmp(data + offset, &magic, sizeof(magic)) == 0 &&
+        journal_check_record(data, size, offset, &record))
+    {
+      return offset;
+    }
   }
 
-  pair_ptr->value = buffer;
-
-  close(fd);
-  free(path);
-
-  return pair_ptr;
+  return size;
 }
 
-static struct pair * find_pair(const char * key)
+/*
+ * Loads the records after the header. A damaged tail without valid records
+ * after it is left for the caller to truncate, it is what a crash during an
+ * append leaves behind. Damage with valid records after it is skipped.
+ * Returns false when out of memory.
+ */
+static bool journal_load(const char * data, off_t size, off_t * valid_size_ptr, bool * damaged_ptr)
 {
-  struct list_head * node_ptr;
-  struct pair * pair_ptr;
+  struct journal_record record;
+  off_t offset;
+  off_t next;
+  const char * key_ptr;
 
-  list_for_each(node_ptr, &g_pairs)
+  *damaged_ptr = false;
+
+  offset = sizeof(struct journal_header);
+  while (offset < size)
   {
-    pair_ptr = list_entry(node_ptr, struct pair, siblings);
-    if (strcmp(pair_ptr->key, key) == 0)
+    if (!journal_check_record(data, size, offset, &record))
     {
-      return pair_ptr;
+      next = journal_find_record(data, size, offset + 1);
+      if (next == size)
+      {
+        break;
+      }
+
+      log_error(
+        "Journal \"%s\" is damaged at offset %llu, skipping %llu bytes",
+        g_journal_path,
+        (unsigned long long)offset,
+        (unsigned long long)(next - offset));
+      *damaged_ptr = true;
+      offset = next;
+      continue;
+    }
+
+    key_ptr = data + offset + sizeof(record);
+    if (!journal_apply_record(key_ptr, record.key_len, key_ptr + record.key_len, record.value_len))
+    {
+      return false;
     }
+
+    offset += sizeof(record) + record.key_len + record.value_len;
   }
 
-  return NULL;
+  *valid_size_ptr = offset;
+  return true;
 }
 
-static void emit_changed(struct pair * pair_ptr)
+/* returns malloc()ed path for keeping a copy of the journal, NULL on failure */
+static char * journal_aside_path(const char * reason)
 {
-  cdbus_signal_emit(
-    cdbus_g_dbus_connection,
-    CONF_OBJECT_PATH,
-    CONF_IFACE,
-    "changed",
-    "sst",
-    &pair_ptr->key,
-    &pair_ptr->value,
-    &pair_ptr->version);
+  char suffix[64];
+
+  snprintf(suffix, sizeof(suffix), ".%s.%llu", reason, (unsigned long long)time(NULL));
+  return catdup(g_journal_path, suffix);
 }
 
-/***************************************************************************/
-/* D-Bus interface implementation */
+static size_t journal_live_size(void);
+static bool journal_rewrite(size_t size);
 
-static void conf_set(struct cdbus_method_call * call_ptr)
+static bool journal_open(void)
 {
-  const char * key;
-  const char * value;
-  struct pair * pair_ptr;
-  char * buffer;
-  bool store;
+  char * dirpath;
+  char * aside_path;
+  struct stat st;
+  void * data;
+  struct journal_header header;
+  bool damaged;
+  bool loaded;
 
-  if (!dbus_message_get_args(
-        call_ptr->message,
-        &cdbus_g_dbus_error,
-        DBUS_TYPE_STRING, &key,
-        DBUS_TYPE_STRING, &value,
-        DBUS_TYPE_INVALID))
+  dirpath = catdup(getenv("HOME"), STORAGE_JOURNAL_DIR);
+  if (dirpath == NULL)
   {
-    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid arguments to method \"%s\": %s",  call_ptr->method_name, cdbus_g_dbus_error.message);
-    dbus_error_free(&cdbus_g_dbus_error);
-    return;
+    return false;
   }
 
-  log_info("set '%s' <- '%s'", key, value);
-
-  pair_ptr = find_pair(key);
-  if (pair_ptr == NULL)
+  if (!ensure_dir_exist(dirpath, 0700))
   {
-    pair_ptr = create_pair(key, value);
-    if (pair_ptr == NULL)
-    {
-      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Memory allocation failed");
-      return;
-    }
+    free(dirpath);
+    return false;
+  }
 
-    emit_changed(pair_ptr);
+  free(dirpath);
+
+  g_journal_path = catdup(getenv("HOME"), STORAGE_JOURNAL_FILE);
+  if (g_journal_path == NULL)
+  {
+    return false;
+  }
 
-    store = true;
+reopen:
+  g_journal_fd = open(g_journal_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  if (g_journal_fd == -1)
+  {
+    log_error("Failed to open \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+    goto free_path;
   }
-  else
+
+  if (fstat(g_journal_fd, &st) != 0)
   {
-    store = strcmp(pair_ptr->value, value) != 0;
-    if (store)
-    {
-      buffer = strdup(value);
-      if (buffer == NULL)
-      {
-        cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Memory allocation failed. strdup(\"%s\") failed for value", value);
-        return;
-      }
-      free(pair_ptr->value);
-      pair_ptr->value = buffer;
-      pair_ptr->version++;
-      pair_ptr->stored = false; /* mark that new value was not stored on disk yet */
+    log_error("Failed to stat \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+    goto close;
+  }
 
-      emit_changed(pair_ptr);
-    }
-    else if (!pair_ptr->stored) /* if store to disk failed last time, retry */
+  if (st.st_size == 0)
+  {
+    if (!journal_write_header(g_journal_fd, g_journal_path))
     {
-      store = true;
+      goto close;
     }
+
+    g_journal_size = sizeof(struct journal_header);
+    return true;
   }
 
-  if (store)
+  if ((size_t)st.st_size >= sizeof(header) &&
+      pread(g_journal_fd, &header, sizeof(header), 0) == sizeof(header) &&
+      memcmp(header.signature, JOURNAL_SIGNATURE, sizeof(header.signature)) == 0)
   {
-    if (!store_pair(pair_ptr))
+    if (header.format_version != JOURNAL_FORMAT_VERSION)
     {
-      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Storing the value of key '%s' to disk failed", pair_ptr->key);
-      return;
+      /* written by a newer version, leave it alone */
+      log_error("Journal \"%s\" has unsupported format version %u", g_journal_path, (unsigned int)header.format_version);
+      goto close;
     }
   }
-
+  else
+  {
+    /* not a journal, keep it for inspection and start a new one */
+    aside_path = journal_aside_path("unknown");
+    if (aside_path == NULL)
+    {
+      goto close;
+    }
+
+    if (rename(g_journal_path, aside_path) != 0)
+    {
+      log_error("rename(\"%s\", \"%s\") failed: %d (%s)", g_journal_path, aside_path, errno, strerror(errno));
+      free(aside_path);
+      goto close;
+    }
+
+    log_error("\"%s\" is not a journal, moved it to \"%s\"", g_journal_path, aside_path);
+    free(aside_path);
+    close(g_journal_fd);
+    goto reopen;
+  }
+
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, g_journal_fd, 0);
+  if (data == MAP_FAILED)
+  {
+    log_error("Failed to mmap \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+    goto close;
+  }
+
+  loaded = journal_load(data, st.st_size, &g_journal_size, &damaged);
+
+  munmap(data, st.st_size);
+
+  if (!loaded)
+  {
+    goto close;
+  }
+
+  if (g_journal_size != st.st_size)
+  {
+    log_error("Journal \"%s\" has incomplete record at offset %llu, truncating", g_journal_path, (unsigned long long)g_journal_size);
+
+    if (ftruncate(g_journal_fd, g_journal_size) != 0)
+    {
+      log_error("Failed to truncate \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+      goto close;
+    }
+  }
+
+  if (damaged)
+  {
+    /* keep the damaged journal and continue with one that has the valid records */
+    aside_path = journal_aside_path("damaged");
+    if (aside_path == NULL)
+    {
+      goto close;
+    }
+
+    if (link(g_journal_path, aside_path) != 0)
+    {
+      log_error("link(\"%s\", \"%s\") failed: %d (%s)", g_journal_path, aside_path, errno, strerror(errno));
+      free(aside_path);
+      goto close;
+    }
+
+    log_error("Damaged journal is kept as \"%s\"", aside_path);
+    free(aside_path);
+
+    if (!journal_rewrite(journal_live_size()))
+    {
+      log_error("Continuing with the damaged journal");
+    }
+  }
+
+  return true;
+
+close:
+  close(g_journal_fd);
+  g_journal_fd = -1;
+free_path:
+  free(g_journal_path);
+  g_journal_path = NULL;
+  return false;
+}
+
+static void journal_close(void)
+{
+  if (g_journal_fd != -1)
+  {
+    close(g_journal_fd);
+    g_journal_fd = -1;
+  }
+
+  free(g_journal_path);
+  g_journal_path = NULL;
+}
+
+/* size of the records of the current values */
+static size_t journal_live_size(void)
+{
+  struct list_head * node_ptr;
+  size_t size;
+
+  size = 0;
+  list_for_each(node_ptr, &g_pairs)
+  {
+    size += journal_record_size(list_entry(node_ptr, struct pair, siblings));
+  }
+
+  return size;
+}
+
+/* replace the journal with one that contains only the current values, size is journal_live_size() */
+static bool journal_rewrite(size_t size)
+{
+  char * buffer;
+  char * ptr;
+  char * temp_path;
+  struct list_head * node_ptr;
+  bool ret;
+  int fd;
+
+  ret = false;
+
+  buffer = malloc(size);
+  if (buffer == NULL)
+  {
+    log_error("malloc() failed to allocate %zu bytes for journal rewrite", size);
+    return false;
+  }
+
+  ptr = buffer;
+  list_for_each(node_ptr, &g_pairs)
+  {
+    ptr = journal_put_record(ptr, list_entry(node_ptr, struct pair, siblings));
+  }
+
+  temp_path = catdup(g_journal_path, STORAGE_JOURNAL_TEMP_SUFFIX);
+  if (temp_path == NULL)
+  {
+    goto free_buffer;
+  }
+
+  fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+  if (fd == -1)
+  {
+    log_error("Failed to create \"%s\": %d (%s)", temp_path, errno, strerror(errno));
+    goto free_temp_path;
+  }
+
+  if (!journal_write_header(fd, temp_path) ||
+      !journal_write(fd, temp_path, buffer, size))
+  {
+    goto close_unlink;
+  }
+
+  if (fsync(fd) != 0)
+  {
+    log_error("Failed to fsync \"%s\": %d (%s)", temp_path, errno, strerror(errno));
+    goto close_unlink;
+  }
+
+  if (rename(temp_path, g_journal_path) != 0)
+  {
+    log_error("rename(\"%s\", \"%s\") failed: %d (%s)", temp_path, g_journal_path, errno, strerror(errno));
+    goto close_unlink;
+  }
+
+  close(g_journal_fd);
+  g_journal_fd = fd;
+  g_journal_size = sizeof(struct journal_header) + size;
+  ret = true;
+  goto free_temp_path;
+
+close_unlink:
+  close(fd);
+  unlink(temp_path);
+free_temp_path:
+  free(temp_path);
+free_buffer:
+  free(buffer);
+  return ret;
+}
+
+/* rewrite the journal when it is much bigger than the current values */
+static void journal_compact(void)
+{
+  size_t size;
+
+  size = journal_live_size();
+  if ((off_t)size * 2 > g_journal_size)
+  {
+    return;
+  }
+
+  log_info("Compacting journal: %llu bytes -> %zu bytes", (unsigned long long)g_journal_size, size + sizeof(struct journal_header));
+
+  journal_rewrite(size);
+}
+
+static void emit_changed(struct pair * pair_ptr);
+
+/* The reply, built by the method handler, is sent after the values are stored */
+static void defer_reply(struct cdbus_method_call * call_ptr)
+{
+  struct deferred_reply * deferred_ptr;
+
+  if (call_ptr->reply == NULL)
+  {
+    return;
+  }
+
+  deferred_ptr = malloc(sizeof(struct deferred_reply));
+  if (deferred_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate memory for deferred reply, storing values now");
+    if (!flush())
+    {
+      dbus_message_unref(call_ptr->reply);
+      call_ptr->reply = NULL;
+      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Storing values failed");
+    }
+
+    return;
+  }
+
+  deferred_ptr->call = dbus_message_ref(call_ptr->message);
+  deferred_ptr->reply = call_ptr->reply;
+  call_ptr->reply = NULL;
+
+  list_add_tail(&deferred_ptr->siblings, &g_deferred_replies);
+}
+
+static void send_deferred_replies(bool stored)
+{
+  struct deferred_reply * deferred_ptr;
+
+  while (!list_empty(&g_deferred_replies))
+  {
+    deferred_ptr = list_entry(g_deferred_replies.next, struct deferred_reply, siblings);
+    list_del(&deferred_ptr->siblings);
+
+    if (!stored)
+    {
+      dbus_message_unref(deferred_ptr->reply);
+      deferred_ptr->reply = dbus_message_new_error(deferred_ptr->call, DBUS_ERROR_FAILED, "Storing values failed");
+    }
+
+    if (deferred_ptr->reply == NULL)
+    {
+      log_error("Ran out of memory trying to construct method return");
+    }
+    else
+    {
+      if (!dbus_connection_send(cdbus_g_dbus_connection, deferred_ptr->reply, NULL))
+      {
+        log_error("Ran out of memory trying to send method return");
+      }
+
+      dbus_message_unref(deferred_ptr->reply);
+    }
+
+    dbus_message_unref(deferred_ptr->call);
+    free(deferred_ptr);
+  }
+}
+
+/* undo changes that could not be stored, so memory matches the journal */
+static void restore_stored_values(void)
+{
+  struct list_head * node_ptr;
+  struct list_head * next_ptr;
+  struct pair * pair_ptr;
+
+  list_for_each_safe(node_ptr, next_ptr, &g_pairs)
+  {
+    pair_ptr = list_entry(node_ptr, struct pair, siblings);
+    if (pair_ptr->stored)
+    {
+      continue;
+    }
+
+    if (pair_ptr->stored_value == NULL)
+    {
+      log_error("Dropping key '%s', its value could not be stored", pair_ptr->key);
+      destroy_pair(pair_ptr);
+      continue;
+    }
+
+    log_error("Restoring value of key '%s', the new one could not be stored", pair_ptr->key);
+
+    free(pair_ptr->value);
+    pair_ptr->value = pair_ptr->stored_value;
+    pair_ptr->stored_value = NULL;
+    pair_ptr->stored = true;
+    pair_ptr->version++;        /* older versions are ignored by the clients */
+
+    emit_changed(pair_ptr);
+  }
+}
+
+/* Append all not yet stored values to the journal, sync it and send the
+ * replies that wait for the values. On failure, the stored values are
+ * restored and the waiting calls get an error. */
+static bool flush(void)
+{
+  struct list_head * node_ptr;
+  struct pair * pair_ptr;
+  size_t size;
+  char * buffer;
+  char * ptr;
+
+  g_flush_deadline = 0;
+
+  size = 0;
+  list_for_each(node_ptr, &g_pairs)
+  {
+    pair_ptr = list_entry(node_ptr, struct pair, siblings);
+    if (!pair_ptr->stored)
+    {
+      size += journal_record_size(pair_ptr);
+    }
+  }
+
+  if (size == 0)
+  {
+    send_deferred_replies(true);
+    return true;
+  }
+
+  buffer = malloc(size);
+  if (buffer == NULL)
+  {
+    log_error("malloc() failed to allocate %zu bytes for journal records", size);
+    goto fail;
+  }
+
+  ptr = buffer;
+  list_for_each(node_ptr, &g_pairs)
+  {
+    pair_ptr = list_entry(node_ptr, struct pair, siblings);
+    if (!pair_ptr->stored)
+    {
+      ptr = journal_put_record(ptr, pair_ptr);
+    }
+  }
+
+  if (!journal_write(g_journal_fd, g_journal_path, buffer, size))
+  {
+    goto fail_truncate;
+  }
+
+  if (fdatasync(g_journal_fd) != 0)
+  {
+    log_error("Failed to sync \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+    goto fail_truncate;
+  }
+
+  free(buffer);
+  g_journal_size += size;
+
+  list_for_each(node_ptr, &g_pairs)
+  {
+    pair_ptr = list_entry(node_ptr, struct pair, siblings);
+    pair_ptr->stored = true;
+    free(pair_ptr->stored_value);
+    pair_ptr->stored_value = NULL;
+  }
+
+  send_deferred_replies(true);
+
+  if (g_journal_size > CONF_COMPACT_MIN_SIZE)
+  {
+    journal_compact();
+  }
+
+  return true;
+
+fail_truncate:
+  /* drop the records, the values they carry are restored in memory */
+  if (ftruncate(g_journal_fd, g_journal_size) != 0)
+  {
+    log_error("Failed to truncate \"%s\": %d (%s)", g_journal_path, errno, strerror(errno));
+  }
+
+  free(buffer);
+fail:
+  restore_stored_values();
+  send_deferred_replies(false);
+  return false;
+}
+
+/***************************************************************************/
+/* migration of values stored by older versions */
+
+static char * read_legacy_value(const char * path, off_t size)
+{
+  int fd;
+  char * buffer;
+  ssize_t bytes_read;
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    log_error("Failed to open \"%s\": %d (%s)", path, errno, strerror(errno));
+    return NULL;
+  }
+
+  buffer = malloc((size_t)size + 1);
+  if (buffer == NULL)
+  {
+    log_error("malloc() failed to allocate %zu bytes of memory for value", (size_t)size + 1);
+    close(fd);
+    return NULL;
+  }
+
+  bytes_read = read(fd, buffer, size);
+  if (bytes_read < 0)
+  {
+    log_error("Failed to read() from \"%s\": %d (%s)", path, errno, strerror(errno));
+    free(buffer);
+    close(fd);
+    return NULL;
+  }
+
+  if (bytes_read != size)
+  {
+    log_error("read() from \"%s\" returned %zd instead of %llu", path, bytes_read, (unsigned long long)size);
+    free(buffer);
+    close(fd);
+    return NULL;
+  }
+
+  buffer[size] = 0;
+  close(fd);
+  return buffer;
+}
+
+/* The value of key is stored in STORAGE_BASE_DIR key "/value". All keys
+ * start with '/', so the key is the path of the value dir relative to
+ * STORAGE_BASE_DIR, with a leading '/'. */
+static bool migrate_legacy_dir(const char * dirpath, const char * key, unsigned int * count_ptr)
+{
+  DIR * dir;
+  struct dirent * dentry;
+  char * path;
+  char * subkey;
+  struct stat st;
+  struct pair * pair_ptr;
+  char * value;
+  bool ret;
+
+  dir = opendir(dirpath);
+  if (dir == NULL)
+  {
+    log_error("Cannot open directory '%s': %d (%s)", dirpath, errno, strerror(errno));
+    return false;
+  }
+
+  ret = true;
+
+  while ((dentry = readdir(dir)) != NULL)
+  {
+    if (strcmp(dentry->d_name, ".") == 0 || strcmp(dentry->d_name, "..") == 0)
+    {
+      continue;
+    }
+
+    path = catdupv(dirpath, "/", dentry->d_name, NULL);
+    if (path == NULL)
+    {
+      ret = false;
+      break;
+    }
+
+    if (stat(path, &st) != 0)
+    {
+      log_error("Failed to stat \"%s\": %d (%s)", path, errno, strerror(errno));
+      ret = false;
+    }
+    else if (S_ISDIR(st.st_mode))
+    {
+      subkey = catdupv(key, "/", dentry->d_name, NULL);
+      if (subkey == NULL)
+      {
+        ret = false;
+      }
+      else
+      {
+        ret = migrate_legacy_dir(path, subkey, count_ptr);
+        free(subkey);
+      }
+    }
+    else if (S_ISREG(st.st_mode) && strcmp(dentry->d_name, "value") == 0 && *key != 0)
+    {
+      /* values already in the journal are newer */
+      if (find_pair(key) == NULL)
+      {
+        value = read_legacy_value(path, st.st_size);
+        pair_ptr = value != NULL ? create_pair(key, NULL) : NULL;
+        if (pair_ptr == NULL)
+        {
+          free(value);
+          ret = false;
+        }
+        else
+        {
+          pair_ptr->value = value;
+          (*count_ptr)++;
+        }
+      }
+    }
+
+    free(path);
+
+    if (!ret)
+    {
+      break;
+    }
+  }
+
+  closedir(dir);
+  return ret;
+}
+
+static void migrate_legacy(void)
+{
+  char * dirpath;
+  unsigned int count;
+
+  dirpath = catdup(getenv("HOME"), STORAGE_BASE_DIR);
+  if (dirpath == NULL)
+  {
+    return;
+  }
+
+  if (!check_dir_exists(dirpath))
+  {
+    goto free;
+  }
+
+  count = 0;
+
+  /* on failure, the old files are kept and migration is retried on next start */
+  if (!migrate_legacy_dir(dirpath, "", &count) || !flush())
+  {
+    log_error("Migration of values from \"%s\" failed", dirpath);
+    goto free;
+  }
+
+  log_info("Migrated %u value(s) from \"%s\"", count, dirpath);
+
+  if (!ladish_rmdir_recursive(dirpath))
+  {
+    log_error("Failed to remove \"%s\"", dirpath);
+  }
+
+free:
+  free(dirpath);
+}
+
+static void emit_changed(struct pair * pair_ptr)
+{
+  cdbus_signal_emit(
+    cdbus_g_dbus_connection,
+    CONF_OBJECT_PATH,
+    CONF_IFACE,
+    "changed",
+    "sst",
+    &pair_ptr->key,
+    &pair_ptr->value,
+    &pair_ptr->version);
+}
+
+/***************************************************************************/
+/* D-Bus interface implementation */
+
+static const char * set_pair(const char * key, const char * value, struct pair ** pair_ptr_ptr)
+{
+  struct pair * pair_ptr;
+  char * buffer;
+
+  log_info("set '%s' <- '%s'", key, value);
+
+  pair_ptr = find_pair(key);
+  if (pair_ptr == NULL)
+  {
+    pair_ptr = create_pair(key, value);
+    if (pair_ptr == NULL)
+    {
+      return "Memory allocation failed";
+    }
+
+    emit_changed(pair_ptr);
+  }
+  else if (strcmp(pair_ptr->value, value) != 0)
+  {
+    buffer = strdup(value);
+    if (buffer == NULL)
+    {
+      return "Memory allocation failed. strdup() failed for value";
+    }
+
+    if (pair_ptr->stored)
+    { /* restored if the new value cannot be stored */
+      pair_ptr->stored_value = pair_ptr->value;
+    }
+    else
+    {
+      free(pair_ptr->value);
+    }
+
+    pair_ptr->value = buffer;
+    pair_ptr->version++;
+    pair_ptr->stored = false; /* mark that new value was not stored on disk yet */
+
+    emit_changed(pair_ptr);
+  }
+
+  if (!pair_ptr->stored)
+  {
+    schedule_flush();
+  }
+
+  *pair_ptr_ptr = pair_ptr;
+  return NULL;
+}
+
+static void conf_set(struct cdbus_method_call * call_ptr)
+{
+  const char * key;
+  const char * value;
+  struct pair * pair_ptr;
+  const char * error;
+
+  if (!dbus_message_get_args(
+        call_ptr->message,
+        &cdbus_g_dbus_error,
+        DBUS_TYPE_STRING, &key,
+        DBUS_TYPE_STRING, &value,
+        DBUS_TYPE_INVALID))
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid arguments to method \"%s\": %s",  call_ptr->method_name, cdbus_g_dbus_error.message);
+    dbus_error_free(&cdbus_g_dbus_error);
+    return;
+  }
+
+  error = set_pair(key, value, &pair_ptr);
+  if (error != NULL)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Setting value of key '%s' failed: %s", key, error);
+    return;
+  }
+
   cdbus_method_return_new_single(call_ptr, DBUS_TYPE_UINT64, &pair_ptr->version);
+
+  /* reply only after the value is on disk */
+  if (!pair_ptr->stored)
+  {
+    defer_reply(call_ptr);
+  }
 }
 
 static void conf_get(struct cdbus_method_call * call_ptr)
@@ -489,12 +1347,8 @@ static void conf_get(struct cdbus_method_call * call_ptr)
   pair_ptr = find_pair(key);
   if (pair_ptr == NULL)
   {
-    pair_ptr = load_pair(key);
-    if (pair_ptr == NULL)
-    {
-      cdbus_error(call_ptr, LADISH_DBUS_ERROR_KEY_NOT_FOUND, "Key '%s' not found", key);
-      return;
-    }
+    cdbus_error(call_ptr, LADISH_DBUS_ERROR_KEY_NOT_FOUND, "Key '%s' not found", key);
+    return;
   }
 
   log_info("get '%s' -> '%s'", key, pair_ptr->value);
@@ -506,6 +1360,157 @@ static void conf_get(struct cdbus_method_call * call_ptr)
     DBUS_TYPE_INVALID);
 }
 
+static void conf_get_many(struct cdbus_method_call * call_ptr)
+{
+  DBusMessageIter iter;
+  DBusMessageIter keys_iter;
+  DBusMessageIter array_iter;
+  DBusMessageIter struct_iter;
+  const char * key;
+  struct pair * pair_ptr;
+
+  if (strcmp(dbus_message_get_signature(call_ptr->message), "as") != 0)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid arguments to method \"%s\"", call_ptr->method_name);
+    return;
+  }
+
+  call_ptr->reply = dbus_message_new_method_return(call_ptr->message);
+  if (call_ptr->reply == NULL)
+  {
+    goto fail;
+  }
+
+  dbus_message_iter_init_append(call_ptr->reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(sst)", &array_iter))
+  {
+    goto fail_unref;
+  }
+
+  dbus_message_iter_init(call_ptr->message, &keys_iter);
+  dbus_message_iter_recurse(&keys_iter, &keys_iter);
+
+  while (dbus_message_iter_get_arg_type(&keys_iter) == DBUS_TYPE_STRING)
+  {
+    dbus_message_iter_get_basic(&keys_iter, &key);
+    dbus_message_iter_next(&keys_iter);
+
+    pair_ptr = find_pair(key);
+    if (pair_ptr == NULL)
+    {
+      /* missing keys are simply not included in the reply */
+      continue;
+    }
+
+    log_info("get '%s' -> '%s'", key, pair_ptr->value);
+
+    if (!dbus_message_iter_open_container(&array_iter, DBUS_TYPE_STRUCT, NULL, &struct_iter) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &pair_ptr->key) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &pair_ptr->value) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &pair_ptr->version) ||
+        !dbus_message_iter_close_container(&array_iter, &struct_iter))
+    {
+      goto fail_unref;
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &array_iter))
+  {
+    goto fail_unref;
+  }
+
+  return;
+
+fail_unref:
+  dbus_message_unref(call_ptr->reply);
+  call_ptr->reply = NULL;
+
+fail:
+  log_error("Ran out of memory trying to construct method return");
+}
+
+static void conf_set_many(struct cdbus_method_call * call_ptr)
+{
+  DBusMessageIter iter;
+  DBusMessageIter pairs_iter;
+  DBusMessageIter struct_iter;
+  DBusMessageIter array_iter;
+  const char * key;
+  const char * value;
+  struct pair * pair_ptr;
+  const char * error;
+  bool stored;
+
+  if (strcmp(dbus_message_get_signature(call_ptr->message), "a(ss)") != 0)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid arguments to method \"%s\"", call_ptr->method_name);
+    return;
+  }
+
+  call_ptr->reply = dbus_message_new_method_return(call_ptr->message);
+  if (call_ptr->reply == NULL)
+  {
+    goto fail;
+  }
+
+  dbus_message_iter_init_append(call_ptr->reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, DBUS_TYPE_UINT64_AS_STRING, &array_iter))
+  {
+    goto fail_unref;
+  }
+
+  dbus_message_iter_init(call_ptr->message, &pairs_iter);
+  dbus_message_iter_recurse(&pairs_iter, &pairs_iter);
+
+  stored = true;
+  while (dbus_message_iter_get_arg_type(&pairs_iter) == DBUS_TYPE_STRUCT)
+  {
+    dbus_message_iter_recurse(&pairs_iter, &struct_iter);
+    dbus_message_iter_get_basic(&struct_iter, &key);
+    dbus_message_iter_next(&struct_iter);
+    dbus_message_iter_get_basic(&struct_iter, &value);
+    dbus_message_iter_next(&pairs_iter);
+
+    error = set_pair(key, value, &pair_ptr);
+    if (error != NULL)
+    {
+      dbus_message_unref(call_ptr->reply);
+      call_ptr->reply = NULL;
+      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Setting value of key '%s' failed: %s", key, error);
+      return;
+    }
+
+    if (!dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_UINT64, &pair_ptr->version))
+    {
+      goto fail_unref;
+    }
+
+    stored = stored && pair_ptr->stored;
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &array_iter))
+  {
+    goto fail_unref;
+  }
+
+  /* reply only after the values are on disk */
+  if (!stored)
+  {
+    defer_reply(call_ptr);
+  }
+
+  return;
+
+fail_unref:
+  dbus_message_unref(call_ptr->reply);
+  call_ptr->reply = NULL;
+
+fail:
+  log_error("Ran out of memory trying to construct method return");
+}
+
 static void conf_exit(struct cdbus_method_call * call_ptr)
 {
   log_info("Exit command received through D-Bus");
@@ -525,12 +1530,24 @@ CDBUS_METHOD_ARGS_BEGIN(get, "Get conf value")
   CDBUS_METHOD_ARG_DESCRIBE_OUT("version", DBUS_TYPE_UINT64_AS_STRING, "")
 CDBUS_METHOD_ARGS_END
 
+CDBUS_METHOD_ARGS_BEGIN(GetMany, "Get conf values of multiple keys")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("keys", "as", "")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("values", "a(sst)", "key, value and version of each existing key")
+CDBUS_METHOD_ARGS_END
+
+CDBUS_METHOD_ARGS_BEGIN(SetMany, "Set conf values of multiple keys")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("pairs", "a(ss)", "key and value pairs")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("versions", "at", "new versions, in the order of the pairs")
+CDBUS_METHOD_ARGS_END
+
 CDBUS_METHOD_ARGS_BEGIN(exit, "Tell conf D-Bus service to exit")
 CDBUS_METHOD_ARGS_END
 
 CDBUS_METHODS_BEGIN
   CDBUS_METHOD_DESCRIBE(set, conf_set)
   CDBUS_METHOD_DESCRIBE(get, conf_get)
+  CDBUS_METHOD_DESCRIBE(GetMany, conf_get_many)
+  CDBUS_METHOD_DESCRIBE(SetMany, conf_set_many)
   CDBUS_METHOD_DESCRIBE(exit, conf_exit)
 CDBUS_METHODS_END
 
@@ -50,6 +50,7 @@ struct ladish_app
   char * name;
   char * commandline;
   char * js_commandline;
+  ladish_js_save_handle js_save; /* pending JACK session save, NULL if none */
   bool terminal;
   char level[MAX_LEVEL_CHARCOUNT];
   pid_t pid;
@@ -203,10 +204,14 @@ struct ladish_app * ladish_app_supervisor_find_app_by_id_internal(struct ladish_
   return NULL;
 }
 
+static void ladish_app_cancel_js_save(struct ladish_app * app_ptr);
+
 void remove_app_internal(struct ladish_app_supervisor * supervisor_ptr, struct ladish_app * app_ptr)
 {
   ASSERT(app_ptr->pid == 0);    /* Removing not-stoped app? Zombies will make a rebellion! */
 
+  ladish_app_cancel_js_save(app_ptr);
+
   list_del(&app_ptr->siblings);
 
   supervisor_ptr->version++;
@@ -451,6 +456,7 @@ ladish_app_supervisor_add(
   }
 
   app_ptr->js_commandline = NULL;
+  app_ptr->js_save = NULL;
 
   app_ptr->dbus_name = NULL;
 
@@ -725,6 +731,8 @@ exit:
 
 static void ladish_js_app_save_complete(void * context, const char * commandline)
 {
+  app_ptr->js_save = NULL;
+
   if (commandline != NULL)
   {
     log_info("JS app saved, commandline '%s'", commandline);
@@ -759,6 +767,18 @@ static void ladish_js_app_save_complete(void * context, const char * commandline
 
 #undef app_ptr
 
+/* the save of the supervisor fails if it waits for this app */
+static void ladish_app_cancel_js_save(struct ladish_app * app_ptr)
+{
+  if (app_ptr->js_save == NULL)
+  {
+    return;
+  }
+
+  ladish_js_save_cancel(app_ptr->js_save);
+  ladish_js_app_save_complete(app_ptr, NULL);
+}
+
 static inline void ladish_app_initiate_save(struct ladish_app * app_ptr)
 {
   if (strcmp(app_ptr->level, LADISH_APP_LEVEL_LASH) == 0 &&
@@ -769,7 +789,7 @@ static inline void ladish_app_initiate_save(struct ladish_app * app_ptr)
   else if (strcmp(app_ptr->level, LADISH_APP_LEVEL_JACKSESSION) == 0)
   {
     log_info("Initiating JACK session save for '%s'", app_ptr->name);
-    if (!ladish_js_save_app(app_ptr->uuid, app_ptr->supervisor->js_temp_dir, app_ptr, ladish_js_app_save_complete))
+    if (!ladish_js_save_app(app_ptr->uuid, app_ptr->supervisor->js_temp_dir, app_ptr, ladish_js_app_save_complete, &app_ptr->js_save))
     {
       ladish_js_app_save_complete(app_ptr, NULL);
     }
@@ -803,6 +823,12 @@ bool ladish_app_supervisor_clear(ladish_app_supervisor_handle supervisor_handle)
   struct ladish_app * app_ptr;
   bool lifeless;
 
+  /* the pending saves use the JS temp dir */
+  list_for_each(node_ptr, &supervisor_ptr->applist)
+  {
+    ladish_app_cancel_js_save(list_entry(node_ptr, struct ladish_app, siblings));
+  }
+
   free(supervisor_ptr->js_temp_dir);
   supervisor_ptr->js_temp_dir = NULL;
   free(supervisor_ptr->js_dir);
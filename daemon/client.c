@@ -26,6 +26,8 @@
 
 #include "common.h"
 #include "client.h"
+#include "slab.h"
+#include "intern.h"
 
 struct ladish_client
 {
@@ -33,13 +35,15 @@ struct ladish_client
   uuid_t uuid_interlink;                   /* The UUID of the linked client (vgraph <-> jack graph) */
   uuid_t uuid_app;                         /* The UUID of the app that owns this client */
   uint64_t jack_id;                        /* JACK client ID */
-  char * jack_name;                        /* JACK client name */
+  const char * jack_name;                  /* JACK client name, interned */
   pid_t pid;                               /* process id. */
   bool has_js_callback;                    /* Whether the client has set jack session callback */
   ladish_dict_handle dict;
   void * vgraph;                /* virtual graph */
 };
 
+static struct ladish_slab g_client_slab = LADISH_SLAB_INITIALIZER("client", struct ladish_client);
+
 bool
 ladish_client_create(
   const uuid_t uuid_ptr,
@@ -47,17 +51,17 @@ ladish_client_create(
 {
   struct ladish_client * client_ptr;
 
-  client_ptr = malloc(sizeof(struct ladish_client));
+  client_ptr = ladish_slab_alloc(&g_client_slab);
   if (client_ptr == NULL)
   {
-    log_error("malloc() failed to allocate struct ladish_client");
+    log_error("ladish_slab_alloc() failed to allocate struct ladish_client");
     return false;
   }
 
   if (!ladish_dict_create(&client_ptr->dict))
   {
     log_error("ladish_dict_create() failed for client");
-    free(client_ptr);
+    ladish_slab_free(&g_client_slab, client_ptr);
     return false;
   }
 
@@ -109,8 +113,8 @@ ladish_client_destroy(
   log_info("client %p destroy", client_ptr);
 
   ladish_dict_destroy(client_ptr->dict);
-  free(client_ptr->jack_name);
-  free(client_ptr);
+  ladish_intern_unref(client_ptr->jack_name);
+  ladish_slab_free(&g_client_slab, client_ptr);
 }
 
 ladish_dict_handle ladish_client_get_dict(ladish_client_handle client_handle)
@@ -136,17 +140,17 @@ uint64_t ladish_client_get_jack_id(ladish_client_handle client_handle)
 
 void ladish_client_set_jack_name(ladish_client_handle client_handle, const char * jack_name)
 {
-  char * name_dup;
+  const char * name;
 
-  name_dup = strdup(jack_name);
-  if (name_dup == NULL)
+  name = ladish_intern(jack_name);
+  if (name == NULL)
   {
-    log_error("stdup(\"%s\") failed", jack_name);
+    log_error("ladish_intern(\"%s\") failed", jack_name);
     return;
   }
 
-  free(client_ptr->jack_name);
-  client_ptr->jack_name = name_dup;
+  ladish_intern_unref(client_ptr->jack_name);
+  client_ptr->jack_name = name;
 }
 
 const char * ladish_client_get_jack_name(ladish_client_handle client_handle)
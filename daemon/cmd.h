@@ -34,6 +34,15 @@
 #define LADISH_COMMAND_STATE_WAITING     2
 #define LADISH_COMMAND_STATE_DONE        3
 
+/* External events that resume waiting commands */
+#define LADISH_COMMAND_EVENT_CHILD_EXIT  0x01 /* a child process terminated */
+#define LADISH_COMMAND_EVENT_JACK        0x02 /* JACK server started or stopped */
+#define LADISH_COMMAND_EVENT_GRAPH       0x04 /* JACK client, port or connection appeared or disappeared */
+
+/* Commands are run in the order they are queued, but a command waits only
+ * for the commands queued before it in the same lane. There is a lane for
+ * the studio apps and one for each room. Barrier commands, the default,
+ * wait for all commands queued before them and block all queued after them. */
 struct ladish_command
 {
   struct list_head siblings;
@@ -41,14 +50,35 @@ struct ladish_command
   unsigned int state;
   bool cancel;
 
+  const char * name;            /* for the metrics interface */
+  uint64_t queued_time;         /* microseconds */
+
+  bool barrier;
+  uuid_t lane;                  /* room uuid, null for the studio lane */
+  unsigned int pass;            /* ladish_cqueue_run() pass that last run the command */
+
+  /* Waiting commands that did not call ladish_command_wait() are run on every pass */
+  bool wait_registered;
+  bool woken;                   /* ladish_command_wakeup() was called */
+  unsigned int wait_events;     /* LADISH_COMMAND_EVENT_XXX mask */
+  uint64_t wakeup_time;         /* microseconds, 0 for none */
+
   void * context;
   bool (* run)(void * context);
   void (* destructor)(void * context);
+
+  /* Set by idempotent commands. A command is coalesced into the last command queued in
+   * its lane when that one is of same type, is still pending and equal returns true. */
+  bool (* equal)(void * context, void * other_context);
 };
 
 struct ladish_cqueue
 {
   bool cancel;
+  bool last_coalesced;          /* ladish_cqueue_drop_command() has nothing to drop */
+  unsigned int count;
+  unsigned int pass;
+  unsigned int events;          /* LADISH_COMMAND_EVENT_XXX fired since the last pass */
   struct list_head queue;
 };
 
@@ -58,8 +88,18 @@ void ladish_cqueue_cancel(struct ladish_cqueue * queue_ptr);
 bool ladish_cqueue_add_command(struct ladish_cqueue * queue_ptr, struct ladish_command * command_ptr);
 void ladish_cqueue_drop_command(struct ladish_cqueue * queue_ptr);
 void ladish_cqueue_clear(struct ladish_cqueue * queue_ptr);
-
-void * ladish_command_new(size_t size);
+unsigned int ladish_cqueue_get_count(struct ladish_cqueue * queue_ptr, unsigned int * waiting_count_ptr);
+void ladish_cqueue_notify(struct ladish_cqueue * queue_ptr, unsigned int events);
+
+void * ladish_command_new(size_t size, const char * name);
+void ladish_command_set_lane(struct ladish_command * cmd_ptr, const uuid_t room_uuid);
+void ladish_command_set_lane_by_opath(struct ladish_command * cmd_ptr, const char * opath);
+
+/* Called by run() of a command that stays in waiting state. It will be run again when one
+ * of the events fires, when ladish_command_wakeup() is called or when timeout (microseconds,
+ * 0 for none) expires, whichever happens first. */
+void ladish_command_wait(struct ladish_command * cmd_ptr, unsigned int events, uint64_t timeout);
+void ladish_command_wakeup(struct ladish_command * cmd_ptr);
 
 bool ladish_command_new_studio(void * call_ptr, struct ladish_cqueue * queue_ptr, const char * studio_name);
 bool ladish_command_load_studio(void * call_ptr, struct ladish_cqueue * queue_ptr, const char * studio_name, bool autostart);
@@ -91,17 +91,19 @@ run_target_stop(
     {
       cmd_ptr->initiate_stop(app);
       cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
-      return true;
+      log_info("Waiting '%s' process termination (%s)...", app_name, cmd_ptr->target_state_description);
     }
 
     ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
-    log_info("Waiting '%s' process termination (%s)...", app_name, cmd_ptr->target_state_description);
+    ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT, 0);
     return true;
   }
 
   if (!ladish_virtualizer_is_hidden_app(ladish_studio_get_jack_graph(), app_uuid, app_name))
   {
     log_info("Waiting '%s' client disappear (%s)...", app_name, cmd_ptr->target_state_description);
+    cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
+    ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_GRAPH, 0);
     return true;
   }
 
@@ -151,6 +153,15 @@ static void destructor(void * context)
   free(cmd_ptr->opath);
 }
 
+static bool equal(void * context, void * other_context)
+{
+  struct ladish_command_change_app_state * other_ptr = other_context;
+
+  return cmd_ptr->id == other_ptr->id &&
+    cmd_ptr->target_state == other_ptr->target_state &&
+    strcmp(cmd_ptr->opath, other_ptr->opath) == 0;
+}
+
 #undef cmd_ptr
 
 bool ladish_command_change_app_state(void * call_ptr, struct ladish_cqueue * queue_ptr, const char * opath, uint64_t id, unsigned int target_state)
@@ -165,7 +176,7 @@ bool ladish_command_change_app_state(void * call_ptr, struct ladish_cqueue * que
     goto fail;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_change_app_state));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_change_app_state), "change_app_state");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
@@ -174,6 +185,8 @@ bool ladish_command_change_app_state(void * call_ptr, struct ladish_cqueue * que
 
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
+  cmd_ptr->command.equal = equal;
+  ladish_command_set_lane_by_opath(&cmd_ptr->command, opath);
   cmd_ptr->opath = opath_dup;
   cmd_ptr->id = id;
   cmd_ptr->target_state = target_state;
@@ -62,13 +62,13 @@ found:
   {
     ladish_room_initiate_stop(room, true);
     cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
-    return true;
   }
 
   ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
 
   if (!ladish_room_stopped(room))
   {
+    ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT | LADISH_COMMAND_EVENT_GRAPH, 0);
     return true;
   }
 
@@ -104,7 +104,7 @@ bool ladish_command_delete_room(void * call_ptr, struct ladish_cqueue * queue_pt
     goto fail;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_delete_room));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_delete_room), "delete_room");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
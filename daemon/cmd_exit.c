@@ -49,7 +49,7 @@ bool ladish_command_exit(void * call_ptr, struct ladish_cqueue * queue_ptr)
     goto fail;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command), "exit");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -36,13 +36,77 @@ struct ladish_command_load_project
   struct ladish_command command;
   uuid_t room_uuid;
   char * project_dir;
+  bool prefetched;              /* whether the project file was read when the command was queued */
+  ladish_worker_job_handle job; /* not NULL while the project file is being read */
+  ladish_xml_document_handle document;
 };
 
+#define cmd_ptr ((struct ladish_command_load_project *)context)
+
+static void ladish_load_project_read_complete(void * context, ladish_xml_document_handle document)
+{
+  cmd_ptr->job = NULL;
+  cmd_ptr->document = document;
+  ladish_command_wakeup(&cmd_ptr->command);
+}
+
+#undef cmd_ptr
+
 #define cmd_ptr ((struct ladish_command_load_project *)command_context)
 
+static bool ladish_load_project_read(void * command_context)
+{
+  ASSERT(cmd_ptr->job == NULL);
+  ASSERT(cmd_ptr->document == NULL);
+
+  /* the file is read and parsed by a worker thread, the project is loaded when it is done */
+  return ladish_read_project_async(cmd_ptr->project_dir, cmd_ptr, ladish_load_project_read_complete, &cmd_ptr->job);
+}
+
 static bool run(void * command_context)
 {
   ladish_room_handle room;
+  bool ret;
+
+  if (cmd_ptr->command.state == LADISH_COMMAND_STATE_PENDING)
+  {
+    if (!cmd_ptr->prefetched && !ladish_load_project_read(cmd_ptr))
+    {
+      return false;
+    }
+
+    cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
+  }
+
+  ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
+
+  if (cmd_ptr->job != NULL)
+  {
+    ladish_command_wait(&cmd_ptr->command, 0, 0);
+    return true;                /* still reading */
+  }
+
+  if (cmd_ptr->prefetched &&
+      (cmd_ptr->document == NULL || !ladish_xml_document_is_current(cmd_ptr->document)))
+  {
+    /* a command that was before this one in the queue may have written the file */
+    log_info("Project file in '%s' changed since it was prefetched, reading it again", cmd_ptr->project_dir);
+
+    if (cmd_ptr->document != NULL)
+    {
+      ladish_xml_document_destroy(cmd_ptr->document);
+      cmd_ptr->document = NULL;
+    }
+
+    cmd_ptr->prefetched = false;
+    if (!ladish_load_project_read(cmd_ptr))
+    {
+      return false;
+    }
+
+    ladish_command_wait(&cmd_ptr->command, 0, 0);
+    return true;
+  }
 
   room = ladish_studio_find_room_by_uuid(cmd_ptr->room_uuid);
   if (room == NULL)
@@ -52,7 +116,15 @@ static bool run(void * command_context)
     return false;
   }
 
-  if (!ladish_room_load_project(room, cmd_ptr->project_dir))
+  ret = ladish_room_load_project(room, cmd_ptr->project_dir, cmd_ptr->document);
+
+  if (cmd_ptr->document != NULL)
+  {
+    ladish_xml_document_destroy(cmd_ptr->document);
+    cmd_ptr->document = NULL;
+  }
+
+  if (!ret)
   {
     log_error("Project load failed.");
     return false;
@@ -67,6 +139,17 @@ static bool run(void * command_context)
 static void destructor(void * command_context)
 {
   log_info("load project command destructor");
+
+  if (cmd_ptr->job != NULL)
+  {
+    ladish_worker_abandon(cmd_ptr->job);
+  }
+
+  if (cmd_ptr->document != NULL)
+  {
+    ladish_xml_document_destroy(cmd_ptr->document);
+  }
+
   free(cmd_ptr->project_dir);
 }
 
@@ -94,7 +177,7 @@ ladish_command_load_project(
     goto fail_drop_unload_command;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_load_project));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_load_project), "load_project");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -104,7 +187,10 @@ ladish_command_load_project(
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
   uuid_copy(cmd_ptr->room_uuid, room_uuid_ptr);
+  ladish_command_set_lane(&cmd_ptr->command, room_uuid_ptr);
   cmd_ptr->project_dir = project_dir_dup;
+  cmd_ptr->job = NULL;
+  cmd_ptr->document = NULL;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
   {
@@ -112,6 +198,11 @@ ladish_command_load_project(
     goto fail_destroy_command;
   }
 
+  /* Start reading the project file now. When projects are loaded in several
+   * rooms, their files are parsed concurrently while the commands still load
+   * them one by one, in the queue order. */
+  cmd_ptr->prefetched = ladish_load_project_read(cmd_ptr);
+
   return true;
 
 fail_destroy_command:
@@ -26,11 +26,6 @@
 
 #include "common.h"
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <unistd.h>
-
 #include "escape.h"
 #include "cmd.h"
 #include "studio_internal.h"
@@ -885,83 +880,74 @@ struct ladish_command_load_studio
 {
   struct ladish_command command;
   char * studio_name;
+  char * path;
+  ladish_worker_job_handle job; /* not NULL while the studio file is being read */
+  ladish_xml_document_handle document;
 };
 
-#define cmd_ptr ((struct ladish_command_load_studio *)command_context)
+#define cmd_ptr ((struct ladish_command_load_studio *)context)
 
-static bool run(void * command_context)
+static void ladish_load_studio_read_complete(void * context, ladish_xml_document_handle document)
 {
-  char * path;
-  struct stat st;
-  XML_Parser parser;
-  int bytes_read;
-  void * buffer;
-  int fd;
-  enum XML_Status xmls;
-  struct ladish_parse_context parse_context;
+  ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
+  cmd_ptr->job = NULL;
+  cmd_ptr->document = document;
+  ladish_command_wakeup(&cmd_ptr->command);
+}
 
-  ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_PENDING);
+#undef cmd_ptr
 
-  if (!ladish_studio_compose_filename(cmd_ptr->studio_name, &path, NULL))
-  {
-    log_error("failed to compose path of studio \%s\" file", cmd_ptr->studio_name);
-    return false;
-  }
+#define cmd_ptr ((struct ladish_command_load_studio *)command_context)
 
-  log_info("Loading studio... ('%s')", path);
+static bool run(void * command_context)
+{
+  struct ladish_parse_context parse_context;
+  bool parsed;
 
-  if (stat(path, &st) != 0)
+  if (cmd_ptr->command.state == LADISH_COMMAND_STATE_PENDING)
   {
-    log_error("failed to stat '%s': %d (%s)", path, errno, strerror(errno));
-    free(path);
-    return false;
-  }
+    if (!ladish_studio_compose_filename(cmd_ptr->studio_name, &cmd_ptr->path, NULL))
+    {
+      log_error("failed to compose path of studio \%s\" file", cmd_ptr->studio_name);
+      return false;
+    }
 
-  g_studio.name = cmd_ptr->studio_name;
-  cmd_ptr->studio_name = NULL;
+    log_info("Loading studio... ('%s')", cmd_ptr->path);
 
-  g_studio.filename = path;
+    /* the file is read and parsed by a worker thread, the studio is created when it is done */
+    if (!ladish_xml_document_read_async(cmd_ptr->path, cmd_ptr, ladish_load_studio_read_complete, &cmd_ptr->job))
+    {
+      return false;
+    }
 
-  if (!jack_reset_all_params())
-  {
-    log_error("jack_reset_all_params() failed");
-    return false;
+    cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
+    ladish_command_wait(&cmd_ptr->command, 0, 0);
+    return true;
   }
 
-  fd = open(path, O_RDONLY);
-  if (fd == -1)
+  ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
+
+  if (cmd_ptr->job != NULL)
   {
-    log_error("failed to open '%s': %d (%s)", path, errno, strerror(errno));
-    return false;
+    ladish_command_wait(&cmd_ptr->command, 0, 0);
+    return true;                /* still reading */
   }
 
-  parser = XML_ParserCreate(NULL);
-  if (parser == NULL)
+  if (cmd_ptr->document == NULL)
   {
-    log_error("XML_ParserCreate() failed to create parser object.");
-    close(fd);
+    ladish_notify_simple(LADISH_NOTIFY_URGENCY_HIGH, "Studio load failed", LADISH_CHECK_LOG_TEXT);
     return false;
   }
 
-  //log_info("conf file size is %llu bytes", (unsigned long long)st.st_size);
-
-  /* we are expecting that conf file has small enough size to fit in memory */
+  g_studio.name = cmd_ptr->studio_name;
+  cmd_ptr->studio_name = NULL;
 
-  buffer = XML_GetBuffer(parser, st.st_size);
-  if (buffer == NULL)
-  {
-    log_error("XML_GetBuffer() failed.");
-    XML_ParserFree(parser);
-    close(fd);
-    return false;
-  }
+  g_studio.filename = cmd_ptr->path;
+  cmd_ptr->path = NULL;
 
-  bytes_read = read(fd, buffer, st.st_size);
-  if (bytes_read != st.st_size)
+  if (!jack_reset_all_params())
   {
-    log_error("read() returned unexpected result.");
-    XML_ParserFree(parser);
-    close(fd);
+    log_error("jack_reset_all_params() failed");
     return false;
   }
 
@@ -973,37 +959,17 @@ static bool run(void * command_context)
   parse_context.dict = NULL;
   parse_context.room = NULL;
 
-  XML_SetElementHandler(parser, callback_elstart, callback_elend);
-  XML_SetCharacterDataHandler(parser, callback_chrdata);
-  XML_SetUserData(parser, &parse_context);
-
   if (!ladish_studio_show())
   {
     log_error("ladish_studio_show() failed.");
-    XML_ParserFree(parser);
-    close(fd);
-    return false;
-  }
-
-  xmls = XML_ParseBuffer(parser, bytes_read, XML_TRUE);
-  if (xmls == XML_STATUS_ERROR)
-  {
-    if (!parse_context.error)
-    {
-      log_error("XML_ParseBuffer() failed.");
-    }
-
-    ladish_notify_simple(LADISH_NOTIFY_URGENCY_HIGH, "Studio load failed", LADISH_CHECK_LOG_TEXT);
-    ladish_studio_clear();
-    XML_ParserFree(parser);
-    close(fd);
     return false;
   }
 
-  XML_ParserFree(parser);
-  close(fd);
+  parsed = ladish_xml_document_parse(cmd_ptr->document, &parse_context, callback_elstart, callback_elend, callback_chrdata);
+  ladish_xml_document_destroy(cmd_ptr->document);
+  cmd_ptr->document = NULL;
 
-  if (parse_context.error)
+  if (!parsed || parse_context.error)
   {
     ladish_studio_clear();
     ladish_notify_simple(LADISH_NOTIFY_URGENCY_HIGH, "Studio load failed", LADISH_CHECK_LOG_TEXT);
@@ -1013,7 +979,7 @@ static bool run(void * command_context)
   ladish_interlink(ladish_studio_get_studio_graph(), ladish_studio_get_studio_app_supervisor());
 
   g_studio.persisted = true;
-  log_info("Studio loaded. ('%s')", path);
+  log_info("Studio loaded. ('%s')", g_studio.filename);
 
   ladish_graph_dump(g_studio.jack_graph);
   ladish_graph_dump(g_studio.studio_graph);
@@ -1035,6 +1001,19 @@ static bool run(void * command_context)
 static void destructor(void * command_context)
 {
   log_info("load studio command destructor");
+
+  if (cmd_ptr->job != NULL)
+  {
+    ladish_worker_abandon(cmd_ptr->job);
+  }
+
+  if (cmd_ptr->document != NULL)
+  {
+    ladish_xml_document_destroy(cmd_ptr->document);
+  }
+
+  free(cmd_ptr->path);
+
   if (cmd_ptr->studio_name != NULL)
   {
     free(cmd_ptr->studio_name);
@@ -1060,7 +1039,7 @@ bool ladish_command_load_studio(void * call_ptr, struct ladish_cqueue * queue_pt
     goto fail_free_name;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_load_studio));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_load_studio), "load_studio");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -1070,6 +1049,9 @@ bool ladish_command_load_studio(void * call_ptr, struct ladish_cqueue * queue_pt
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
   cmd_ptr->studio_name = studio_name_dup;
+  cmd_ptr->path = NULL;
+  cmd_ptr->job = NULL;
+  cmd_ptr->document = NULL;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
   {
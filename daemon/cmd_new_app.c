@@ -202,7 +202,7 @@ ladish_command_new_app(
     goto fail_free_name;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_new_app));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_new_app), "new_app");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
@@ -211,6 +211,7 @@ ladish_command_new_app(
 
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
+  ladish_command_set_lane_by_opath(&cmd_ptr->command, opath);
   cmd_ptr->opath = opath_dup;
   cmd_ptr->commandline = commandline_dup;
   cmd_ptr->name = name_dup;
@@ -91,7 +91,7 @@ bool ladish_command_new_studio(void * call_ptr, struct ladish_cqueue * queue_ptr
     goto fail_drop_unload_command;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_new_studio));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_new_studio), "new_studio");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -113,7 +113,7 @@ bool ladish_command_remove_app(void * call_ptr, struct ladish_cqueue * queue_ptr
     goto fail_drop_stop_command;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_remove_app));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_remove_app), "remove_app");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
@@ -122,6 +122,7 @@ bool ladish_command_remove_app(void * call_ptr, struct ladish_cqueue * queue_ptr
 
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
+  ladish_command_set_lane_by_opath(&cmd_ptr->command, opath);
   cmd_ptr->opath = opath_dup;
   cmd_ptr->id = id;
 
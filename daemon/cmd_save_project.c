@@ -45,6 +45,7 @@ void ladish_room_project_save_complete(void * command_context, bool success)
 {
   cmd_ptr->done = true;
   cmd_ptr->success = success;
+  ladish_command_wakeup(&cmd_ptr->command);
 
   if (!success)
   {
@@ -60,6 +61,7 @@ static bool run(void * command_context)
   {
     if (!cmd_ptr->done)
     {
+      ladish_command_wait(&cmd_ptr->command, 0, 0);
       return true;
     }
 
@@ -84,17 +86,40 @@ static bool run(void * command_context)
   cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
 
   ladish_room_save_project(room, cmd_ptr->project_dir, cmd_ptr->project_name, cmd_ptr, ladish_room_project_save_complete);
+  ladish_command_wait(&cmd_ptr->command, 0, 0);
 
   return true;
 }
 
 static void destructor(void * command_context)
 {
+  ladish_room_handle room;
+
   log_info("save project command destructor");
+
+  /* queue is cleared while the project is being saved */
+  if (cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING && !cmd_ptr->done)
+  {
+    room = ladish_studio_find_room_by_uuid(cmd_ptr->room_uuid);
+    if (room != NULL)
+    {
+      ladish_room_abandon_project_save(room);
+    }
+  }
+
   free(cmd_ptr->project_name);
   free(cmd_ptr->project_dir);
 }
 
+static bool equal(void * command_context, void * other_context)
+{
+  struct ladish_command_save_project * other_ptr = other_context;
+
+  return uuid_compare(cmd_ptr->room_uuid, other_ptr->room_uuid) == 0 &&
+    strcmp(cmd_ptr->project_dir, other_ptr->project_dir) == 0 &&
+    strcmp(cmd_ptr->project_name, other_ptr->project_name) == 0;
+}
+
 #undef cmd_ptr
 
 bool
@@ -123,7 +148,7 @@ ladish_command_save_project(
     goto fail_free_dir;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_save_project));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_save_project), "save_project");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -134,6 +159,8 @@ ladish_command_save_project(
 
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
+  cmd_ptr->command.equal = equal;
+  ladish_command_set_lane(&cmd_ptr->command, room_uuid_ptr);
   cmd_ptr->project_dir = project_dir_dup;
   cmd_ptr->project_name = project_name_dup;
   cmd_ptr->done = false;
@@ -186,8 +186,45 @@ struct ladish_command_save_studio
   char * studio_name;
   bool done;
   bool success;
+  bool renaming;                /* whether save will initiate a rename */
+  ladish_worker_job_handle job; /* not NULL while the studio file is being written */
 };
 
+#define cmd_ptr ((struct ladish_command_save_studio *)context)
+
+static void ladish_studio_xml_save_complete(void * context, bool success)
+{
+  ASSERT(cmd_ptr->command.state == LADISH_COMMAND_STATE_WAITING);
+
+  cmd_ptr->job = NULL;
+
+  if (!success)
+  {
+    ladish_notify_simple(LADISH_NOTIFY_URGENCY_HIGH, "Studio save failed", LADISH_CHECK_LOG_TEXT);
+    cmd_ptr->success = false;
+    cmd_ptr->done = true;
+    ladish_command_wakeup(&cmd_ptr->command);
+    return;
+  }
+
+  log_info("studio saved. (%s)", g_studio.filename);
+  g_studio.persisted = true;
+  g_studio.automatic = false;   /* even if it was automatic, it is not anymore because it is saved */
+
+  if (cmd_ptr->renaming)
+  {
+    free(g_studio.name);
+    g_studio.name = cmd_ptr->studio_name;
+    cmd_ptr->studio_name = NULL; /* mark that descructor does not need to free the new name buffer */
+    ladish_studio_emit_renamed(); /* uses g_studio.name */
+  }
+
+  cmd_ptr->done = true;
+  ladish_command_wakeup(&cmd_ptr->command);
+}
+
+#undef cmd_ptr
+
 static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
 {
   struct list_head * node_ptr;
@@ -199,9 +236,7 @@ static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
   char * filename;              /* filename */
   char * bak_filename;          /* filename of the backup file */
   char * old_filename;          /* filename where studio was persisted before save */
-  struct stat st;
   struct ladish_write_context save_context;
-  bool renaming;
 
   ret = false;
 
@@ -215,8 +250,7 @@ static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
     goto exit;
   }
 
-  /* whether save will initiate a rename */
-  renaming = strcmp(cmd_ptr->studio_name, g_studio.name) != 0;
+  cmd_ptr->renaming = strcmp(cmd_ptr->studio_name, g_studio.name) != 0;
 
   if (g_studio.filename == NULL)
   {
@@ -231,7 +265,7 @@ static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
     /* saving already persisted studio that was not renamed */
     old_filename = filename;
   }
-  else if (!renaming)
+  else if (!cmd_ptr->renaming)
   {
     /* saving already renamed studio */
     old_filename = g_studio.filename;
@@ -248,33 +282,14 @@ static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
   ASSERT(g_studio.filename != NULL);
   ASSERT(g_studio.filename != bak_filename);
 
-  if (bak_filename != NULL)
-  {
-    ASSERT(old_filename != NULL);
-
-    if (stat(old_filename, &st) == 0) /* if old filename does not exist, rename with fail */
-    {
-      if (rename(old_filename, bak_filename) != 0)
-      {
-        log_error("rename(%s, %s) failed: %d (%s)", old_filename, bak_filename, errno, strerror(errno));
-        goto free_filenames;
-      }
-    }
-    else
-    {
-      /* mark that there is no backup file */
-      free(bak_filename);
-      bak_filename = NULL;
-    }
-  }
-
   log_info("saving studio... (%s)", g_studio.filename);
 
-  fd = open(g_studio.filename, O_WRONLY | O_TRUNC | O_CREAT, 0666);
+  /* The xml is composed in memory. The backup rename and the file write are
+   * done by a worker thread, see ladish_studio_xml_save_complete() */
+  fd = ladish_save_buffer_create("ladish-studio");
   if (fd == -1)
   {
-    log_error("open(%s) failed: %d (%s)", g_studio.filename, errno, strerror(errno));
-    goto rename_back;
+    goto free_filenames;
   }
 
   if (!ladish_write_string(fd, "<?xml version=\"1.0\"?>\n"))
@@ -391,34 +406,13 @@ static bool ladish_save_studio_xml(struct ladish_command_save_studio * cmd_ptr)
     goto close;
   }
 
-  log_info("studio saved. (%s)", g_studio.filename);
-  g_studio.persisted = true;
-  g_studio.automatic = false;   /* even if it was automatic, it is not anymore because it is saved */
-
-  ret = true;
-
-  if (renaming)
-  {
-    free(g_studio.name);
-    g_studio.name = cmd_ptr->studio_name;
-    cmd_ptr->studio_name = NULL; /* mark that descructor does not need to free the new name buffer */
-    ladish_studio_emit_renamed(); /* uses g_studio.name */
-  }
+  /* fd is closed by ladish_save_file_async() */
+  ret = ladish_save_file_async(fd, g_studio.filename, old_filename, bak_filename, cmd_ptr, ladish_studio_xml_save_complete, &cmd_ptr->job);
+  goto free_filenames;
 
 close:
   close(fd);
 
-rename_back:
-  if (!ret && bak_filename != NULL)
-  {
-    /* save failed - try to rename the backup file back */
-    ASSERT(old_filename != NULL);
-    if (rename(bak_filename, old_filename) != 0)
-    {
-      log_error("rename(%s, %s) failed: %d (%s)", bak_filename, g_studio.filename, errno, strerror(errno));
-    }
-  }
-
 free_filenames:
   if (bak_filename != NULL)
   {
@@ -452,16 +446,14 @@ static void ladish_studio_apps_save_complete(void * context, bool success)
   log_info("Studio apps saved successfully");
   if (ladish_save_studio_xml(cmd_ptr))
   {
-    goto done;
+    return;                     /* the command is done when the studio file is written */
   }
 
 fail:
   ladish_notify_simple(LADISH_NOTIFY_URGENCY_HIGH, "Studio save failed", LADISH_CHECK_LOG_TEXT);
   cmd_ptr->success = false;
-
-done:
   cmd_ptr->done = true;
-  return;
+  ladish_command_wakeup(&cmd_ptr->command);
 }
 
 #undef cmd_ptr
@@ -474,6 +466,7 @@ static bool run(void * command_context)
   {
     if (!cmd_ptr->done)
     {
+      ladish_command_wait(&cmd_ptr->command, 0, 0);
       return true;
     }
 
@@ -499,6 +492,7 @@ static bool run(void * command_context)
   cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
 
   ladish_app_supervisor_save(g_studio.app_supervisor, cmd_ptr, ladish_studio_apps_save_complete);
+  ladish_command_wait(&cmd_ptr->command, 0, 0);
 
   return true;
 }
@@ -506,12 +500,22 @@ static bool run(void * command_context)
 static void destructor(void * command_context)
 {
   log_info("save studio command destructor");
+
+  if (cmd_ptr->job != NULL)
+  {
+    ladish_worker_abandon(cmd_ptr->job);
+  }
   if (cmd_ptr->studio_name != NULL)
   {
     free(cmd_ptr->studio_name);
   }
 }
 
+static bool equal(void * command_context, void * other_context)
+{
+  return strcmp(cmd_ptr->studio_name, ((struct ladish_command_save_studio *)other_context)->studio_name) == 0;
+}
+
 #undef cmd_ptr
 
 bool ladish_command_save_studio(void * call_ptr, struct ladish_cqueue * queue_ptr, const char * new_studio_name)
@@ -526,7 +530,7 @@ bool ladish_command_save_studio(void * call_ptr, struct ladish_cqueue * queue_pt
     goto fail;
   }
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_save_studio));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_save_studio), "save_studio");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -535,9 +539,12 @@ bool ladish_command_save_studio(void * call_ptr, struct ladish_cqueue * queue_pt
 
   cmd_ptr->command.run = run;
   cmd_ptr->command.destructor = destructor;
+  cmd_ptr->command.equal = equal;
   cmd_ptr->studio_name = studio_name_dup;
   cmd_ptr->done = false;
   cmd_ptr->success = true;
+  cmd_ptr->renaming = false;
+  cmd_ptr->job = NULL;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
   {
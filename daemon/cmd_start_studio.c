@@ -49,6 +49,7 @@ static bool run(void * context)
 {
   bool jack_server_started;
   unsigned int app_count;
+  uint64_t now;
 
   switch (cmd_ptr->command.state)
   {
@@ -102,13 +103,15 @@ static bool run(void * context)
       /* we are still waiting for the JACK server start */
       ASSERT(!ladish_environment_get(&g_studio.env_store, ladish_environment_jack_server_started)); /* someone else consumed the state change? */
 
-      if (cmd_ptr->deadline != 0 && ladish_get_current_microseconds() >= cmd_ptr->deadline)
+      now = ladish_get_current_microseconds();
+      if (cmd_ptr->deadline != 0 && now >= cmd_ptr->deadline)
       {
         log_error("Starting JACK server succeded, but 'started' signal was not received within 5 seconds.");
         cmd_ptr->command.state = LADISH_COMMAND_STATE_DONE;
         return false;
       }
 
+      ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_JACK, cmd_ptr->deadline != 0 ? cmd_ptr->deadline - now : 0);
       return true;
     }
 
@@ -128,13 +131,19 @@ static bool run(void * context)
   return false;
 }
 
+/* Starting the studio twice in a row is same as starting it once */
+static bool equal(void * UNUSED(context), void * UNUSED(other_context))
+{
+  return true;
+}
+
 #undef cmd_ptr
 
 bool ladish_command_start_studio(void * call_ptr, struct ladish_cqueue * queue_ptr)
 {
   struct ladish_command_start_studio * cmd_ptr;
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_start_studio));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_start_studio), "start_studio");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
@@ -142,6 +151,7 @@ bool ladish_command_start_studio(void * call_ptr, struct ladish_cqueue * queue_p
   }
 
   cmd_ptr->command.run = run;
+  cmd_ptr->command.equal = equal;
   cmd_ptr->deadline = 0;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
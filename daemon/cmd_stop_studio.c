@@ -37,6 +37,9 @@
 #define STOP_STATE_WAITING_FOR_CHILDS_TERMINATION       3
 #define STOP_STATE_WAITING_FOR_JACK_SERVER_STOP         4
 
+/* JACK server state is polled when stop request failed, microseconds */
+#define STOP_POLL_INTERVAL 100000
+
 struct ladish_command_stop_studio
 {
   struct ladish_command command;
@@ -93,6 +96,7 @@ static bool run(void * context)
     {
       if (!ladish_studio_iterate_rooms(NULL, room_stopped))
       {
+        ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT | LADISH_COMMAND_EVENT_GRAPH, 0);
         return true;
       }
 
@@ -105,6 +109,7 @@ static bool run(void * context)
       log_info("%u JACK clients started by ladish are visible", clients_count);
       if (clients_count != 0)
       {
+        ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_GRAPH, 0);
         return true;
       }
 
@@ -117,6 +122,7 @@ static bool run(void * context)
       log_info("%u child processes are running", clients_count);
       if (clients_count != 0)
       {
+        ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT, 0);
         return true;
       }
 
@@ -139,6 +145,7 @@ static bool run(void * context)
           cmd_ptr->deadline += 5000000;
         }
 
+        ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_JACK, STOP_POLL_INTERVAL);
         return true;
       }
     }
@@ -160,6 +167,7 @@ static bool run(void * context)
         return false;
       }
 
+      ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_JACK, STOP_POLL_INTERVAL);
       return true;
     }
 
@@ -167,6 +175,7 @@ static bool run(void * context)
     {
       /* we are still waiting for the JACK server stop */
       ASSERT(ladish_environment_get(&g_studio.env_store, ladish_environment_jack_server_started)); /* someone else consumed the state change? */
+      ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_JACK, 0);
       return true;
     }
 
@@ -189,13 +198,19 @@ static bool run(void * context)
   return false;
 }
 
+/* Stopping the studio twice in a row is same as stopping it once */
+static bool equal(void * UNUSED(context), void * UNUSED(other_context))
+{
+  return true;
+}
+
 #undef cmd_ptr
 
 bool ladish_command_stop_studio(void * call_ptr, struct ladish_cqueue * queue_ptr)
 {
   struct ladish_command_stop_studio * cmd_ptr;
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_stop_studio));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_stop_studio), "stop_studio");
   if (cmd_ptr == NULL)
   {
     cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_command_new() failed.");
@@ -203,6 +218,7 @@ bool ladish_command_stop_studio(void * call_ptr, struct ladish_cqueue * queue_pt
   }
 
   cmd_ptr->command.run = run;
+  cmd_ptr->command.equal = equal;
   cmd_ptr->deadline = 0;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
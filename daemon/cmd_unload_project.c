@@ -58,6 +58,7 @@ static bool run(void * command_context)
     else
     {
       cmd_ptr->command.state = LADISH_COMMAND_STATE_WAITING;
+      ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT | LADISH_COMMAND_EVENT_GRAPH, 0);
     }
 
     return true;
@@ -69,6 +70,10 @@ static bool run(void * command_context)
   {
     cmd_ptr->command.state = LADISH_COMMAND_STATE_DONE;
   }
+  else
+  {
+    ladish_command_wait(&cmd_ptr->command, LADISH_COMMAND_EVENT_CHILD_EXIT | LADISH_COMMAND_EVENT_GRAPH, 0);
+  }
 
   return true;
 }
@@ -83,7 +88,7 @@ ladish_command_unload_project(
 {
   struct ladish_command_unload_project * cmd_ptr;
 
-  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_unload_project));
+  cmd_ptr = ladish_command_new(sizeof(struct ladish_command_unload_project), "unload_project");
   if (cmd_ptr == NULL)
   {
     log_error("ladish_command_new() failed.");
@@ -92,6 +97,7 @@ ladish_command_unload_project(
 
   cmd_ptr->command.run = run;
   uuid_copy(cmd_ptr->room_uuid, room_uuid_ptr);
+  ladish_command_set_lane(&cmd_ptr->command, room_uuid_ptr);
   cmd_ptr->room = NULL;
 
   if (!ladish_cqueue_add_command(queue_ptr, &cmd_ptr->command))
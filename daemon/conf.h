@@ -32,11 +32,15 @@
 #define LADISH_CONF_KEY_DAEMON_TERMINAL           "/org/ladish/daemon/terminal"
 #define LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART   "/org/ladish/daemon/studio_autostart"
 #define LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY      "/org/ladish/daemon/js_save_delay"
+#define LADISH_CONF_KEY_DAEMON_LOG_FILTER         "/org/ladish/daemon/log_filter"
+#define LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE  "/org/ladish/daemon/virtualizer_trace"
 
 #define LADISH_CONF_KEY_DAEMON_NOTIFY_DEFAULT             true
 #define LADISH_CONF_KEY_DAEMON_SHELL_DEFAULT              "sh"
 #define LADISH_CONF_KEY_DAEMON_TERMINAL_DEFAULT           "xterm"
 #define LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART_DEFAULT   true
 #define LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY_DEFAULT      0
+#define LADISH_CONF_KEY_DAEMON_LOG_FILTER_DEFAULT         ""
+#define LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE_DEFAULT  false
 
 #endif /* #ifndef CONF_H__795797BE_4EB8_44F8_BD9C_B8A9CB975228__INCLUDED */
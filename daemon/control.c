@@ -34,6 +34,7 @@
 #include "../lib/wkports.h"
 #include "../proxies/conf_proxy.h"
 #include "conf.h"
+#include "meta_index.h"
 
 #define INTERFACE_NAME IFACE_CONTROL
 
@@ -544,7 +545,7 @@ fail:
 
 #define array_iter_ptr ((DBusMessageIter *)context)
 
-static bool get_studio_list_callback(void * UNUSED(call_ptr), void * context, const char * studio, uint32_t modtime)
+static bool get_studio_list_callback(void * UNUSED(call_ptr), void * context, const char * studio, const struct ladish_meta_info * info_ptr)
 {
   DBusMessageIter struct_iter;
   DBusMessageIter dict_iter;
@@ -564,7 +565,10 @@ static bool get_studio_list_callback(void * UNUSED(call_ptr), void * context, co
 /*   if (!maybe_add_dict_entry_string(&dict_iter, "Description", xxx)) */
 /*     goto close_dict; */
 
-  if (!cdbus_add_dict_entry_uint32(&dict_iter, "Modification Time", modtime))
+  if (!cdbus_add_dict_entry_uint32(&dict_iter, "Modification Time", info_ptr->modtime))
+    goto close_dict;
+
+  if (!cdbus_add_dict_entry_uint32(&dict_iter, "Applications", info_ptr->app_count))
     goto close_dict;
 
   ret = true;
@@ -890,6 +894,36 @@ static void ladish_exit(struct cdbus_method_call * call_ptr)
   cdbus_method_return_new_void(call_ptr);
 }
 
+static void ladish_get_log_filter(struct cdbus_method_call * call_ptr)
+{
+  const char * filter;
+
+  filter = ladish_log_get_filter();
+  cdbus_method_return_new_single(call_ptr, DBUS_TYPE_STRING, &filter);
+}
+
+static void ladish_set_log_filter(struct cdbus_method_call * call_ptr)
+{
+  const char * filter;
+
+  dbus_error_init(&cdbus_g_dbus_error);
+
+  if (!dbus_message_get_args(call_ptr->message, &cdbus_g_dbus_error, DBUS_TYPE_STRING, &filter, DBUS_TYPE_INVALID))
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid arguments to method \"%s\": %s",  call_ptr->method_name, cdbus_g_dbus_error.message);
+    dbus_error_free(&cdbus_g_dbus_error);
+    return;
+  }
+
+  if (!ladish_log_set_filter(filter))
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "Invalid log filter \"%s\"", filter);
+    return;
+  }
+
+  cdbus_method_return_new_void(call_ptr);
+}
+
 void emit_studio_appeared(void)
 {
   cdbus_signal_emit(cdbus_g_dbus_connection, CONTROL_OBJECT_PATH, INTERFACE_NAME, "StudioAppeared", "");
@@ -950,6 +984,14 @@ CDBUS_METHOD_ARGS_END
 CDBUS_METHOD_ARGS_BEGIN(Exit, "Tell ladish D-Bus service to exit")
 CDBUS_METHOD_ARGS_END
 
+CDBUS_METHOD_ARGS_BEGIN(GetLogFilter, "Get log filter")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("filter", "s", "Comma separated list of level, module=level and rate=lines_per_second")
+CDBUS_METHOD_ARGS_END
+
+CDBUS_METHOD_ARGS_BEGIN(SetLogFilter, "Set log filter, until the daemon exits or the configuration key changes")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("filter", "s", "Comma separated list of level, module=level and rate=lines_per_second, empty for default")
+CDBUS_METHOD_ARGS_END
+
 CDBUS_METHODS_BEGIN
   CDBUS_METHOD_DESCRIBE(IsStudioLoaded, ladish_is_studio_loaded)
   CDBUS_METHOD_DESCRIBE(GetStudioList, ladish_get_studio_list)
@@ -961,6 +1003,8 @@ CDBUS_METHODS_BEGIN
   CDBUS_METHOD_DESCRIBE(CreateRoomTemplate, ladish_create_room_template)
   CDBUS_METHOD_DESCRIBE(DeleteRoomTemplate, ladish_delete_room_template)
   CDBUS_METHOD_DESCRIBE(Exit, ladish_exit)
+  CDBUS_METHOD_DESCRIBE(GetLogFilter, ladish_get_log_filter)
+  CDBUS_METHOD_DESCRIBE(SetLogFilter, ladish_set_log_filter)
 CDBUS_METHODS_END
 
 CDBUS_SIGNAL_ARGS_BEGIN(StudioAppeared, "Studio D-Bus object appeared")
@@ -26,109 +26,276 @@
 
 #include "cmd.h"
 #include "control.h"
+#include "metrics.h"
+#include "studio.h"
+#include "room.h"
+#include "../dbus_constants.h"
+#include "../common/ladish_time.h"
 
 void ladish_cqueue_init(struct ladish_cqueue * queue_ptr)
 {
   queue_ptr->cancel = false;
+  queue_ptr->last_coalesced = false;
+  queue_ptr->count = 0;
+  queue_ptr->pass = 0;
+  queue_ptr->events = 0;
   INIT_LIST_HEAD(&queue_ptr->queue);
 }
 
-void ladish_cqueue_run(struct ladish_cqueue * queue_ptr)
+static void ladish_cqueue_remove_command(struct ladish_cqueue * queue_ptr, struct ladish_command * cmd_ptr)
 {
-  struct list_head * node_ptr;
-  struct ladish_command * cmd_ptr;
+  list_del(&cmd_ptr->siblings);
+  queue_ptr->count--;
 
-loop:
-  if (list_empty(&queue_ptr->queue))
+  if (cmd_ptr->destructor != NULL)
   {
-    return;
+    cmd_ptr->destructor(cmd_ptr->context);
   }
 
-  node_ptr = queue_ptr->queue.next;
-  cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+  free(cmd_ptr);
+}
 
-  ASSERT(cmd_ptr->run != NULL);
-  ASSERT(cmd_ptr->state == LADISH_COMMAND_STATE_PENDING || cmd_ptr->state == LADISH_COMMAND_STATE_WAITING);
+static bool ladish_command_same_lane(struct ladish_command * cmd1_ptr, struct ladish_command * cmd2_ptr)
+{
+  return !cmd1_ptr->barrier && !cmd2_ptr->barrier && uuid_compare(cmd1_ptr->lane, cmd2_ptr->lane) == 0;
+}
+
+/* whether a command queued before the supplied one is still in its lane */
+static bool ladish_cqueue_lane_busy(struct ladish_cqueue * queue_ptr, struct ladish_command * cmd_ptr)
+{
+  struct list_head * node_ptr;
 
-  if (cmd_ptr->state == LADISH_COMMAND_STATE_PENDING)
-  { /* if this is a new command, put a separator so its impact is clearly visible in the log */
-    log_info("-------");
+  for (node_ptr = queue_ptr->queue.next; node_ptr != &cmd_ptr->siblings; node_ptr = node_ptr->next)
+  {
+    if (ladish_command_same_lane(list_entry(node_ptr, struct ladish_command, siblings), cmd_ptr))
+    {
+      return true;
+    }
   }
 
-  if (!cmd_ptr->run(cmd_ptr->context))
+  return false;
+}
+
+/* A failed barrier halts the whole queue, a failed lane command halts its lane */
+static void ladish_cqueue_halt(struct ladish_cqueue * queue_ptr, struct ladish_command * failed_cmd_ptr)
+{
+  struct list_head * node_ptr;
+  struct list_head * next_ptr;
+  struct ladish_command * cmd_ptr;
+
+  if (failed_cmd_ptr->barrier)
   {
     ladish_cqueue_clear(queue_ptr);
-    emit_queue_execution_halted();
     return;
   }
 
-  switch (cmd_ptr->state)
+  log_error("halting the command lane of '%s'", failed_cmd_ptr->name);
+
+  list_for_each_safe(node_ptr, next_ptr, &queue_ptr->queue)
   {
-  case LADISH_COMMAND_STATE_DONE:
-    break;
-  case LADISH_COMMAND_STATE_WAITING:
-    return;
-  default:
-    log_error("unexpected cmd state %u after run()", cmd_ptr->state);
-    ASSERT_NO_PASS;
-    ladish_cqueue_clear(queue_ptr);
-    emit_queue_execution_halted();
-    return;
+    cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+    if (cmd_ptr != failed_cmd_ptr && ladish_command_same_lane(cmd_ptr, failed_cmd_ptr))
+    {
+      ladish_cqueue_remove_command(queue_ptr, cmd_ptr);
+    }
   }
 
-  list_del(node_ptr);
+  ladish_cqueue_remove_command(queue_ptr, failed_cmd_ptr);
+}
+
+/* whether a waiting command has anything new to check */
+static bool ladish_command_runnable(struct ladish_command * cmd_ptr, unsigned int events, uint64_t now)
+{
+  if (cmd_ptr->state != LADISH_COMMAND_STATE_WAITING || !cmd_ptr->wait_registered || cmd_ptr->woken)
+  {
+    return true;
+  }
 
-  if (cmd_ptr->destructor != NULL)
+  if ((cmd_ptr->wait_events & events) != 0)
   {
-    cmd_ptr->destructor(cmd_ptr->context);
+    return true;
   }
 
-  free(cmd_ptr);
+  return cmd_ptr->wakeup_time != 0 && now >= cmd_ptr->wakeup_time;
+}
 
-  if (queue_ptr->cancel && list_empty(&queue_ptr->queue))
+void ladish_cqueue_run(struct ladish_cqueue * queue_ptr)
+{
+  struct list_head * node_ptr;
+  struct ladish_command * cmd_ptr;
+  unsigned int events;
+  uint64_t now;
+
+  if (list_empty(&queue_ptr->queue))
   {
-    queue_ptr->cancel = false;
+    queue_ptr->events = 0;
+    return;
   }
 
-  goto loop;
+  queue_ptr->pass++;
+  events = queue_ptr->events;
+  queue_ptr->events = 0;
+  now = ladish_get_current_microseconds();
+
+loop:
+  for (node_ptr = queue_ptr->queue.next; node_ptr != &queue_ptr->queue; node_ptr = node_ptr->next)
+  {
+    cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+
+    if (cmd_ptr->barrier && node_ptr != queue_ptr->queue.next)
+    { /* wait for the commands queued before the barrier */
+      return;
+    }
+
+    if (cmd_ptr->pass == queue_ptr->pass || ladish_cqueue_lane_busy(queue_ptr, cmd_ptr))
+    { /* already waiting in this pass or its lane is busy */
+      continue;
+    }
+
+    if (!ladish_command_runnable(cmd_ptr, events, now))
+    { /* nothing happened that the command waits for */
+      if (cmd_ptr->barrier)
+      {
+        return;
+      }
+      continue;
+    }
+
+    ASSERT(cmd_ptr->run != NULL);
+    ASSERT(cmd_ptr->state == LADISH_COMMAND_STATE_PENDING || cmd_ptr->state == LADISH_COMMAND_STATE_WAITING);
+
+    if (cmd_ptr->state == LADISH_COMMAND_STATE_PENDING)
+    { /* if this is a new command, put a separator so its impact is clearly visible in the log */
+      log_info("-------");
+      ladish_metrics_command_started(cmd_ptr->name, ladish_metrics_elapsed(cmd_ptr->queued_time));
+    }
+
+    cmd_ptr->pass = queue_ptr->pass;
+    cmd_ptr->wait_registered = false;
+    cmd_ptr->woken = false;
+    cmd_ptr->wait_events = 0;
+    cmd_ptr->wakeup_time = 0;
+
+    if (!cmd_ptr->run(cmd_ptr->context))
+    {
+      ladish_metrics_command_done(cmd_ptr->name, ladish_metrics_elapsed(cmd_ptr->queued_time), false);
+      ladish_cqueue_halt(queue_ptr, cmd_ptr);
+      emit_queue_execution_halted();
+      queue_ptr->events |= events; /* commands in other lanes did not see them yet */
+      return;
+    }
+
+    switch (cmd_ptr->state)
+    {
+    case LADISH_COMMAND_STATE_DONE:
+      break;
+    case LADISH_COMMAND_STATE_WAITING:
+      if (cmd_ptr->barrier)
+      {
+        return;
+      }
+      continue;
+    default:
+      log_error("unexpected cmd state %u after run()", cmd_ptr->state);
+      ASSERT_NO_PASS;
+      ladish_cqueue_clear(queue_ptr);
+      emit_queue_execution_halted();
+      return;
+    }
+
+    ladish_metrics_command_done(cmd_ptr->name, ladish_metrics_elapsed(cmd_ptr->queued_time), true);
+
+    ladish_cqueue_remove_command(queue_ptr, cmd_ptr);
+
+    if (queue_ptr->cancel && list_empty(&queue_ptr->queue))
+    {
+      queue_ptr->cancel = false;
+    }
+
+    /* run() may have queued new commands, start over, waiting commands are skipped by pass */
+    goto loop;
+  }
 }
 
 void ladish_cqueue_cancel(struct ladish_cqueue * queue_ptr)
 {
   struct list_head * node_ptr;
+  struct list_head * next_ptr;
   struct ladish_command * cmd_ptr;
+  bool waiting;
 
   if (list_empty(&queue_ptr->queue))
   { /* nothing to cancel */
     return;
   }
 
-  node_ptr = queue_ptr->queue.next; /* current command */
-  cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
-  if (cmd_ptr->state != LADISH_COMMAND_STATE_WAITING)
+  /* clear all commands except currently waiting ones */
+  waiting = false;
+  list_for_each_safe(node_ptr, next_ptr, &queue_ptr->queue)
   {
-    ladish_cqueue_clear(queue_ptr);
-    return;
+    cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+    if (cmd_ptr->state == LADISH_COMMAND_STATE_WAITING)
+    {
+      cmd_ptr->cancel = true;
+      cmd_ptr->woken = true;
+      waiting = true;
+    }
+    else
+    {
+      ladish_cqueue_remove_command(queue_ptr, cmd_ptr);
+    }
   }
 
-  /* clear all commands except currently waiting one */
-  while (queue_ptr->queue.next != queue_ptr->queue.prev)
-  {
-    node_ptr = queue_ptr->queue.prev;
-    list_del(node_ptr);
+  queue_ptr->cancel = waiting;
+}
 
-    cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+/* the last command queued in the lane of the supplied one, barriers end lanes */
+static struct ladish_command * ladish_cqueue_lane_tail(struct ladish_cqueue * queue_ptr, struct ladish_command * cmd_ptr)
+{
+  struct list_head * node_ptr;
+  struct ladish_command * tail_ptr;
 
-    if (cmd_ptr->destructor != NULL)
+  for (node_ptr = queue_ptr->queue.prev; node_ptr != &queue_ptr->queue; node_ptr = node_ptr->prev)
+  {
+    tail_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+    if (cmd_ptr->barrier || tail_ptr->barrier || ladish_command_same_lane(tail_ptr, cmd_ptr))
     {
-      cmd_ptr->destructor(cmd_ptr->context);
+      return tail_ptr;
     }
+  }
+
+  return NULL;
+}
+
+static bool ladish_cqueue_coalesce(struct ladish_cqueue * queue_ptr, struct ladish_command * cmd_ptr)
+{
+  struct ladish_command * tail_ptr;
+
+  if (cmd_ptr->equal == NULL)
+  {
+    return false;
+  }
+
+  tail_ptr = ladish_cqueue_lane_tail(queue_ptr, cmd_ptr);
+  if (tail_ptr == NULL ||
+      tail_ptr->state != LADISH_COMMAND_STATE_PENDING ||
+      tail_ptr->run != cmd_ptr->run ||
+      tail_ptr->barrier != cmd_ptr->barrier ||
+      !cmd_ptr->equal(cmd_ptr->context, tail_ptr->context))
+  {
+    return false;
+  }
 
-    free(cmd_ptr);
+  log_info("'%s' command coalesced with the queued one", cmd_ptr->name);
+  ladish_metrics_command_coalesced(cmd_ptr->name);
+
+  if (cmd_ptr->destructor != NULL)
+  {
+    cmd_ptr->destructor(cmd_ptr->context);
   }
 
-  queue_ptr->cancel = true;
-  cmd_ptr->cancel = true;
+  free(cmd_ptr);
+  return true;
 }
 
 bool ladish_cqueue_add_command(struct ladish_cqueue * queue_ptr, struct ladish_command * cmd_ptr)
@@ -141,30 +308,27 @@ bool ladish_cqueue_add_command(struct ladish_cqueue * queue_ptr, struct ladish_c
   }
 
   ASSERT(cmd_ptr->state == LADISH_COMMAND_STATE_PREPARE);
+
+  /* on success the command is owned by the queue, even when coalesced */
+  queue_ptr->last_coalesced = ladish_cqueue_coalesce(queue_ptr, cmd_ptr);
+  if (queue_ptr->last_coalesced)
+  {
+    return true;
+  }
+
   cmd_ptr->state = LADISH_COMMAND_STATE_PENDING;
+  cmd_ptr->queued_time = ladish_get_current_microseconds();
 
   list_add_tail(&cmd_ptr->siblings, &queue_ptr->queue);
+  queue_ptr->count++;
   return true;
 }
 
 void ladish_cqueue_clear(struct ladish_cqueue * queue_ptr)
 {
-  struct list_head * node_ptr;
-  struct ladish_command * cmd_ptr;
-
   while (!list_empty(&queue_ptr->queue))
   {
-    node_ptr = queue_ptr->queue.next;
-    list_del(node_ptr);
-
-    cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
-
-    if (cmd_ptr->destructor != NULL)
-    {
-      cmd_ptr->destructor(cmd_ptr->context);
-    }
-
-    free(cmd_ptr);
+    ladish_cqueue_remove_command(queue_ptr, list_entry(queue_ptr->queue.next, struct ladish_command, siblings));
   }
 
   queue_ptr->cancel = false;
@@ -172,15 +336,18 @@ void ladish_cqueue_clear(struct ladish_cqueue * queue_ptr)
 
 void ladish_cqueue_drop_command(struct ladish_cqueue * queue_ptr)
 {
-  struct list_head * node_ptr;
   struct ladish_command * cmd_ptr;
 
+  if (queue_ptr->last_coalesced)
+  { /* the equal command queued before stays */
+    queue_ptr->last_coalesced = false;
+    return;
+  }
+
   ASSERT(!list_empty(&queue_ptr->queue)); /* there is nothing to drop */
 
   /* remove the last command from the queue */
-  node_ptr = queue_ptr->queue.prev;
-  list_del(node_ptr);
-  cmd_ptr = list_entry(node_ptr, struct ladish_command, siblings);
+  cmd_ptr = list_entry(queue_ptr->queue.prev, struct ladish_command, siblings);
 
   ASSERT(cmd_ptr->run != NULL);
 
@@ -188,15 +355,31 @@ void ladish_cqueue_drop_command(struct ladish_cqueue * queue_ptr)
   /* commands that are not yet prepared and those that are already processed are not supposed to be in the queue */
   ASSERT(cmd_ptr->state == LADISH_COMMAND_STATE_PENDING);
 
-  if (cmd_ptr->destructor != NULL)
+  ladish_cqueue_remove_command(queue_ptr, cmd_ptr);
+}
+
+unsigned int ladish_cqueue_get_count(struct ladish_cqueue * queue_ptr, unsigned int * waiting_count_ptr)
+{
+  struct list_head * node_ptr;
+
+  *waiting_count_ptr = 0;
+  list_for_each(node_ptr, &queue_ptr->queue)
   {
-    cmd_ptr->destructor(cmd_ptr->context);
+    if (list_entry(node_ptr, struct ladish_command, siblings)->state == LADISH_COMMAND_STATE_WAITING)
+    {
+      (*waiting_count_ptr)++;
+    }
   }
 
-  free(cmd_ptr);
+  return queue_ptr->count;
 }
 
-void * ladish_command_new(size_t size)
+void ladish_cqueue_notify(struct ladish_cqueue * queue_ptr, unsigned int events)
+{
+  queue_ptr->events |= events;
+}
+
+void * ladish_command_new(size_t size, const char * name)
 {
   struct ladish_command * cmd_ptr;
 
@@ -211,10 +394,91 @@ void * ladish_command_new(size_t size)
 
   cmd_ptr->state = LADISH_COMMAND_STATE_PREPARE;
   cmd_ptr->cancel = false;
+  cmd_ptr->name = name;
+  cmd_ptr->queued_time = 0;
+
+  cmd_ptr->barrier = true;
+  uuid_clear(cmd_ptr->lane);
+  cmd_ptr->pass = 0;
+
+  cmd_ptr->wait_registered = false;
+  cmd_ptr->woken = false;
+  cmd_ptr->wait_events = 0;
+  cmd_ptr->wakeup_time = 0;
 
   cmd_ptr->context = cmd_ptr;
   cmd_ptr->run = NULL;
   cmd_ptr->destructor = NULL;
+  cmd_ptr->equal = NULL;
 
   return cmd_ptr;
 }
+
+void ladish_command_set_lane(struct ladish_command * cmd_ptr, const uuid_t room_uuid)
+{
+  cmd_ptr->barrier = false;
+  uuid_copy(cmd_ptr->lane, room_uuid);
+}
+
+struct ladish_command_lane_context
+{
+  const char * opath;
+  ladish_room_handle room;
+};
+
+#define lane_context_ptr ((struct ladish_command_lane_context *)context)
+
+static bool ladish_command_match_room_opath(void * context, ladish_room_handle room)
+{
+  if (strcmp(ladish_room_get_opath(room), lane_context_ptr->opath) == 0)
+  {
+    lane_context_ptr->room = room;
+    return false;               /* stop iteration */
+  }
+
+  return true;
+}
+
+#undef lane_context_ptr
+
+/* the lane of the studio or the room app supervisor, commands for unknown objects stay barriers */
+void ladish_command_set_lane_by_opath(struct ladish_command * cmd_ptr, const char * opath)
+{
+  struct ladish_command_lane_context context;
+  uuid_t room_uuid;
+
+  if (strcmp(opath, STUDIO_OBJECT_PATH) == 0)
+  {
+    uuid_clear(room_uuid);
+    ladish_command_set_lane(cmd_ptr, room_uuid);
+    return;
+  }
+
+  context.opath = opath;
+  context.room = NULL;
+  ladish_studio_iterate_rooms(&context, ladish_command_match_room_opath);
+  if (context.room != NULL)
+  {
+    ladish_room_get_uuid(context.room, room_uuid);
+    ladish_command_set_lane(cmd_ptr, room_uuid);
+  }
+}
+
+void ladish_command_wait(struct ladish_command * cmd_ptr, unsigned int events, uint64_t timeout)
+{
+  ASSERT(cmd_ptr->state == LADISH_COMMAND_STATE_WAITING);
+
+  cmd_ptr->wait_registered = true;
+  cmd_ptr->wait_events = events;
+  cmd_ptr->wakeup_time = 0;
+
+  if (timeout != 0)
+  {
+    cmd_ptr->wakeup_time = ladish_get_current_microseconds() + timeout;
+  }
+}
+
+void ladish_command_wakeup(struct ladish_command * cmd_ptr)
+{
+  cmd_ptr->woken = true;
+}
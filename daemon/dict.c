@@ -25,6 +25,7 @@
  */
 
 #include "dict.h"
+#include "slab.h"
 
 struct ladish_dict_entry
 {
@@ -38,14 +39,17 @@ struct ladish_dict
   struct list_head entries;
 };
 
+static struct ladish_slab g_dict_slab = LADISH_SLAB_INITIALIZER("dict", struct ladish_dict);
+static struct ladish_slab g_dict_entry_slab = LADISH_SLAB_INITIALIZER("dict entry", struct ladish_dict_entry);
+
 bool ladish_dict_create(ladish_dict_handle * dict_handle_ptr)
 {
   struct ladish_dict * dict_ptr;
 
-  dict_ptr = malloc(sizeof(struct ladish_dict));
+  dict_ptr = ladish_slab_alloc(&g_dict_slab);
   if (dict_ptr == NULL)
   {
-    log_error("malloc() failed to allocate struct ladish_dict");
+    log_error("ladish_slab_alloc() failed to allocate struct ladish_dict");
     return false;
   }
 
@@ -78,7 +82,7 @@ static void ladish_dict_drop_entry(struct ladish_dict_entry * entry_ptr)
   list_del(&entry_ptr->siblings);
   free(entry_ptr->key);
   free(entry_ptr->value);
-  free(entry_ptr);
+  ladish_slab_free(&g_dict_entry_slab, entry_ptr);
 }
 
 #define dict_ptr ((struct ladish_dict *)dict_handle)
@@ -86,7 +90,7 @@ static void ladish_dict_drop_entry(struct ladish_dict_entry * entry_ptr)
 void ladish_dict_destroy(ladish_dict_handle dict_handle)
 {
   ladish_dict_clear(dict_handle);
-  free(dict_ptr);
+  ladish_slab_free(&g_dict_slab, dict_ptr);
 }
 
 bool ladish_dict_set(ladish_dict_handle dict_handle, const char * key, const char * value)
@@ -109,10 +113,10 @@ bool ladish_dict_set(ladish_dict_handle dict_handle, const char * key, const cha
     return true;
   }
 
-  entry_ptr = malloc(sizeof(struct ladish_dict_entry));
+  entry_ptr = ladish_slab_alloc(&g_dict_entry_slab);
   if (entry_ptr == NULL)
   {
-    log_error("malloc() failed to allocate struct ladish_dict_entry");
+    log_error("ladish_slab_alloc() failed to allocate struct ladish_dict_entry");
     return false;
   }
 
@@ -120,7 +124,7 @@ bool ladish_dict_set(ladish_dict_handle dict_handle, const char * key, const cha
   if (entry_ptr->key == NULL)
   {
     log_error("strdup() failed to duplicate dict key");
-    free(entry_ptr);
+    ladish_slab_free(&g_dict_entry_slab, entry_ptr);
     return false;
   }
 
@@ -129,7 +133,7 @@ bool ladish_dict_set(ladish_dict_handle dict_handle, const char * key, const cha
   {
     log_error("strdup() failed to duplicate dict value");
     free(entry_ptr->key);
-    free(entry_ptr);
+    ladish_slab_free(&g_dict_entry_slab, entry_ptr);
     return false;
   }
 
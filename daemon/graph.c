@@ -29,13 +29,16 @@
 #include "graph.h"
 #include "../dbus_constants.h"
 #include "virtualizer.h"
+#include "slab.h"
+#include "intern.h"
+#include "../common/ladish_time.h"
 
 struct ladish_graph_port
 {
   struct list_head siblings_client;
   struct list_head siblings_graph;
   struct ladish_graph_client * client_ptr;
-  char * name;
+  const char * name;            /* interned */
   uint32_t type;
   uint32_t flags;
   uint64_t id;
@@ -43,12 +46,13 @@ struct ladish_graph_port
   bool hidden;
   bool link;
   uuid_t link_uuid_override;
+  struct list_head connections[2]; /* connections where this port is port1 and port2 respectively */
 };
 
 struct ladish_graph_client
 {
   struct list_head siblings;
-  char * name;
+  const char * name;            /* interned */
   uint64_t id;
   ladish_client_handle client;
   struct list_head ports;
@@ -58,6 +62,8 @@ struct ladish_graph_client
 struct ladish_graph_connection
 {
   struct list_head siblings;
+  struct list_head siblings_port[2];    /* in port1_ptr->connections[0] and port2_ptr->connections[1] */
+  struct list_head siblings_pending;    /* in ladish_graph::pending_connections, empty when not queued */
   uint64_t id;
   bool hidden;
   struct ladish_graph_port * port1_ptr;
@@ -73,7 +79,11 @@ struct ladish_graph
   struct list_head clients;
   struct list_head ports;
   struct list_head connections;
+  struct list_head pending_connections; /* hidden connections to connect at end of event burst */
+  struct list_head siblings_pending;    /* in g_pending_graphs, empty when not queued */
+  struct list_head siblings;            /* in g_graphs */
   uint64_t graph_version;
+  uint64_t signals_emitted;
   uint64_t next_client_id;
   uint64_t next_port_id;
   uint64_t next_connection_id;
@@ -82,12 +92,33 @@ struct ladish_graph
   void * context;
   ladish_graph_connect_request_handler connect_handler;
   ladish_graph_disconnect_request_handler disconnect_handler;
+  ladish_graph_flush_requests_handler flush_handler;
 };
 
+#define port_connection_entry(node_ptr, index)                                                  \
+  ((index) == 0 ?                                                                               \
+   list_entry(node_ptr, struct ladish_graph_connection, siblings_port[0]) :                     \
+   list_entry(node_ptr, struct ladish_graph_connection, siblings_port[1]))
+
+/* graphs with pending_connections, flushed by ladish_graph_run() */
+static LIST_HEAD(g_pending_graphs);
+
+/* when the first connection was queued, a burst that lasts longer than the max delay is not waited for */
+static uint64_t g_pending_since;
+#define LADISH_GRAPH_MAX_CONNECT_DELAY_USEC 100000
+
+/* all graphs, for the metrics interface */
+static LIST_HEAD(g_graphs);
+
+static struct ladish_slab g_client_slab = LADISH_SLAB_INITIALIZER("graph client", struct ladish_graph_client);
+static struct ladish_slab g_port_slab = LADISH_SLAB_INITIALIZER("graph port", struct ladish_graph_port);
+static struct ladish_slab g_connection_slab = LADISH_SLAB_INITIALIZER("graph connection", struct ladish_graph_connection);
+
 static void ladish_graph_emit_ports_disconnected(struct ladish_graph * graph_ptr, struct ladish_graph_connection * connection_ptr)
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -110,6 +141,7 @@ static void ladish_graph_emit_ports_connected(struct ladish_graph * graph_ptr, s
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -132,6 +164,7 @@ static void ladish_graph_emit_client_appeared(struct ladish_graph * graph_ptr, s
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -147,6 +180,7 @@ static void ladish_graph_emit_client_disappeared(struct ladish_graph * graph_ptr
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -162,6 +196,7 @@ static void ladish_graph_emit_port_appeared(struct ladish_graph * graph_ptr, str
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -181,6 +216,7 @@ static void ladish_graph_emit_port_disappeared(struct ladish_graph * graph_ptr,
 {
   ASSERT(graph_ptr->opath != NULL);
 
+  graph_ptr->signals_emitted++;
   cdbus_signal_emit(
     cdbus_g_dbus_connection,
     graph_ptr->opath,
@@ -224,28 +260,39 @@ ladish_graph_find_connection_ports_by_name_internal(
    *
    * all these conditions have to be met for a port pair to match
    */
+
+  /* names that are not interned are not used by any client or port */
+  client1_name = ladish_intern_find(client1_name);
+  port1_name = ladish_intern_find(port1_name);
+  client2_name = ladish_intern_find(client2_name);
+  port2_name = ladish_intern_find(port2_name);
+  if (client1_name == NULL || port1_name == NULL || client2_name == NULL || port2_name == NULL)
+  {
+    return false;
+  }
+
   list_for_each(client1_node_ptr, &graph_ptr->clients)
   {
     client1_ptr = list_entry(client1_node_ptr, struct ladish_graph_client, siblings);
-    if (strcmp(client1_ptr->name, client1_name) == 0)
+    if (client1_ptr->name == client1_name)
     {
       list_for_each(port1_node_ptr, &client1_ptr->ports)
       {
         port1_ptr = list_entry(port1_node_ptr, struct ladish_graph_port, siblings_client);
         if (JACKDBUS_PORT_IS_OUTPUT(port1_ptr->flags) &&
-            strcmp(port1_ptr->name, port1_name) == 0)
+            port1_ptr->name == port1_name)
         {
           list_for_each(client2_node_ptr, &graph_ptr->clients)
           {
             client2_ptr = list_entry(client2_node_ptr, struct ladish_graph_client, siblings);
-            if (strcmp(client2_ptr->name, client2_name) == 0)
+            if (client2_ptr->name == client2_name)
             {
               list_for_each(port2_node_ptr, &client2_ptr->ports)
               {
                 port2_ptr = list_entry(port2_node_ptr, struct ladish_graph_port, siblings_client);
                 if (port2_ptr->type == port1_ptr->type &&
                     JACKDBUS_PORT_IS_INPUT(port2_ptr->flags) &&
-                    strcmp(port2_ptr->name, port2_name) == 0)
+                    port2_ptr->name == port2_name)
                 {
                   *port1_ptr_ptr = port1_ptr;
                   *port2_ptr_ptr = port2_ptr;
@@ -411,14 +458,17 @@ ladish_graph_find_connection_by_ports(
 {
   struct list_head * node_ptr;
   struct ladish_graph_connection * connection_ptr;
+  unsigned int i;
 
-  list_for_each(node_ptr, &graph_ptr->connections)
+  for (i = 0; i < 2; i++)
   {
-    connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-    if ((connection_ptr->port1_ptr == port1_ptr && connection_ptr->port2_ptr == port2_ptr) ||
-        (connection_ptr->port1_ptr == port2_ptr && connection_ptr->port2_ptr == port1_ptr))
+    list_for_each(node_ptr, &port1_ptr->connections[i])
     {
-      return connection_ptr;
+      connection_ptr = port_connection_entry(node_ptr, i);
+      if (connection_ptr->port1_ptr == port2_ptr || connection_ptr->port2_ptr == port2_ptr)
+      {
+        return connection_ptr;
+      }
     }
   }
 
@@ -747,7 +797,7 @@ static void connect_ports_by_name(struct cdbus_method_call * call_ptr)
     return;
   }
 
-  if (graph_ptr->connect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, port1->port, port2->port))
+  if (graph_ptr->connect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, port1->port, port2->port, false))
   {
     cdbus_method_return_new_void(call_ptr);
   }
@@ -795,7 +845,7 @@ static void connect_ports_by_id(struct cdbus_method_call * call_ptr)
 
   log_info("connecting '%s':'%s' to '%s':'%s'", port1_ptr->client_ptr->name, port1_ptr->name, port2_ptr->client_ptr->name, port2_ptr->name);
 
-  if (graph_ptr->connect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, port1_ptr->port, port2_ptr->port))
+  if (graph_ptr->connect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, port1_ptr->port, port2_ptr->port, false))
   {
     cdbus_method_return_new_void(call_ptr);
   }
@@ -815,7 +865,7 @@ static void disconnect_ports(struct cdbus_method_call * call_ptr, struct ladish_
     connection_ptr->port2_ptr->name);
 
   connection_ptr->changing = true;
-  if (graph_ptr->disconnect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, connection_ptr->id))
+  if (graph_ptr->disconnect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, connection_ptr->id, false))
   {
     cdbus_method_return_new_void(call_ptr);
   }
@@ -987,8 +1037,11 @@ bool ladish_graph_create(ladish_graph_handle * graph_handle_ptr, const char * op
   INIT_LIST_HEAD(&graph_ptr->clients);
   INIT_LIST_HEAD(&graph_ptr->ports);
   INIT_LIST_HEAD(&graph_ptr->connections);
+  INIT_LIST_HEAD(&graph_ptr->pending_connections);
+  INIT_LIST_HEAD(&graph_ptr->siblings_pending);
 
   graph_ptr->graph_version = 1;
+  graph_ptr->signals_emitted = 0;
   graph_ptr->next_client_id = 1;
   graph_ptr->next_port_id = 1;
   graph_ptr->next_connection_id = 1;
@@ -996,9 +1049,12 @@ bool ladish_graph_create(ladish_graph_handle * graph_handle_ptr, const char * op
   graph_ptr->context = NULL;
   graph_ptr->connect_handler = NULL;
   graph_ptr->disconnect_handler = NULL;
+  graph_ptr->flush_handler = NULL;
 
   graph_ptr->persist = true;
 
+  list_add_tail(&graph_ptr->siblings, &g_graphs);
+
   *graph_handle_ptr = (ladish_graph_handle)graph_ptr;
   return true;
 }
@@ -1133,6 +1189,160 @@ static void ladish_graph_hide_connection_internal(struct ladish_graph * graph_pt
   }
 }
 
+/* connect request is issued by ladish_graph_run(), once the current burst of events is processed */
+static void ladish_graph_queue_hidden_connections(struct ladish_graph * graph_ptr, struct ladish_graph_port * port_ptr)
+{
+  struct list_head * node_ptr;
+  struct ladish_graph_connection * connection_ptr;
+  unsigned int i;
+
+  if (graph_ptr->connect_handler == NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < 2; i++)
+  {
+    list_for_each(node_ptr, &port_ptr->connections[i])
+    {
+      connection_ptr = port_connection_entry(node_ptr, i);
+      if (connection_ptr->hidden &&
+          !connection_ptr->changing &&
+          !connection_ptr->port1_ptr->hidden &&
+          !connection_ptr->port2_ptr->hidden &&
+          list_empty(&connection_ptr->siblings_pending))
+      {
+        list_add_tail(&connection_ptr->siblings_pending, &graph_ptr->pending_connections);
+      }
+    }
+  }
+
+  if (!list_empty(&graph_ptr->pending_connections) && list_empty(&graph_ptr->siblings_pending))
+  {
+    if (list_empty(&g_pending_graphs))
+    {
+      g_pending_since = ladish_get_current_microseconds();
+    }
+
+    list_add_tail(&graph_ptr->siblings_pending, &g_pending_graphs);
+  }
+}
+
+static void ladish_graph_drop_pending_connections(struct ladish_graph * graph_ptr)
+{
+  while (!list_empty(&graph_ptr->pending_connections))
+  {
+    list_del_init(graph_ptr->pending_connections.next);
+  }
+
+  list_del_init(&graph_ptr->siblings_pending);
+}
+
+static void ladish_graph_connect_hidden_connection(struct ladish_graph * graph_ptr, struct ladish_graph_connection * connection_ptr)
+{
+  if (!connection_ptr->hidden ||
+      connection_ptr->changing ||
+      connection_ptr->port1_ptr->hidden ||
+      connection_ptr->port2_ptr->hidden)
+  {
+    return;
+  }
+
+  log_info(
+    "auto connecting '%s':'%s' to '%s':'%s'",
+    connection_ptr->port1_ptr->client_ptr->name,
+    connection_ptr->port1_ptr->name,
+    connection_ptr->port2_ptr->client_ptr->name,
+    connection_ptr->port2_ptr->name);
+
+  connection_ptr->changing = true;
+  if (!graph_ptr->connect_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr, connection_ptr->port1_ptr->port, connection_ptr->port2_ptr->port, true))
+  {
+    connection_ptr->changing = false;
+    log_error("auto connect failed.");
+  }
+}
+
+void
+ladish_graph_iterate_metrics(
+  void * context,
+  void (* callback)(void * context, const struct ladish_graph_metrics * metrics_ptr))
+{
+  struct list_head * graph_node_ptr;
+  struct list_head * node_ptr;
+  struct ladish_graph * graph_ptr;
+  struct ladish_graph_metrics metrics;
+
+  list_for_each(graph_node_ptr, &g_graphs)
+  {
+    graph_ptr = list_entry(graph_node_ptr, struct ladish_graph, siblings);
+
+    metrics.opath = graph_ptr->opath;
+    metrics.signals_emitted = graph_ptr->signals_emitted;
+    metrics.clients = 0;
+    metrics.ports = 0;
+    metrics.connections = 0;
+
+    list_for_each(node_ptr, &graph_ptr->clients)
+    {
+      metrics.clients++;
+    }
+
+    list_for_each(node_ptr, &graph_ptr->ports)
+    {
+      metrics.ports++;
+    }
+
+    list_for_each(node_ptr, &graph_ptr->connections)
+    {
+      metrics.connections++;
+    }
+
+    callback(context, &metrics);
+  }
+}
+
+void ladish_graph_run(void)
+{
+  struct ladish_graph * graph_ptr;
+  struct ladish_graph_connection * connection_ptr;
+
+  if (list_empty(&g_pending_graphs))
+  {
+    return;
+  }
+
+  /* the burst is over when there are no more incoming messages to dispatch,
+     but a continuous stream of messages must not delay the connects forever */
+  if (dbus_connection_get_dispatch_status(cdbus_g_dbus_connection) == DBUS_DISPATCH_DATA_REMAINS &&
+      ladish_get_current_microseconds() - g_pending_since < LADISH_GRAPH_MAX_CONNECT_DELAY_USEC)
+  {
+    return;
+  }
+
+  /* connect handler may queue more connections, even for graph that is being flushed */
+  while (!list_empty(&g_pending_graphs))
+  {
+    graph_ptr = list_entry(g_pending_graphs.next, struct ladish_graph, siblings_pending);
+    list_del_init(&graph_ptr->siblings_pending);
+
+    /* pending connections are dropped when the handlers are cleared */
+    ASSERT(graph_ptr->connect_handler != NULL);
+
+    while (!list_empty(&graph_ptr->pending_connections))
+    {
+      connection_ptr = list_entry(graph_ptr->pending_connections.next, struct ladish_graph_connection, siblings_pending);
+      list_del_init(&connection_ptr->siblings_pending);
+      ladish_graph_connect_hidden_connection(graph_ptr, connection_ptr);
+    }
+
+    if (graph_ptr->flush_handler != NULL)
+    {
+      graph_ptr->flush_handler(graph_ptr->context, (ladish_graph_handle)graph_ptr);
+    }
+  }
+}
+
 static void ladish_graph_show_port_internal(struct ladish_graph * graph_ptr, struct ladish_graph_port * port_ptr)
 {
   if (port_ptr->client_ptr->hidden)
@@ -1151,7 +1361,7 @@ static void ladish_graph_show_port_internal(struct ladish_graph * graph_ptr, str
   if (graph_ptr->opath != NULL)
   {
     ladish_graph_emit_port_appeared(graph_ptr, port_ptr);
-    ladish_try_connect_hidden_connections((ladish_graph_handle)graph_ptr);
+    ladish_graph_queue_hidden_connections(graph_ptr, port_ptr);
   }
 }
 
@@ -1183,18 +1393,22 @@ static void ladish_hide_connections(struct ladish_graph * graph_ptr, struct ladi
 {
   struct list_head * node_ptr;
   struct ladish_graph_connection * connection_ptr;
+  unsigned int i;
 
   log_info("hidding connections of port %"PRIu64, port_ptr->id);
 
   ASSERT(graph_ptr->opath != NULL);
 
-  list_for_each(node_ptr, &graph_ptr->connections)
+  for (i = 0; i < 2; i++)
   {
-    connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-    if (!connection_ptr->hidden && (connection_ptr->port1_ptr == port_ptr || connection_ptr->port2_ptr == port_ptr))
+    list_for_each(node_ptr, &port_ptr->connections[i])
     {
-      log_info("hidding connection between ports %"PRIu64" and %"PRIu64, connection_ptr->port1_ptr->id, connection_ptr->port2_ptr->id);
-      ladish_graph_hide_connection_internal(graph_ptr, connection_ptr);
+      connection_ptr = port_connection_entry(node_ptr, i);
+      if (!connection_ptr->hidden)
+      {
+        log_info("hidding connection between ports %"PRIu64" and %"PRIu64, connection_ptr->port1_ptr->id, connection_ptr->port2_ptr->id);
+        ladish_graph_hide_connection_internal(graph_ptr, connection_ptr);
+      }
     }
   }
 }
@@ -1202,6 +1416,9 @@ static void ladish_hide_connections(struct ladish_graph * graph_ptr, struct ladi
 static void ladish_graph_remove_connection_internal(struct ladish_graph * graph_ptr, struct ladish_graph_connection * connection_ptr)
 {
   list_del(&connection_ptr->siblings);
+  list_del(&connection_ptr->siblings_port[0]);
+  list_del(&connection_ptr->siblings_port[1]);
+  list_del(&connection_ptr->siblings_pending);
   graph_ptr->graph_version++;
 
   if (!connection_ptr->hidden && graph_ptr->opath != NULL)
@@ -1210,20 +1427,19 @@ static void ladish_graph_remove_connection_internal(struct ladish_graph * graph_
   }
 
   ladish_dict_destroy(connection_ptr->dict);
-  free(connection_ptr);
+  ladish_slab_free(&g_connection_slab, connection_ptr);
 }
 
 static void ladish_graph_remove_port_connections(struct ladish_graph * graph_ptr, struct ladish_graph_port * port_ptr)
 {
-  struct list_head * node_ptr;
-  struct list_head * temp_node_ptr;
   struct ladish_graph_connection * connection_ptr;
+  unsigned int i;
 
-  list_for_each_safe(node_ptr, temp_node_ptr, &graph_ptr->connections)
+  for (i = 0; i < 2; i++)
   {
-    connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-    if (connection_ptr->port1_ptr == port_ptr || connection_ptr->port2_ptr == port_ptr)
+    while (!list_empty(&port_ptr->connections[i]))
     {
+      connection_ptr = port_connection_entry(port_ptr->connections[i].next, i);
       log_info("removing connection between ports %"PRIu64" and %"PRIu64, connection_ptr->port1_ptr->id, connection_ptr->port2_ptr->id);
       ladish_graph_remove_connection_internal(graph_ptr, connection_ptr);
     }
@@ -1251,8 +1467,8 @@ ladish_graph_remove_port_internal(
     ladish_graph_emit_port_disappeared(graph_ptr, port_ptr);
   }
 
-  free(port_ptr->name);
-  free(port_ptr);
+  ladish_intern_unref(port_ptr->name);
+  ladish_slab_free(&g_port_slab, port_ptr);
 }
 
 static
@@ -1283,14 +1499,14 @@ ladish_graph_remove_client_internal(
     ladish_graph_emit_client_disappeared(graph_ptr, client_ptr);
   }
 
-  free(client_ptr->name);
+  ladish_intern_unref(client_ptr->name);
 
   if (destroy_client)
   {
     ladish_client_destroy(client_ptr->client);
   }
 
-  free(client_ptr);
+  ladish_slab_free(&g_client_slab, client_ptr);
 }
 
 bool ladish_graph_client_looks_empty_internal(struct ladish_graph * graph_ptr, struct ladish_graph_client * client_ptr)
@@ -1321,6 +1537,8 @@ bool ladish_graph_client_looks_empty_internal(struct ladish_graph * graph_ptr, s
 void ladish_graph_destroy(ladish_graph_handle graph_handle)
 {
   ladish_graph_clear(graph_handle, NULL);
+  list_del(&graph_ptr->siblings_pending);
+  list_del(&graph_ptr->siblings);
   ladish_dict_destroy(graph_ptr->dict);
   if (graph_ptr->opath != NULL)
   {
@@ -1344,12 +1562,20 @@ ladish_graph_set_connection_handlers(
   ladish_graph_handle graph_handle,
   void * graph_context,
   ladish_graph_connect_request_handler connect_handler,
-  ladish_graph_disconnect_request_handler disconnect_handler)
+  ladish_graph_disconnect_request_handler disconnect_handler,
+  ladish_graph_flush_requests_handler flush_handler)
 {
   log_info("setting connection handlers for graph '%s'", graph_ptr->opath != NULL ? graph_ptr->opath : "JACK");
   graph_ptr->context = graph_context;
   graph_ptr->connect_handler = connect_handler;
   graph_ptr->disconnect_handler = disconnect_handler;
+  graph_ptr->flush_handler = flush_handler;
+
+  /* nobody to connect them, a stopped room for example */
+  if (connect_handler == NULL)
+  {
+    ladish_graph_drop_pending_connections(graph_ptr);
+  }
 }
 
 void ladish_graph_clear(ladish_graph_handle graph_handle, ladish_graph_simple_port_callback port_callback)
@@ -1404,6 +1630,27 @@ void ladish_graph_show_connection(ladish_graph_handle graph_handle, uint64_t con
   ladish_graph_emit_ports_connected(graph_ptr, connection_ptr);
 }
 
+/* deferred connect or disconnect request failed, the connection can be requested again */
+void ladish_graph_connection_change_failed(ladish_graph_handle graph_handle, ladish_port_handle port1_handle, ladish_port_handle port2_handle)
+{
+  struct ladish_graph_port * port1_ptr;
+  struct ladish_graph_port * port2_ptr;
+  struct ladish_graph_connection * connection_ptr;
+
+  port1_ptr = ladish_graph_find_port(graph_ptr, port1_handle);
+  port2_ptr = ladish_graph_find_port(graph_ptr, port2_handle);
+  if (port1_ptr == NULL || port2_ptr == NULL)
+  {
+    return;
+  }
+
+  connection_ptr = ladish_graph_find_connection_by_ports(graph_ptr, port1_ptr, port2_ptr);
+  if (connection_ptr != NULL)
+  {
+    connection_ptr->changing = false;
+  }
+}
+
 void ladish_graph_show_port(ladish_graph_handle graph_handle, ladish_port_handle port_handle)
 {
   struct ladish_graph_port * port_ptr;
@@ -1509,18 +1756,18 @@ bool ladish_graph_add_client(ladish_graph_handle graph_handle, ladish_client_han
 
   log_info("adding client '%s' (%p) to graph %s", name, client_handle, graph_ptr->opath != NULL ? graph_ptr->opath : "JACK");
 
-  client_ptr = malloc(sizeof(struct ladish_graph_client));
+  client_ptr = ladish_slab_alloc(&g_client_slab);
   if (client_ptr == NULL)
   {
-    log_error("malloc() failed for struct ladish_graph_client");
+    log_error("ladish_slab_alloc() failed for struct ladish_graph_client");
     return false;
   }
 
-  client_ptr->name = strdup(name);
+  client_ptr->name = ladish_intern(name);
   if (client_ptr->name == NULL)
   {
-    log_error("strdup() failed for graph client name");
-    free(client_ptr);
+    log_error("ladish_intern() failed for graph client name");
+    ladish_slab_free(&g_client_slab, client_ptr);
     return false;
   }
 
@@ -1605,18 +1852,18 @@ ladish_graph_add_port(
 
   log_info("adding port '%s' (%p) to client '%s' in graph %s", name, port_handle, client_ptr->name, graph_ptr->opath != NULL ? graph_ptr->opath : "JACK");
 
-  port_ptr = malloc(sizeof(struct ladish_graph_port));
+  port_ptr = ladish_slab_alloc(&g_port_slab);
   if (port_ptr == NULL)
   {
-    log_error("malloc() failed for struct ladish_graph_port");
+    log_error("ladish_slab_alloc() failed for struct ladish_graph_port");
     return false;
   }
 
-  port_ptr->name = strdup(name);
+  port_ptr->name = ladish_intern(name);
   if (port_ptr->name == NULL)
   {
-    log_error("strdup() failed for graph port name");
-    free(port_ptr);
+    log_error("ladish_intern() failed for graph port name");
+    ladish_slab_free(&g_port_slab, port_ptr);
     return false;
   }
 
@@ -1634,6 +1881,9 @@ ladish_graph_add_port(
     uuid_generate(port_ptr->link_uuid_override);
   }
 
+  INIT_LIST_HEAD(&port_ptr->connections[0]);
+  INIT_LIST_HEAD(&port_ptr->connections[1]);
+
   port_ptr->client_ptr = client_ptr;
   list_add_tail(&port_ptr->siblings_client, &client_ptr->ports);
   list_add_tail(&port_ptr->siblings_graph, &graph_ptr->ports);
@@ -1662,17 +1912,17 @@ ladish_graph_add_connection(
   port2_ptr = ladish_graph_find_port(graph_ptr, port2_handle);
   ASSERT(port2_ptr != NULL);
 
-  connection_ptr = malloc(sizeof(struct ladish_graph_connection));
+  connection_ptr = ladish_slab_alloc(&g_connection_slab);
   if (connection_ptr == NULL)
   {
-    log_error("malloc() failed for struct ladish_graph_connection");
+    log_error("ladish_slab_alloc() failed for struct ladish_graph_connection");
     return 0;
   }
 
   if (!ladish_dict_create(&connection_ptr->dict))
   {
     log_error("ladish_dict_create() failed for connection");
-    free(connection_ptr);
+    ladish_slab_free(&g_connection_slab, connection_ptr);
     return 0;
   }
 
@@ -1684,6 +1934,9 @@ ladish_graph_add_connection(
   graph_ptr->graph_version++;
 
   list_add_tail(&connection_ptr->siblings, &graph_ptr->connections);
+  list_add_tail(&connection_ptr->siblings_port[0], &port1_ptr->connections[0]);
+  list_add_tail(&connection_ptr->siblings_port[1], &port2_ptr->connections[1]);
+  INIT_LIST_HEAD(&connection_ptr->siblings_pending);
 
   /* log_info( */
   /*   "new connection %"PRIu64" between '%s':'%s' and '%s':'%s'", */
@@ -1813,10 +2066,16 @@ ladish_client_handle ladish_graph_find_client_by_name(ladish_graph_handle graph_
   struct list_head * node_ptr;
   struct ladish_graph_client * client_ptr;
 
+  name = ladish_intern_find(name);
+  if (name == NULL)
+  {
+    return NULL;
+  }
+
   list_for_each(node_ptr, &graph_ptr->clients)
   {
     client_ptr = list_entry(node_ptr, struct ladish_graph_client, siblings);
-    if (strcmp(client_ptr->name, name) == 0 &&
+    if (client_ptr->name == name &&
         (!appless || !ladish_client_has_app(client_ptr->client))) /* if appless is true, then an appless client is being searched */
     {
       return client_ptr->client;
@@ -1861,6 +2120,12 @@ ladish_graph_find_port_by_name(
   client_ptr = ladish_graph_find_client(graph_ptr, client_handle);
   if (client_ptr != NULL)
   {
+    name = ladish_intern_find(name);
+    if (name == NULL)
+    {
+      return NULL;
+    }
+
     list_for_each(node_ptr, &client_ptr->ports)
     {
       port_ptr = list_entry(node_ptr, struct ladish_graph_port, siblings_client);
@@ -1870,7 +2135,7 @@ ladish_graph_find_port_by_name(
         continue;
       }
 
-      if (strcmp(port_ptr->name, name) == 0)
+      if (port_ptr->name == name)
       {
         return port_ptr->port;
       }
@@ -2100,6 +2365,7 @@ ladish_graph_move_port(
   struct ladish_graph_client * client_ptr;
   struct list_head * node_ptr;
   struct ladish_graph_connection * connection_ptr;
+  unsigned int i;
 
   port_ptr = ladish_graph_find_port(graph_ptr, port_handle);
   if (port_ptr == NULL)
@@ -2121,13 +2387,16 @@ ladish_graph_move_port(
 
   if (graph_ptr->opath != NULL && !port_ptr->hidden)
   {
-    list_for_each(node_ptr, &graph_ptr->connections)
+    for (i = 0; i < 2; i++)
     {
-      connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-      if (!connection_ptr->hidden && (connection_ptr->port1_ptr == port_ptr || connection_ptr->port2_ptr == port_ptr))
+      list_for_each(node_ptr, &port_ptr->connections[i])
       {
-        ladish_graph_emit_ports_disconnected(graph_ptr, connection_ptr);
-        graph_ptr->graph_version++;
+        connection_ptr = port_connection_entry(node_ptr, i);
+        if (!connection_ptr->hidden)
+        {
+          ladish_graph_emit_ports_disconnected(graph_ptr, connection_ptr);
+          graph_ptr->graph_version++;
+        }
       }
     }
 
@@ -2144,14 +2413,17 @@ ladish_graph_move_port(
   {
     ladish_graph_emit_port_appeared(graph_ptr, port_ptr);
 
-    list_for_each(node_ptr, &graph_ptr->connections)
+    for (i = 0; i < 2; i++)
     {
-      connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-      if (!connection_ptr->hidden && (connection_ptr->port1_ptr == port_ptr || connection_ptr->port2_ptr == port_ptr))
+      list_for_each(node_ptr, &port_ptr->connections[i])
       {
-        graph_ptr->next_connection_id++;
-        graph_ptr->graph_version++;
-        ladish_graph_emit_ports_connected(graph_ptr, connection_ptr);
+        connection_ptr = port_connection_entry(node_ptr, i);
+        if (!connection_ptr->hidden)
+        {
+          graph_ptr->next_connection_id++;
+          graph_ptr->graph_version++;
+          ladish_graph_emit_ports_connected(graph_ptr, connection_ptr);
+        }
       }
     }
   }
@@ -2163,21 +2435,21 @@ ladish_graph_rename_client(
   ladish_client_handle client_handle,
   const char * new_client_name)
 {
-  char * name;
+  const char * name;
   struct ladish_graph_client * client_ptr;
-  char * old_name;
+  const char * old_name;
 
-  name = strdup(new_client_name);
+  name = ladish_intern(new_client_name);
   if (name == NULL)
   {
-    log_error("strdup('%s') failed.", new_client_name);
+    log_error("ladish_intern('%s') failed.", new_client_name);
     return false;
   }
 
   client_ptr = ladish_graph_find_client(graph_ptr, client_handle);
   if (client_ptr == NULL)
   {
-    free(name);
+    ladish_intern_unref(name);
     ASSERT_NO_PASS;
     return false;
   }
@@ -2189,6 +2461,7 @@ ladish_graph_rename_client(
 
   if (!client_ptr->hidden && graph_ptr->opath != NULL)
   {
+    graph_ptr->signals_emitted++;
     cdbus_signal_emit(
       cdbus_g_dbus_connection,
       graph_ptr->opath,
@@ -2201,7 +2474,7 @@ ladish_graph_rename_client(
       &client_ptr->name);
   }
 
-  free(old_name);
+  ladish_intern_unref(old_name);
 
   return true;
 }
@@ -2212,14 +2485,14 @@ ladish_graph_rename_port(
   ladish_port_handle port_handle,
   const char * new_port_name)
 {
-  char * name;
+  const char * name;
   struct ladish_graph_port * port_ptr;
-  char * old_name;
+  const char * old_name;
 
-  name = strdup(new_port_name);
+  name = ladish_intern(new_port_name);
   if (name == NULL)
   {
-    log_error("strdup('%s') failed.", new_port_name);
+    log_error("ladish_intern('%s') failed.", new_port_name);
     return false;
   }
 
@@ -2227,7 +2500,7 @@ ladish_graph_rename_port(
   if (port_ptr == NULL)
   {
     ASSERT_NO_PASS;
-    free(name);
+    ladish_intern_unref(name);
     return false;
   }
 
@@ -2238,6 +2511,7 @@ ladish_graph_rename_port(
 
   if (!port_ptr->hidden && graph_ptr->opath != NULL)
   {
+    graph_ptr->signals_emitted++;
     cdbus_signal_emit(
       cdbus_g_dbus_connection,
       graph_ptr->opath,
@@ -2252,7 +2526,7 @@ ladish_graph_rename_port(
       &port_ptr->name);
   }
 
-  free(old_name);
+  ladish_intern_unref(old_name);
 
   return true;
 }
@@ -2335,35 +2609,12 @@ void ladish_try_connect_hidden_connections(ladish_graph_handle graph_handle)
   list_for_each(node_ptr, &graph_ptr->connections)
   {
     connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-    log_debug(
-      "checking connection (%s, %s) '%s':'%s' (%s) to '%s':'%s' (%s)",
-      connection_ptr->hidden ? "hidden" : "visible",
-      connection_ptr->changing ? "changing" : "not changing",
-      connection_ptr->port1_ptr->client_ptr->name,
-      connection_ptr->port1_ptr->name,
-      connection_ptr->port1_ptr->hidden ? "hidden" : "visible",
-      connection_ptr->port2_ptr->client_ptr->name,
-      connection_ptr->port2_ptr->name,
-      connection_ptr->port2_ptr->hidden ? "hidden" : "visible");
-    if (connection_ptr->hidden &&
-        !connection_ptr->changing &&
-        !connection_ptr->port1_ptr->hidden &&
-        !connection_ptr->port2_ptr->hidden)
-    {
-      log_info(
-        "auto connecting '%s':'%s' to '%s':'%s'",
-        connection_ptr->port1_ptr->client_ptr->name,
-        connection_ptr->port1_ptr->name,
-        connection_ptr->port2_ptr->client_ptr->name,
-        connection_ptr->port2_ptr->name);
+    ladish_graph_connect_hidden_connection(graph_ptr, connection_ptr);
+  }
 
-      connection_ptr->changing = true;
-      if (!graph_ptr->connect_handler(graph_ptr->context, graph_handle, connection_ptr->port1_ptr->port, connection_ptr->port2_ptr->port))
-      {
-        connection_ptr->changing = false;
-        log_error("auto connect failed.");
-      }
-    }
+  if (graph_ptr->flush_handler != NULL)
+  {
+    graph_ptr->flush_handler(graph_ptr->context, graph_handle);
   }
 }
 
@@ -2371,6 +2622,7 @@ bool ladish_disconnect_visible_connections(ladish_graph_handle graph_handle)
 {
   struct list_head * node_ptr;
   struct ladish_graph_connection * connection_ptr;
+  bool ret;
 
   if (graph_ptr->disconnect_handler == NULL)
   {
@@ -2380,19 +2632,10 @@ bool ladish_disconnect_visible_connections(ladish_graph_handle graph_handle)
 
   ASSERT(graph_ptr->opath != NULL);
 
+  ret = true;
   list_for_each(node_ptr, &graph_ptr->connections)
   {
     connection_ptr = list_entry(node_ptr, struct ladish_graph_connection, siblings);
-    log_debug(
-      "checking connection (%s, %s) '%s':'%s' (%s) to '%s':'%s' (%s)",
-      connection_ptr->hidden ? "hidden" : "visible",
-      connection_ptr->changing ? "changing" : "not changing",
-      connection_ptr->port1_ptr->client_ptr->name,
-      connection_ptr->port1_ptr->name,
-      connection_ptr->port1_ptr->hidden ? "hidden" : "visible",
-      connection_ptr->port2_ptr->client_ptr->name,
-      connection_ptr->port2_ptr->name,
-      connection_ptr->port2_ptr->hidden ? "hidden" : "visible");
     if (!connection_ptr->hidden &&
         !connection_ptr->changing &&
         !connection_ptr->port1_ptr->hidden &&
@@ -2406,16 +2649,23 @@ bool ladish_disconnect_visible_connections(ladish_graph_handle graph_handle)
         connection_ptr->port2_ptr->name);
 
       connection_ptr->changing = true;
-      if (!graph_ptr->disconnect_handler(graph_ptr->context, graph_handle, connection_ptr->id))
+      if (!graph_ptr->disconnect_handler(graph_ptr->context, graph_handle, connection_ptr->id, true))
       {
         connection_ptr->changing = false;
         log_error("disconnect failed.");
-        return false;
+        ret = false;
+        break;
       }
     }
   }
 
-  return true;
+  /* send the requests queued before the failure too */
+  if (graph_ptr->flush_handler != NULL)
+  {
+    graph_ptr->flush_handler(graph_ptr->context, graph_handle);
+  }
+
+  return ret;
 }
 
 void ladish_graph_hide_non_virtual(ladish_graph_handle graph_handle)
@@ -2817,6 +3067,8 @@ void ladish_graph_dump(ladish_graph_handle graph_handle)
       connection_ptr->changing ? " [changing]" : "");
     dump_dict("      ", connection_ptr->dict);
   }
+  ladish_slab_dump();
+  ladish_intern_dump();
 }
 
 void ladish_graph_clear_persist(ladish_graph_handle graph_handle)
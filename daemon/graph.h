@@ -32,20 +32,29 @@
 
 typedef struct ladish_graph_tag { int unused; } * ladish_graph_handle;
 
+/* deferred requests may be queued until the flush handler is called */
 typedef
 bool
 (* ladish_graph_connect_request_handler)(
   void * context,
   ladish_graph_handle graph_handle,
   ladish_port_handle port1,
-  ladish_port_handle port2);
+  ladish_port_handle port2,
+  bool deferred);
 
 typedef
 bool
 (* ladish_graph_disconnect_request_handler)(
   void * context,
   ladish_graph_handle graph_handle,
-  uint64_t connection_id);
+  uint64_t connection_id,
+  bool deferred);
+
+typedef
+void
+(* ladish_graph_flush_requests_handler)(
+  void * context,
+  ladish_graph_handle graph_handle);
 
 typedef void (* ladish_graph_simple_port_callback)(ladish_port_handle port_handle);
 
@@ -61,7 +70,8 @@ ladish_graph_set_connection_handlers(
   ladish_graph_handle graph_handle,
   void * graph_context,
   ladish_graph_connect_request_handler connect_handler,
-  ladish_graph_disconnect_request_handler disconnect_handler);
+  ladish_graph_disconnect_request_handler disconnect_handler,
+  ladish_graph_flush_requests_handler flush_handler);
 
 void ladish_graph_clear(ladish_graph_handle graph_handle, ladish_graph_simple_port_callback port_callback);
 void * ladish_graph_get_dbus_context(ladish_graph_handle graph_handle);
@@ -178,7 +188,23 @@ void ladish_graph_show_client(ladish_graph_handle graph_handle, ladish_client_ha
 void ladish_graph_hide_client(ladish_graph_handle graph_handle, ladish_client_handle client_handle);
 void ladish_graph_adjust_port(ladish_graph_handle graph_handle, ladish_port_handle port_handle, uint32_t type, uint32_t flags);
 void ladish_graph_show_connection(ladish_graph_handle graph_handle, uint64_t connection_id);
+void ladish_graph_connection_change_failed(ladish_graph_handle graph_handle, ladish_port_handle port1_handle, ladish_port_handle port2_handle);
 void ladish_try_connect_hidden_connections(ladish_graph_handle graph_handle);
+void ladish_graph_run(void);
+
+struct ladish_graph_metrics
+{
+  const char * opath;           /* NULL for JACK graphs */
+  uint64_t signals_emitted;     /* patchbay signals */
+  unsigned int clients;
+  unsigned int ports;
+  unsigned int connections;
+};
+
+void
+ladish_graph_iterate_metrics(
+  void * context,
+  void (* callback)(void * context, const struct ladish_graph_metrics * metrics_ptr));
 bool ladish_disconnect_visible_connections(ladish_graph_handle graph_handle);
 void ladish_graph_hide_non_virtual(ladish_graph_handle graph_handle);
 void ladish_graph_get_port_uuid(ladish_graph_handle graph, ladish_port_handle port, uuid_t uuid_ptr);
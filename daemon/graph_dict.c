@@ -31,47 +31,47 @@
 
 #define graph_handle ((ladish_graph_handle)call_ptr->iface_context)
 
-bool find_dict(struct cdbus_method_call * call_ptr, uint32_t object_type, uint64_t object_id, ladish_dict_handle * dict_handle_ptr)
+static ladish_dict_handle lookup_dict(struct cdbus_method_call * call_ptr, uint32_t object_type, uint64_t object_id)
 {
   ladish_client_handle client;
   ladish_port_handle port;
-  ladish_dict_handle dict;
 
   switch (object_type)
   {
   case GRAPH_DICT_OBJECT_TYPE_GRAPH:
-    *dict_handle_ptr = ladish_graph_get_dict(graph_handle);
-    return true;
+    return ladish_graph_get_dict(graph_handle);
   case GRAPH_DICT_OBJECT_TYPE_CLIENT:
     client = ladish_graph_find_client_by_id(graph_handle, object_id);
-    if (client == NULL)
-    {
-      cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "cannot find client %"PRIu64".", object_id);
-      return false;
-    }
-    *dict_handle_ptr = ladish_client_get_dict(client);
-    return true;
+    return client != NULL ? ladish_client_get_dict(client) : NULL;
   case GRAPH_DICT_OBJECT_TYPE_PORT:
     port = ladish_graph_find_port_by_id(graph_handle, object_id);
-    if (port == NULL)
-    {
-      cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "cannot find port %"PRIu64".", object_id);
-      return false;
-    }
-    *dict_handle_ptr = ladish_port_get_dict(port);
-    return true;
+    return port != NULL ? ladish_port_get_dict(port) : NULL;
   case GRAPH_DICT_OBJECT_TYPE_CONNECTION:
-    dict = ladish_graph_get_connection_dict(graph_handle, object_id);
-    if (dict == NULL)
-    {
-      cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "cannot find connection %"PRIu64".", object_id);
-    }
+    return ladish_graph_get_connection_dict(graph_handle, object_id);
+  }
 
-    *dict_handle_ptr = dict;
-    return false;
+  return NULL;
+}
+
+bool find_dict(struct cdbus_method_call * call_ptr, uint32_t object_type, uint64_t object_id, ladish_dict_handle * dict_handle_ptr)
+{
+  static const char * const object_type_names[] = {"graph", "client", "port", "connection"};
+
+  *dict_handle_ptr = lookup_dict(call_ptr, object_type, object_id);
+  if (*dict_handle_ptr != NULL)
+  {
+    return true;
+  }
+
+  if (object_type > GRAPH_DICT_OBJECT_TYPE_CONNECTION)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "find_dict() not implemented for object type %"PRIu32".", object_type);
+  }
+  else
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "cannot find %s %"PRIu64".", object_type_names[object_type], object_id);
   }
 
-  cdbus_error(call_ptr, DBUS_ERROR_INVALID_ARGS, "find_dict() not implemented for object type %"PRIu32".", object_type);
   return false;
 }
 
@@ -181,6 +181,187 @@ void ladish_dict_drop_dbus(struct cdbus_method_call * call_ptr)
   cdbus_method_return_new_void(call_ptr);
 }
 
+void ladish_dict_get_many_dbus(struct cdbus_method_call * call_ptr)
+{
+  DBusMessageIter iter;
+  DBusMessageIter objects_iter;
+  DBusMessageIter object_iter;
+  DBusMessageIter keys_iter;
+  DBusMessageIter reply_iter;
+  DBusMessageIter entries_iter;
+  DBusMessageIter entry_iter;
+  dbus_uint32_t object_type;
+  dbus_uint64_t object_id;
+  ladish_dict_handle dict;
+  const char * key;
+  const char * value;
+
+  if (!dbus_message_has_signature(call_ptr->message, "a(ut)as"))
+  {
+    cdbus_error(
+      call_ptr,
+      DBUS_ERROR_INVALID_ARGS,
+      "Invalid arguments to method \"%s\": signature is '%s' but expected signature is 'a(ut)as'",
+      call_ptr->method_name,
+      dbus_message_get_signature(call_ptr->message));
+    return;
+  }
+
+  call_ptr->reply = dbus_message_new_method_return(call_ptr->message);
+  if (call_ptr->reply == NULL)
+  {
+    log_error("Ran out of memory trying to construct method return");
+    return;
+  }
+
+  dbus_message_iter_init_append(call_ptr->reply, &reply_iter);
+
+  if (!dbus_message_iter_open_container(&reply_iter, DBUS_TYPE_ARRAY, "(utss)", &entries_iter))
+  {
+    goto nomem;
+  }
+
+  dbus_message_iter_init(call_ptr->message, &iter);
+  dbus_message_iter_recurse(&iter, &objects_iter);
+  dbus_message_iter_next(&iter);
+
+  for (;
+       dbus_message_iter_get_arg_type(&objects_iter) != DBUS_TYPE_INVALID;
+       dbus_message_iter_next(&objects_iter))
+  {
+    dbus_message_iter_recurse(&objects_iter, &object_iter);
+
+    dbus_message_iter_get_basic(&object_iter, &object_type);
+    dbus_message_iter_next(&object_iter);
+
+    dbus_message_iter_get_basic(&object_iter, &object_id);
+
+    dict = lookup_dict(call_ptr, object_type, object_id);
+    if (dict == NULL)
+    {
+      /* the object may have disappeared since the caller got its id */
+      continue;
+    }
+
+    for (dbus_message_iter_recurse(&iter, &keys_iter);
+         dbus_message_iter_get_arg_type(&keys_iter) != DBUS_TYPE_INVALID;
+         dbus_message_iter_next(&keys_iter))
+    {
+      dbus_message_iter_get_basic(&keys_iter, &key);
+
+      value = ladish_dict_get(dict, key);
+      if (value == NULL)
+      {
+        continue;
+      }
+
+      if (!dbus_message_iter_open_container(&entries_iter, DBUS_TYPE_STRUCT, NULL, &entry_iter))
+      {
+        goto nomem_close_entries;
+      }
+
+      if (!dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_UINT32, &object_type) ||
+          !dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_UINT64, &object_id) ||
+          !dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &key) ||
+          !dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &value))
+      {
+        goto nomem_close_entry;
+      }
+
+      if (!dbus_message_iter_close_container(&entries_iter, &entry_iter))
+      {
+        goto nomem_close_entries;
+      }
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&reply_iter, &entries_iter))
+  {
+    goto nomem;
+  }
+
+  return;
+
+nomem_close_entry:
+  dbus_message_iter_close_container(&entries_iter, &entry_iter);
+
+nomem_close_entries:
+  dbus_message_iter_close_container(&reply_iter, &entries_iter);
+
+nomem:
+  dbus_message_unref(call_ptr->reply);
+  call_ptr->reply = NULL;
+  log_error("Ran out of memory trying to construct method return");
+}
+
+void ladish_dict_set_many_dbus(struct cdbus_method_call * call_ptr)
+{
+  DBusMessageIter iter;
+  DBusMessageIter entries_iter;
+  DBusMessageIter entry_iter;
+  dbus_uint32_t object_type;
+  dbus_uint64_t object_id;
+  ladish_dict_handle dict;
+  const char * key;
+  const char * value;
+  unsigned int set_count;
+  unsigned int ignored_count;
+
+  if (!dbus_message_has_signature(call_ptr->message, "a(utss)"))
+  {
+    cdbus_error(
+      call_ptr,
+      DBUS_ERROR_INVALID_ARGS,
+      "Invalid arguments to method \"%s\": signature is '%s' but expected signature is 'a(utss)'",
+      call_ptr->method_name,
+      dbus_message_get_signature(call_ptr->message));
+    return;
+  }
+
+  set_count = 0;
+  ignored_count = 0;
+
+  dbus_message_iter_init(call_ptr->message, &iter);
+
+  for (dbus_message_iter_recurse(&iter, &entries_iter);
+       dbus_message_iter_get_arg_type(&entries_iter) != DBUS_TYPE_INVALID;
+       dbus_message_iter_next(&entries_iter))
+  {
+    dbus_message_iter_recurse(&entries_iter, &entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &object_type);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &object_id);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &key);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &value);
+
+    dict = lookup_dict(call_ptr, object_type, object_id);
+    if (dict == NULL)
+    {
+      /* updates are batched by the caller, the object may have disappeared meanwhile */
+      ignored_count++;
+      continue;
+    }
+
+    if (!ladish_dict_set(dict, key, value))
+    {
+      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "ladish_dict_set(\"%s\", \"%s\") failed.", key, value);
+      return;
+    }
+
+    set_count++;
+  }
+
+  log_info("Set %u dict value(s), ignored %u for unknown objects", set_count, ignored_count);
+
+  cdbus_method_return_new_void(call_ptr);
+}
+
 CDBUS_METHOD_ARGS_BEGIN(Set, "Set value for specified key")
   CDBUS_METHOD_ARG_DESCRIBE_IN("object_type", "u", "Type of object, 0 - graph, 1 - client, 2 - port, 3 - connection")
   CDBUS_METHOD_ARG_DESCRIBE_IN("object_id", "t", "ID of the object")
@@ -201,10 +382,22 @@ CDBUS_METHOD_ARGS_BEGIN(Drop, "Drop entry, if key exists")
   CDBUS_METHOD_ARG_DESCRIBE_IN("key", "s", "Key of the entry to drop")
 CDBUS_METHOD_ARGS_END
 
+CDBUS_METHOD_ARGS_BEGIN(GetDicts, "Get values for specified keys of many objects")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("objects", "a(ut)", "Objects to query, each one is (object_type, object_id)")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("keys", "as", "Keys to query")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("entries", "a(utss)", "Existing entries, each one is (object_type, object_id, key, value)")
+CDBUS_METHOD_ARGS_END
+
+CDBUS_METHOD_ARGS_BEGIN(SetDicts, "Set values for many keys at once")
+  CDBUS_METHOD_ARG_DESCRIBE_IN("entries", "a(utss)", "Entries to set, each one is (object_type, object_id, key, value)")
+CDBUS_METHOD_ARGS_END
+
 CDBUS_METHODS_BEGIN
   CDBUS_METHOD_DESCRIBE(Set, ladish_dict_set_dbus)
   CDBUS_METHOD_DESCRIBE(Get, ladish_dict_get_dbus)
   CDBUS_METHOD_DESCRIBE(Drop, ladish_dict_drop_dbus)
+  CDBUS_METHOD_DESCRIBE(GetDicts, ladish_dict_get_many_dbus)
+  CDBUS_METHOD_DESCRIBE(SetDicts, ladish_dict_set_many_dbus)
 CDBUS_METHODS_END
 
 CDBUS_INTERFACE_DEFAULT_HANDLER_METHODS_ONLY(g_iface_graph_dict, IFACE_GRAPH_DICT)
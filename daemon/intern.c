@@ -0,0 +1,239 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the interned strings
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "intern.h"
+#include "slab.h"
+#include "../common/hash.h"
+
+#define LADISH_INTERN_MIN_BUCKETS 256
+
+struct ladish_intern_entry
+{
+  struct ladish_intern_entry * next; /* in the hash bucket */
+  struct ladish_slab * slab_ptr;     /* NULL when allocated with malloc() */
+  uint32_t hash;
+  unsigned int refcount;
+  char str[];
+};
+
+#define ladish_intern_entry_from_str(istr) ((struct ladish_intern_entry *)((char *)(istr) - offsetof(struct ladish_intern_entry, str)))
+
+/* most client and port names fit in the small size classes */
+static struct ladish_slab g_slabs[] =
+{
+  {.name = "interned string 64", .object_size = 64, .chunk_objects = 64},
+  {.name = "interned string 128", .object_size = 128, .chunk_objects = 32},
+};
+
+static struct ladish_intern_entry ** g_buckets;
+static unsigned int g_bucket_count;
+static unsigned int g_count;
+static size_t g_heap_size;      /* bytes of entries allocated with malloc() */
+
+static struct ladish_intern_entry * ladish_intern_lookup(const char * str, uint32_t hash)
+{
+  struct ladish_intern_entry * entry_ptr;
+
+  if (g_buckets == NULL)
+  {
+    return NULL;
+  }
+
+  for (entry_ptr = g_buckets[ladish_hash_bucket(hash, g_bucket_count)]; entry_ptr != NULL; entry_ptr = entry_ptr->next)
+  {
+    if (entry_ptr->hash == hash && strcmp(entry_ptr->str, str) == 0)
+    {
+      return entry_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static bool ladish_intern_resize(unsigned int bucket_count)
+{
+  struct ladish_intern_entry ** buckets;
+  struct ladish_intern_entry * entry_ptr;
+  unsigned int i;
+  unsigned int index;
+
+  buckets = calloc(bucket_count, sizeof(struct ladish_intern_entry *));
+  if (buckets == NULL)
+  {
+    log_error("calloc() failed to allocate %u interned string buckets", bucket_count);
+    return false;
+  }
+
+  for (i = 0; i < g_bucket_count; i++)
+  {
+    while (g_buckets[i] != NULL)
+    {
+      entry_ptr = g_buckets[i];
+      g_buckets[i] = entry_ptr->next;
+
+      index = ladish_hash_bucket(entry_ptr->hash, bucket_count);
+      entry_ptr->next = buckets[index];
+      buckets[index] = entry_ptr;
+    }
+  }
+
+  free(g_buckets);
+  g_buckets = buckets;
+  g_bucket_count = bucket_count;
+  return true;
+}
+
+const char * ladish_intern(const char * str)
+{
+  struct ladish_intern_entry * entry_ptr;
+  struct ladish_slab * slab_ptr;
+  uint32_t hash;
+  size_t size;
+  unsigned int i;
+  unsigned int index;
+
+  hash = ladish_hash_string(str);
+
+  entry_ptr = ladish_intern_lookup(str, hash);
+  if (entry_ptr != NULL)
+  {
+    entry_ptr->refcount++;
+    return entry_ptr->str;
+  }
+
+  if (g_count >= g_bucket_count &&
+      !ladish_intern_resize(g_bucket_count == 0 ? LADISH_INTERN_MIN_BUCKETS : g_bucket_count * 2) &&
+      g_buckets == NULL)
+  {
+    return NULL;
+  }
+
+  size = sizeof(struct ladish_intern_entry) + strlen(str) + 1;
+
+  slab_ptr = NULL;
+  for (i = 0; i < sizeof(g_slabs) / sizeof(g_slabs[0]); i++)
+  {
+    if (size <= g_slabs[i].object_size)
+    {
+      slab_ptr = g_slabs + i;
+      break;
+    }
+  }
+
+  if (slab_ptr != NULL)
+  {
+    entry_ptr = ladish_slab_alloc(slab_ptr);
+  }
+  else
+  {
+    entry_ptr = malloc(size);
+  }
+
+  if (entry_ptr == NULL)
+  {
+    log_error("failed to allocate interned string '%s'", str);
+    return NULL;
+  }
+
+  if (slab_ptr == NULL)
+  {
+    g_heap_size += size;
+  }
+
+  entry_ptr->slab_ptr = slab_ptr;
+  entry_ptr->hash = hash;
+  entry_ptr->refcount = 1;
+  strcpy(entry_ptr->str, str);
+
+  index = ladish_hash_bucket(hash, g_bucket_count);
+  entry_ptr->next = g_buckets[index];
+  g_buckets[index] = entry_ptr;
+  g_count++;
+
+  return entry_ptr->str;
+}
+
+const char * ladish_intern_ref(const char * istr)
+{
+  struct ladish_intern_entry * entry_ptr;
+
+  entry_ptr = ladish_intern_entry_from_str(istr);
+  ASSERT(entry_ptr->refcount > 0);
+  entry_ptr->refcount++;
+  return istr;
+}
+
+void ladish_intern_unref(const char * istr)
+{
+  struct ladish_intern_entry * entry_ptr;
+  struct ladish_intern_entry ** link_ptr_ptr;
+
+  if (istr == NULL)
+  {
+    return;
+  }
+
+  entry_ptr = ladish_intern_entry_from_str(istr);
+  ASSERT(entry_ptr->refcount > 0);
+  entry_ptr->refcount--;
+  if (entry_ptr->refcount != 0)
+  {
+    return;
+  }
+
+  link_ptr_ptr = g_buckets + ladish_hash_bucket(entry_ptr->hash, g_bucket_count);
+  while (*link_ptr_ptr != entry_ptr)
+  {
+    ASSERT(*link_ptr_ptr != NULL);
+    link_ptr_ptr = &(*link_ptr_ptr)->next;
+  }
+
+  *link_ptr_ptr = entry_ptr->next;
+  g_count--;
+
+  if (entry_ptr->slab_ptr != NULL)
+  {
+    ladish_slab_free(entry_ptr->slab_ptr, entry_ptr);
+  }
+  else
+  {
+    g_heap_size -= sizeof(struct ladish_intern_entry) + strlen(entry_ptr->str) + 1;
+    free(entry_ptr);
+  }
+}
+
+const char * ladish_intern_find(const char * str)
+{
+  struct ladish_intern_entry * entry_ptr;
+
+  entry_ptr = ladish_intern_lookup(str, ladish_hash_string(str));
+  return entry_ptr != NULL ? entry_ptr->str : NULL;
+}
+
+void ladish_intern_dump(void)
+{
+  log_info("interned strings: %u in %u buckets, %zu bytes outside of slabs", g_count, g_bucket_count, g_heap_size);
+}
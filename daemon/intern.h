@@ -0,0 +1,49 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the interned strings
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef INTERN_H__F3338A77_F340_44F6_ABEE_D14586DAFC20__INCLUDED
+#define INTERN_H__F3338A77_F340_44F6_ABEE_D14586DAFC20__INCLUDED
+
+#include "common.h"
+
+/* Equal strings share one refcounted instance, so two interned strings are
+ * equal only when the pointers are equal. Used only from the main thread. */
+
+/* new reference to the interned copy of str, NULL on failure */
+const char * ladish_intern(const char * str);
+
+/* another reference to an interned string */
+const char * ladish_intern_ref(const char * istr);
+
+/* NULL is ignored */
+void ladish_intern_unref(const char * istr);
+
+/* interned copy of str without taking a reference, NULL when there is none */
+const char * ladish_intern_find(const char * str);
+
+void ladish_intern_dump(void);
+
+#endif /* #ifndef INTERN_H__F3338A77_F340_44F6_ABEE_D14586DAFC20__INCLUDED */
@@ -32,6 +32,8 @@
 #include "../proxies/jack_proxy.h"
 #include "../proxies/conf_proxy.h"
 #include "conf.h"
+#include "worker.h"
+#include "../common/ladish_time.h"
 
 struct ladish_js_find_app_client_context
 {
@@ -130,68 +132,165 @@ ladish_js_find_app_client(
 
 struct ladish_js_save_app_context
 {
+  struct list_head siblings;    /* in g_delayed_saves while waiting for the save delay */
+  uint64_t deadline;
+  bool delayed;
+  ladish_worker_job_handle job; /* the job that moves the client dir, NULL if not queued yet */
+
   void * context;
-  void (* callback)(
+  void (* callback)(              /* NULL if cancelled */
     void * context,
     const char * commandline);
 
   char * target_dir;            /* the dir supplied as parameter to ladish_js_save_app() */
   char * temp_dir;              /* temp dir that is passed to jack session notify */
   char * client_dir;            /* client dir within the temp dir */
+
+  /* used by the worker job that moves the client dir to the target dir */
+  char * commandline;
+  bool success;
+  char error[LADISH_WORKER_ERROR_MAX];
 };
 
+/* saves waiting for the delay before the client dir is moved */
+static LIST_HEAD(g_delayed_saves);
+
+static void ladish_js_save_app_context_destroy(struct ladish_js_save_app_context * ctx_ptr)
+{
+  free(ctx_ptr->commandline);
+  free(ctx_ptr->client_dir);
+  free(ctx_ptr->temp_dir);
+  free(ctx_ptr->target_dir);
+  free(ctx_ptr);
+}
+
 #define ctx_ptr ((struct ladish_js_save_app_context *)context)
 
+/* Called in a worker thread, must not log */
+static void ladish_js_save_app_move(void * context)
+{
+  ctx_ptr->success = false;
+
+  if (rename(ctx_ptr->client_dir, ctx_ptr->target_dir) != 0)
+  {
+    snprintf(ctx_ptr->error, sizeof(ctx_ptr->error), "rename('%s' -> '%s') failed. errno = %d (%s)", ctx_ptr->client_dir, ctx_ptr->target_dir, errno, strerror(errno));
+    return;
+  }
+
+  if (rmdir(ctx_ptr->temp_dir) < 0)
+  {
+    snprintf(ctx_ptr->error, sizeof(ctx_ptr->error), "rmdir('%s') failed. errno = %d (%s)", ctx_ptr->temp_dir, errno, strerror(errno));
+    return;
+  }
+
+  ctx_ptr->success = true;
+}
+
+static void ladish_js_save_app_move_complete(void * context)
+{
+  if (!ctx_ptr->success)
+  {
+    log_error("%s", ctx_ptr->error);
+  }
+
+  ctx_ptr->callback(ctx_ptr->context, ctx_ptr->success ? ctx_ptr->commandline : NULL);
+}
+
+static void ladish_js_save_app_move_destroy(void * context)
+{
+  ladish_js_save_app_context_destroy(ctx_ptr);
+}
+
+static void ladish_js_save_app_queue_move(void * context)
+{
+  log_debug("moving '%s' to '%s' and removing temp dir '%s'", ctx_ptr->client_dir, ctx_ptr->target_dir, ctx_ptr->temp_dir);
+
+  /* the renames are done in a worker thread */
+  if (!ladish_worker_queue(ctx_ptr, ladish_js_save_app_move, ladish_js_save_app_move_complete, ladish_js_save_app_move_destroy, &ctx_ptr->job))
+  {
+    ctx_ptr->callback(ctx_ptr->context, NULL);
+    ladish_js_save_app_context_destroy(ctx_ptr);
+  }
+}
+
 void ladish_js_save_app_complete(void * context, const char * commandline)
 {
-  int iret;
   unsigned int delay;
+  uint64_t now;
+
+  if (ctx_ptr->callback == NULL)
+  {
+    log_info("JS app save complete but cancelled. commandline='%s'", commandline != NULL ? commandline : "");
+    ladish_js_save_app_context_destroy(ctx_ptr);
+    return;
+  }
 
   if (commandline == NULL)
   {
-    goto call;
+    goto fail;
   }
 
   log_info("JS app save complete. commandline='%s'", commandline);
 
-  if (!conf_get_uint(LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY, &delay))
+  ctx_ptr->commandline = strdup(commandline);
+  if (ctx_ptr->commandline == NULL)
   {
-    delay = LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY_DEFAULT;
+    log_error("strdup() failed for js commandline");
+    goto fail;
   }
 
-  if (delay > 0)
+  if (!conf_get_uint(LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY, &delay))
   {
-    log_info("sleeping for %u seconds...", delay);
-    sleep(delay);
+    delay = LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY_DEFAULT;
   }
 
-  iret = rename(ctx_ptr->client_dir, ctx_ptr->target_dir);
-  if (iret != 0)
+  now = delay > 0 ? ladish_get_current_microseconds() : 0;
+  if (now == 0)
   {
-    log_error("rename('%s' -> '%s') failed. errno = %d (%s)", ctx_ptr->client_dir, ctx_ptr->target_dir, errno, strerror(errno));
-    commandline = NULL;
-    goto call;
+    ladish_js_save_app_queue_move(ctx_ptr);
+    return;
   }
 
-  log_debug("removing temp dir '%s'", ctx_ptr->temp_dir);
-  iret = rmdir(ctx_ptr->temp_dir);
-  if (iret < 0)
+  /* the dir is moved by ladish_js_run() once the delay passes */
+  log_info("waiting for %u seconds...", delay);
+  ctx_ptr->deadline = now + (uint64_t)delay * 1000000;
+  ctx_ptr->delayed = true;
+  list_add_tail(&ctx_ptr->siblings, &g_delayed_saves);
+  return;
+
+fail:
+  ctx_ptr->callback(ctx_ptr->context, NULL);
+  ladish_js_save_app_context_destroy(ctx_ptr);
+}
+
+#undef ctx_ptr
+
+void ladish_js_run(void)
+{
+  struct list_head * node_ptr;
+  struct list_head * temp_node_ptr;
+  struct ladish_js_save_app_context * ctx_ptr;
+  uint64_t now;
+
+  if (list_empty(&g_delayed_saves))
   {
-    log_error("rmdir('%s') failed. errno = %d (%s)", ctx_ptr->temp_dir, errno, strerror(errno));
-    commandline = NULL;
+    return;
   }
 
-call:
-  ctx_ptr->callback(ctx_ptr->context, commandline);
+  now = ladish_get_current_microseconds();
 
-  free(ctx_ptr->client_dir);
-  free(ctx_ptr->temp_dir);
-  free(ctx_ptr->target_dir);
-  free(ctx_ptr);
+  list_for_each_safe(node_ptr, temp_node_ptr, &g_delayed_saves)
+  {
+    ctx_ptr = list_entry(node_ptr, struct ladish_js_save_app_context, siblings);
+    if (now >= ctx_ptr->deadline)
+    {
+      list_del(&ctx_ptr->siblings);
+      ctx_ptr->delayed = false;
+      ladish_js_save_app_queue_move(ctx_ptr);
+    }
+  }
 }
 
-#undef ctx_ptr
-
 bool
 ladish_js_save_app(
   uuid_t app_uuid,
@@ -199,7 +298,8 @@ ladish_js_save_app(
   void * completion_context,
   void (* completion_callback)(
     void * completion_context,
-    const char * commandline))
+    const char * commandline),
+  ladish_js_save_handle * save_handle_ptr)
 {
   struct ladish_js_save_app_context * ctx_ptr;
   char app_uuid_str[37];
@@ -260,6 +360,9 @@ ladish_js_save_app(
 
   ctx_ptr->callback = completion_callback;
   ctx_ptr->context = completion_context;
+  ctx_ptr->commandline = NULL;
+  ctx_ptr->delayed = false;
+  ctx_ptr->job = NULL;
 
   if (!jack_proxy_session_save_one(true, js_client, ctx_ptr->temp_dir, ctx_ptr, ladish_js_save_app_complete))
   {
@@ -269,6 +372,7 @@ ladish_js_save_app(
 
   log_info("JS app save initiated");
 
+  *save_handle_ptr = (ladish_js_save_handle)ctx_ptr;
   return true;
 
 fail_rm_temp_dir:
@@ -288,3 +392,32 @@ fail_free_struct:
 fail:
   return false;
 }
+
+#define ctx_ptr ((struct ladish_js_save_app_context *)save_handle)
+
+void ladish_js_save_cancel(ladish_js_save_handle save_handle)
+{
+  ASSERT(ctx_ptr->callback != NULL);
+
+  log_info("cancelling JS app save to '%s'", ctx_ptr->target_dir);
+
+  if (ctx_ptr->delayed)
+  {
+    /* the client dir is left in the temp dir */
+    list_del(&ctx_ptr->siblings);
+    ladish_js_save_app_context_destroy(ctx_ptr);
+    return;
+  }
+
+  if (ctx_ptr->job != NULL)
+  {
+    /* the move is still done, the worker will destroy the context */
+    ladish_worker_abandon(ctx_ptr->job);
+    return;
+  }
+
+  /* waiting for the jack session reply, ladish_js_save_app_complete() will destroy the context */
+  ctx_ptr->callback = NULL;
+}
+
+#undef ctx_ptr
@@ -29,6 +29,9 @@
 
 #include "common.h"
 
+typedef struct ladish_js_save_tag { int unused; } * ladish_js_save_handle;
+
+/* On success, the completion callback will be called once, unless the save is cancelled before that */
 bool
 ladish_js_save_app(
   uuid_t app_uuid,
@@ -36,6 +39,13 @@ ladish_js_save_app(
   void * completion_context,
   void (* completion_callback)(
     void * completion_context,
-    const char * commandline));
+    const char * commandline),
+  ladish_js_save_handle * save_handle_ptr);
+
+/* The completion callback will not be called. Must be called before the completion callback is called. */
+void ladish_js_save_cancel(ladish_js_save_handle save_handle);
+
+/* to be called from the main loop */
+void ladish_js_run(void);
 
 #endif /* #ifndef JACK_SESSION_H__3C0F2ED2_7FAB_460F_A34F_4E3CAB6AC552__INCLUDED */
@@ -32,6 +32,7 @@
 #include "client.h"
 #include "port.h"
 #include "room.h"
+#include "xml_document.h"
 
 #define PARSE_CONTEXT_ROOT                0
 #define PARSE_CONTEXT_STUDIO              1
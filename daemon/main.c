@@ -50,6 +50,11 @@
 #include "conf.h"
 #include "recent_projects.h"
 #include "lash_server.h"
+#include "meta_index.h"
+#include "worker.h"
+#include "metrics.h"
+#include "jack_session.h"
+#include "../common/ladish_time.h"
 
 bool g_quit;
 const char * g_dbus_unique_name;
@@ -166,7 +171,11 @@ static bool connect_dbus(void)
     goto unref_connection;
   }
 
-  g_control_object = cdbus_object_path_new(CONTROL_OBJECT_PATH, &g_lashd_interface_control, NULL, NULL);
+  g_control_object = cdbus_object_path_new(
+    CONTROL_OBJECT_PATH,
+    &g_lashd_interface_control, NULL,
+    &g_iface_metrics, NULL,
+    NULL);
   if (g_control_object == NULL)
   {
     goto unref_connection;
@@ -283,11 +292,34 @@ static void on_conf_notify_changed(void * UNUSED(context), const char * UNUSED(k
   }
 }
 
+static void on_conf_log_filter_changed(void * UNUSED(context), const char * UNUSED(key), const char * value)
+{
+  if (value == NULL)
+  {
+    value = LADISH_CONF_KEY_DAEMON_LOG_FILTER_DEFAULT;
+  }
+
+  ladish_log_set_filter(value);
+}
+
+static const char * const g_conf_keys[] =
+{
+  LADISH_CONF_KEY_DAEMON_NOTIFY,
+  LADISH_CONF_KEY_DAEMON_SHELL,
+  LADISH_CONF_KEY_DAEMON_TERMINAL,
+  LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART,
+  LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY,
+  LADISH_CONF_KEY_DAEMON_LOG_FILTER,
+  LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE,
+  NULL
+};
+
 int main(int argc, char ** argv, char ** envp)
 {
   struct stat st;
   char timestamp_str[26];
   int ret;
+  uint64_t iteration_start;
 
   if (stat(argv[0], &st) < 0) {
     st.st_mtime = 0;
@@ -299,6 +331,8 @@ int main(int argc, char ** argv, char ** envp)
 
   dbus_threads_init_default();
 
+  ladish_log_init();
+
   log_info("------------------");
   log_info("LADI session handler activated. Version %s (%s) built on %s", PACKAGE_VERSION, GIT_VERSION, timestamp_str);
 
@@ -341,6 +375,8 @@ int main(int argc, char ** argv, char ** envp)
     goto uninit_dbus;
   }
 
+  conf_prefetch(g_conf_keys);
+
   if (!conf_register(LADISH_CONF_KEY_DAEMON_NOTIFY, on_conf_notify_changed, NULL))
   {
     goto uninit_conf;
@@ -366,11 +402,26 @@ int main(int argc, char ** argv, char ** envp)
     goto uninit_conf;
   }
 
-  if (!ladish_recent_projects_init())
+  if (!conf_register(LADISH_CONF_KEY_DAEMON_LOG_FILTER, on_conf_log_filter_changed, NULL))
+  {
+    goto uninit_conf;
+  }
+
+  if (!conf_register(LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE, NULL, NULL))
+  {
+    goto uninit_conf;
+  }
+
+  if (!ladish_worker_init())
   {
     goto uninit_conf;
   }
 
+  if (!ladish_recent_projects_init())
+  {
+    goto uninit_worker;
+  }
+
   if (!a2j_proxy_init())
   {
     goto uninit_recent_projects;
@@ -386,19 +437,36 @@ int main(int argc, char ** argv, char ** envp)
     goto uninit_jmcore;
   }
 
-  if (!lash_server_init())
+  if (!ladish_meta_index_init())
   {
     goto uninit_studio;
   }
 
+  if (!lash_server_init())
+  {
+    goto uninit_meta_index;
+  }
+
   ladish_notify_simple(LADISH_NOTIFY_URGENCY_LOW, "LADI Session Handler daemon activated", NULL);
 
   while (!g_quit)
   {
-    dbus_connection_read_write_dispatch(cdbus_g_dbus_connection, 50);
+    /* same as dbus_connection_read_write_dispatch() but the wait is not measured */
+    if (dbus_connection_get_dispatch_status(cdbus_g_dbus_connection) != DBUS_DISPATCH_DATA_REMAINS)
+    {
+      dbus_connection_read_write(cdbus_g_dbus_connection, 50);
+    }
+
+    iteration_start = ladish_get_current_microseconds();
+    dbus_connection_dispatch(cdbus_g_dbus_connection);
+    ladish_graph_run();
     loader_run();
+    ladish_worker_run();
+    ladish_js_run();
     ladish_studio_run();
+    ladish_meta_index_run();
     ladish_check_integrity();
+    ladish_metrics_main_loop_iteration(ladish_metrics_elapsed(iteration_start));
   }
 
   emit_clean_exit();
@@ -410,6 +478,9 @@ int main(int argc, char ** argv, char ** envp)
 
   lash_server_uninit();
 
+uninit_meta_index:
+  ladish_meta_index_uninit();
+
 uninit_studio:
   ladish_studio_uninit();
 
@@ -422,6 +493,9 @@ uninit_a2j:
 uninit_recent_projects:
   ladish_recent_projects_uninit();
 
+uninit_worker:
+  ladish_worker_uninit();
+
 uninit_conf:
   if (g_use_notify)
   {
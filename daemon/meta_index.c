@@ -0,0 +1,955 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the studio and project metadata index
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The index keeps name, modification time, description and application count
+ * of every studio in the studios directory and of the most recently queried
+ * projects (the recent projects are prefetched). Projects that disappear are
+ * dropped from the index. Entries are invalidated
+ * through inotify and rescanned on the next main loop iteration. Rescans of
+ * many entries (the initial one, after inotify queue overflow) are spread
+ * over a small set of threads. The scan code that runs in the threads must
+ * not touch anything but the entry it is given; logging is done afterwards,
+ * from the main thread.
+ */
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <expat.h>
+
+#include "meta_index.h"
+#include "studio_internal.h"
+#include "room_internal.h"
+#include "recent_projects.h"
+#include "escape.h"
+#include "../common/catdup.h"
+#include "../common/hash.h"
+
+#define META_INDEX_HASH_SIZE 256 /* must be power of two */
+#define META_INDEX_MAX_THREADS 4
+#define META_INDEX_MAX_PROJECTS 128 /* least recently queried projects are evicted */
+
+#define META_INDEX_STUDIOS_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF)
+#define META_INDEX_PROJECT_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF)
+
+struct ladish_meta_entry
+{
+  struct list_head siblings;        /* link in ladish_meta_table::entries */
+  struct hlist_node hash_siblings;  /* link in ladish_meta_table::buckets */
+  bool project;
+  char * key;                       /* studio name or project dir */
+  char * path;                      /* path of the xml file */
+  int wd;                           /* inotify watch of the project dir, -1 for studios */
+  bool stale;                       /* needs rescan */
+  bool seen;                        /* used when rescanning the studios dir */
+
+  /* scan results */
+  bool present;                     /* xml file exists and is regular file */
+  int error;                        /* errno of the last failed syscall, 0 on success */
+  bool parse_failed;
+  char * name;                      /* project name from the xml file */
+  char * description;               /* project description from the xml file */
+  uint32_t modtime;
+  uint32_t app_count;
+};
+
+struct ladish_meta_table
+{
+  struct list_head entries;         /* projects are in least recently queried first order */
+  size_t count;
+  struct hlist_head buckets[META_INDEX_HASH_SIZE];
+};
+
+struct ladish_meta_parse_context
+{
+  XML_Parser parser;
+  struct ladish_meta_entry * entry_ptr;
+  bool in_description;
+  size_t description_len;
+  bool oom;
+};
+
+struct ladish_meta_scan_batch
+{
+  struct ladish_meta_entry ** entries;
+  size_t count;
+  size_t next;
+};
+
+static struct ladish_meta_table g_studios;
+static struct ladish_meta_table g_projects;
+static int g_inotify_fd = -1;
+static int g_studios_wd = -1;
+
+static void ladish_meta_table_init(struct ladish_meta_table * table_ptr)
+{
+  size_t i;
+
+  INIT_LIST_HEAD(&table_ptr->entries);
+  table_ptr->count = 0;
+  for (i = 0; i < META_INDEX_HASH_SIZE; i++)
+  {
+    INIT_HLIST_HEAD(table_ptr->buckets + i);
+  }
+}
+
+static struct ladish_meta_entry * ladish_meta_table_find(struct ladish_meta_table * table_ptr, const char * key)
+{
+  struct hlist_head * bucket_ptr;
+  struct hlist_node * node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+
+  bucket_ptr = table_ptr->buckets + ladish_hash_bucket(ladish_hash_string(key), META_INDEX_HASH_SIZE);
+  hlist_for_each_entry(entry_ptr, node_ptr, bucket_ptr, hash_siblings)
+  {
+    if (strcmp(entry_ptr->key, key) == 0)
+    {
+      return entry_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static void ladish_meta_entry_clear_results(struct ladish_meta_entry * entry_ptr)
+{
+  free(entry_ptr->name);
+  entry_ptr->name = NULL;
+  free(entry_ptr->description);
+  entry_ptr->description = NULL;
+
+  entry_ptr->present = false;
+  entry_ptr->error = 0;
+  entry_ptr->parse_failed = false;
+  entry_ptr->modtime = 0;
+  entry_ptr->app_count = 0;
+}
+
+static
+struct ladish_meta_entry *
+ladish_meta_entry_create(
+  struct ladish_meta_table * table_ptr,
+  bool project,
+  const char * key,
+  char * path)
+{
+  struct ladish_meta_entry * entry_ptr;
+
+  entry_ptr = malloc(sizeof(struct ladish_meta_entry));
+  if (entry_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate struct ladish_meta_entry");
+    return NULL;
+  }
+
+  entry_ptr->key = strdup(key);
+  if (entry_ptr->key == NULL)
+  {
+    log_error("strdup() failed for metadata index key '%s'", key);
+    free(entry_ptr);
+    return NULL;
+  }
+
+  entry_ptr->project = project;
+  entry_ptr->path = path;
+  entry_ptr->wd = -1;
+  entry_ptr->stale = true;
+  entry_ptr->seen = true;
+  entry_ptr->name = NULL;
+  entry_ptr->description = NULL;
+  ladish_meta_entry_clear_results(entry_ptr);
+
+  list_add_tail(&entry_ptr->siblings, &table_ptr->entries);
+  table_ptr->count++;
+  hlist_add_head(
+    &entry_ptr->hash_siblings,
+    table_ptr->buckets + ladish_hash_bucket(ladish_hash_string(key), META_INDEX_HASH_SIZE));
+
+  return entry_ptr;
+}
+
+static void ladish_meta_entry_destroy(struct ladish_meta_entry * entry_ptr)
+{
+  list_del(&entry_ptr->siblings);
+  hlist_del(&entry_ptr->hash_siblings);
+  (entry_ptr->project ? &g_projects : &g_studios)->count--;
+
+  ladish_meta_entry_clear_results(entry_ptr);
+  free(entry_ptr->path);
+  free(entry_ptr->key);
+  free(entry_ptr);
+}
+
+static void ladish_meta_table_clear(struct ladish_meta_table * table_ptr)
+{
+  while (!list_empty(&table_ptr->entries))
+  {
+    ladish_meta_entry_destroy(list_entry(table_ptr->entries.next, struct ladish_meta_entry, siblings));
+  }
+}
+
+/**********************************************************************************/
+/* scan, called from worker threads; must not touch anything but the entry        */
+/**********************************************************************************/
+
+#define context_ptr ((struct ladish_meta_parse_context *)data)
+
+static void ladish_meta_elstart_callback(void * data, const char * el, const char ** attr)
+{
+  size_t len;
+
+  if (strcmp(el, "application") == 0)
+  {
+    context_ptr->entry_ptr->app_count++;
+    return;
+  }
+
+  if (!context_ptr->entry_ptr->project)
+  {
+    return;
+  }
+
+  if (strcmp(el, "project") == 0 && context_ptr->entry_ptr->name == NULL)
+  {
+    for (; attr[0] != NULL; attr += 2)
+    {
+      if (strcmp(attr[0], "name") == 0)
+      {
+        len = strlen(attr[1]) + 1;
+        context_ptr->entry_ptr->name = malloc(len);
+        if (context_ptr->entry_ptr->name == NULL)
+        {
+          context_ptr->oom = true;
+          XML_StopParser(context_ptr->parser, XML_FALSE);
+          return;
+        }
+
+        context_ptr->entry_ptr->name[unescape(attr[1], len, context_ptr->entry_ptr->name)] = 0;
+        break;
+      }
+    }
+
+    return;
+  }
+
+  if (strcmp(el, "description") == 0 && context_ptr->entry_ptr->description == NULL)
+  {
+    context_ptr->in_description = true;
+    context_ptr->description_len = 0;
+  }
+}
+
+static void ladish_meta_elend_callback(void * data, const char * el)
+{
+  char * description;
+
+  if (!context_ptr->in_description || strcmp(el, "description") != 0)
+  {
+    return;
+  }
+
+  context_ptr->in_description = false;
+
+  description = context_ptr->entry_ptr->description;
+  if (description != NULL)
+  {
+    description[unescape(description, context_ptr->description_len, description)] = 0;
+  }
+}
+
+static void ladish_meta_chardata_callback(void * data, const XML_Char * s, int len)
+{
+  char * description;
+
+  if (!context_ptr->in_description)
+  {
+    return;
+  }
+
+  description = realloc(context_ptr->entry_ptr->description, context_ptr->description_len + len + 1);
+  if (description == NULL)
+  {
+    context_ptr->oom = true;
+    XML_StopParser(context_ptr->parser, XML_FALSE);
+    return;
+  }
+
+  memcpy(description + context_ptr->description_len, s, len);
+  context_ptr->description_len += len;
+  description[context_ptr->description_len] = 0;
+  context_ptr->entry_ptr->description = description;
+}
+
+#undef context_ptr
+
+static void ladish_meta_entry_scan(struct ladish_meta_entry * entry_ptr)
+{
+  struct stat st;
+  int fd;
+  void * buffer;
+  ssize_t bytes_read;
+  struct ladish_meta_parse_context parse_context;
+
+  ladish_meta_entry_clear_results(entry_ptr);
+  entry_ptr->stale = false;
+
+  if (stat(entry_ptr->path, &st) != 0)
+  {
+    entry_ptr->error = errno;
+    return;
+  }
+
+  if (!S_ISREG(st.st_mode))
+  {
+    return;
+  }
+
+  entry_ptr->present = true;
+  entry_ptr->modtime = st.st_mtime;
+
+  fd = open(entry_ptr->path, O_RDONLY);
+  if (fd == -1)
+  {
+    entry_ptr->error = errno;
+    return;
+  }
+
+  parse_context.parser = XML_ParserCreate(NULL);
+  if (parse_context.parser == NULL)
+  {
+    entry_ptr->error = ENOMEM;
+    goto close;
+  }
+
+  parse_context.entry_ptr = entry_ptr;
+  parse_context.in_description = false;
+  parse_context.description_len = 0;
+  parse_context.oom = false;
+
+  XML_SetUserData(parse_context.parser, &parse_context);
+  XML_SetElementHandler(parse_context.parser, ladish_meta_elstart_callback, ladish_meta_elend_callback);
+  XML_SetCharacterDataHandler(parse_context.parser, ladish_meta_chardata_callback);
+
+  /* we are expecting that xml file has small enough size to fit in memory */
+
+  buffer = XML_GetBuffer(parse_context.parser, st.st_size);
+  if (buffer == NULL)
+  {
+    entry_ptr->error = ENOMEM;
+    goto free_parser;
+  }
+
+  bytes_read = read(fd, buffer, st.st_size);
+  if (bytes_read != st.st_size)
+  {
+    entry_ptr->error = bytes_read == -1 ? errno : EIO;
+    goto free_parser;
+  }
+
+  if (XML_ParseBuffer(parse_context.parser, bytes_read, XML_TRUE) == XML_STATUS_ERROR)
+  {
+    entry_ptr->parse_failed = !parse_context.oom;
+    entry_ptr->error = parse_context.oom ? ENOMEM : 0;
+  }
+
+free_parser:
+  XML_ParserFree(parse_context.parser);
+close:
+  close(fd);
+}
+
+static void * ladish_meta_scan_thread(void * arg)
+{
+  struct ladish_meta_scan_batch * batch_ptr;
+  size_t index;
+
+  batch_ptr = arg;
+
+  while ((index = __sync_fetch_and_add(&batch_ptr->next, 1)) < batch_ptr->count)
+  {
+    ladish_meta_entry_scan(batch_ptr->entries[index]);
+  }
+
+  return NULL;
+}
+
+/**********************************************************************************/
+/* main thread                                                                    */
+/**********************************************************************************/
+
+static size_t ladish_meta_table_collect_stale(struct ladish_meta_table * table_ptr, struct ladish_meta_entry ** entries)
+{
+  struct list_head * node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+  size_t count;
+
+  count = 0;
+
+  list_for_each(node_ptr, &table_ptr->entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct ladish_meta_entry, siblings);
+    if (entry_ptr->stale)
+    {
+      if (entries != NULL)
+      {
+        entries[count] = entry_ptr;
+      }
+
+      count++;
+    }
+  }
+
+  return count;
+}
+
+static void ladish_meta_scan_batch_run(struct ladish_meta_scan_batch * batch_ptr)
+{
+  pthread_t threads[META_INDEX_MAX_THREADS - 1];
+  size_t threads_count;
+  size_t i;
+  int ret;
+
+  batch_ptr->next = 0;
+
+  threads_count = ladish_min(batch_ptr->count, META_INDEX_MAX_THREADS) - 1;
+  for (i = 0; i < threads_count; i++)
+  {
+    ret = pthread_create(threads + i, NULL, ladish_meta_scan_thread, batch_ptr);
+    if (ret != 0)
+    {
+      log_error("pthread_create() failed for metadata scan thread: %d (%s)", ret, strerror(ret));
+      break;
+    }
+  }
+
+  threads_count = i;
+
+  /* the main thread is one of the workers */
+  ladish_meta_scan_thread(batch_ptr);
+
+  for (i = 0; i < threads_count; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+static void ladish_meta_index_drop_project(struct ladish_meta_entry * entry_ptr)
+{
+  struct list_head * node_ptr;
+  int wd;
+
+  wd = entry_ptr->wd;
+  ladish_meta_entry_destroy(entry_ptr);
+
+  if (wd == -1 || g_inotify_fd == -1)
+  {
+    return;
+  }
+
+  /* same dir can be reached through different paths */
+  list_for_each(node_ptr, &g_projects.entries)
+  {
+    if (list_entry(node_ptr, struct ladish_meta_entry, siblings)->wd == wd)
+    {
+      return;
+    }
+  }
+
+  if (inotify_rm_watch(g_inotify_fd, wd) != 0)
+  {
+    log_error("inotify_rm_watch() failed: %d (%s)", errno, strerror(errno));
+  }
+}
+
+static void ladish_meta_index_refresh(void)
+{
+  struct ladish_meta_scan_batch batch;
+  struct ladish_meta_entry * entry_ptr;
+  size_t studios_count;
+  size_t i;
+
+  studios_count = ladish_meta_table_collect_stale(&g_studios, NULL);
+  batch.count = studios_count + ladish_meta_table_collect_stale(&g_projects, NULL);
+  if (batch.count == 0)
+  {
+    return;
+  }
+
+  batch.entries = malloc(batch.count * sizeof(struct ladish_meta_entry *));
+  if (batch.entries == NULL)
+  {
+    log_error("malloc() failed to allocate array of %zu metadata index entries", batch.count);
+    return;
+  }
+
+  ladish_meta_table_collect_stale(&g_studios, batch.entries);
+  ladish_meta_table_collect_stale(&g_projects, batch.entries + studios_count);
+
+  ladish_meta_scan_batch_run(&batch);
+
+  for (i = 0; i < batch.count; i++)
+  {
+    entry_ptr = batch.entries[i];
+
+    if (entry_ptr->error != 0 && entry_ptr->error != ENOENT)
+    {
+      log_error("failed to scan '%s': %d (%s)", entry_ptr->path, entry_ptr->error, strerror(entry_ptr->error));
+    }
+    else if (entry_ptr->parse_failed)
+    {
+      log_error("failed to parse '%s'", entry_ptr->path);
+    }
+
+    if (!entry_ptr->project && !entry_ptr->present)
+    {
+      ladish_meta_entry_destroy(entry_ptr);
+    }
+    else if (entry_ptr->project && entry_ptr->error == ENOENT)
+    {
+      ladish_meta_index_drop_project(entry_ptr);
+    }
+  }
+
+  free(batch.entries);
+}
+
+static void ladish_meta_index_studio_file_changed(const char * filename, bool removed)
+{
+  size_t len;
+  char * name;
+  char * path;
+  struct ladish_meta_entry * entry_ptr;
+
+  len = strlen(filename);
+  if (len <= 4 || strcmp(filename + (len - 4), ".xml") != 0)
+  {
+    return;
+  }
+
+  name = malloc(len - 4 + 1);
+  if (name == NULL)
+  {
+    log_error("malloc() failed.");
+    return;
+  }
+
+  name[unescape(filename, len - 4, name)] = 0;
+
+  entry_ptr = ladish_meta_table_find(&g_studios, name);
+  if (entry_ptr != NULL)
+  {
+    if (removed)
+    {
+      ladish_meta_entry_destroy(entry_ptr);
+    }
+    else
+    {
+      entry_ptr->stale = true;
+      entry_ptr->seen = true;
+    }
+  }
+  else if (!removed)
+  {
+    path = catdup(g_studios_dir, filename);
+    if (path == NULL)
+    {
+      log_error("catdup() failed to compose path of studio '%s'", name);
+    }
+    else if (ladish_meta_entry_create(&g_studios, false, name, path) == NULL)
+    {
+      free(path);
+    }
+  }
+
+  free(name);
+}
+
+static bool ladish_meta_index_rescan_studios_dir(void)
+{
+  DIR * dir;
+  struct dirent * dentry;
+  struct list_head * node_ptr;
+  struct list_head * temp_node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+  int err;
+
+  dir = opendir(g_studios_dir);
+  if (dir == NULL)
+  {
+    err = errno;
+    log_error("Cannot open directory '%s': %d (%s)", g_studios_dir, err, strerror(err));
+    errno = err;
+    return false;
+  }
+
+  list_for_each(node_ptr, &g_studios.entries)
+  {
+    list_entry(node_ptr, struct ladish_meta_entry, siblings)->seen = false;
+  }
+
+  while ((dentry = readdir(dir)) != NULL)
+  {
+    ladish_meta_index_studio_file_changed(dentry->d_name, false);
+  }
+
+  closedir(dir);
+
+  list_for_each_safe(node_ptr, temp_node_ptr, &g_studios.entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct ladish_meta_entry, siblings);
+    if (!entry_ptr->seen)
+    {
+      ladish_meta_entry_destroy(entry_ptr);
+    }
+  }
+
+  return true;
+}
+
+static void ladish_meta_index_invalidate_projects(int wd)
+{
+  struct list_head * node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+
+  list_for_each(node_ptr, &g_projects.entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct ladish_meta_entry, siblings);
+    if (wd == -1 || entry_ptr->wd == wd)
+    {
+      entry_ptr->stale = true;
+    }
+  }
+}
+
+static void ladish_meta_index_forget_project_watch(int wd)
+{
+  struct list_head * node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+
+  list_for_each(node_ptr, &g_projects.entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct ladish_meta_entry, siblings);
+    if (entry_ptr->wd == wd)
+    {
+      entry_ptr->wd = -1;
+      entry_ptr->stale = true;
+    }
+  }
+}
+
+static void ladish_meta_index_handle_event(const struct inotify_event * event_ptr)
+{
+  if ((event_ptr->mask & IN_Q_OVERFLOW) != 0)
+  {
+    log_info("inotify queue overflow, rescanning studios and projects");
+    ladish_meta_index_rescan_studios_dir();
+    ladish_meta_index_invalidate_projects(-1);
+    return;
+  }
+
+  if (event_ptr->wd == g_studios_wd)
+  {
+    if ((event_ptr->mask & IN_IGNORED) != 0)
+    {
+      log_error("studios directory '%s' is not watched anymore", g_studios_dir);
+      g_studios_wd = -1;
+      return;
+    }
+
+    if (event_ptr->len == 0)
+    {
+      return;
+    }
+
+    ladish_meta_index_studio_file_changed(event_ptr->name, (event_ptr->mask & (IN_DELETE | IN_MOVED_FROM)) != 0);
+    return;
+  }
+
+  if ((event_ptr->mask & IN_IGNORED) != 0)
+  {
+    ladish_meta_index_forget_project_watch(event_ptr->wd);
+    return;
+  }
+
+  if (event_ptr->len == 0 || strcmp(event_ptr->name, LADISH_PROJECT_FILENAME + 1) == 0)
+  {
+    ladish_meta_index_invalidate_projects(event_ptr->wd);
+  }
+}
+
+/* without inotify (or after the studios dir watch is lost) the index cannot be trusted */
+static bool ladish_meta_index_trusted(void)
+{
+  return g_inotify_fd != -1 && g_studios_wd != -1;
+}
+
+static void ladish_meta_index_watch_project(struct ladish_meta_entry * entry_ptr)
+{
+  if (g_inotify_fd == -1)
+  {
+    return;
+  }
+
+  entry_ptr->wd = inotify_add_watch(g_inotify_fd, entry_ptr->key, META_INDEX_PROJECT_WATCH_MASK);
+  if (entry_ptr->wd == -1 && errno != ENOENT)
+  {
+    log_error("inotify_add_watch() failed for project dir '%s': %d (%s)", entry_ptr->key, errno, strerror(errno));
+  }
+}
+
+static struct ladish_meta_entry * ladish_meta_index_add_project(const char * project_dir)
+{
+  char * path;
+  struct ladish_meta_entry * entry_ptr;
+
+  path = catdup(project_dir, LADISH_PROJECT_FILENAME);
+  if (path == NULL)
+  {
+    log_error("catdup() failed to compose xml file path");
+    return NULL;
+  }
+
+  entry_ptr = ladish_meta_entry_create(&g_projects, true, project_dir, path);
+  if (entry_ptr == NULL)
+  {
+    free(path);
+    return NULL;
+  }
+
+  ladish_meta_index_watch_project(entry_ptr);
+  return entry_ptr;
+}
+
+static bool ladish_meta_index_prefetch_project(void * UNUSED(context), const char * project_dir)
+{
+  if (ladish_meta_table_find(&g_projects, project_dir) == NULL)
+  {
+    ladish_meta_index_add_project(project_dir);
+  }
+
+  return true;
+}
+
+bool ladish_meta_index_init(void)
+{
+  ladish_meta_table_init(&g_studios);
+  ladish_meta_table_init(&g_projects);
+
+  g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (g_inotify_fd == -1)
+  {
+    log_error("inotify_init1() failed: %d (%s). Studio and project lists will not be cached.", errno, strerror(errno));
+  }
+  else
+  {
+    g_studios_wd = inotify_add_watch(g_inotify_fd, g_studios_dir, META_INDEX_STUDIOS_WATCH_MASK);
+    if (g_studios_wd == -1)
+    {
+      log_error("inotify_add_watch() failed for '%s': %d (%s). Studio list will not be cached.", g_studios_dir, errno, strerror(errno));
+    }
+  }
+
+  ladish_meta_index_rescan_studios_dir();
+  ladish_recent_projects_iterate(NULL, ladish_meta_index_prefetch_project);
+  ladish_meta_index_refresh();
+
+  return true;
+}
+
+void ladish_meta_index_uninit(void)
+{
+  ladish_meta_table_clear(&g_studios);
+  ladish_meta_table_clear(&g_projects);
+
+  if (g_inotify_fd != -1)
+  {
+    close(g_inotify_fd);         /* this removes all watches */
+    g_inotify_fd = -1;
+    g_studios_wd = -1;
+  }
+}
+
+void ladish_meta_index_run(void)
+{
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  const char * ptr;
+  const struct inotify_event * event_ptr;
+
+  if (g_inotify_fd == -1)
+  {
+    return;
+  }
+
+  while ((len = read(g_inotify_fd, buffer, sizeof(buffer))) > 0)
+  {
+    for (ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event_ptr->len)
+    {
+      event_ptr = (const struct inotify_event *)ptr;
+      ladish_meta_index_handle_event(event_ptr);
+    }
+  }
+
+  if (len == -1 && errno != EAGAIN)
+  {
+    log_error("read() from inotify fd failed: %d (%s)", errno, strerror(errno));
+  }
+
+  ladish_meta_index_refresh();
+}
+
+static void ladish_meta_entry_get_info(struct ladish_meta_entry * entry_ptr, struct ladish_meta_info * info_ptr)
+{
+  info_ptr->name = entry_ptr->project ? entry_ptr->name : entry_ptr->key;
+  info_ptr->description = entry_ptr->description;
+  info_ptr->modtime = entry_ptr->modtime;
+  info_ptr->app_count = entry_ptr->app_count;
+}
+
+bool
+ladish_meta_index_iterate_studios(
+  void * context,
+  bool (* callback)(void * context, const struct ladish_meta_info * info_ptr))
+{
+  struct list_head * node_ptr;
+  struct ladish_meta_entry * entry_ptr;
+  struct ladish_meta_info info;
+
+  if (!ladish_meta_index_trusted() && !ladish_meta_index_rescan_studios_dir())
+  {
+    return false;
+  }
+
+  ladish_meta_index_refresh();
+
+  list_for_each(node_ptr, &g_studios.entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct ladish_meta_entry, siblings);
+    ladish_meta_entry_get_info(entry_ptr, &info);
+    if (!callback(context, &info))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ladish_meta_index_get_studio(const char * studio_name, struct ladish_meta_info * info_ptr)
+{
+  struct ladish_meta_entry * entry_ptr;
+  char * path;
+
+  entry_ptr = ladish_meta_table_find(&g_studios, studio_name);
+  if (entry_ptr == NULL && !ladish_meta_index_trusted())
+  {
+    if (!ladish_studio_compose_filename(studio_name, &path, NULL))
+    {
+      return false;
+    }
+
+    entry_ptr = ladish_meta_entry_create(&g_studios, false, studio_name, path);
+    if (entry_ptr == NULL)
+    {
+      free(path);
+      return false;
+    }
+  }
+
+  if (entry_ptr == NULL)
+  {
+    return false;
+  }
+
+  if (entry_ptr->stale || !ladish_meta_index_trusted())
+  {
+    ladish_meta_entry_scan(entry_ptr);
+    if (!entry_ptr->present)
+    {
+      ladish_meta_entry_destroy(entry_ptr);
+      return false;
+    }
+  }
+
+  ladish_meta_entry_get_info(entry_ptr, info_ptr);
+  return true;
+}
+
+bool ladish_meta_index_get_project(const char * project_dir, struct ladish_meta_info * info_ptr)
+{
+  struct ladish_meta_entry * entry_ptr;
+
+  entry_ptr = ladish_meta_table_find(&g_projects, project_dir);
+  if (entry_ptr == NULL)
+  {
+    entry_ptr = ladish_meta_index_add_project(project_dir);
+    if (entry_ptr == NULL)
+    {
+      return false;
+    }
+
+    while (g_projects.count > META_INDEX_MAX_PROJECTS)
+    {
+      ladish_meta_index_drop_project(list_entry(g_projects.entries.next, struct ladish_meta_entry, siblings));
+    }
+  }
+  else
+  {
+    list_move_tail(&entry_ptr->siblings, &g_projects.entries);
+
+    if (entry_ptr->wd == -1)
+    {
+      /* the dir was moved or did not exist when the entry was created */
+      ladish_meta_index_watch_project(entry_ptr);
+      entry_ptr->stale = true;
+    }
+  }
+
+  if (entry_ptr->stale || entry_ptr->wd == -1)
+  {
+    ladish_meta_entry_scan(entry_ptr);
+    if (entry_ptr->error == ENOENT)
+    {
+      ladish_meta_index_drop_project(entry_ptr);
+      return false;
+    }
+
+    if (entry_ptr->error != 0)
+    {
+      log_error("failed to scan '%s': %d (%s)", entry_ptr->path, entry_ptr->error, strerror(entry_ptr->error));
+    }
+  }
+
+  ladish_meta_entry_get_info(entry_ptr, info_ptr);
+  return entry_ptr->present;
+}
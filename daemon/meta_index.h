@@ -0,0 +1,54 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the studio and project metadata index
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef META_INDEX_H__1F0D8A43_55C2_4B0E_A2B8_93D8C4E0F1A7__INCLUDED
+#define META_INDEX_H__1F0D8A43_55C2_4B0E_A2B8_93D8C4E0F1A7__INCLUDED
+
+#include "common.h"
+
+/* Strings are owned by the index and stay valid until control returns to the main loop */
+struct ladish_meta_info
+{
+  const char * name;            /* studio name or project name */
+  const char * description;     /* project description, NULL for studios */
+  uint32_t modtime;             /* modification time of the xml file */
+  uint32_t app_count;           /* number of applications stored in the xml file */
+};
+
+bool ladish_meta_index_init(void);
+void ladish_meta_index_uninit(void);
+void ladish_meta_index_run(void);
+
+/* When the studios dir cannot be read, false is returned and errno is set */
+bool
+ladish_meta_index_iterate_studios(
+  void * context,
+  bool (* callback)(void * context, const struct ladish_meta_info * info_ptr));
+
+bool ladish_meta_index_get_studio(const char * studio_name, struct ladish_meta_info * info_ptr);
+bool ladish_meta_index_get_project(const char * project_dir, struct ladish_meta_info * info_ptr);
+
+#endif /* #ifndef META_INDEX_H__1F0D8A43_55C2_4B0E_A2B8_93D8C4E0F1A7__INCLUDED */
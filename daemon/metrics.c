@@ -0,0 +1,558 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the daemon metrics D-Bus interface
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "common.h"
+#include "metrics.h"
+#include "graph.h"
+#include "loader.h"
+#include "cmd.h"
+#include "studio.h"
+#include "../dbus_constants.h"
+
+#define MAX_COMMAND_TYPES 32
+
+#define GRAPH_METRIC_SIGNALS     0
+#define GRAPH_METRIC_CLIENTS     1
+#define GRAPH_METRIC_PORTS       2
+#define GRAPH_METRIC_CONNECTIONS 3
+
+struct ladish_metrics_command
+{
+  const char * name;
+  uint64_t failures;
+  uint64_t coalesced;
+  struct ladish_histogram wait;
+  struct ladish_histogram latency;
+};
+
+/* Metrics are written as Prometheus samples, "name{labels} value" */
+struct ladish_metrics_writer
+{
+  void * context;
+  void (* family)(void * context, const char * name, const char * type, const char * help);
+  void (* sample)(void * context, const char * name, const char * labels, uint64_t value);
+};
+
+struct ladish_metrics_graph_context
+{
+  const struct ladish_metrics_writer * writer_ptr;
+  unsigned int metric;
+};
+
+static struct ladish_histogram g_main_loop;
+static struct ladish_metrics_command g_commands[MAX_COMMAND_TYPES];
+static unsigned int g_commands_count;
+
+void ladish_metrics_main_loop_iteration(uint64_t usecs)
+{
+  ladish_histogram_add(&g_main_loop, usecs);
+}
+
+static struct ladish_metrics_command * ladish_metrics_find_command(const char * name)
+{
+  unsigned int i;
+
+  for (i = 0; i < g_commands_count; i++)
+  {
+    if (strcmp(g_commands[i].name, name) == 0)
+    {
+      return g_commands + i;
+    }
+  }
+
+  if (g_commands_count == MAX_COMMAND_TYPES)
+  {
+    ASSERT_NO_PASS;
+    return NULL;
+  }
+
+  g_commands[g_commands_count].name = name;
+  return g_commands + g_commands_count++;
+}
+
+void ladish_metrics_command_started(const char * name, uint64_t usecs)
+{
+  struct ladish_metrics_command * command_ptr;
+
+  command_ptr = ladish_metrics_find_command(name != NULL ? name : "unknown");
+  if (command_ptr == NULL)
+  {
+    return;
+  }
+
+  ladish_histogram_add(&command_ptr->wait, usecs);
+}
+
+void ladish_metrics_command_done(const char * name, uint64_t usecs, bool success)
+{
+  struct ladish_metrics_command * command_ptr;
+
+  command_ptr = ladish_metrics_find_command(name != NULL ? name : "unknown");
+  if (command_ptr == NULL)
+  {
+    return;
+  }
+
+  ladish_histogram_add(&command_ptr->latency, usecs);
+  if (!success)
+  {
+    command_ptr->failures++;
+  }
+}
+
+void ladish_metrics_command_coalesced(const char * name)
+{
+  struct ladish_metrics_command * command_ptr;
+
+  command_ptr = ladish_metrics_find_command(name != NULL ? name : "unknown");
+  if (command_ptr == NULL)
+  {
+    return;
+  }
+
+  command_ptr->coalesced++;
+}
+
+/* Writes name="value" with the value escaped per the Prometheus text format; truncates on overflow */
+static
+void
+ladish_metrics_format_label(
+  char * buffer,
+  size_t size,
+  const char * name,
+  const char * value)
+{
+  size_t len;
+  const char * escape;
+  size_t escape_len;
+
+  ASSERT(size > 0);
+
+  len = (size_t)snprintf(buffer, size, "%s=\"", name);
+  if (len + 2 > size)
+  {
+    buffer[0] = 0;
+    return;
+  }
+
+  for (; *value != 0; value++)
+  {
+    switch (*value)
+    {
+    case '\\':
+      escape = "\\\\";
+      break;
+    case '"':
+      escape = "\\\"";
+      break;
+    case '\n':
+      escape = "\\n";
+      break;
+    default:
+      escape = NULL;
+    }
+
+    escape_len = escape != NULL ? 2 : 1;
+
+    /* keep room for the closing quote and the terminator */
+    if (len + escape_len + 2 > size)
+    {
+      break;
+    }
+
+    if (escape != NULL)
+    {
+      memcpy(buffer + len, escape, 2);
+    }
+    else
+    {
+      buffer[len] = *value;
+    }
+
+    len += escape_len;
+  }
+
+  buffer[len++] = '"';
+  buffer[len] = 0;
+}
+
+static
+void
+ladish_metrics_write_histogram(
+  const struct ladish_metrics_writer * writer_ptr,
+  const char * name,
+  const char * labels,
+  const struct ladish_histogram * histogram_ptr)
+{
+  char sample_name[128];
+  char sample_labels[320];       /* labels (up to 256) plus the le label */
+  char bound_str[32];
+  uint64_t bound;
+  uint64_t cumulative;
+  unsigned int i;
+
+  snprintf(sample_name, sizeof(sample_name), "%s_bucket", name);
+
+  cumulative = 0;
+  for (i = 0; i < LADISH_HISTOGRAM_BUCKETS; i++)
+  {
+    cumulative += histogram_ptr->buckets[i];
+
+    bound = ladish_histogram_bucket_bound(i);
+    if (bound == UINT64_MAX)
+    {
+      strcpy(bound_str, "+Inf");
+    }
+    else
+    {
+      snprintf(bound_str, sizeof(bound_str), "%" PRIu64, bound);
+    }
+
+    snprintf(sample_labels, sizeof(sample_labels), "%s%sle=\"%s\"", labels, *labels != 0 ? "," : "", bound_str);
+    writer_ptr->sample(writer_ptr->context, sample_name, sample_labels, cumulative);
+  }
+
+  snprintf(sample_name, sizeof(sample_name), "%s_sum", name);
+  writer_ptr->sample(writer_ptr->context, sample_name, labels, histogram_ptr->sum);
+
+  snprintf(sample_name, sizeof(sample_name), "%s_count", name);
+  writer_ptr->sample(writer_ptr->context, sample_name, labels, histogram_ptr->count);
+}
+
+#define graph_context_ptr ((struct ladish_metrics_graph_context *)context)
+
+static void ladish_metrics_write_graph(void * context, const struct ladish_graph_metrics * metrics_ptr)
+{
+  char labels[256];
+  uint64_t value;
+
+  ladish_metrics_format_label(labels, sizeof(labels), "graph", metrics_ptr->opath != NULL ? metrics_ptr->opath : "JACK");
+
+  switch (graph_context_ptr->metric)
+  {
+  case GRAPH_METRIC_SIGNALS:
+    value = metrics_ptr->signals_emitted;
+    break;
+  case GRAPH_METRIC_CLIENTS:
+    value = metrics_ptr->clients;
+    break;
+  case GRAPH_METRIC_PORTS:
+    value = metrics_ptr->ports;
+    break;
+  case GRAPH_METRIC_CONNECTIONS:
+    value = metrics_ptr->connections;
+    break;
+  default:
+    ASSERT_NO_PASS;
+    return;
+  }
+
+  graph_context_ptr->writer_ptr->sample(graph_context_ptr->writer_ptr->context, NULL, labels, value);
+}
+
+#undef graph_context_ptr
+
+static
+void
+ladish_metrics_write_graphs(
+  const struct ladish_metrics_writer * writer_ptr,
+  const char * name,
+  const char * type,
+  const char * help,
+  unsigned int metric)
+{
+  struct ladish_metrics_graph_context context;
+
+  /* samples are written without name, the family one is used */
+  writer_ptr->family(writer_ptr->context, name, type, help);
+
+  context.writer_ptr = writer_ptr;
+  context.metric = metric;
+
+  ladish_graph_iterate_metrics(&context, ladish_metrics_write_graph);
+}
+
+static void ladish_metrics_write(const struct ladish_metrics_writer * writer_ptr)
+{
+  char labels[256];
+  unsigned int i;
+  unsigned int depth;
+  unsigned int waiting;
+
+  writer_ptr->family(writer_ptr->context, "ladish_main_loop_duration_microseconds", "histogram", "Duration of main loop iterations, excluding the wait for D-Bus messages");
+  ladish_metrics_write_histogram(writer_ptr, "ladish_main_loop_duration_microseconds", "", &g_main_loop);
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_latency_microseconds", "histogram", "Time from queueing a command to its completion");
+  for (i = 0; i < g_commands_count; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "command", g_commands[i].name);
+    ladish_metrics_write_histogram(writer_ptr, "ladish_command_latency_microseconds", labels, &g_commands[i].latency);
+  }
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_failures_total", "counter", "Commands that failed and halted the queue");
+  for (i = 0; i < g_commands_count; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "command", g_commands[i].name);
+    writer_ptr->sample(writer_ptr->context, "ladish_command_failures_total", labels, g_commands[i].failures);
+  }
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_wait_microseconds", "histogram", "Time from queueing a command to its first run");
+  for (i = 0; i < g_commands_count; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "command", g_commands[i].name);
+    ladish_metrics_write_histogram(writer_ptr, "ladish_command_wait_microseconds", labels, &g_commands[i].wait);
+  }
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_coalesced_total", "counter", "Commands merged into an identical pending command");
+  for (i = 0; i < g_commands_count; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "command", g_commands[i].name);
+    writer_ptr->sample(writer_ptr->context, "ladish_command_coalesced_total", labels, g_commands[i].coalesced);
+  }
+
+  depth = ladish_cqueue_get_count(ladish_studio_get_cmd_queue(), &waiting);
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_queue_depth", "gauge", "Commands in the studio command queue");
+  writer_ptr->sample(writer_ptr->context, "ladish_command_queue_depth", "", depth);
+
+  writer_ptr->family(writer_ptr->context, "ladish_command_queue_waiting", "gauge", "Queued commands that started and wait for an external event");
+  writer_ptr->sample(writer_ptr->context, "ladish_command_queue_waiting", "", waiting);
+
+  writer_ptr->family(writer_ptr->context, "ladish_dbus_call_latency_microseconds", "histogram", "Latency of synchronous D-Bus calls");
+  for (i = 0; i < LADISH_METRICS_PEER_COUNT; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "peer", g_ladish_metrics_peers[i].name);
+    ladish_metrics_write_histogram(writer_ptr, "ladish_dbus_call_latency_microseconds", labels, &g_ladish_metrics_peers[i].latency);
+  }
+
+  writer_ptr->family(writer_ptr->context, "ladish_dbus_call_errors_total", "counter", "Synchronous D-Bus calls that failed");
+  for (i = 0; i < LADISH_METRICS_PEER_COUNT; i++)
+  {
+    ladish_metrics_format_label(labels, sizeof(labels), "peer", g_ladish_metrics_peers[i].name);
+    writer_ptr->sample(writer_ptr->context, "ladish_dbus_call_errors_total", labels, g_ladish_metrics_peers[i].errors);
+  }
+
+  ladish_metrics_write_graphs(writer_ptr, "ladish_patchbay_signals_total", "counter", "Patchbay signals emitted", GRAPH_METRIC_SIGNALS);
+  ladish_metrics_write_graphs(writer_ptr, "ladish_graph_clients", "gauge", "Clients in graph", GRAPH_METRIC_CLIENTS);
+  ladish_metrics_write_graphs(writer_ptr, "ladish_graph_ports", "gauge", "Ports in graph", GRAPH_METRIC_PORTS);
+  ladish_metrics_write_graphs(writer_ptr, "ladish_graph_connections", "gauge", "Connections in graph", GRAPH_METRIC_CONNECTIONS);
+
+  writer_ptr->family(writer_ptr->context, "ladish_child_processes", "gauge", "Child processes started by the daemon");
+  writer_ptr->sample(writer_ptr->context, "ladish_child_processes", "", loader_get_app_count());
+
+  writer_ptr->family(writer_ptr->context, "ladish_log_lines_total", "counter", "Log lines written");
+  writer_ptr->sample(writer_ptr->context, "ladish_log_lines_total", "", ladish_log_get_line_count());
+}
+
+/* family name is remembered for samples written without name */
+struct ladish_metrics_text_context
+{
+  FILE * file;
+  const char * family;
+};
+
+#define text_context_ptr ((struct ladish_metrics_text_context *)context)
+
+static void ladish_metrics_text_family(void * context, const char * name, const char * type, const char * help)
+{
+  text_context_ptr->family = name;
+  fprintf(text_context_ptr->file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void ladish_metrics_text_sample(void * context, const char * name, const char * labels, uint64_t value)
+{
+  if (name == NULL)
+  {
+    name = text_context_ptr->family;
+  }
+
+  if (*labels != 0)
+  {
+    fprintf(text_context_ptr->file, "%s{%s} %" PRIu64 "\n", name, labels, value);
+  }
+  else
+  {
+    fprintf(text_context_ptr->file, "%s %" PRIu64 "\n", name, value);
+  }
+}
+
+#undef text_context_ptr
+
+struct ladish_metrics_dict_context
+{
+  DBusMessageIter * dict_iter_ptr;
+  const char * family;
+  bool error;
+};
+
+#define dict_context_ptr ((struct ladish_metrics_dict_context *)context)
+
+static void ladish_metrics_dict_family(void * context, const char * name, const char * UNUSED(type), const char * UNUSED(help))
+{
+  dict_context_ptr->family = name;
+}
+
+static void ladish_metrics_dict_sample(void * context, const char * name, const char * labels, uint64_t value)
+{
+  char key[512];
+  const char * key_ptr;
+  DBusMessageIter entry_iter;
+
+  if (dict_context_ptr->error)
+  {
+    return;
+  }
+
+  if (name == NULL)
+  {
+    name = dict_context_ptr->family;
+  }
+
+  if (*labels != 0)
+  {
+    snprintf(key, sizeof(key), "%s{%s}", name, labels);
+  }
+  else
+  {
+    snprintf(key, sizeof(key), "%s", name);
+  }
+
+  key_ptr = key;
+
+  if (!dbus_message_iter_open_container(dict_context_ptr->dict_iter_ptr, DBUS_TYPE_DICT_ENTRY, NULL, &entry_iter))
+  {
+    dict_context_ptr->error = true;
+    return;
+  }
+
+  if (!dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &key_ptr) ||
+      !dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_UINT64, &value))
+  {
+    dict_context_ptr->error = true;
+  }
+
+  if (!dbus_message_iter_close_container(dict_context_ptr->dict_iter_ptr, &entry_iter))
+  {
+    dict_context_ptr->error = true;
+  }
+}
+
+#undef dict_context_ptr
+
+/**********************************************************************************/
+/*                                D-Bus methods                                   */
+/**********************************************************************************/
+
+static void ladish_metrics_get_counters(struct cdbus_method_call * call_ptr)
+{
+  DBusMessageIter iter, dict_iter;
+  struct ladish_metrics_dict_context context;
+  struct ladish_metrics_writer writer;
+
+  call_ptr->reply = dbus_message_new_method_return(call_ptr->message);
+  if (call_ptr->reply == NULL)
+  {
+    goto fail;
+  }
+
+  dbus_message_iter_init_append(call_ptr->reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{st}", &dict_iter))
+  {
+    goto fail_unref;
+  }
+
+  context.dict_iter_ptr = &dict_iter;
+  context.family = NULL;
+  context.error = false;
+  writer.context = &context;
+  writer.family = ladish_metrics_dict_family;
+  writer.sample = ladish_metrics_dict_sample;
+
+  ladish_metrics_write(&writer);
+
+  if (!dbus_message_iter_close_container(&iter, &dict_iter) || context.error)
+  {
+    goto fail_unref;
+  }
+
+  return;
+
+fail_unref:
+  dbus_message_unref(call_ptr->reply);
+  call_ptr->reply = NULL;
+
+fail:
+  log_error("Ran out of memory trying to construct method return");
+}
+
+static void ladish_metrics_dump(struct cdbus_method_call * call_ptr)
+{
+  struct ladish_metrics_text_context context;
+  struct ladish_metrics_writer writer;
+  char * buffer;
+  size_t size;
+
+  buffer = NULL;
+  context.file = open_memstream(&buffer, &size);
+  if (context.file == NULL)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_FAILED, "open_memstream() failed: %d (%s)", errno, strerror(errno));
+    return;
+  }
+
+  context.family = NULL;
+  writer.context = &context;
+  writer.family = ladish_metrics_text_family;
+  writer.sample = ladish_metrics_text_sample;
+
+  ladish_metrics_write(&writer);
+
+  if (ferror(context.file) || fclose(context.file) != 0)
+  {
+    cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Failed to compose metrics text");
+    free(buffer);
+    return;
+  }
+
+  cdbus_method_return_new_single(call_ptr, DBUS_TYPE_STRING, &buffer);
+  free(buffer);
+}
+
+CDBUS_METHOD_ARGS_BEGIN(GetCounters, "Get values of all counters, histograms as cumulative buckets, sum and count")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("counters", "a{st}", "Sample name with Prometheus labels as key, sample value as value")
+CDBUS_METHOD_ARGS_END
+
+CDBUS_METHOD_ARGS_BEGIN(Dump, "Get all metrics in the Prometheus text exposition format")
+  CDBUS_METHOD_ARG_DESCRIBE_OUT("text", "s", "Metrics text")
+CDBUS_METHOD_ARGS_END
+
+CDBUS_METHODS_BEGIN
+  CDBUS_METHOD_DESCRIBE(GetCounters, ladish_metrics_get_counters)
+  CDBUS_METHOD_DESCRIBE(Dump, ladish_metrics_dump)
+CDBUS_METHODS_END
+
+CDBUS_INTERFACE_DEFAULT_HANDLER_METHODS_ONLY(g_iface_metrics, IFACE_METRICS)
@@ -0,0 +1,40 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the daemon metrics D-Bus interface
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef METRICS_H__FD7F6D0E_939D_440E_AAD7_B1899F1171C7__INCLUDED
+#define METRICS_H__FD7F6D0E_939D_440E_AAD7_B1899F1171C7__INCLUDED
+
+#include "common.h"
+#include "../common/metrics.h"
+
+extern const struct cdbus_interface_descriptor g_iface_metrics;
+
+void ladish_metrics_main_loop_iteration(uint64_t usecs);
+void ladish_metrics_command_started(const char * name, uint64_t usecs);
+void ladish_metrics_command_done(const char * name, uint64_t usecs, bool success);
+void ladish_metrics_command_coalesced(const char * name);
+
+#endif /* #ifndef METRICS_H__FD7F6D0E_939D_440E_AAD7_B1899F1171C7__INCLUDED */
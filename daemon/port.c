@@ -25,6 +25,7 @@
  */
 
 #include "port.h"
+#include "slab.h"
 
 /* JACK port */
 struct ladish_port
@@ -43,6 +44,8 @@ struct ladish_port
   ladish_dict_handle dict;
 };
 
+static struct ladish_slab g_port_slab = LADISH_SLAB_INITIALIZER("port", struct ladish_port);
+
 bool
 ladish_port_create(
   const uuid_t uuid_ptr,
@@ -51,17 +54,17 @@ ladish_port_create(
 {
   struct ladish_port * port_ptr;
 
-  port_ptr = malloc(sizeof(struct ladish_port));
+  port_ptr = ladish_slab_alloc(&g_port_slab);
   if (port_ptr == NULL)
   {
-    log_error("malloc() failed to allocate struct ladish_port");
+    log_error("ladish_slab_alloc() failed to allocate struct ladish_port");
     return false;
   }
 
   if (!ladish_dict_create(&port_ptr->dict))
   {
     log_error("ladish_dict_create() failed for port");
-    free(port_ptr);
+    ladish_slab_free(&g_port_slab, port_ptr);
     return false;
   }
 
@@ -100,7 +103,7 @@ void ladish_port_destroy(ladish_port_handle port_handle)
   log_info("port %p destroy", port_ptr);
   ASSERT(port_ptr->refcount == 0);
   ladish_dict_destroy(port_ptr->dict);
-  free(port_ptr);
+  ladish_slab_free(&g_port_slab, port_ptr);
 }
 
 ladish_dict_handle ladish_port_get_dict(ladish_port_handle port_handle)
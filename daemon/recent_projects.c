@@ -29,6 +29,7 @@
 #include "../common/catdup.h"
 #include "../dbus_constants.h"
 #include "room.h"
+#include "meta_index.h"
 
 #define RECENT_PROJECTS_STORE_FILE "recent_projects"
 #define RECENT_PROJECTS_STORE_MAX_ITEMS 50
@@ -68,6 +69,14 @@ void ladish_recent_project_use(const char * project_path)
   ladish_recent_store_use_item(g_recent_projects_store, project_path);
 }
 
+void
+ladish_recent_projects_iterate(
+  void * callback_context,
+  bool (* callback)(void * callback_context, const char * project_path))
+{
+  ladish_recent_store_iterate_items(g_recent_projects_store, callback_context, callback);
+}
+
 /**********************************************************************************/
 /*                                D-Bus methods                                   */
 /**********************************************************************************/
@@ -85,11 +94,15 @@ bool recent_projects_callback(void * callback_context, const char * project_path
 {
   DBusMessageIter struct_iter;
   DBusMessageIter dict_iter;
-  char * name;
+  struct ladish_meta_info info;
 
   ASSERT(ctx_ptr->max_items > 0);
 
-  name = ladish_get_project_name(project_path);
+  if (!ladish_meta_index_get_project(project_path, &info))
+  {
+    info.name = NULL;
+    info.description = NULL;
+  }
 
   if (!dbus_message_iter_open_container(&ctx_ptr->array_iter, DBUS_TYPE_STRUCT, NULL, &struct_iter))
   {
@@ -109,7 +122,13 @@ bool recent_projects_callback(void * callback_context, const char * project_path
     goto close_struct;
   }
 
-  if (!cdbus_maybe_add_dict_entry_string(&dict_iter, "name", name))
+  if (!cdbus_maybe_add_dict_entry_string(&dict_iter, "name", info.name))
+  {
+    ctx_ptr->error = true;
+    goto close_dict;
+  }
+
+  if (!cdbus_maybe_add_dict_entry_string(&dict_iter, "description", info.description))
   {
     ctx_ptr->error = true;
     goto close_dict;
@@ -128,8 +147,6 @@ close_struct:
   }
 
 exit:
-  free(name);                   /* safe if name is NULL */
-
   if (ctx_ptr->error)
   {
     return false;               /* stop the iteration if error occurs */
@@ -34,6 +34,11 @@ void ladish_recent_projects_uninit(void);
 
 void ladish_recent_project_use(const char * project_path);
 
+void
+ladish_recent_projects_iterate(
+  void * callback_context,
+  bool (* callback)(void * callback_context, const char * project_path));
+
 extern const struct cdbus_interface_descriptor g_iface_recent_items;
 
 #endif /* #ifndef RECENT_PROJECTS_H__51B24E64_1629_43A4_B312_14E84080E68E__INCLUDED */
@@ -37,38 +37,103 @@ struct ladish_recent_store
   char * path;
   unsigned int max_items;
   char ** items;
+  ladish_worker_job_handle save_job; /* not NULL while the file is being written */
+  bool dirty;                   /* items changed while the file was being written */
 };
 
 static
-void
-ladish_recent_store_save(
-  struct ladish_recent_store * store_ptr)
+bool
+ladish_recent_store_write(
+  struct ladish_recent_store * store_ptr,
+  int fd)
 {
   unsigned int i;
-  int fd;
-
-  fd = open(store_ptr->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-  if (fd == -1)
-  {
-    log_error("open(%s) failed: %d (%s)", store_ptr->path, errno, strerror(errno));
-    return;
-  }
 
   for (i = 0; i < store_ptr->max_items && store_ptr->items[i] != NULL; i++)
   {
     if (!ladish_write_string(fd, store_ptr->items[i]))
     {
       log_error("write to file '%s' failed", store_ptr->path);
-      break;
+      return false;
     }
 
     if (!ladish_write_string(fd, "\n"))
     {
       log_error("write to file '%s' failed", store_ptr->path);
-      break;
+      return false;
     }
   }
 
+  return true;
+}
+
+static
+void
+ladish_recent_store_save(
+  struct ladish_recent_store * store_ptr);
+
+#define store_ptr ((struct ladish_recent_store *)context)
+
+static void ladish_recent_store_save_complete(void * context, bool UNUSED(success))
+{
+  store_ptr->save_job = NULL;
+
+  if (store_ptr->dirty)
+  {
+    store_ptr->dirty = false;
+    ladish_recent_store_save(store_ptr);
+  }
+}
+
+#undef store_ptr
+
+/* The file is written by a worker thread. Items that change while it is
+ * being written are saved when it is done. */
+static
+void
+ladish_recent_store_save(
+  struct ladish_recent_store * store_ptr)
+{
+  int fd;
+
+  if (store_ptr->save_job != NULL)
+  {
+    store_ptr->dirty = true;
+    return;
+  }
+
+  fd = ladish_save_buffer_create("ladish-recent");
+  if (fd == -1)
+  {
+    return;
+  }
+
+  if (!ladish_recent_store_write(store_ptr, fd))
+  {
+    close(fd);
+    return;
+  }
+
+  /* fd is closed by ladish_save_file_async() */
+  ladish_save_file_async(fd, store_ptr->path, NULL, NULL, store_ptr, ladish_recent_store_save_complete, &store_ptr->save_job);
+}
+
+static
+void
+ladish_recent_store_save_sync(
+  struct ladish_recent_store * store_ptr)
+{
+  int fd;
+
+  fd = open(store_ptr->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1)
+  {
+    log_error("open(%s) failed: %d (%s)", store_ptr->path, errno, strerror(errno));
+    return;
+  }
+
+  ladish_recent_store_write(store_ptr, fd);
+
   close(fd);
 }
 
@@ -197,6 +262,8 @@ ladish_recent_store_create(
   }
 
   store_ptr->max_items = max_items;
+  store_ptr->save_job = NULL;
+  store_ptr->dirty = false;
 
   /* try to load items from file */
   ladish_recent_store_load(store_ptr);
@@ -221,6 +288,17 @@ ladish_recent_store_destroy(
 {
   unsigned int i;
 
+  if (store_ptr->save_job != NULL)
+  {
+    ladish_worker_wait(store_ptr->save_job);
+    ladish_worker_abandon(store_ptr->save_job);
+  }
+
+  if (store_ptr->dirty)
+  {
+    ladish_recent_store_save_sync(store_ptr);
+  }
+
   for (i = 0; i < store_ptr->max_items && store_ptr->items[i] != NULL; i++)
   {
     free(store_ptr->items[i]);
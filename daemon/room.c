@@ -289,6 +289,7 @@ ladish_room_create(
   room_ptr->project_dir = NULL;
   room_ptr->project_description = NULL;
   room_ptr->project_notes = NULL;
+  room_ptr->save_ctx_ptr = NULL;
   room_ptr->project_state = ROOM_PROJECT_STATE_UNLOADED;
 
   if (template != NULL)
@@ -381,6 +382,8 @@ void ladish_room_destroy(ladish_room_handle room_handle)
 {
   if (!room_ptr->template)
   {
+    ladish_room_drop_project_save(room_ptr, true);
+
     /* project has either both name and dir no none of them */
     ASSERT((room_ptr->project_dir == NULL && room_ptr->project_name == NULL) || (room_ptr->project_dir != NULL && room_ptr->project_name != NULL));
     free(room_ptr->project_dir);
@@ -569,7 +572,7 @@ void ladish_room_initiate_stop(ladish_room_handle room_handle, bool clear_persis
     return;
   }
 
-  ladish_graph_set_connection_handlers(room_ptr->graph, NULL, NULL, NULL);
+  ladish_graph_set_connection_handlers(room_ptr->graph, NULL, NULL, NULL, NULL);
 
   if (clear_persist)
   {
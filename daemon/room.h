@@ -31,6 +31,7 @@
 #include "graph.h"
 #include "app_supervisor.h"
 #include "virtualizer.h"
+#include "xml_document.h"
 
 typedef struct ladish_room_tag { int unused; } * ladish_room_handle;
 
@@ -96,9 +97,17 @@ ladish_room_save_project(
   void * context,
   ladish_room_save_complete_callback callback);
 
+/* The save complete callback will not be called */
+void ladish_room_abandon_project_save(ladish_room_handle room_handle);
+
 bool ladish_room_unload_project(ladish_room_handle room_handle);
-bool ladish_room_load_project(ladish_room_handle room_handle, const char * project_dir);
+bool ladish_room_load_project(ladish_room_handle room_handle, const char * project_dir, ladish_xml_document_handle document);
 
-char * ladish_get_project_name(const char * project_dir);
+bool
+ladish_read_project_async(
+  const char * project_dir,
+  void * context,
+  ladish_xml_document_callback callback,
+  ladish_worker_job_handle * job_handle_ptr);
 
 #endif /* #ifndef ROOM_H__9A1CF253_0A17_402A_BDF8_9BD72B467118__INCLUDED */
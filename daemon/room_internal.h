@@ -61,9 +61,11 @@ struct ladish_room
   char * project_name;
   char * project_description;
   char * project_notes;
+  struct ladish_room_save_context * save_ctx_ptr; /* not NULL while project is being saved */
 };
 
 void ladish_room_emit_project_properties_changed(struct ladish_room * room_ptr);
 void ladish_room_clear_project(struct ladish_room * room_ptr);
+void ladish_room_drop_project_save(struct ladish_room * room_ptr, bool room_destroyed);
 
 #endif /* #ifndef ROOM_INTERNAL_H__FAF5B68F_E419_442A_8F9B_C729BAC00422__INCLUDED */
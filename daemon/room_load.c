@@ -782,15 +782,8 @@ static void callback_elend(void * data, const char * UNUSED(el))
 
 #define room_ptr ((struct ladish_room *)room_handle)
 
-bool ladish_room_load_project(ladish_room_handle room_handle, const char * project_dir)
+bool ladish_room_load_project(ladish_room_handle room_handle, const char * project_dir, ladish_xml_document_handle document)
 {
-  char * path;
-  struct stat st;
-  XML_Parser parser;
-  int bytes_read;
-  void * buffer;
-  int fd;
-  enum XML_Status xmls;
   struct ladish_parse_context parse_context;
   bool ret;
 
@@ -811,54 +804,12 @@ bool ladish_room_load_project(ladish_room_handle room_handle, const char * proje
     goto exit;
   }
 
-  path = catdup(project_dir, LADISH_PROJECT_FILENAME);
-  if (path == NULL)
+  if (document == NULL)
   {
-    log_error("catdup() failed to compose xml file path");
+    /* the project file could not be read, the error is already logged */
     goto exit;
   }
 
-  if (stat(path, &st) != 0)
-  {
-    log_error("failed to stat '%s': %d (%s)", path, errno, strerror(errno));
-    goto free_path;
-  }
-
-  fd = open(path, O_RDONLY);
-  if (fd == -1)
-  {
-    log_error("failed to open '%s': %d (%s)", path, errno, strerror(errno));
-    goto free_path;
-  }
-
-  parser = XML_ParserCreate(NULL);
-  if (parser == NULL)
-  {
-    log_error("XML_ParserCreate() failed to create parser object.");
-    goto close;
-  }
-
-  //log_info("conf file size is %llu bytes", (unsigned long long)st.st_size);
-
-  /* we are expecting that conf file has small enough size to fit in memory */
-
-  buffer = XML_GetBuffer(parser, st.st_size);
-  if (buffer == NULL)
-  {
-    log_error("XML_GetBuffer() failed.");
-    goto free_parser;
-  }
-
-  bytes_read = read(fd, buffer, st.st_size);
-  if (bytes_read != st.st_size)
-  {
-    log_error("read() returned unexpected result.");
-    goto free_parser;
-  }
-
-  //log_info("\n----------\n%s\n-----------\n", buffer);
-  //goto free_parser;
-
   parse_context.error = XML_FALSE;
   parse_context.depth = -1;
   parse_context.str = NULL;
@@ -867,24 +818,16 @@ bool ladish_room_load_project(ladish_room_handle room_handle, const char * proje
   parse_context.dict = NULL;
   parse_context.room = room_handle;
 
-  XML_SetElementHandler(parser, callback_elstart, callback_elend);
-  XML_SetCharacterDataHandler(parser, callback_chrdata);
-  XML_SetUserData(parser, &parse_context);
-
   ladish_app_supervisor_set_directory(room_ptr->app_supervisor, project_dir);
   if (!ladish_app_supervisor_set_project_name(room_ptr->app_supervisor, room_ptr->project_name))
   {
     ladish_app_supervisor_set_project_name(room_ptr->app_supervisor, NULL);
   }
 
-  xmls = XML_ParseBuffer(parser, bytes_read, XML_TRUE);
-  if (xmls == XML_STATUS_ERROR && !parse_context.error)
-  {
-    log_error("XML_ParseBuffer() failed.");
-  }
-  if (xmls == XML_STATUS_ERROR || parse_context.error)
+  if (!ladish_xml_document_parse(document, &parse_context, callback_elstart, callback_elend, callback_chrdata) ||
+      parse_context.error)
   {
-    goto free_parser;
+    goto exit;
   }
 
   ladish_interlink(room_ptr->graph, room_ptr->app_supervisor);
@@ -901,12 +844,6 @@ bool ladish_room_load_project(ladish_room_handle room_handle, const char * proje
 
   ret = true;
 
-free_parser:
-  XML_ParserFree(parser);
-close:
-  close(fd);
-free_path:
-  free(path);
 exit:
   if (!ret)
   {
@@ -923,110 +860,24 @@ exit:
 
 #undef room_ptr
 
-#define context_ptr ((struct ladish_parse_context *)data)
-
-static void project_name_elstart_callback(void * data, const char * el, const char ** attr)
-{
-  const char * name;
-  const char * uuid_str;
-  uuid_t uuid;
-  size_t len;
-
-  if (strcmp(el, "project") == 0)
-  {
-    if (ladish_get_name_and_uuid_attributes("/project", attr, &name, &uuid_str, uuid))
-    {
-      len = strlen(name) + 1;
-      context_ptr->str = malloc(len);
-      if (context_ptr->str == NULL)
-      {
-        log_error("malloc() failed for project name with length %zu", len);
-        return;
-      }
-
-      unescape(name, len, context_ptr->str);
-    }
-
-    XML_StopParser(context_ptr->parser, XML_TRUE);
-    return;
-  }
-}
-
-#undef context_ptr
-
-char * ladish_get_project_name(const char * project_dir)
+bool
+ladish_read_project_async(
+  const char * project_dir,
+  void * context,
+  ladish_xml_document_callback callback,
+  ladish_worker_job_handle * job_handle_ptr)
 {
   char * path;
-  struct stat st;
-  XML_Parser parser;
-  int bytes_read;
-  void * buffer;
-  int fd;
-  enum XML_Status xmls;
-  struct ladish_parse_context parse_context;
-
-  parse_context.str = NULL;
+  bool ret;
 
   path = catdup(project_dir, LADISH_PROJECT_FILENAME);
   if (path == NULL)
   {
     log_error("catdup() failed to compose xml file path");
-    goto exit;
-  }
-
-  if (stat(path, &st) != 0)
-  {
-    log_error("failed to stat '%s': %d (%s)", path, errno, strerror(errno));
-    goto free_path;
-  }
-
-  fd = open(path, O_RDONLY);
-  if (fd == -1)
-  {
-    log_error("failed to open '%s': %d (%s)", path, errno, strerror(errno));
-    goto free_path;
-  }
-
-  parser = XML_ParserCreate(NULL);
-  if (parser == NULL)
-  {
-    log_error("XML_ParserCreate() failed to create parser object.");
-    goto close;
+    return false;
   }
 
-  /* we are expecting that conf file has small enough size to fit in memory */
-
-  buffer = XML_GetBuffer(parser, st.st_size);
-  if (buffer == NULL)
-  {
-    log_error("XML_GetBuffer() failed.");
-    goto free_parser;
-  }
-
-  bytes_read = read(fd, buffer, st.st_size);
-  if (bytes_read != st.st_size)
-  {
-    log_error("read() returned unexpected result.");
-    goto free_parser;
-  }
-
-  XML_SetElementHandler(parser, project_name_elstart_callback, NULL);
-  XML_SetUserData(parser, &parse_context);
-
-  parse_context.parser = parser;
-
-  xmls = XML_ParseBuffer(parser, bytes_read, XML_TRUE);
-  if (xmls == XML_STATUS_ERROR)
-  {
-    log_error("XML_ParseBuffer() failed.");
-  }
-
-free_parser:
-  XML_ParserFree(parser);
-close:
-  close(fd);
-free_path:
+  ret = ladish_xml_document_read_async(path, context, callback, job_handle_ptr);
   free(path);
-exit:
-  return parse_context.str;
+  return ret;
 }
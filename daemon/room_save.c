@@ -48,13 +48,17 @@ struct ladish_room_save_context
   char * project_name;
   char * old_project_dir;
   char * old_project_name;
+  ladish_worker_job_handle job; /* not NULL while the project file is being written */
 
   void * context;
-  ladish_room_save_complete_callback callback;
+  ladish_room_save_complete_callback callback; /* NULL when the save is abandoned */
 };
 
 static void ladish_room_save_context_destroy(struct ladish_room_save_context * ctx_ptr)
 {
+  ASSERT(ctx_ptr->room->save_ctx_ptr == ctx_ptr);
+  ctx_ptr->room->save_ctx_ptr = NULL;
+
   if (ctx_ptr->project_name != NULL && ctx_ptr->project_name != ctx_ptr->room->project_name)
   {
     free(ctx_ptr->room->project_name);
@@ -87,21 +91,56 @@ static void ladish_room_save_complete(struct ladish_room_save_context * ctx_ptr,
     ctx_ptr->room->project_dir = ctx_ptr->old_project_dir;
   }
 
-  ctx_ptr->callback(ctx_ptr->context, success);
+  if (ctx_ptr->callback != NULL)
+  {
+    ctx_ptr->callback(ctx_ptr->context, success);
+  }
 
   ladish_room_save_context_destroy(ctx_ptr);
 }
 
-static bool ladish_room_save_project_xml(struct ladish_room * room_ptr)
+void ladish_room_drop_project_save(struct ladish_room * room_ptr, bool room_destroyed)
 {
+  struct ladish_room_save_context * ctx_ptr;
+
+  ctx_ptr = room_ptr->save_ctx_ptr;
+  if (ctx_ptr == NULL)
+  {
+    return;
+  }
+
+  log_info("Abandoning save of project '%s' in room '%s'", room_ptr->project_name, room_ptr->name);
+
+  ctx_ptr->callback = NULL;
+
+  if (ctx_ptr->job != NULL)
+  {
+    ladish_worker_abandon(ctx_ptr->job);
+    ctx_ptr->job = NULL;
+  }
+  else if (!room_destroyed)
+  {
+    /* apps are being saved, the save is dropped when the app supervisor completes */
+    return;
+  }
+
+  ladish_room_save_complete(ctx_ptr, false);
+}
+
+static void ladish_room_project_xml_save_complete(void * context, bool success);
+
+static bool ladish_room_save_project_xml(struct ladish_room_save_context * ctx_ptr)
+{
+  struct ladish_room * room_ptr;
   bool ret;
   time_t timestamp;
   char timestamp_str[26];
   char uuid_str[37];
   char * filename;
-  char * bak_filename;
   int fd;
 
+  room_ptr = ctx_ptr->room;
+
   time(&timestamp);
   ctime_r(&timestamp, timestamp_str);
   timestamp_str[24] = 0;
@@ -118,18 +157,11 @@ static bool ladish_room_save_project_xml(struct ladish_room * room_ptr)
     goto exit;
   }
 
-  bak_filename = catdup(filename, ".bak");
-  if (bak_filename == NULL)
-  {
-    log_error("catdup() failed to compose project xml backup filename");
-    goto free_filename;
-  }
-
-  fd = open(filename, O_WRONLY | O_TRUNC | O_CREAT, 0666);
+  /* the xml is composed in memory and written to the file by a worker thread */
+  fd = ladish_save_buffer_create("ladish-project");
   if (fd == -1)
   {
-    log_error("open(%s) failed: %d (%s)", filename, errno, strerror(errno));
-    goto free_bak_filename;
+    goto free_filename;
   }
 
   if (!ladish_write_string(fd, "<?xml version=\"1.0\"?>\n"))
@@ -276,12 +308,12 @@ static bool ladish_room_save_project_xml(struct ladish_room * room_ptr)
     goto close;
   }
 
-  ret = true;
+  /* fd is closed by ladish_save_file_async() */
+  ret = ladish_save_file_async(fd, filename, NULL, NULL, ctx_ptr, ladish_room_project_xml_save_complete, &ctx_ptr->job);
+  goto free_filename;
 
 close:
   close(fd);
-free_bak_filename:
-  free(bak_filename);
 free_filename:
   free(filename);
 exit:
@@ -294,18 +326,29 @@ static void ladish_room_apps_save_complete(void * context, bool success)
 {
   log_info("Project '%s' apps in room '%s' %s to '%s'", ctx_ptr->room->project_name, ctx_ptr->room->name, success ? "saved successfully" : "failed to save", ctx_ptr->room->project_dir);
 
-  if (!success)
+  if (!success || ctx_ptr->callback == NULL)
   {
     ladish_room_save_complete(ctx_ptr, false);
     return;
   }
 
-  if (!ladish_room_save_project_xml(ctx_ptr->room))
+  if (!ladish_room_save_project_xml(ctx_ptr))
   {
     ladish_room_save_complete(ctx_ptr, false);
     /* TODO: try to rollback apps save stage */
     return;
   }
+}
+
+static void ladish_room_project_xml_save_complete(void * context, bool success)
+{
+  ctx_ptr->job = NULL;
+
+  if (!success)
+  {
+    ladish_room_save_complete(ctx_ptr, false);
+    return;
+  }
 
   ladish_room_emit_project_properties_changed(ctx_ptr->room);
 
@@ -388,9 +431,13 @@ ladish_room_save_project(
   ctx_ptr->room = room_ptr;
   ctx_ptr->project_name = NULL;
   ctx_ptr->project_dir = NULL;
+  ctx_ptr->job = NULL;
   ctx_ptr->context = context;
   ctx_ptr->callback = callback;
 
+  ASSERT(room_ptr->save_ctx_ptr == NULL);
+  room_ptr->save_ctx_ptr = ctx_ptr;
+
   ctx_ptr->old_project_dir = room_ptr->project_dir;
   ctx_ptr->old_project_name = room_ptr->project_name;
 
@@ -478,4 +525,9 @@ destroy_ctx:
   ladish_room_save_complete(ctx_ptr, false);
 }
 
+void ladish_room_abandon_project_save(ladish_room_handle room_handle)
+{
+  ladish_room_drop_project_save(room_ptr, false);
+}
+
 #undef room_ptr
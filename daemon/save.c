@@ -24,6 +24,12 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "save.h"
@@ -1170,3 +1176,216 @@ bool ladish_write_jgraph(int fd, int indent, ladish_graph_handle vgraph, ladish_
 
   return true;
 }
+
+struct ladish_save_file_job
+{
+  int buffer_fd;
+  char * path;
+  char * old_path;
+  char * bak_path;
+  void * context;
+  ladish_save_complete_callback callback;
+  bool success;
+  char error[LADISH_WORKER_ERROR_MAX];
+};
+
+int ladish_save_buffer_create(const char * name)
+{
+  int fd;
+
+  fd = memfd_create(name, MFD_CLOEXEC);
+  if (fd == -1)
+  {
+    log_error("memfd_create(%s) failed: %d (%s)", name, errno, strerror(errno));
+  }
+
+  return fd;
+}
+
+/* Called in a worker thread, must not log */
+static bool ladish_save_file_copy(struct ladish_save_file_job * job_ptr)
+{
+  char buffer[65536];
+  off_t offset;
+  ssize_t bytes_read;
+  ssize_t bytes_written;
+  ssize_t done;
+  int fd;
+
+  fd = open(job_ptr->path, O_WRONLY | O_TRUNC | O_CREAT, 0666);
+  if (fd == -1)
+  {
+    snprintf(job_ptr->error, sizeof(job_ptr->error), "open(%s) failed: %d (%s)", job_ptr->path, errno, strerror(errno));
+    return false;
+  }
+
+  offset = 0;
+  while ((bytes_read = pread(job_ptr->buffer_fd, buffer, sizeof(buffer), offset)) != 0)
+  {
+    if (bytes_read == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      snprintf(job_ptr->error, sizeof(job_ptr->error), "pread() failed to read save buffer: %d (%s)", errno, strerror(errno));
+      goto close;
+    }
+
+    for (done = 0; done < bytes_read; done += bytes_written)
+    {
+      bytes_written = write(fd, buffer + done, bytes_read - done);
+      if (bytes_written == -1)
+      {
+        if (errno == EINTR)
+        {
+          bytes_written = 0;
+          continue;
+        }
+
+        snprintf(job_ptr->error, sizeof(job_ptr->error), "write() failed to write file '%s': %d (%s)", job_ptr->path, errno, strerror(errno));
+        goto close;
+      }
+    }
+
+    offset += bytes_read;
+  }
+
+  if (fsync(fd) != 0)
+  {
+    snprintf(job_ptr->error, sizeof(job_ptr->error), "fsync() failed for '%s': %d (%s)", job_ptr->path, errno, strerror(errno));
+    goto close;
+  }
+
+  if (close(fd) != 0)
+  {
+    snprintf(job_ptr->error, sizeof(job_ptr->error), "close() failed for '%s': %d (%s)", job_ptr->path, errno, strerror(errno));
+    return false;
+  }
+
+  return true;
+
+close:
+  close(fd);
+  return false;
+}
+
+#define job_ptr ((struct ladish_save_file_job *)context)
+
+static void ladish_save_file_job_work(void * context)
+{
+  struct stat st;
+
+  job_ptr->success = false;
+
+  if (job_ptr->bak_path != NULL)
+  {
+    if (stat(job_ptr->old_path, &st) == 0) /* if old filename does not exist, rename with fail */
+    {
+      if (rename(job_ptr->old_path, job_ptr->bak_path) != 0)
+      {
+        snprintf(job_ptr->error, sizeof(job_ptr->error), "rename(%s, %s) failed: %d (%s)", job_ptr->old_path, job_ptr->bak_path, errno, strerror(errno));
+        return;
+      }
+    }
+    else
+    {
+      /* mark that there is no backup file */
+      free(job_ptr->bak_path);
+      job_ptr->bak_path = NULL;
+    }
+  }
+
+  job_ptr->success = ladish_save_file_copy(job_ptr);
+
+  if (!job_ptr->success && job_ptr->bak_path != NULL)
+  {
+    /* save failed - try to rename the backup file back */
+    if (rename(job_ptr->bak_path, job_ptr->old_path) != 0)
+    {
+      /* the original error is more important, append this one */
+      snprintf(
+        job_ptr->error + strlen(job_ptr->error),
+        sizeof(job_ptr->error) - strlen(job_ptr->error),
+        "; rename(%s, %s) failed: %d (%s)",
+        job_ptr->bak_path,
+        job_ptr->old_path,
+        errno,
+        strerror(errno));
+    }
+  }
+}
+
+static void ladish_save_file_job_complete(void * context)
+{
+  if (!job_ptr->success)
+  {
+    log_error("%s", job_ptr->error);
+  }
+
+  job_ptr->callback(job_ptr->context, job_ptr->success);
+}
+
+static void ladish_save_file_job_destroy(void * context)
+{
+  close(job_ptr->buffer_fd);
+  free(job_ptr->path);
+  free(job_ptr->old_path);
+  free(job_ptr->bak_path);
+  free(job_ptr);
+}
+
+#undef job_ptr
+
+bool
+ladish_save_file_async(
+  int buffer_fd,
+  const char * path,
+  const char * old_path,
+  const char * bak_path,
+  void * context,
+  ladish_save_complete_callback callback,
+  ladish_worker_job_handle * job_handle_ptr)
+{
+  struct ladish_save_file_job * job_ptr;
+
+  ASSERT(bak_path == NULL || old_path != NULL);
+
+  job_ptr = malloc(sizeof(struct ladish_save_file_job));
+  if (job_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate ladish_save_file_job struct");
+    goto close;
+  }
+
+  job_ptr->buffer_fd = buffer_fd;
+  job_ptr->context = context;
+  job_ptr->callback = callback;
+  job_ptr->success = false;
+  job_ptr->error[0] = 0;
+  job_ptr->path = strdup(path);
+  job_ptr->old_path = old_path != NULL ? strdup(old_path) : NULL;
+  job_ptr->bak_path = bak_path != NULL ? strdup(bak_path) : NULL;
+
+  if (job_ptr->path == NULL ||
+      (old_path != NULL && job_ptr->old_path == NULL) ||
+      (bak_path != NULL && job_ptr->bak_path == NULL))
+  {
+    log_error("strdup() failed for save file paths");
+    ladish_save_file_job_destroy(job_ptr);
+    return false;
+  }
+
+  if (!ladish_worker_queue(job_ptr, ladish_save_file_job_work, ladish_save_file_job_complete, ladish_save_file_job_destroy, job_handle_ptr))
+  {
+    ladish_save_file_job_destroy(job_ptr);
+    return false;
+  }
+
+  return true;
+
+close:
+  close(buffer_fd);
+  return false;
+}
@@ -32,6 +32,7 @@
 #include "graph.h"
 #include "app_supervisor.h"
 #include "room.h"
+#include "worker.h"
 
 #define LADISH_XML_BASE_INDENT "  "
 
@@ -50,4 +51,22 @@ bool ladish_write_vgraph(int fd, int indent, ladish_graph_handle vgraph, ladish_
 bool ladish_write_room_link_ports(int fd, int indent, ladish_room_handle room);
 bool ladish_write_jgraph(int fd, int indent, ladish_graph_handle vgraph, ladish_app_supervisor_handle app_supervisor);
 
+/* In-memory file where the main thread writes the xml before ladish_save_file_async() is called */
+int ladish_save_buffer_create(const char * name);
+
+typedef void (* ladish_save_complete_callback)(void * context, bool success);
+
+/* Copy contents of the buffer to path in a worker thread. buffer_fd is always closed.
+ * If bak_path is not NULL, old_path, if it exists, is renamed to bak_path first
+ * and renamed back if writing of path fails. */
+bool
+ladish_save_file_async(
+  int buffer_fd,
+  const char * path,
+  const char * old_path,
+  const char * bak_path,
+  void * context,
+  ladish_save_complete_callback callback,
+  ladish_worker_job_handle * job_handle_ptr);
+
 #endif /* #ifndef SAVE_H__120D6D3D_90A9_4998_8F00_23FCB8BA8DE9__INCLUDED */
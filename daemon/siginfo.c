@@ -402,6 +402,10 @@ static void dump_registers(ucontext_t * ucontext)
 
 static void signal_handler(int signum, siginfo_t * info, void * ptr)
 {
+#if !defined(SIGINFO_TEST)
+    /* the log writer thread may never run again */
+    ladish_log_flush_sync();
+#endif
     dump_siginfo(signum, info);
 #if defined(USE_UCONTEXT)
     dump_registers(ptr);
@@ -0,0 +1,147 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the object slabs
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "slab.h"
+
+#define LADISH_SLAB_ALIGN 16
+#define LADISH_SLAB_ROUND(size) (((size) + LADISH_SLAB_ALIGN - 1) & ~(size_t)(LADISH_SLAB_ALIGN - 1))
+
+/* chunk header is the link to the next chunk, padded to keep the objects aligned */
+#define LADISH_SLAB_CHUNK_HEADER LADISH_SLAB_ROUND(sizeof(void *))
+
+static struct ladish_slab * g_slabs;
+
+static size_t ladish_slab_get_chunk_size(const struct ladish_slab * slab_ptr)
+{
+  return LADISH_SLAB_CHUNK_HEADER + slab_ptr->chunk_objects * LADISH_SLAB_ROUND(slab_ptr->object_size);
+}
+
+static bool ladish_slab_grow(struct ladish_slab * slab_ptr)
+{
+  char * chunk;
+  char * object;
+  size_t object_size;
+  unsigned int i;
+
+  chunk = malloc(ladish_slab_get_chunk_size(slab_ptr));
+  if (chunk == NULL)
+  {
+    log_error("malloc() failed to allocate chunk for %u '%s' objects", slab_ptr->chunk_objects, slab_ptr->name);
+    return false;
+  }
+
+  *(void **)chunk = slab_ptr->chunks;
+  slab_ptr->chunks = chunk;
+  slab_ptr->chunk_count++;
+  slab_ptr->heap_allocations++;
+
+  object_size = LADISH_SLAB_ROUND(slab_ptr->object_size);
+  object = chunk + LADISH_SLAB_CHUNK_HEADER;
+  for (i = 0; i < slab_ptr->chunk_objects; i++)
+  {
+    *(void **)object = slab_ptr->free_objects;
+    slab_ptr->free_objects = object;
+    object += object_size;
+  }
+
+  return true;
+}
+
+void * ladish_slab_alloc(struct ladish_slab * slab_ptr)
+{
+  void * object;
+
+  ASSERT(slab_ptr->object_size >= sizeof(void *));
+
+  if (!slab_ptr->registered)
+  {
+    slab_ptr->next = g_slabs;
+    g_slabs = slab_ptr;
+    slab_ptr->registered = true;
+  }
+
+  if (slab_ptr->free_objects == NULL && !ladish_slab_grow(slab_ptr))
+  {
+    return NULL;
+  }
+
+  object = slab_ptr->free_objects;
+  slab_ptr->free_objects = *(void **)object;
+  slab_ptr->in_use++;
+  slab_ptr->allocations++;
+
+  return object;
+}
+
+void ladish_slab_free(struct ladish_slab * slab_ptr, void * object)
+{
+  void * chunk;
+
+  ASSERT(slab_ptr->in_use > 0);
+
+  *(void **)object = slab_ptr->free_objects;
+  slab_ptr->free_objects = object;
+  slab_ptr->in_use--;
+
+  if (slab_ptr->in_use != 0)
+  {
+    return;
+  }
+
+  /* last object freed, release all chunks */
+  while (slab_ptr->chunks != NULL)
+  {
+    chunk = slab_ptr->chunks;
+    slab_ptr->chunks = *(void **)chunk;
+    free(chunk);
+  }
+
+  slab_ptr->chunk_count = 0;
+  slab_ptr->free_objects = NULL;
+}
+
+size_t ladish_slab_get_heap_size(const struct ladish_slab * slab_ptr)
+{
+  return slab_ptr->chunk_count * ladish_slab_get_chunk_size(slab_ptr);
+}
+
+void ladish_slab_dump(void)
+{
+  struct ladish_slab * slab_ptr;
+
+  log_info("slabs:");
+  for (slab_ptr = g_slabs; slab_ptr != NULL; slab_ptr = slab_ptr->next)
+  {
+    log_info(
+      "  %s: %u in use, %u chunk(s), %zu bytes, %"PRIu64" allocations, %"PRIu64" heap allocations",
+      slab_ptr->name,
+      slab_ptr->in_use,
+      slab_ptr->chunk_count,
+      ladish_slab_get_heap_size(slab_ptr),
+      slab_ptr->allocations,
+      slab_ptr->heap_allocations);
+  }
+}
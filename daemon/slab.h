@@ -0,0 +1,57 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the object slabs
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef SLAB_H__ABBC74F5_3654_4536_B253_D08DC54DCEAF__INCLUDED
+#define SLAB_H__ABBC74F5_3654_4536_B253_D08DC54DCEAF__INCLUDED
+
+#include "common.h"
+
+/* Objects of one type are carved from chunks allocated on the heap. Freed
+ * objects are reused and chunks are released when the last object is freed.
+ * Slabs are used only from the main thread. */
+struct ladish_slab
+{
+  const char * name;
+  size_t object_size;
+  unsigned int chunk_objects;
+  void * chunks;                /* linked through the first pointer of each chunk */
+  void * free_objects;          /* linked through the first pointer of each object */
+  unsigned int chunk_count;
+  unsigned int in_use;
+  uint64_t allocations;
+  uint64_t heap_allocations;    /* chunks allocated */
+  struct ladish_slab * next;    /* in the list of used slabs, for the statistics */
+  bool registered;
+};
+
+#define LADISH_SLAB_INITIALIZER(slab_name, type) {.name = slab_name, .object_size = sizeof(type), .chunk_objects = 64}
+
+void * ladish_slab_alloc(struct ladish_slab * slab_ptr);
+void ladish_slab_free(struct ladish_slab * slab_ptr, void * object);
+size_t ladish_slab_get_heap_size(const struct ladish_slab * slab_ptr);
+void ladish_slab_dump(void);
+
+#endif /* #ifndef SLAB_H__ABBC74F5_3654_4536_B253_D08DC54DCEAF__INCLUDED */
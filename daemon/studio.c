@@ -521,12 +521,14 @@ static void ladish_studio_on_jack_server_started(void)
 {
   log_info("JACK server start detected.");
   ladish_environment_set(&g_studio.env_store, ladish_environment_jack_server_started);
+  ladish_cqueue_notify(&g_studio.cmd_queue, LADISH_COMMAND_EVENT_JACK);
 }
 
 static void ladish_studio_on_jack_server_stopped(void)
 {
   log_info("JACK server stop detected.");
   ladish_environment_reset(&g_studio.env_store, ladish_environment_jack_server_started);
+  ladish_cqueue_notify(&g_studio.cmd_queue, LADISH_COMMAND_EVENT_JACK);
 }
 
 static void ladish_studio_on_jack_server_appeared(void)
@@ -691,6 +693,8 @@ void ladish_studio_on_child_exit(pid_t pid, int exit_status)
   context.exit_status = exit_status;
   context.found = false;
 
+  ladish_cqueue_notify(&g_studio.cmd_queue, LADISH_COMMAND_EVENT_CHILD_EXIT);
+
   ladish_studio_iterate_virtual_graphs(&context, ladish_studio_on_child_exit_callback);
 
   if (!context.found)
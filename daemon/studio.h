@@ -38,7 +38,13 @@ void ladish_studio_run(void);
 bool ladish_studio_is_loaded(void);
 bool ladish_studio_is_started(void);
 
-bool ladish_studios_iterate(void * call_ptr, void * context, bool (* callback)(void * call_ptr, void * context, const char * studio, uint32_t modtime));
+struct ladish_meta_info;
+
+bool
+ladish_studios_iterate(
+  void * call_ptr,
+  void * context,
+  bool (* callback)(void * call_ptr, void * context, const char * studio, const struct ladish_meta_info * info_ptr));
 bool ladish_studio_delete(void * call_ptr, const char * studio_name);
 
 void ladish_studio_on_child_exit(pid_t pid, int exit_status);
@@ -26,143 +26,78 @@
 
 #include "common.h"
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <dirent.h>
-
 #include "studio_internal.h"
-#include "../common/catdup.h"
-#include "escape.h"
+#include "meta_index.h"
 
 struct ladish_studios_iterate_context
 {
   void * call_ptr;
   void * context;
-  bool (* callback)(void * call_ptr, void * context, const char * studio, uint32_t modtime);
+  bool (* callback)(void * call_ptr, void * context, const char * studio, const struct ladish_meta_info * info_ptr);
   unsigned int counter;
+  bool callback_failed;
 };
 
 #define ctx_ptr ((struct ladish_studios_iterate_context *)callback_context)
 
-bool recent_studio_callback(void * callback_context, const char * item)
+static bool recent_studio_callback(void * callback_context, const char * item)
 {
-  char * path;
-  struct stat st;
+  struct ladish_meta_info info;
 
-  if (!ladish_studio_compose_filename(item, &path, NULL))
+  if (ladish_meta_index_get_studio(item, &info))
   {
-    log_error("failed to compose path of (recent) studio \%s\" file", item);
-    goto exit;
+    ctx_ptr->callback(ctx_ptr->call_ptr, ctx_ptr->context, item, &info);
+    ctx_ptr->counter++;
   }
 
-  if (stat(path, &st) != 0)
-  {
-    if (errno != ENOENT)
-    {
-      log_error("failed to stat '%s': %d (%s)", path, errno, strerror(errno));
-    }
+  return true;
+}
 
-    goto free;
+static bool studio_callback(void * callback_context, const struct ladish_meta_info * info_ptr)
+{
+  if (ladish_recent_store_check_known(g_studios_recent_store, info_ptr->name))
+  {
+    return true;
   }
 
-  if (!S_ISREG(st.st_mode))
+  if (!ctx_ptr->callback(ctx_ptr->call_ptr, ctx_ptr->context, info_ptr->name, info_ptr))
   {
-    log_info("Ignoring recent studio that is not regular file. Mode is %07o", st.st_mode);
-    goto free;
+    ctx_ptr->callback_failed = true;
+    return false;
   }
 
-  ctx_ptr->callback(ctx_ptr->call_ptr, ctx_ptr->context, item, st.st_mtime);
-  ctx_ptr->counter++;
-
-free:
-  free(path);
-exit:
   return true;
 }
 
 #undef ctx_ptr
 
-bool ladish_studios_iterate(void * call_ptr, void * context, bool (* callback)(void * call_ptr, void * context, const char * studio, uint32_t modtime))
+bool
+ladish_studios_iterate(
+  void * call_ptr,
+  void * context,
+  bool (* callback)(void * call_ptr, void * context, const char * studio, const struct ladish_meta_info * info_ptr))
 {
-  DIR * dir;
-  struct dirent * dentry;
-  size_t len;
-  struct stat st;
-  char * path;
-  char * name;
   struct ladish_studios_iterate_context ctx;
 
   ctx.call_ptr = call_ptr;
   ctx.context = context;
   ctx.callback = callback;
   ctx.counter = 0;
+  ctx.callback_failed = false;
 
   ladish_recent_store_iterate_items(g_studios_recent_store, &ctx, recent_studio_callback);
 
   /* TODO: smarter error handling based on ctx.counter (dbus error vs just logged error) */
 
-  dir = opendir(g_studios_dir);
-  if (dir == NULL)
+  if (!ladish_meta_index_iterate_studios(&ctx, studio_callback))
   {
-    cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Cannot open directory '%s': %d (%s)", g_studios_dir, errno, strerror(errno));
-    return false;
-  }
-
-  while ((dentry = readdir(dir)) != NULL)
-  {
-    len = strlen(dentry->d_name);
-    if (len <= 4 || strcmp(dentry->d_name + (len - 4), ".xml") != 0)
-      continue;
-
-    path = catdup(g_studios_dir, dentry->d_name);
-    if (path == NULL)
+    if (!ctx.callback_failed)
     {
-      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "catdup() failed");
-      closedir(dir);
-      return false;
+      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "Cannot open directory '%s': %d (%s)", g_studios_dir, errno, strerror(errno));
     }
 
-    if (stat(path, &st) != 0)
-    {
-      cdbus_error(call_ptr, DBUS_ERROR_FAILED, "failed to stat '%s': %d (%s)", path, errno, strerror(errno));
-      free(path);
-      closedir(dir);
-      return false;
-    }
-
-    free(path);
-
-    if (!S_ISREG(st.st_mode))
-    {
-      //log_info("Ignoring direntry that is not regular file. Mode is %07o", st.st_mode);
-      continue;
-    }
-
-    name = malloc(len - 4 + 1);
-    if (name == NULL)
-    {
-      log_error("malloc() failed.");
-      closedir(dir);
-      return false;
-    }
-
-    name[unescape(dentry->d_name, len - 4, name)] = 0;
-    //log_info("name = '%s'", name);
-
-    if (!ladish_recent_store_check_known(g_studios_recent_store, name))
-    {
-      if (!callback(call_ptr, context, name, st.st_mtime))
-      {
-        free(name);
-        closedir(dir);
-        return false;
-      }
-    }
-
-    free(name);
+    return false;
   }
 
-  closedir(dir);
   return true;
 }
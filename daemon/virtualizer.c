@@ -34,6 +34,9 @@
 #include "../common/catdup.h"
 #include "room.h"
 #include "studio.h"
+#include "vtrace.h"
+#include "conf.h"
+#include "../proxies/conf_proxy.h"
 #if BUILD_ALSAPID
 #include "../alsapid/alsapid.h"
 #endif
@@ -273,6 +276,8 @@ lookup_port(
 
 static void clear(void * UNUSED(context))
 {
+  ladish_vtrace(LADISH_VTRACE_CLEAR);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("clear");
 }
 
@@ -287,10 +292,15 @@ static void client_appeared(void * context, uint64_t id, const char * jack_name)
   pid_t pid;
   ladish_graph_handle graph;
   bool jmcore;
+  bool pid_known;
+  int64_t jmcore_pid;
 
+  ladish_vtrace(LADISH_VTRACE_CLIENT_APPEARED, id, jack_name);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("client_appeared(%"PRIu64", %s)", id, jack_name);
 
   a2j_name = a2j_proxy_get_jack_client_name_cached();
+  ladish_vtrace(LADISH_VTRACE_REPLY_A2J_NAME, a2j_name);
   is_a2j = a2j_name != NULL && strcmp(a2j_name, jack_name) == 0;
 
   name = jack_name;
@@ -298,7 +308,9 @@ static void client_appeared(void * context, uint64_t id, const char * jack_name)
   graph = NULL;
   jmcore = false;
 
-  if (!graph_proxy_get_client_pid(virtualizer_ptr->jack_graph_proxy, id, &pid))
+  pid_known = graph_proxy_get_client_pid(virtualizer_ptr->jack_graph_proxy, id, &pid);
+  ladish_vtrace(LADISH_VTRACE_REPLY_CLIENT_PID, id, pid_known, (int64_t)(pid_known ? pid : 0));
+  if (!pid_known)
   {
     log_info("client %"PRIu64" pid is unknown", id);
   }
@@ -308,7 +320,9 @@ static void client_appeared(void * context, uint64_t id, const char * jack_name)
 
     if (pid != 0) /* skip internal clients that will match the pending clients in the graph, both have zero pid */
     {
-      jmcore = pid == jmcore_proxy_get_pid_cached();
+      jmcore_pid = jmcore_proxy_get_pid_cached();
+      ladish_vtrace(LADISH_VTRACE_REPLY_JMCORE_PID, jmcore_pid);
+      jmcore = pid == jmcore_pid;
       if (jmcore)
       {
         log_info("jmcore client appeared");
@@ -421,7 +435,7 @@ exit:
   return;
 }
 
-static void port_disappeared(void * context, uint64_t client_id, uint64_t port_id);
+static void port_disappeared_internal(void * context, uint64_t client_id, uint64_t port_id);
 
 bool
 force_port_disappear(
@@ -447,7 +461,7 @@ force_port_disappear(
 
   client_id = ladish_client_get_jack_id(client_handle);
   port_id = ladish_port_get_jack_id(port_handle);
-  port_disappeared(context, client_id, port_id);
+  port_disappeared_internal(context, client_id, port_id);
 
   return true;
 }
@@ -460,6 +474,8 @@ static void client_disappeared(void * context, uint64_t id)
   ladish_app_handle app;
   ladish_graph_handle vgraph;
 
+  ladish_vtrace(LADISH_VTRACE_CLIENT_DISAPPEARED, id);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("client_disappeared(%"PRIu64")", id);
 
   client = ladish_graph_find_client_by_jack_id(virtualizer_ptr->jack_graph, id);
@@ -552,6 +568,8 @@ port_appeared(
   const char * vport_name;
   ladish_graph_handle vgraph;
 
+  ladish_vtrace(LADISH_VTRACE_PORT_APPEARED, client_id, port_id, real_jack_port_name, is_input, is_terminal, is_midi);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("port_appeared(%"PRIu64", %"PRIu64", %s (%s, %s))", client_id, port_id, real_jack_port_name, is_input ? "in" : "out", is_midi ? "midi" : "audio");
 
   alsa_client_name = NULL;
@@ -631,9 +649,16 @@ port_appeared(
   if (is_a2j)
   {
     log_info("a2j port appeared");
-    if (!a2j_proxy_map_jack_port(real_jack_port_name, &alsa_client_name, &alsa_port_name, &alsa_client_id))
+    is_a2j = a2j_proxy_map_jack_port(real_jack_port_name, &alsa_client_name, &alsa_port_name, &alsa_client_id);
+    ladish_vtrace(
+      LADISH_VTRACE_REPLY_A2J_MAP,
+      real_jack_port_name,
+      is_a2j,
+      is_a2j ? alsa_client_name : NULL,
+      is_a2j ? alsa_port_name : NULL,
+      (uint64_t)(is_a2j ? alsa_client_id : 0));
+    if (!is_a2j)
     {
-      is_a2j = false;
       alsa_client_name = catdup("FAILED ", jack_client_name);
       if (alsa_client_name == NULL)
       {
@@ -952,7 +977,7 @@ static void maybe_clear_a2j_port_pid(ladish_graph_handle vgraph, ladish_client_h
   }
 }
 
-static void port_disappeared(void * context, uint64_t client_id, uint64_t port_id)
+static void port_disappeared_internal(void * context, uint64_t client_id, uint64_t port_id)
 {
   ladish_client_handle jclient;
   ladish_client_handle vclient;
@@ -1038,6 +1063,13 @@ static void port_disappeared(void * context, uint64_t client_id, uint64_t port_i
   }
 }
 
+static void port_disappeared(void * context, uint64_t client_id, uint64_t port_id)
+{
+  ladish_vtrace(LADISH_VTRACE_PORT_DISAPPEARED, client_id, port_id);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
+  port_disappeared_internal(context, client_id, port_id);
+}
+
 static
 void
 port_renamed(
@@ -1050,6 +1082,7 @@ port_renamed(
   ladish_port_handle port;
   ladish_graph_handle vgraph;
 
+  ladish_vtrace(LADISH_VTRACE_PORT_RENAMED, client_id, port_id, old_port_name, new_port_name);
   log_info("port_renamed(%"PRIu64":%"PRIu64", '%s', '%s')", client_id, port_id, old_port_name, new_port_name);
 
   port = ladish_graph_find_port_by_jack_id(virtualizer_ptr->jack_graph, port_id, true, true);
@@ -1073,7 +1106,7 @@ port_renamed(
   }
 }
 
-static bool ports_connect_request(void * context, ladish_graph_handle graph_handle, ladish_port_handle port1, ladish_port_handle port2)
+static bool ports_connect_request(void * context, ladish_graph_handle graph_handle, ladish_port_handle port1, ladish_port_handle port2, bool deferred)
 {
   uint64_t port1_id;
   uint64_t port2_id;
@@ -1092,10 +1125,17 @@ static bool ports_connect_request(void * context, ladish_graph_handle graph_hand
     port2_id = ladish_port_get_jack_id_room(port2);
   }
 
+  ladish_vtrace(LADISH_VTRACE_REQUEST_CONNECT, port1_id, port2_id);
+
+  if (deferred)
+  {
+    return graph_proxy_connect_ports_deferred(virtualizer_ptr->jack_graph_proxy, virtualizer_ptr, port1_id, port2_id);
+  }
+
   return graph_proxy_connect_ports(virtualizer_ptr->jack_graph_proxy, port1_id, port2_id);
 }
 
-static bool ports_disconnect_request(void * context, ladish_graph_handle graph_handle, uint64_t connection_id)
+static bool ports_disconnect_request(void * context, ladish_graph_handle graph_handle, uint64_t connection_id, bool deferred)
 {
   ladish_port_handle port1;
   ladish_port_handle port2;
@@ -1123,9 +1163,49 @@ static bool ports_disconnect_request(void * context, ladish_graph_handle graph_h
     port2_id = ladish_port_get_jack_id_room(port2);
   }
 
+  ladish_vtrace(LADISH_VTRACE_REQUEST_DISCONNECT, port1_id, port2_id);
+
+  if (deferred)
+  {
+    return graph_proxy_disconnect_ports_deferred(virtualizer_ptr->jack_graph_proxy, virtualizer_ptr, port1_id, port2_id);
+  }
+
   return graph_proxy_disconnect_ports(virtualizer_ptr->jack_graph_proxy, port1_id, port2_id);
 }
 
+static void connection_request_failed(void * context, bool connect, uint64_t port1_id, uint64_t port2_id)
+{
+  ladish_port_handle port1;
+  ladish_port_handle port2;
+  ladish_graph_handle vgraph1;
+  ladish_graph_handle vgraph2;
+
+  log_error("virtualizer: %s request failed", connect ? "connect" : "disconnect");
+
+  if (!lookup_port(virtualizer_ptr, port1_id, &port1, &vgraph1) ||
+      !lookup_port(virtualizer_ptr, port2_id, &port2, &vgraph2) ||
+      vgraph1 != vgraph2)
+  {
+    return;
+  }
+
+  ladish_graph_connection_change_failed(vgraph1, port1, port2);
+}
+
+static void connection_requests_completed(void * UNUSED(context), unsigned int count, unsigned int failed_count)
+{
+  log_info("virtualizer: %u connection requests completed, %u failed", count, failed_count);
+}
+
+static void flush_connection_requests(void * context, ladish_graph_handle UNUSED(graph_handle))
+{
+  graph_proxy_connections_flush(
+    virtualizer_ptr->jack_graph_proxy,
+    virtualizer_ptr,
+    connection_request_failed,
+    connection_requests_completed);
+}
+
 static void ports_connected(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id)
 {
   ladish_port_handle port1;
@@ -1134,6 +1214,8 @@ static void ports_connected(void * context, uint64_t client1_id, uint64_t port1_
   ladish_graph_handle vgraph1;
   ladish_graph_handle vgraph2;
 
+  ladish_vtrace(LADISH_VTRACE_PORTS_CONNECTED, client1_id, port1_id, client2_id, port2_id);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("ports_connected %"PRIu64":%"PRIu64" %"PRIu64":%"PRIu64"", client1_id, port1_id, client2_id, port2_id);
 
   if (!lookup_port(virtualizer_ptr, port1_id, &port1, &vgraph1))
@@ -1175,6 +1257,8 @@ static void ports_disconnected(void * context, uint64_t client1_id, uint64_t por
   ladish_graph_handle vgraph1;
   ladish_graph_handle vgraph2;
 
+  ladish_vtrace(LADISH_VTRACE_PORTS_DISCONNECTED, client1_id, port1_id, client2_id, port2_id);
+  ladish_cqueue_notify(ladish_studio_get_cmd_queue(), LADISH_COMMAND_EVENT_GRAPH);
   log_info("ports_disconnected %"PRIu64":%"PRIu64" %"PRIu64":%"PRIu64"", client1_id, port1_id, client2_id, port2_id);
 
   if (!lookup_port(virtualizer_ptr, port1_id, &port1, &vgraph1))
@@ -1215,6 +1299,32 @@ static void ports_disconnected(void * context, uint64_t client1_id, uint64_t por
 
 #undef virtualizer_ptr
 
+static void ladish_virtualizer_start_trace(void)
+{
+  bool trace;
+  char * path;
+
+  if (!conf_get_bool(LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE, &trace))
+  {
+    trace = LADISH_CONF_KEY_DAEMON_VIRTUALIZER_TRACE_DEFAULT;
+  }
+
+  if (!trace)
+  {
+    return;
+  }
+
+  path = catdup(g_base_dir, LADISH_VTRACE_FILE);
+  if (path == NULL)
+  {
+    log_error("catdup() failed to compose virtualizer trace path");
+    return;
+  }
+
+  ladish_vtrace_open(path);
+  free(path);
+}
+
 bool
 ladish_virtualizer_create(
   graph_proxy_handle jack_graph_proxy,
@@ -1236,6 +1346,8 @@ ladish_virtualizer_create(
   virtualizer_ptr->system_midi_client_id = 0;
   virtualizer_ptr->our_clients_count = 0;
 
+  ladish_virtualizer_start_trace();
+
   if (!graph_proxy_attach(
         jack_graph_proxy,
         virtualizer_ptr,
@@ -1249,6 +1361,7 @@ ladish_virtualizer_create(
         ports_connected,
         ports_disconnected))
   {
+    ladish_vtrace_close();
     free(virtualizer_ptr);
     return false;
   }
@@ -1264,7 +1377,7 @@ ladish_virtualizer_set_graph_connection_handlers(
   ladish_virtualizer_handle handle,
   ladish_graph_handle graph)
 {
-  ladish_graph_set_connection_handlers(graph, virtualizer_ptr, ports_connect_request, ports_disconnect_request);
+  ladish_graph_set_connection_handlers(graph, virtualizer_ptr, ports_connect_request, ports_disconnect_request, flush_connection_requests);
 }
 
 unsigned int
@@ -1504,8 +1617,12 @@ ladish_virtualizer_destroy(
 {
   log_info("ladish_virtualizer_destroy() called");
 
+  graph_proxy_connections_cancel(virtualizer_ptr->jack_graph_proxy, virtualizer_ptr);
+
   graph_proxy_detach((graph_proxy_handle)handle, virtualizer_ptr);
   free(virtualizer_ptr);
+
+  ladish_vtrace_close();
 }
 
 #undef virtualizer_ptr
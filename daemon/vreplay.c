@@ -0,0 +1,775 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains the offline replay of virtualizer traces
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * ladishd records the trace when the /org/ladish/daemon/virtualizer_trace
+ * conf key is set. This program is linked with the daemon code, but the
+ * proxies are replaced with stubs that answer from the trace. JACK is
+ * reported as started externally, so the virtualizer runs in an automatic
+ * studio and the recorded callbacks are fed to it as fast as possible.
+ *
+ * The graphs still emit their D-Bus signals, run it in a private bus:
+ *
+ *   dbus-run-session -- ladish_vreplay ~/.ladish/virtualizer.trace
+ *
+ * Results are printed as one JSON object per run, times are in microseconds.
+ */
+
+#include "common.h"
+
+#include <getopt.h>
+#include <limits.h>
+
+#include "studio.h"
+#include "graph.h"
+#include "vtrace.h"
+#include "../common/dirhelpers.h"
+#include "../common/ladish_time.h"
+#include "../common/metrics.h"
+#include "../proxies/graph_proxy.h"
+#include "../proxies/jack_proxy.h"
+#include "../proxies/a2j_proxy.h"
+#include "../proxies/jmcore_proxy.h"
+#include "../proxies/conf_proxy.h"
+#include "../proxies/notify_proxy.h"
+#include "../proxies/lash_client_proxy.h"
+
+/* the replay input, record types up to this one are graph_proxy callbacks */
+#define REPLAY_LAST_CALLBACK LADISH_VTRACE_PORTS_DISCONNECTED
+
+bool g_quit;
+char * g_base_dir;
+
+struct replay_graph
+{
+  void * context;
+  void (* clear)(void * context);
+  void (* client_appeared)(void * context, uint64_t id, const char * name);
+  void (* client_renamed)(void * context, uint64_t client_id, const char * old_client_name, const char * new_client_name);
+  void (* client_disappeared)(void * context, uint64_t id);
+  void (* port_appeared)(void * context, uint64_t client_id, uint64_t port_id, const char * port_name, bool is_input, bool is_terminal, bool is_midi);
+  void (* port_renamed)(void * context, uint64_t client_id, uint64_t port_id, const char * old_port_name, const char * new_port_name);
+  void (* port_disappeared)(void * context, uint64_t client_id, uint64_t port_id);
+  void (* ports_connected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id);
+  void (* ports_disconnected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id);
+  unsigned int deferred;        /* requests queued since the last flush */
+};
+
+struct replay_callback_stats
+{
+  struct ladish_histogram latency;
+  uint64_t max;
+};
+
+struct replay_result
+{
+  unsigned int replies;         /* answered from the trace */
+  unsigned int replies_missing; /* the next record was not the expected reply */
+  unsigned int requests;
+  unsigned int requests_matched;
+  unsigned int skipped;         /* replies and requests not consumed by the replay */
+  uint64_t duration;
+  struct replay_callback_stats callbacks[REPLAY_LAST_CALLBACK + 1];
+};
+
+static struct replay_graph g_graph;
+static struct ladish_vtrace g_trace;
+static size_t g_cursor;         /* the next record */
+static struct replay_result g_result;
+
+static jack_proxy_callback_server_started g_jack_server_started;
+static jack_proxy_callback_server_stopped g_jack_server_stopped;
+
+static struct option g_long_options[] =
+{
+  {"repeat", required_argument, NULL, 'r'},
+  {"log-filter", required_argument, NULL, 'l'},
+  {"help", no_argument, NULL, 'h'},
+  {NULL, 0, NULL, 0}
+};
+
+static void usage(const char * program)
+{
+  fprintf(
+    stderr,
+    "Usage: %s [options] TRACE\n"
+    "  -r, --repeat N         number of runs (default 1)\n"
+    "  -l, --log-filter SPEC  ladishd log filter (default \"error\")\n",
+    program);
+}
+
+static bool parse_uint(const char * str, unsigned int * value_ptr)
+{
+  char * end;
+  unsigned long value;
+
+  errno = 0;
+  value = strtoul(str, &end, 10);
+  if (errno != 0 || end == str || *end != 0 || value > UINT_MAX)
+  {
+    return false;
+  }
+
+  *value_ptr = value;
+  return true;
+}
+
+/* returns the next record if it is of the expected type */
+static struct ladish_vtrace_record * replay_peek(unsigned int type)
+{
+  if (g_cursor < g_trace.count && g_trace.records[g_cursor].type == type)
+  {
+    return g_trace.records + g_cursor;
+  }
+
+  return NULL;
+}
+
+static struct ladish_vtrace_record * replay_reply(unsigned int type)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  record_ptr = replay_peek(type);
+  if (record_ptr == NULL)
+  {
+    log_error("expected %s reply is not in the trace at record %zu", ladish_vtrace_type_name(type), g_cursor);
+    g_result.replies_missing++;
+    return NULL;
+  }
+
+  g_cursor++;
+  g_result.replies++;
+  return record_ptr;
+}
+
+static bool replay_request(unsigned int type, uint64_t port1_id, uint64_t port2_id)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  g_result.requests++;
+
+  record_ptr = replay_peek(type);
+  if (record_ptr != NULL && record_ptr->values[0].u == port1_id && record_ptr->values[1].u == port2_id)
+  {
+    g_cursor++;
+    g_result.requests_matched++;
+  }
+
+  return true;
+}
+
+static void replay_dispatch(const struct ladish_vtrace_record * record_ptr)
+{
+  const union ladish_vtrace_value * v;
+
+  v = record_ptr->values;
+
+  switch (record_ptr->type)
+  {
+  case LADISH_VTRACE_CLEAR:
+    g_graph.clear(g_graph.context);
+    break;
+  case LADISH_VTRACE_CLIENT_APPEARED:
+    g_graph.client_appeared(g_graph.context, v[0].u, v[1].s);
+    break;
+  case LADISH_VTRACE_CLIENT_RENAMED:
+    if (g_graph.client_renamed != NULL)
+    {
+      g_graph.client_renamed(g_graph.context, v[0].u, v[1].s, v[2].s);
+    }
+    break;
+  case LADISH_VTRACE_CLIENT_DISAPPEARED:
+    g_graph.client_disappeared(g_graph.context, v[0].u);
+    break;
+  case LADISH_VTRACE_PORT_APPEARED:
+    g_graph.port_appeared(g_graph.context, v[0].u, v[1].u, v[2].s, v[3].b, v[4].b, v[5].b);
+    break;
+  case LADISH_VTRACE_PORT_RENAMED:
+    g_graph.port_renamed(g_graph.context, v[0].u, v[1].u, v[2].s, v[3].s);
+    break;
+  case LADISH_VTRACE_PORT_DISAPPEARED:
+    g_graph.port_disappeared(g_graph.context, v[0].u, v[1].u);
+    break;
+  case LADISH_VTRACE_PORTS_CONNECTED:
+    g_graph.ports_connected(g_graph.context, v[0].u, v[1].u, v[2].u, v[3].u);
+    break;
+  case LADISH_VTRACE_PORTS_DISCONNECTED:
+    g_graph.ports_disconnected(g_graph.context, v[0].u, v[1].u, v[2].u, v[3].u);
+    break;
+  default:
+    ASSERT_NO_PASS;
+  }
+}
+
+/* mimic the ladishd main loop, one callback per iteration */
+static void replay_iteration(void)
+{
+  ladish_graph_run();
+  ladish_studio_run();
+  dbus_connection_read_write_dispatch(cdbus_g_dbus_connection, 0);
+}
+
+static bool replay(void)
+{
+  const struct ladish_vtrace_record * record_ptr;
+  struct replay_callback_stats * stats_ptr;
+  uint64_t start;
+  uint64_t usecs;
+
+  memset(&g_result, 0, sizeof(g_result));
+  g_cursor = 0;
+
+  /* JACK was started externally, ladish_studio_run() creates automatic studio and the virtualizer */
+  g_jack_server_started();
+  replay_iteration();
+
+  if (g_graph.context == NULL)
+  {
+    log_error("virtualizer was not created");
+    return false;
+  }
+
+  start = ladish_get_current_microseconds();
+
+  while (g_cursor < g_trace.count)
+  {
+    record_ptr = g_trace.records + g_cursor++;
+    if (record_ptr->type > REPLAY_LAST_CALLBACK)
+    {
+      g_result.skipped++;
+      continue;
+    }
+
+    stats_ptr = g_result.callbacks + record_ptr->type;
+    usecs = ladish_get_current_microseconds();
+    replay_dispatch(record_ptr);
+    replay_iteration();
+    usecs = ladish_metrics_elapsed(usecs);
+
+    ladish_histogram_add(&stats_ptr->latency, usecs);
+    if (usecs > stats_ptr->max)
+    {
+      stats_ptr->max = usecs;
+    }
+  }
+
+  g_result.duration = ladish_metrics_elapsed(start);
+
+  /* unload the automatic studio, the unload command is run by the second iteration */
+  g_jack_server_stopped();
+  replay_iteration();
+  replay_iteration();
+
+  return true;
+}
+
+static uint64_t replay_percentile(const struct replay_callback_stats * stats_ptr, unsigned int percent)
+{
+  uint64_t target;
+  uint64_t sum;
+  unsigned int i;
+
+  target = (stats_ptr->latency.count * percent + 99) / 100;
+  sum = 0;
+  for (i = 0; i < LADISH_HISTOGRAM_BUCKETS - 1; i++)
+  {
+    sum += stats_ptr->latency.buckets[i];
+    if (sum >= target)
+    {
+      return ladish_min(ladish_histogram_bucket_bound(i), stats_ptr->max);
+    }
+  }
+
+  return stats_ptr->max;
+}
+
+static void print_result(FILE * file, const char * path, unsigned int run)
+{
+  const struct replay_callback_stats * stats_ptr;
+  unsigned int type;
+  bool first;
+
+  fprintf(
+    file,
+    "{\"trace\": \"%s\", \"run\": %u, \"records\": %zu, \"recorded\": %"PRIu64", \"duration\": %"PRIu64", "
+    "\"replies\": %u, \"replies_missing\": %u, \"requests\": %u, \"requests_matched\": %u, \"skipped\": %u, \"callbacks\": {",
+    path,
+    run,
+    g_trace.count,
+    g_trace.count != 0 ? g_trace.records[g_trace.count - 1].time : 0,
+    g_result.duration,
+    g_result.replies,
+    g_result.replies_missing,
+    g_result.requests,
+    g_result.requests_matched,
+    g_result.skipped);
+
+  first = true;
+  for (type = 0; type <= REPLAY_LAST_CALLBACK; type++)
+  {
+    stats_ptr = g_result.callbacks + type;
+    if (stats_ptr->latency.count == 0)
+    {
+      continue;
+    }
+
+    fprintf(
+      file,
+      "%s\"%s\": {\"count\": %"PRIu64", \"total\": %"PRIu64", \"p50\": %"PRIu64", \"p99\": %"PRIu64", \"max\": %"PRIu64"}",
+      first ? "" : ", ",
+      ladish_vtrace_type_name(type),
+      stats_ptr->latency.count,
+      stats_ptr->latency.sum,
+      replay_percentile(stats_ptr, 50),
+      replay_percentile(stats_ptr, 99),
+      stats_ptr->max);
+    first = false;
+  }
+
+  fprintf(file, "}}\n");
+}
+
+int main(int argc, char ** argv)
+{
+  const char * log_filter;
+  const char * path;
+  char base_dir[] = "/tmp/ladish_vreplay.XXXXXX";
+  unsigned int repeat;
+  unsigned int i;
+  bool valid;
+  int opt;
+  int ret;
+
+  repeat = 1;
+  log_filter = "error";
+
+  while ((opt = getopt_long(argc, argv, "r:l:h", g_long_options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'r':
+      valid = parse_uint(optarg, &repeat);
+      break;
+    case 'l':
+      log_filter = optarg;
+      valid = true;
+      break;
+    case 'h':
+      usage(argv[0]);
+      return 0;
+    default:
+      valid = false;
+    }
+
+    if (!valid)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (optind + 1 != argc)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  path = argv[optind];
+
+  ladish_log_init();
+
+  if (!ladish_log_set_filter(log_filter))
+  {
+    fprintf(stderr, "Invalid log filter \"%s\"\n", log_filter);
+    return 1;
+  }
+
+  ret = 1;
+
+  if (!ladish_vtrace_load(path, &g_trace))
+  {
+    fprintf(stderr, "Cannot load trace \"%s\", see the ladishd log for details\n", path);
+    goto exit;
+  }
+
+  dbus_error_init(&cdbus_g_dbus_error);
+  cdbus_g_dbus_connection = dbus_bus_get(DBUS_BUS_SESSION, &cdbus_g_dbus_error);
+  if (dbus_error_is_set(&cdbus_g_dbus_error))
+  {
+    fprintf(stderr, "Failed to get bus: %s\n", cdbus_g_dbus_error.message);
+    dbus_error_free(&cdbus_g_dbus_error);
+    goto unload_trace;
+  }
+
+  /* the studio list and the recent studios store should not be the ones of the user */
+  g_base_dir = mkdtemp(base_dir);
+  if (g_base_dir == NULL)
+  {
+    fprintf(stderr, "mkdtemp() failed: %d (%s)\n", errno, strerror(errno));
+    goto unref_connection;
+  }
+
+  if (!ladish_studio_init())
+  {
+    fprintf(stderr, "Studio initialization failed, see the ladishd log for details\n");
+    goto remove_base_dir;
+  }
+
+  ret = 0;
+  for (i = 0; i < repeat; i++)
+  {
+    if (!replay())
+    {
+      fprintf(stderr, "Replay failed, see the ladishd log for details\n");
+      ret = 1;
+      break;
+    }
+
+    print_result(stdout, path, i);
+  }
+
+  ladish_studio_uninit();
+remove_base_dir:
+  ladish_rmdir_recursive(g_base_dir);
+unref_connection:
+  dbus_connection_unref(cdbus_g_dbus_connection);
+unload_trace:
+  ladish_vtrace_unload(&g_trace);
+exit:
+  return ret;
+}
+
+/* graph_proxy stubs, the virtualizer is the only user */
+
+bool
+graph_proxy_create(
+  const char * UNUSED(service),
+  const char * UNUSED(object),
+  bool UNUSED(graph_dict_supported),
+  bool UNUSED(graph_manager_supported),
+  graph_proxy_handle * graph_proxy_ptr)
+{
+  *graph_proxy_ptr = (graph_proxy_handle)&g_graph;
+  return true;
+}
+
+void graph_proxy_destroy(graph_proxy_handle UNUSED(graph))
+{
+}
+
+bool graph_proxy_activate(graph_proxy_handle UNUSED(graph))
+{
+  return true;
+}
+
+bool
+graph_proxy_attach(
+  graph_proxy_handle UNUSED(graph),
+  void * context,
+  void (* clear)(void * context),
+  void (* client_appeared)(void * context, uint64_t id, const char * name),
+  void (* client_renamed)(void * context, uint64_t client_id, const char * old_client_name, const char * new_client_name),
+  void (* client_disappeared)(void * context, uint64_t id),
+  void (* port_appeared)(void * context, uint64_t client_id, uint64_t port_id, const char * port_name, bool is_input, bool is_terminal, bool is_midi),
+  void (* port_renamed)(void * context, uint64_t client_id, uint64_t port_id, const char * old_port_name, const char * new_port_name),
+  void (* port_disappeared)(void * context, uint64_t client_id, uint64_t port_id),
+  void (* ports_connected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id),
+  void (* ports_disconnected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id))
+{
+  g_graph.context = context;
+  g_graph.clear = clear;
+  g_graph.client_appeared = client_appeared;
+  g_graph.client_renamed = client_renamed;
+  g_graph.client_disappeared = client_disappeared;
+  g_graph.port_appeared = port_appeared;
+  g_graph.port_renamed = port_renamed;
+  g_graph.port_disappeared = port_disappeared;
+  g_graph.ports_connected = ports_connected;
+  g_graph.ports_disconnected = ports_disconnected;
+  g_graph.deferred = 0;
+  return true;
+}
+
+void graph_proxy_detach(graph_proxy_handle UNUSED(graph), void * UNUSED(context))
+{
+  g_graph.context = NULL;
+}
+
+bool graph_proxy_connect_ports(graph_proxy_handle UNUSED(graph), uint64_t port1_id, uint64_t port2_id)
+{
+  return replay_request(LADISH_VTRACE_REQUEST_CONNECT, port1_id, port2_id);
+}
+
+bool graph_proxy_disconnect_ports(graph_proxy_handle UNUSED(graph), uint64_t port1_id, uint64_t port2_id)
+{
+  return replay_request(LADISH_VTRACE_REQUEST_DISCONNECT, port1_id, port2_id);
+}
+
+bool graph_proxy_connect_ports_deferred(graph_proxy_handle UNUSED(graph), void * UNUSED(context), uint64_t port1_id, uint64_t port2_id)
+{
+  g_graph.deferred++;
+  return replay_request(LADISH_VTRACE_REQUEST_CONNECT, port1_id, port2_id);
+}
+
+bool graph_proxy_disconnect_ports_deferred(graph_proxy_handle UNUSED(graph), void * UNUSED(context), uint64_t port1_id, uint64_t port2_id)
+{
+  g_graph.deferred++;
+  return replay_request(LADISH_VTRACE_REQUEST_DISCONNECT, port1_id, port2_id);
+}
+
+/* all requests succeed immediately */
+bool
+graph_proxy_connections_flush(
+  graph_proxy_handle UNUSED(graph),
+  void * context,
+  void (* request_failed)(void * context, bool connect, uint64_t port1_id, uint64_t port2_id),
+  void (* completed)(void * context, unsigned int count, unsigned int failed_count))
+{
+  unsigned int count;
+
+  count = g_graph.deferred;
+  g_graph.deferred = 0;
+
+  if (count != 0 && completed != NULL)
+  {
+    completed(context, count, 0);
+  }
+
+  return true;
+}
+
+void graph_proxy_connections_cancel(graph_proxy_handle UNUSED(graph), void * UNUSED(context))
+{
+  g_graph.deferred = 0;
+}
+
+bool graph_proxy_get_client_pid(graph_proxy_handle UNUSED(graph), uint64_t client_id, pid_t * pid_ptr)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  record_ptr = replay_peek(LADISH_VTRACE_REPLY_CLIENT_PID);
+  if (record_ptr == NULL || record_ptr->values[0].u != client_id)
+  {
+    log_error("pid of client %"PRIu64" is not in the trace at record %zu", client_id, g_cursor);
+    g_result.replies_missing++;
+    return false;
+  }
+
+  g_cursor++;
+  g_result.replies++;
+
+  *pid_ptr = (pid_t)record_ptr->values[2].i;
+  return record_ptr->values[1].b;
+}
+
+/* a2j and jmcore stubs */
+
+const char * a2j_proxy_get_jack_client_name_cached(void)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  record_ptr = replay_reply(LADISH_VTRACE_REPLY_A2J_NAME);
+  return record_ptr != NULL ? record_ptr->values[0].s : NULL;
+}
+
+bool
+a2j_proxy_map_jack_port(
+  const char * jack_port_name,
+  char ** alsa_client_name_ptr_ptr,
+  char ** alsa_port_name_ptr_ptr,
+  uint32_t * alsa_client_id_ptr)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  record_ptr = replay_peek(LADISH_VTRACE_REPLY_A2J_MAP);
+  if (record_ptr == NULL || strcmp(record_ptr->values[0].s, jack_port_name) != 0)
+  {
+    log_error("a2j mapping of '%s' is not in the trace at record %zu", jack_port_name, g_cursor);
+    g_result.replies_missing++;
+    return false;
+  }
+
+  g_cursor++;
+  g_result.replies++;
+
+  if (!record_ptr->values[1].b)
+  {
+    return false;
+  }
+
+  *alsa_client_name_ptr_ptr = strdup(record_ptr->values[2].s);
+  *alsa_port_name_ptr_ptr = strdup(record_ptr->values[3].s);
+  if (*alsa_client_name_ptr_ptr == NULL || *alsa_port_name_ptr_ptr == NULL)
+  {
+    log_error("strdup() failed for a2j mapping of '%s'", jack_port_name);
+    free(*alsa_client_name_ptr_ptr);
+    free(*alsa_port_name_ptr_ptr);
+    return false;
+  }
+
+  *alsa_client_id_ptr = (uint32_t)record_ptr->values[4].u;
+  return true;
+}
+
+int64_t jmcore_proxy_get_pid_cached(void)
+{
+  struct ladish_vtrace_record * record_ptr;
+
+  record_ptr = replay_reply(LADISH_VTRACE_REPLY_JMCORE_PID);
+  return record_ptr != NULL ? record_ptr->values[0].i : 0;
+}
+
+bool jmcore_proxy_create_link(bool UNUSED(midi), const char * UNUSED(input_port_name), const char * UNUSED(output_port_name))
+{
+  return false;
+}
+
+bool jmcore_proxy_destroy_link(const char * UNUSED(port_name))
+{
+  return false;
+}
+
+/* jack_proxy stubs, the server is reported as started externally */
+
+bool
+jack_proxy_init(
+  jack_proxy_callback_server_started server_started,
+  jack_proxy_callback_server_stopped server_stopped,
+  jack_proxy_callback_server_appeared UNUSED(server_appeared),
+  jack_proxy_callback_server_disappeared UNUSED(server_disappeared))
+{
+  g_jack_server_started = server_started;
+  g_jack_server_stopped = server_stopped;
+  return true;
+}
+
+void jack_proxy_uninit(void)
+{
+}
+
+bool jack_proxy_is_started(bool * started_ptr)
+{
+  *started_ptr = g_graph.context != NULL;
+  return true;
+}
+
+bool jack_proxy_start_server(void)
+{
+  return false;
+}
+
+bool jack_proxy_stop_server(void)
+{
+  return false;
+}
+
+bool
+jack_proxy_read_conf_container(
+  const char * UNUSED(address),
+  void * UNUSED(callback_context),
+  bool (* callback)(void * context, bool leaf, const char * address, char * child))
+{
+  return true;
+}
+
+bool
+jack_proxy_get_parameter_value(
+  const char * UNUSED(address),
+  bool * UNUSED(is_set_ptr),
+  struct jack_parameter_variant * UNUSED(parameter_ptr))
+{
+  return false;
+}
+
+bool
+jack_proxy_set_parameter_value(
+  const char * UNUSED(address),
+  const struct jack_parameter_variant * UNUSED(parameter_ptr))
+{
+  return false;
+}
+
+bool jack_reset_all_params(void)
+{
+  return false;
+}
+
+bool
+jack_proxy_session_save_one(
+  bool UNUSED(queue),
+  const char * UNUSED(target),
+  const char * UNUSED(path),
+  void * UNUSED(callback_context),
+  void (* completion_callback)(
+    void * context,
+    const char * commandline))
+{
+  return false;
+}
+
+bool
+jack_proxy_session_has_callback(
+  const char * UNUSED(client),
+  bool * UNUSED(has_callback_ptr))
+{
+  return false;
+}
+
+/* conf, notify and lash client stubs, defaults are used for all conf keys */
+
+bool conf_get(const char * UNUSED(key), const char ** UNUSED(value_ptr))
+{
+  return false;
+}
+
+bool conf_get_bool(const char * UNUSED(key), bool * UNUSED(value_ptr))
+{
+  return false;
+}
+
+bool conf_get_uint(const char * UNUSED(key), unsigned int * UNUSED(value_ptr))
+{
+  return false;
+}
+
+void ladish_notify_simple(uint8_t UNUSED(urgency), const char * UNUSED(summary), const char * UNUSED(body))
+{
+}
+
+bool lash_client_proxy_quit(const char * UNUSED(dest))
+{
+  return false;
+}
+
+bool lash_client_proxy_save(const char * UNUSED(dest), const char * UNUSED(app_dir))
+{
+  return false;
+}
+
+bool lash_client_proxy_restore(const char * UNUSED(dest), const char * UNUSED(app_dir))
+{
+  return false;
+}
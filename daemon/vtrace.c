@@ -0,0 +1,459 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the virtualizer input trace
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The trace is a file header followed by records. Each record is a header
+ * followed by the values listed in the record type signature:
+ *
+ *   u - uint64_t id
+ *   i - int64_t pid
+ *   b - bool, one byte
+ *   s - uint32_t length, the string bytes and a terminating zero,
+ *       NULL strings have length UINT32_MAX and no bytes
+ *
+ * Everything is in host byte order, the trace is meant to be replayed
+ * on the machine it was recorded on.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdarg.h>
+
+#include "vtrace.h"
+#include "../common/ladish_time.h"
+
+#define VTRACE_MAGIC "LADISHVT"
+#define VTRACE_VERSION 1
+#define VTRACE_BYTE_ORDER 0x01020304
+
+#define VTRACE_NULL_STRING UINT32_MAX
+
+/* stdio buffers the records, flush them at least once per second */
+#define VTRACE_FLUSH_INTERVAL 1000000
+
+struct vtrace_file_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+};
+
+struct vtrace_record_header
+{
+  uint32_t type;
+  uint32_t size;                /* of the values that follow */
+  uint64_t time;
+};
+
+static const struct
+{
+  const char * name;
+  const char * signature;
+} g_vtrace_types[LADISH_VTRACE_TYPE_COUNT] =
+{
+  [LADISH_VTRACE_CLEAR]              = {"clear",              ""},
+  [LADISH_VTRACE_CLIENT_APPEARED]    = {"client_appeared",    "us"},
+  [LADISH_VTRACE_CLIENT_RENAMED]     = {"client_renamed",     "uss"},
+  [LADISH_VTRACE_CLIENT_DISAPPEARED] = {"client_disappeared", "u"},
+  [LADISH_VTRACE_PORT_APPEARED]      = {"port_appeared",      "uusbbb"},
+  [LADISH_VTRACE_PORT_RENAMED]       = {"port_renamed",       "uuss"},
+  [LADISH_VTRACE_PORT_DISAPPEARED]   = {"port_disappeared",   "uu"},
+  [LADISH_VTRACE_PORTS_CONNECTED]    = {"ports_connected",    "uuuu"},
+  [LADISH_VTRACE_PORTS_DISCONNECTED] = {"ports_disconnected", "uuuu"},
+  [LADISH_VTRACE_REPLY_CLIENT_PID]   = {"client_pid",         "ubi"},
+  [LADISH_VTRACE_REPLY_A2J_NAME]     = {"a2j_name",           "s"},
+  [LADISH_VTRACE_REPLY_JMCORE_PID]   = {"jmcore_pid",         "i"},
+  [LADISH_VTRACE_REPLY_A2J_MAP]      = {"a2j_map",            "sbssu"},
+  [LADISH_VTRACE_REQUEST_CONNECT]    = {"connect",            "uu"},
+  [LADISH_VTRACE_REQUEST_DISCONNECT] = {"disconnect",         "uu"},
+};
+
+FILE * g_ladish_vtrace_file;
+static uint64_t g_vtrace_start_time;
+static uint64_t g_vtrace_flush_time;
+
+const char * ladish_vtrace_type_name(unsigned int type)
+{
+  if (type >= LADISH_VTRACE_TYPE_COUNT)
+  {
+    return "unknown";
+  }
+
+  return g_vtrace_types[type].name;
+}
+
+bool ladish_vtrace_open(const char * path)
+{
+  struct vtrace_file_header header;
+
+  ladish_vtrace_close();
+
+  g_ladish_vtrace_file = fopen(path, "w");
+  if (g_ladish_vtrace_file == NULL)
+  {
+    log_error("Cannot open virtualizer trace file \"%s\": %d (%s)", path, errno, strerror(errno));
+    return false;
+  }
+
+  memcpy(header.magic, VTRACE_MAGIC, sizeof(header.magic));
+  header.version = VTRACE_VERSION;
+  header.byte_order = VTRACE_BYTE_ORDER;
+
+  if (fwrite(&header, sizeof(header), 1, g_ladish_vtrace_file) != 1)
+  {
+    log_error("Cannot write virtualizer trace file header: %d (%s)", errno, strerror(errno));
+    fclose(g_ladish_vtrace_file);
+    g_ladish_vtrace_file = NULL;
+    return false;
+  }
+
+  g_vtrace_start_time = ladish_get_current_microseconds();
+  g_vtrace_flush_time = g_vtrace_start_time;
+
+  log_info("Tracing virtualizer input to \"%s\"", path);
+  return true;
+}
+
+void ladish_vtrace_close(void)
+{
+  if (g_ladish_vtrace_file == NULL)
+  {
+    return;
+  }
+
+  if (fclose(g_ladish_vtrace_file) != 0)
+  {
+    log_error("Cannot close virtualizer trace file: %d (%s)", errno, strerror(errno));
+  }
+
+  g_ladish_vtrace_file = NULL;
+}
+
+/* returns size of the values, writes them only when file is not NULL */
+static size_t ladish_vtrace_write_values(FILE * file, const char * signature, va_list ap)
+{
+  size_t size;
+  uint64_t u;
+  int64_t i;
+  uint8_t b;
+  const char * s;
+  uint32_t len;
+
+  size = 0;
+  for (; *signature != 0; signature++)
+  {
+    switch (*signature)
+    {
+    case 'u':
+      u = va_arg(ap, uint64_t);
+      size += sizeof(u);
+      if (file != NULL)
+      {
+        fwrite(&u, sizeof(u), 1, file);
+      }
+      break;
+    case 'i':
+      i = va_arg(ap, int64_t);
+      size += sizeof(i);
+      if (file != NULL)
+      {
+        fwrite(&i, sizeof(i), 1, file);
+      }
+      break;
+    case 'b':
+      b = va_arg(ap, int) ? 1 : 0;
+      size += sizeof(b);
+      if (file != NULL)
+      {
+        fwrite(&b, sizeof(b), 1, file);
+      }
+      break;
+    case 's':
+      s = va_arg(ap, const char *);
+      len = s != NULL ? strlen(s) : VTRACE_NULL_STRING;
+      size += sizeof(len);
+      if (file != NULL)
+      {
+        fwrite(&len, sizeof(len), 1, file);
+      }
+      if (s != NULL)
+      {
+        size += len + 1;
+        if (file != NULL)
+        {
+          fwrite(s, len + 1, 1, file);
+        }
+      }
+      break;
+    default:
+      ASSERT_NO_PASS;
+    }
+  }
+
+  return size;
+}
+
+void ladish_vtrace_record(unsigned int type, ...)
+{
+  va_list ap;
+  struct vtrace_record_header header;
+  uint64_t now;
+
+  ASSERT(type < LADISH_VTRACE_TYPE_COUNT);
+
+  if (g_ladish_vtrace_file == NULL)
+  {
+    return;
+  }
+
+  now = ladish_get_current_microseconds();
+
+  va_start(ap, type);
+  header.size = ladish_vtrace_write_values(NULL, g_vtrace_types[type].signature, ap);
+  va_end(ap);
+
+  header.type = type;
+  header.time = now > g_vtrace_start_time ? now - g_vtrace_start_time : 0;
+  fwrite(&header, sizeof(header), 1, g_ladish_vtrace_file);
+
+  va_start(ap, type);
+  ladish_vtrace_write_values(g_ladish_vtrace_file, g_vtrace_types[type].signature, ap);
+  va_end(ap);
+
+  if (now - g_vtrace_flush_time >= VTRACE_FLUSH_INTERVAL)
+  {
+    fflush(g_ladish_vtrace_file);
+    g_vtrace_flush_time = now;
+  }
+
+  if (ferror(g_ladish_vtrace_file))
+  {
+    log_error("Writing virtualizer trace failed, tracing stopped");
+    ladish_vtrace_close();
+  }
+}
+
+static
+bool
+ladish_vtrace_decode(
+  const char * signature,
+  const uint8_t * data,
+  size_t size,
+  struct ladish_vtrace_record * record_ptr)
+{
+  const uint8_t * end;
+  union ladish_vtrace_value * value_ptr;
+  uint32_t len;
+
+  end = data + size;
+  value_ptr = record_ptr->values;
+
+  for (; *signature != 0; signature++, value_ptr++)
+  {
+    switch (*signature)
+    {
+    case 'u':
+    case 'i':
+      if ((size_t)(end - data) < sizeof(uint64_t))
+      {
+        return false;
+      }
+      memcpy(&value_ptr->u, data, sizeof(uint64_t));
+      data += sizeof(uint64_t);
+      break;
+    case 'b':
+      if (data == end)
+      {
+        return false;
+      }
+      value_ptr->b = *data != 0;
+      data++;
+      break;
+    case 's':
+      if ((size_t)(end - data) < sizeof(len))
+      {
+        return false;
+      }
+      memcpy(&len, data, sizeof(len));
+      data += sizeof(len);
+      if (len == VTRACE_NULL_STRING)
+      {
+        value_ptr->s = NULL;
+        break;
+      }
+      if ((size_t)(end - data) <= len || data[len] != 0)
+      {
+        return false;
+      }
+      value_ptr->s = (const char *)data;
+      data += len + 1;
+      break;
+    default:
+      ASSERT_NO_PASS;
+      return false;
+    }
+  }
+
+  return data == end;
+}
+
+bool ladish_vtrace_load(const char * path, struct ladish_vtrace * trace_ptr)
+{
+  int fd;
+  struct stat st;
+  ssize_t ret;
+  size_t offset;
+  struct vtrace_file_header file_header;
+  struct vtrace_record_header header;
+  struct ladish_vtrace_record * record_ptr;
+
+  trace_ptr->data = NULL;
+  trace_ptr->records = NULL;
+  trace_ptr->count = 0;
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    log_error("open(%s) failed: %d (%s)", path, errno, strerror(errno));
+    goto fail;
+  }
+
+  if (fstat(fd, &st) != 0)
+  {
+    log_error("fstat(%s) failed: %d (%s)", path, errno, strerror(errno));
+    goto close;
+  }
+
+  trace_ptr->size = (size_t)st.st_size;
+  trace_ptr->data = malloc(trace_ptr->size);
+  if (trace_ptr->data == NULL)
+  {
+    log_error("malloc() failed to allocate %zu bytes for the trace '%s'", trace_ptr->size, path);
+    goto close;
+  }
+
+  for (offset = 0; offset < trace_ptr->size; offset += ret)
+  {
+    ret = read(fd, (char *)trace_ptr->data + offset, trace_ptr->size - offset);
+    if (ret == -1)
+    {
+      log_error("read(%s) failed: %d (%s)", path, errno, strerror(errno));
+      goto free;
+    }
+
+    if (ret == 0)
+    {
+      log_error("read(%s) returned less bytes than the file size", path);
+      goto free;
+    }
+  }
+
+  if (trace_ptr->size < sizeof(file_header))
+  {
+    log_error("'%s' is too short for a virtualizer trace", path);
+    goto free;
+  }
+
+  memcpy(&file_header, trace_ptr->data, sizeof(file_header));
+  if (memcmp(file_header.magic, VTRACE_MAGIC, sizeof(file_header.magic)) != 0)
+  {
+    log_error("'%s' is not a virtualizer trace", path);
+    goto free;
+  }
+
+  if (file_header.version != VTRACE_VERSION)
+  {
+    log_error("'%s' is virtualizer trace version %"PRIu32", expected %u", path, file_header.version, VTRACE_VERSION);
+    goto free;
+  }
+
+  if (file_header.byte_order != VTRACE_BYTE_ORDER)
+  {
+    log_error("'%s' was recorded on a machine with different byte order", path);
+    goto free;
+  }
+
+  /* count records first, the tail of a trace that was not closed can be incomplete */
+  for (offset = sizeof(file_header); trace_ptr->size - offset >= sizeof(header); offset += sizeof(header) + header.size)
+  {
+    memcpy(&header, (char *)trace_ptr->data + offset, sizeof(header));
+    if (header.size > trace_ptr->size - offset - sizeof(header))
+    {
+      break;
+    }
+
+    trace_ptr->count++;
+  }
+
+  if (offset != trace_ptr->size)
+  {
+    log_error("'%s' has %zu trailing bytes, the trace was probably not closed", path, trace_ptr->size - offset);
+  }
+
+  trace_ptr->records = malloc(trace_ptr->count * sizeof(struct ladish_vtrace_record));
+  if (trace_ptr->records == NULL && trace_ptr->count != 0)
+  {
+    log_error("malloc() failed to allocate %zu trace records", trace_ptr->count);
+    goto free;
+  }
+
+  record_ptr = trace_ptr->records;
+  for (offset = sizeof(file_header); record_ptr < trace_ptr->records + trace_ptr->count; offset += sizeof(header) + header.size)
+  {
+    memcpy(&header, (char *)trace_ptr->data + offset, sizeof(header));
+
+    if (header.type >= LADISH_VTRACE_TYPE_COUNT ||
+        !ladish_vtrace_decode(g_vtrace_types[header.type].signature, (uint8_t *)trace_ptr->data + offset + sizeof(header), header.size, record_ptr))
+    {
+      log_error("'%s' has invalid record of type %"PRIu32" at offset %zu", path, header.type, offset);
+      goto free_records;
+    }
+
+    record_ptr->type = header.type;
+    record_ptr->time = header.time;
+    record_ptr++;
+  }
+
+  close(fd);
+  return true;
+
+free_records:
+  free(trace_ptr->records);
+free:
+  free(trace_ptr->data);
+close:
+  close(fd);
+fail:
+  return false;
+}
+
+void ladish_vtrace_unload(struct ladish_vtrace * trace_ptr)
+{
+  free(trace_ptr->records);
+  free(trace_ptr->data);
+}
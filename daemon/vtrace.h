@@ -0,0 +1,106 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the virtualizer input trace
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef VTRACE_H__5B0E7C3A_2F6D_4C1B_9A84_7D3E1F05B6C2__INCLUDED
+#define VTRACE_H__5B0E7C3A_2F6D_4C1B_9A84_7D3E1F05B6C2__INCLUDED
+
+#include "common.h"
+
+/* Stored in the base dir, overwritten each time the virtualizer is created */
+#define LADISH_VTRACE_FILE "/virtualizer.trace"
+
+/* graph_proxy monitor callbacks, the replay input */
+#define LADISH_VTRACE_CLEAR               0  /* */
+#define LADISH_VTRACE_CLIENT_APPEARED     1  /* client id, name */
+#define LADISH_VTRACE_CLIENT_RENAMED      2  /* client id, old name, new name */
+#define LADISH_VTRACE_CLIENT_DISAPPEARED  3  /* client id */
+#define LADISH_VTRACE_PORT_APPEARED       4  /* client id, port id, name, is input, is terminal, is midi */
+#define LADISH_VTRACE_PORT_RENAMED        5  /* client id, port id, old name, new name */
+#define LADISH_VTRACE_PORT_DISAPPEARED    6  /* client id, port id */
+#define LADISH_VTRACE_PORTS_CONNECTED     7  /* client1 id, port1 id, client2 id, port2 id */
+#define LADISH_VTRACE_PORTS_DISCONNECTED  8  /* client1 id, port1 id, client2 id, port2 id */
+
+/* replies of the D-Bus calls made while handling the callbacks */
+#define LADISH_VTRACE_REPLY_CLIENT_PID    9  /* client id, success, pid */
+#define LADISH_VTRACE_REPLY_A2J_NAME      10 /* a2j jack client name, NULL when a2j is not running */
+#define LADISH_VTRACE_REPLY_JMCORE_PID    11 /* pid */
+#define LADISH_VTRACE_REPLY_A2J_MAP       12 /* jack port name, success, alsa client name, alsa port name, alsa client id */
+
+/* connection requests made by the virtualizer */
+#define LADISH_VTRACE_REQUEST_CONNECT     13 /* port1 id, port2 id */
+#define LADISH_VTRACE_REQUEST_DISCONNECT  14 /* port1 id, port2 id */
+
+#define LADISH_VTRACE_TYPE_COUNT          15
+
+/* Maximum number of values in a record */
+#define LADISH_VTRACE_MAX_VALUES 6
+
+/* uint64_t ids are passed as is, pids as int64_t, booleans as bool and strings as const char * */
+#define ladish_vtrace(type, ...)                        \
+  do                                                    \
+  {                                                     \
+    if (g_ladish_vtrace_file != NULL)                   \
+    {                                                   \
+      ladish_vtrace_record(type, ## __VA_ARGS__);       \
+    }                                                   \
+  } while (0)
+
+extern FILE * g_ladish_vtrace_file;
+
+bool ladish_vtrace_open(const char * path);
+void ladish_vtrace_close(void);
+void ladish_vtrace_record(unsigned int type, ...);
+
+const char * ladish_vtrace_type_name(unsigned int type);
+
+union ladish_vtrace_value
+{
+  uint64_t u;
+  int64_t i;
+  bool b;
+  const char * s;               /* points to the trace data, may be NULL */
+};
+
+struct ladish_vtrace_record
+{
+  unsigned int type;
+  uint64_t time;                /* microseconds since the trace was opened */
+  union ladish_vtrace_value values[LADISH_VTRACE_MAX_VALUES];
+};
+
+struct ladish_vtrace
+{
+  void * data;
+  size_t size;
+  struct ladish_vtrace_record * records;
+  size_t count;
+};
+
+/* Read whole trace in memory, records are in the order they were written */
+bool ladish_vtrace_load(const char * path, struct ladish_vtrace * trace_ptr);
+void ladish_vtrace_unload(struct ladish_vtrace * trace_ptr);
+
+#endif /* #ifndef VTRACE_H__5B0E7C3A_2F6D_4C1B_9A84_7D3E1F05B6C2__INCLUDED */
@@ -0,0 +1,248 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the file I/O worker pool
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Load and save commands used to read, parse and write files in the main
+ * thread, blocking graph and D-Bus handling while the disk was busy. They
+ * now queue jobs to a small pool of threads. A job produces a result that is
+ * owned by the job context and the main thread applies it from the complete
+ * callback. Commands stay in the WAITING state until that happens.
+ */
+
+#include "common.h"
+
+#include <pthread.h>
+
+#include "worker.h"
+
+#define WORKER_THREADS 4
+
+#define WORKER_JOB_STATE_QUEUED  0
+#define WORKER_JOB_STATE_RUNNING 1
+#define WORKER_JOB_STATE_DONE    2
+
+struct ladish_worker_job
+{
+  struct list_head siblings;
+  unsigned int state;           /* protected by g_mutex */
+  bool abandoned;               /* accessed only by the main thread */
+  void * context;
+  void (* work)(void * context);
+  void (* complete)(void * context);
+  void (* destructor)(void * context);
+};
+
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_queued_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_done_cond = PTHREAD_COND_INITIALIZER;
+static LIST_HEAD(g_queued);     /* protected by g_mutex */
+static LIST_HEAD(g_done);       /* protected by g_mutex */
+static bool g_stop;             /* protected by g_mutex */
+static pthread_t g_threads[WORKER_THREADS];
+static unsigned int g_threads_count;
+
+static void * ladish_worker_thread(void * UNUSED(arg))
+{
+  struct ladish_worker_job * job_ptr;
+
+  pthread_mutex_lock(&g_mutex);
+
+  for (;;)
+  {
+    /* queued jobs are finished even when quitting, they may be writing files */
+    while (list_empty(&g_queued) && !g_stop)
+    {
+      pthread_cond_wait(&g_queued_cond, &g_mutex);
+    }
+
+    if (list_empty(&g_queued))
+    {
+      break;
+    }
+
+    job_ptr = list_entry(g_queued.next, struct ladish_worker_job, siblings);
+    list_del(&job_ptr->siblings);
+    job_ptr->state = WORKER_JOB_STATE_RUNNING;
+
+    pthread_mutex_unlock(&g_mutex);
+    job_ptr->work(job_ptr->context);
+    pthread_mutex_lock(&g_mutex);
+
+    job_ptr->state = WORKER_JOB_STATE_DONE;
+    list_add_tail(&job_ptr->siblings, &g_done);
+    pthread_cond_broadcast(&g_done_cond);
+  }
+
+  pthread_mutex_unlock(&g_mutex);
+  return NULL;
+}
+
+bool ladish_worker_init(void)
+{
+  int ret;
+
+  g_stop = false;
+
+  for (g_threads_count = 0; g_threads_count < WORKER_THREADS; g_threads_count++)
+  {
+    ret = pthread_create(g_threads + g_threads_count, NULL, ladish_worker_thread, NULL);
+    if (ret != 0)
+    {
+      log_error("pthread_create() failed for worker thread: %d (%s)", ret, strerror(ret));
+      break;
+    }
+  }
+
+  if (g_threads_count == 0)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+static void ladish_worker_job_destroy(struct ladish_worker_job * job_ptr)
+{
+  if (job_ptr->destructor != NULL)
+  {
+    job_ptr->destructor(job_ptr->context);
+  }
+
+  free(job_ptr);
+}
+
+void ladish_worker_uninit(void)
+{
+  unsigned int i;
+
+  pthread_mutex_lock(&g_mutex);
+  g_stop = true;
+  pthread_cond_broadcast(&g_queued_cond);
+  pthread_mutex_unlock(&g_mutex);
+
+  for (i = 0; i < g_threads_count; i++)
+  {
+    pthread_join(g_threads[i], NULL);
+  }
+
+  ASSERT(list_empty(&g_queued));
+
+  /* The main loop is not running anymore, objects that complete callbacks
+   * would update are destroyed already. */
+  while (!list_empty(&g_done))
+  {
+    ladish_worker_job_destroy(list_entry(g_done.next, struct ladish_worker_job, siblings));
+  }
+}
+
+void ladish_worker_run(void)
+{
+  struct list_head done;
+  struct ladish_worker_job * job_ptr;
+
+  pthread_mutex_lock(&g_mutex);
+  if (list_empty(&g_done))
+  {
+    pthread_mutex_unlock(&g_mutex);
+    return;
+  }
+
+  INIT_LIST_HEAD(&done);
+  list_splice_init(&g_done, &done);
+  pthread_mutex_unlock(&g_mutex);
+
+  while (!list_empty(&done))
+  {
+    job_ptr = list_entry(done.next, struct ladish_worker_job, siblings);
+    list_del(&job_ptr->siblings);
+
+    if (!job_ptr->abandoned && job_ptr->complete != NULL)
+    {
+      job_ptr->complete(job_ptr->context);
+    }
+
+    ladish_worker_job_destroy(job_ptr);
+  }
+}
+
+bool
+ladish_worker_queue(
+  void * context,
+  void (* work)(void * context),
+  void (* complete)(void * context),
+  void (* destructor)(void * context),
+  ladish_worker_job_handle * job_handle_ptr)
+{
+  struct ladish_worker_job * job_ptr;
+
+  ASSERT(work != NULL);
+
+  job_ptr = malloc(sizeof(struct ladish_worker_job));
+  if (job_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate ladish_worker_job struct");
+    return false;
+  }
+
+  job_ptr->state = WORKER_JOB_STATE_QUEUED;
+  job_ptr->abandoned = false;
+  job_ptr->context = context;
+  job_ptr->work = work;
+  job_ptr->complete = complete;
+  job_ptr->destructor = destructor;
+
+  if (job_handle_ptr != NULL)
+  {
+    *job_handle_ptr = (ladish_worker_job_handle)job_ptr;
+  }
+
+  pthread_mutex_lock(&g_mutex);
+  list_add_tail(&job_ptr->siblings, &g_queued);
+  pthread_cond_signal(&g_queued_cond);
+  pthread_mutex_unlock(&g_mutex);
+
+  return true;
+}
+
+#define job_ptr ((struct ladish_worker_job *)job_handle)
+
+void ladish_worker_abandon(ladish_worker_job_handle job_handle)
+{
+  ASSERT(!job_ptr->abandoned);
+  job_ptr->abandoned = true;
+}
+
+void ladish_worker_wait(ladish_worker_job_handle job_handle)
+{
+  pthread_mutex_lock(&g_mutex);
+  while (job_ptr->state != WORKER_JOB_STATE_DONE)
+  {
+    pthread_cond_wait(&g_done_cond, &g_mutex);
+  }
+  pthread_mutex_unlock(&g_mutex);
+}
+
+#undef job_ptr
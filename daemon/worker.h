@@ -0,0 +1,63 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the file I/O worker pool
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef WORKER_H__7A3E2C51_9D4B_4F86_B1E0_2C5D8F6A9B13__INCLUDED
+#define WORKER_H__7A3E2C51_9D4B_4F86_B1E0_2C5D8F6A9B13__INCLUDED
+
+#include "common.h"
+
+typedef struct ladish_worker_job_tag { int unused; } * ladish_worker_job_handle;
+
+/* Maximum length of error message that work callback can store for logging by the complete callback */
+#define LADISH_WORKER_ERROR_MAX 256
+
+bool ladish_worker_init(void);
+void ladish_worker_uninit(void);
+void ladish_worker_run(void);
+
+/* The work callback is called in a worker thread. It must not touch anything
+ * but the job context. It must not log either, errors should be stored in the
+ * job context and logged by the complete callback.
+ * The complete callback is called in the main thread by ladish_worker_run().
+ * The destructor is called in the main thread after the complete callback or,
+ * for abandoned jobs, after the work callback returns. complete and destructor
+ * may be NULL. Jobs are started in the order they are queued but may complete
+ * in any order. */
+bool
+ladish_worker_queue(
+  void * context,
+  void (* work)(void * context),
+  void (* complete)(void * context),
+  void (* destructor)(void * context),
+  ladish_worker_job_handle * job_handle_ptr);
+
+/* The complete callback will not be called. Must be called before the complete callback is called. */
+void ladish_worker_abandon(ladish_worker_job_handle job_handle);
+
+/* Block until the work callback returns. Must be called before the complete callback is called. */
+void ladish_worker_wait(ladish_worker_job_handle job_handle);
+
+#endif /* #ifndef WORKER_H__7A3E2C51_9D4B_4F86_B1E0_2C5D8F6A9B13__INCLUDED */
@@ -0,0 +1,454 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains implementation of the XML documents read by worker threads
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "xml_document.h"
+
+#define XML_RECORD_ELEMENT_START 'S'  /* uint32 attribute count, name, attribute key/value pairs */
+#define XML_RECORD_ELEMENT_END   'E'  /* name */
+#define XML_RECORD_CHRDATA       'C'  /* uint32 length, data (not NUL terminated) */
+
+/* Sequence of records, one for each expat callback. Strings are NUL terminated. */
+struct ladish_xml_document
+{
+  char * path;
+  struct stat st;               /* of the file when it was read */
+  char * data;
+  size_t size;
+  size_t used;
+  size_t chrdata_offset;        /* offset of the last record if it is chrdata, (size_t)-1 otherwise */
+  uint32_t max_attr_count;
+  bool error;
+};
+
+struct ladish_xml_read_job
+{
+  char * path;
+  struct ladish_xml_document * document;
+  void * context;
+  ladish_xml_document_callback callback;
+  char error[LADISH_WORKER_ERROR_MAX];
+};
+
+static void * ladish_xml_document_append(struct ladish_xml_document * document_ptr, const void * data, size_t size)
+{
+  size_t new_size;
+  char * new_data;
+  char * ptr;
+
+  if (document_ptr->error)
+  {
+    return NULL;
+  }
+
+  if (document_ptr->used + size > document_ptr->size)
+  {
+    new_size = document_ptr->size;
+    while (document_ptr->used + size > new_size)
+    {
+      new_size *= 2;
+    }
+
+    new_data = realloc(document_ptr->data, new_size);
+    if (new_data == NULL)
+    {
+      document_ptr->error = true;
+      return NULL;
+    }
+
+    document_ptr->data = new_data;
+    document_ptr->size = new_size;
+  }
+
+  ptr = document_ptr->data + document_ptr->used;
+  memcpy(ptr, data, size);
+  document_ptr->used += size;
+
+  return ptr;
+}
+
+static void ladish_xml_document_append_record(struct ladish_xml_document * document_ptr, char type, const char * name)
+{
+  document_ptr->chrdata_offset = (size_t)-1;
+  ladish_xml_document_append(document_ptr, &type, 1);
+  ladish_xml_document_append(document_ptr, name, strlen(name) + 1);
+}
+
+#define document_ptr ((struct ladish_xml_document *)data)
+
+static void ladish_xml_record_elstart(void * data, const char * el, const char ** attr)
+{
+  char type;
+  uint32_t count;
+
+  for (count = 0; attr[count * 2] != NULL; count++);
+
+  if (count > document_ptr->max_attr_count)
+  {
+    document_ptr->max_attr_count = count;
+  }
+
+  document_ptr->chrdata_offset = (size_t)-1;
+
+  type = XML_RECORD_ELEMENT_START;
+  ladish_xml_document_append(document_ptr, &type, 1);
+  ladish_xml_document_append(document_ptr, &count, sizeof(uint32_t));
+  ladish_xml_document_append(document_ptr, el, strlen(el) + 1);
+
+  while (*attr != NULL)
+  {
+    ladish_xml_document_append(document_ptr, *attr, strlen(*attr) + 1);
+    attr++;
+  }
+}
+
+static void ladish_xml_record_elend(void * data, const char * el)
+{
+  ladish_xml_document_append_record(document_ptr, XML_RECORD_ELEMENT_END, el);
+}
+
+static void ladish_xml_record_chrdata(void * data, const XML_Char * s, int len)
+{
+  char type;
+  uint32_t size;
+  size_t offset;
+
+  /* expat may split character data in several calls, merge them */
+  if (document_ptr->chrdata_offset != (size_t)-1)
+  {
+    offset = document_ptr->chrdata_offset + 1;
+    if (ladish_xml_document_append(document_ptr, s, len) != NULL)
+    {
+      memcpy(&size, document_ptr->data + offset, sizeof(uint32_t));
+      size += len;
+      memcpy(document_ptr->data + offset, &size, sizeof(uint32_t));
+    }
+
+    return;
+  }
+
+  offset = document_ptr->used;
+  type = XML_RECORD_CHRDATA;
+  size = len;
+  ladish_xml_document_append(document_ptr, &type, 1);
+  ladish_xml_document_append(document_ptr, &size, sizeof(uint32_t));
+  ladish_xml_document_append(document_ptr, s, len);
+  document_ptr->chrdata_offset = offset;
+}
+
+#undef document_ptr
+
+/* Called in a worker thread, must not log */
+static struct ladish_xml_document * ladish_xml_document_read(const char * path, char * error, size_t error_size)
+{
+  struct ladish_xml_document * document_ptr;
+  XML_Parser parser;
+  ssize_t bytes_read;
+  void * buffer;
+  int fd;
+
+  document_ptr = malloc(sizeof(struct ladish_xml_document));
+  if (document_ptr == NULL)
+  {
+    snprintf(error, error_size, "malloc() failed to allocate ladish_xml_document struct");
+    goto fail;
+  }
+
+  document_ptr->path = strdup(path);
+  if (document_ptr->path == NULL)
+  {
+    snprintf(error, error_size, "strdup() failed for xml file path");
+    goto free_document;
+  }
+
+  document_ptr->size = 4096;
+  document_ptr->used = 0;
+  document_ptr->chrdata_offset = (size_t)-1;
+  document_ptr->max_attr_count = 0;
+  document_ptr->error = false;
+  document_ptr->data = malloc(document_ptr->size);
+  if (document_ptr->data == NULL)
+  {
+    snprintf(error, error_size, "malloc() failed to allocate xml document buffer");
+    goto free_path;
+  }
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    snprintf(error, error_size, "failed to open '%s': %d (%s)", path, errno, strerror(errno));
+    goto free_data;
+  }
+
+  if (fstat(fd, &document_ptr->st) != 0)
+  {
+    snprintf(error, error_size, "failed to stat '%s': %d (%s)", path, errno, strerror(errno));
+    goto close;
+  }
+
+  parser = XML_ParserCreate(NULL);
+  if (parser == NULL)
+  {
+    snprintf(error, error_size, "XML_ParserCreate() failed to create parser object.");
+    goto close;
+  }
+
+  /* we are expecting that xml file has small enough size to fit in memory */
+
+  buffer = XML_GetBuffer(parser, document_ptr->st.st_size);
+  if (buffer == NULL)
+  {
+    snprintf(error, error_size, "XML_GetBuffer() failed.");
+    goto free_parser;
+  }
+
+  bytes_read = read(fd, buffer, document_ptr->st.st_size);
+  if (bytes_read != document_ptr->st.st_size)
+  {
+    snprintf(error, error_size, "read() returned unexpected result.");
+    goto free_parser;
+  }
+
+  XML_SetElementHandler(parser, ladish_xml_record_elstart, ladish_xml_record_elend);
+  XML_SetCharacterDataHandler(parser, ladish_xml_record_chrdata);
+  XML_SetUserData(parser, document_ptr);
+
+  if (XML_ParseBuffer(parser, bytes_read, XML_TRUE) == XML_STATUS_ERROR)
+  {
+    snprintf(
+      error,
+      error_size,
+      "XML_ParseBuffer() failed for '%s': line %lu: %s",
+      path,
+      (unsigned long)XML_GetCurrentLineNumber(parser),
+      XML_ErrorString(XML_GetErrorCode(parser)));
+    goto free_parser;
+  }
+
+  if (document_ptr->error)
+  {
+    snprintf(error, error_size, "realloc() failed to grow xml document buffer for '%s'", path);
+    goto free_parser;
+  }
+
+  XML_ParserFree(parser);
+  close(fd);
+  return document_ptr;
+
+free_parser:
+  XML_ParserFree(parser);
+close:
+  close(fd);
+free_data:
+  free(document_ptr->data);
+free_path:
+  free(document_ptr->path);
+free_document:
+  free(document_ptr);
+fail:
+  return NULL;
+}
+
+#define job_ptr ((struct ladish_xml_read_job *)context)
+
+static void ladish_xml_read_job_work(void * context)
+{
+  job_ptr->document = ladish_xml_document_read(job_ptr->path, job_ptr->error, sizeof(job_ptr->error));
+}
+
+static void ladish_xml_read_job_complete(void * context)
+{
+  if (job_ptr->document == NULL)
+  {
+    log_error("%s", job_ptr->error);
+  }
+
+  job_ptr->callback(job_ptr->context, (ladish_xml_document_handle)job_ptr->document);
+  job_ptr->document = NULL;     /* the callback owns the document now */
+}
+
+static void ladish_xml_read_job_destroy(void * context)
+{
+  if (job_ptr->document != NULL)
+  {
+    ladish_xml_document_destroy((ladish_xml_document_handle)job_ptr->document);
+  }
+
+  free(job_ptr->path);
+  free(job_ptr);
+}
+
+#undef job_ptr
+
+bool
+ladish_xml_document_read_async(
+  const char * path,
+  void * context,
+  ladish_xml_document_callback callback,
+  ladish_worker_job_handle * job_handle_ptr)
+{
+  struct ladish_xml_read_job * job_ptr;
+
+  job_ptr = malloc(sizeof(struct ladish_xml_read_job));
+  if (job_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate ladish_xml_read_job struct");
+    goto fail;
+  }
+
+  job_ptr->path = strdup(path);
+  if (job_ptr->path == NULL)
+  {
+    log_error("strdup() failed for xml file path '%s'", path);
+    goto free_job;
+  }
+
+  job_ptr->document = NULL;
+  job_ptr->context = context;
+  job_ptr->callback = callback;
+  job_ptr->error[0] = 0;
+
+  if (!ladish_worker_queue(job_ptr, ladish_xml_read_job_work, ladish_xml_read_job_complete, ladish_xml_read_job_destroy, job_handle_ptr))
+  {
+    goto free_path;
+  }
+
+  return true;
+
+free_path:
+  free(job_ptr->path);
+free_job:
+  free(job_ptr);
+fail:
+  return false;
+}
+
+#define document_ptr ((struct ladish_xml_document *)document)
+
+bool
+ladish_xml_document_parse(
+  ladish_xml_document_handle document,
+  void * user_data,
+  XML_StartElementHandler elstart,
+  XML_EndElementHandler elend,
+  XML_CharacterDataHandler chrdata)
+{
+  const char ** attr;
+  const char * ptr;
+  const char * end;
+  const char * name;
+  uint32_t count;
+  uint32_t i;
+
+  attr = malloc(sizeof(const char *) * (document_ptr->max_attr_count * 2 + 1));
+  if (attr == NULL)
+  {
+    log_error("malloc() failed to allocate xml attribute array");
+    return false;
+  }
+
+  ptr = document_ptr->data;
+  end = ptr + document_ptr->used;
+  while (ptr < end)
+  {
+    switch (*ptr++)
+    {
+    case XML_RECORD_ELEMENT_START:
+      memcpy(&count, ptr, sizeof(uint32_t));
+      ptr += sizeof(uint32_t);
+      name = ptr;
+      ptr += strlen(ptr) + 1;
+      for (i = 0; i < count * 2; i++)
+      {
+        attr[i] = ptr;
+        ptr += strlen(ptr) + 1;
+      }
+      attr[i] = NULL;
+      if (elstart != NULL)
+      {
+        elstart(user_data, name, attr);
+      }
+      break;
+    case XML_RECORD_ELEMENT_END:
+      name = ptr;
+      ptr += strlen(ptr) + 1;
+      if (elend != NULL)
+      {
+        elend(user_data, name);
+      }
+      break;
+    case XML_RECORD_CHRDATA:
+      memcpy(&count, ptr, sizeof(uint32_t));
+      ptr += sizeof(uint32_t);
+      if (chrdata != NULL)
+      {
+        chrdata(user_data, ptr, (int)count);
+      }
+      ptr += count;
+      break;
+    default:
+      ASSERT_NO_PASS;
+      free(attr);
+      return false;
+    }
+  }
+
+  free(attr);
+  return true;
+}
+
+/* Whether the file was not modified since it was read */
+bool ladish_xml_document_is_current(ladish_xml_document_handle document)
+{
+  struct stat st;
+
+  if (stat(document_ptr->path, &st) != 0)
+  {
+    return false;
+  }
+
+  return
+    st.st_dev == document_ptr->st.st_dev &&
+    st.st_ino == document_ptr->st.st_ino &&
+    st.st_size == document_ptr->st.st_size &&
+    st.st_mtim.tv_sec == document_ptr->st.st_mtim.tv_sec &&
+    st.st_mtim.tv_nsec == document_ptr->st.st_mtim.tv_nsec;
+}
+
+void ladish_xml_document_destroy(ladish_xml_document_handle document)
+{
+  free(document_ptr->path);
+  free(document_ptr->data);
+  free(document_ptr);
+}
+
+#undef document_ptr
@@ -0,0 +1,59 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains interface of the XML documents read by worker threads
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef XML_DOCUMENT_H__E4B7C2A9_3F61_4D8E_9A05_71C6D2B8F3E4__INCLUDED
+#define XML_DOCUMENT_H__E4B7C2A9_3F61_4D8E_9A05_71C6D2B8F3E4__INCLUDED
+
+#include <expat.h>
+#include "common.h"
+#include "worker.h"
+
+/* XML file that was read and parsed in a worker thread. Parsing it calls
+ * the expat style callbacks in the main thread without touching the disk. */
+typedef struct ladish_xml_document_tag { int unused; } * ladish_xml_document_handle;
+
+/* document is NULL if the file could not be read or is not well-formed; the callback owns the document */
+typedef void (* ladish_xml_document_callback)(void * context, ladish_xml_document_handle document);
+
+bool
+ladish_xml_document_read_async(
+  const char * path,
+  void * context,
+  ladish_xml_document_callback callback,
+  ladish_worker_job_handle * job_handle_ptr);
+
+bool
+ladish_xml_document_parse(
+  ladish_xml_document_handle document,
+  void * user_data,
+  XML_StartElementHandler elstart,
+  XML_EndElementHandler elend,
+  XML_CharacterDataHandler chrdata);
+
+bool ladish_xml_document_is_current(ladish_xml_document_handle document);
+void ladish_xml_document_destroy(ladish_xml_document_handle document);
+
+#endif /* #ifndef XML_DOCUMENT_H__E4B7C2A9_3F61_4D8E_9A05_71C6D2B8F3E4__INCLUDED */
@@ -34,6 +34,8 @@
 #define JACKDBUS_IFACE_PATCHBAY  "org.jackaudio.JackPatchbay"
 #define JACKDBUS_IFACE_SESSMGR   "org.jackaudio.SessionManager"
 
+#define A2J_SERVICE_NAME         "org.gna.home.a2jmidid"
+
 #define SERVICE_NAME             DBUS_NAME_BASE
 #define CONTROL_OBJECT_PATH      DBUS_BASE_PATH "/Control"
 #define IFACE_CONTROL            DBUS_NAME_BASE ".Control"
@@ -49,6 +51,7 @@
 #define LASH_SERVER_OBJECT_PATH  DBUS_BASE_PATH "/LashServer"
 #define IFACE_LASH_SERVER        DBUS_NAME_BASE ".LashServer"
 #define IFACE_LASH_CLIENT        DBUS_NAME_BASE ".LashClient"
+#define IFACE_METRICS            DBUS_NAME_BASE ".Metrics"
 
 #define JMCORE_SERVICE_NAME      DBUS_NAME_BASE ".jmcore"
 #define JMCORE_IFACE             JMCORE_SERVICE_NAME
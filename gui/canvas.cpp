@@ -246,6 +246,8 @@ void
 canvas_clear(
   canvas_handle canvas)
 {
+  canvas_ptr->get()->cancel_arrange();
+
   FlowCanvas::ItemList modules = canvas_ptr->get()->items(); // copy
   for (FlowCanvas::ItemList::iterator m = modules.begin(); m != modules.end(); ++m)
   {
@@ -325,6 +327,51 @@ canvas_arrange(
   }
 }
 
+void
+canvas_cancel_arrange(
+  canvas_handle canvas)
+{
+  canvas_ptr->get()->cancel_arrange();
+}
+
+bool
+canvas_is_arranging(
+  canvas_handle canvas)
+{
+  return canvas_ptr->get()->arranging();
+}
+
+void
+canvas_begin_batch(
+  canvas_handle canvas)
+{
+  canvas_ptr->get()->begin_batch();
+}
+
+void
+canvas_end_batch(
+  canvas_handle canvas)
+{
+  canvas_ptr->get()->end_batch();
+}
+
+bool
+canvas_get_port_at(
+  canvas_handle canvas,
+  double x,
+  double y,
+  void ** port_context_ptr)
+{
+  boost::shared_ptr<port_cls> port = boost::dynamic_pointer_cast<port_cls>(canvas_ptr->get()->get_port_at(x, y));
+  if (port == NULL)
+  {
+    return false;
+  }
+
+  *port_context_ptr = port->m_context;
+  return true;
+}
+
 size_t
 canvas_get_selected_modules_count(
   canvas_handle canvas)
@@ -468,6 +515,14 @@ canvas_destroy_module(
   return true;
 }
 
+bool
+canvas_place_module(
+  canvas_handle canvas,
+  canvas_module_handle module)
+{
+  return canvas_ptr->get()->place_near_neighbours(*module_ptr);
+}
+
 bool
 canvas_create_port(
   canvas_handle canvas,
@@ -505,6 +560,13 @@ canvas_destroy_port(
   return true;
 }
 
+void
+canvas_release_port(
+  canvas_port_handle port)
+{
+  delete port_ptr;
+}
+
 int
 canvas_get_port_color(
   canvas_port_handle port)
@@ -539,8 +601,7 @@ canvas_add_connection(
   canvas_port_handle port2,
   uint32_t color)
 {
-  canvas_ptr->get()->add_connection(*port1_ptr, *port2_ptr, color);
-  return true;
+  return canvas_ptr->get()->add_connection(*port1_ptr, *port2_ptr, color);
 }
 
 bool
@@ -92,10 +92,36 @@ void
 canvas_set_zoom_fit(
   canvas_handle canvas);
 
+/* layout runs in background, modules are moved when it is done */
 void
 canvas_arrange(
   canvas_handle canvas);
 
+void
+canvas_cancel_arrange(
+  canvas_handle canvas);
+
+bool
+canvas_is_arranging(
+  canvas_handle canvas);
+
+/* module layout and canvas size updates are deferred until the outermost canvas_end_batch() */
+void
+canvas_begin_batch(
+  canvas_handle canvas);
+
+void
+canvas_end_batch(
+  canvas_handle canvas);
+
+/* x and y are canvas coordinates */
+bool
+canvas_get_port_at(
+  canvas_handle canvas,
+  double x,
+  double y,
+  void ** port_context_ptr);
+
 size_t
 canvas_get_selected_modules_count(
   canvas_handle canvas);
@@ -127,6 +153,12 @@ canvas_destroy_module(
   canvas_handle canvas,
   canvas_module_handle module);
 
+/* move module next to the modules it is connected to, fails if it has no connections */
+bool
+canvas_place_module(
+  canvas_handle canvas,
+  canvas_module_handle module);
+
 void
 canvas_set_module_name(
   canvas_module_handle module,
@@ -151,6 +183,11 @@ canvas_destroy_port(
   canvas_handle canvas,
   canvas_port_handle port);
 
+/* free port handle without removing the port, for when its module is destroyed */
+void
+canvas_release_port(
+  canvas_port_handle port);
+
 int
 canvas_get_port_color(
   canvas_port_handle port);
@@ -164,6 +201,7 @@ const char *
 canvas_get_port_name(
   canvas_port_handle port);
 
+/* Returns false when the ports are already connected */
 bool
 canvas_add_connection(
   canvas_handle canvas,
@@ -0,0 +1,506 @@
+/* -*- Mode: C ; c-basic-offset: 2 -*- */
+/*
+ * LADI Session Handler (ladish)
+ *
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ **************************************************************************
+ * This file contains the canvas benchmark that runs on synthetic graphs
+ **************************************************************************
+ *
+ * LADI Session Handler is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * LADI Session Handler is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LADI Session Handler. If not, see <http://www.gnu.org/licenses/>
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The canvas is put in an offscreen window, so no window is mapped on screen,
+ * but gtk still needs a display. Run it under Xvfb when there is none:
+ *
+ *   xvfb-run ladish_canvas_bench --modules 200 --ports 16 --connections 1000
+ *
+ * Results are printed as one JSON object per run, times are in seconds.
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <time.h>
+
+#include "canvas.h"
+
+#define BENCH_CANVAS_WIDTH 1600
+#define BENCH_CANVAS_HEIGHT 1200
+
+#define MODULE_SPACING_X 250.0
+#define MODULE_SPACING_Y_BASE 60.0
+#define MODULE_SPACING_Y_PER_PORT 20.0
+
+#define AUDIO_PORT_COLOR 0x244678C0
+#define MIDI_PORT_COLOR 0x960909C0
+
+struct bench_params
+{
+  unsigned int modules;
+  unsigned int ports;           /* per module, half of them inputs */
+  unsigned int connections;
+  unsigned int hit_tests;
+  unsigned int seed;
+  unsigned int repeat;
+  bool batch;
+  bool arrange;
+};
+
+struct bench_result
+{
+  unsigned int connections;     /* actually made, duplicates are skipped */
+  unsigned int hits;
+  bool arranged;
+  double populate;
+  double render;
+  double zoom_full;
+  double hit_test;
+  double arrange;
+  double teardown;
+};
+
+static struct option g_long_options[] =
+{
+  {"modules", required_argument, NULL, 'm'},
+  {"ports", required_argument, NULL, 'p'},
+  {"connections", required_argument, NULL, 'c'},
+  {"hit-tests", required_argument, NULL, 't'},
+  {"seed", required_argument, NULL, 's'},
+  {"repeat", required_argument, NULL, 'r'},
+  {"output", required_argument, NULL, 'o'},
+  {"no-batch", no_argument, NULL, 'B'},
+  {"no-arrange", no_argument, NULL, 'A'},
+  {"help", no_argument, NULL, 'h'},
+  {NULL, 0, NULL, 0}
+};
+
+static void usage(const char * program)
+{
+  fprintf(
+    stderr,
+    "Usage: %s [options]\n"
+    "  -m, --modules N      number of modules (default 100)\n"
+    "  -p, --ports N        ports per module, at least 2 (default 8)\n"
+    "  -c, --connections N  number of connections (default 400)\n"
+    "  -t, --hit-tests N    number of port hit-tests (default 100000)\n"
+    "  -s, --seed N         random seed (default 1)\n"
+    "  -r, --repeat N       number of runs (default 1)\n"
+    "  -o, --output FILE    write results to FILE instead of stdout\n"
+    "      --no-batch       populate without canvas_begin_batch()\n"
+    "      --no-arrange     skip the arrange phase\n",
+    program);
+}
+
+static bool parse_uint(const char * str, unsigned int * value_ptr)
+{
+  char * end;
+  unsigned long value;
+
+  errno = 0;
+  value = strtoul(str, &end, 10);
+  if (errno != 0 || end == str || *end != 0 || value > UINT_MAX)
+  {
+    return false;
+  }
+
+  *value_ptr = value;
+  return true;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void process_events(void)
+{
+  while (gtk_events_pending())
+  {
+    gtk_main_iteration();
+  }
+}
+
+static void module_location_changed(void * UNUSED(module_context), double UNUSED(x), double UNUSED(y))
+{
+}
+
+static double random_range(double max)
+{
+  return max * ((double)rand() / ((double)RAND_MAX + 1.0));
+}
+
+static
+bool
+run(
+  const struct bench_params * params_ptr,
+  struct bench_result * result_ptr)
+{
+  GtkWidget * window;
+  canvas_handle canvas;
+  canvas_module_handle * modules;
+  canvas_port_handle * ports;
+  unsigned int inputs;
+  unsigned int columns;
+  unsigned int module;
+  unsigned int port;
+  unsigned int i;
+  unsigned int src;
+  unsigned int dst;
+  char name[64];
+  double spacing_y;
+  double width;
+  double height;
+  double start;
+  void * port_context;
+  bool ret;
+
+  ret = false;
+
+  modules = calloc(params_ptr->modules, sizeof(canvas_module_handle));
+  ports = calloc((size_t)params_ptr->modules * params_ptr->ports, sizeof(canvas_port_handle));
+  if (modules == NULL || ports == NULL)
+  {
+    log_error("allocation of handle arrays failed");
+    goto free;
+  }
+
+  if (!canvas_create(
+        BENCH_CANVAS_WIDTH,
+        BENCH_CANVAS_HEIGHT,
+        NULL,
+        NULL,
+        NULL,
+        module_location_changed,
+        NULL,
+        NULL,
+        NULL,
+        &canvas))
+  {
+    log_error("canvas_create() failed");
+    goto free;
+  }
+
+  window = gtk_offscreen_window_new();
+  gtk_container_add(GTK_CONTAINER(window), canvas_get_widget(canvas));
+  gtk_widget_show_all(window);
+  process_events();
+
+  inputs = params_ptr->ports / 2;
+  columns = 1;
+  while (columns * columns < params_ptr->modules)
+  {
+    columns++;
+  }
+  spacing_y = MODULE_SPACING_Y_BASE + MODULE_SPACING_Y_PER_PORT * params_ptr->ports;
+  width = MODULE_SPACING_X * columns;
+  height = spacing_y * ((params_ptr->modules + columns - 1) / columns);
+
+  /* populate, in the same order graph_canvas creates objects */
+  start = now();
+
+  if (params_ptr->batch)
+  {
+    canvas_begin_batch(canvas);
+  }
+
+  for (module = 0; module < params_ptr->modules; module++)
+  {
+    sprintf(name, "module %u", module);
+    if (!canvas_create_module(
+          canvas,
+          name,
+          MODULE_SPACING_X * (module % columns),
+          spacing_y * (module / columns),
+          true,
+          true,
+          NULL,
+          modules + module))
+    {
+      log_error("canvas_create_module(\"%s\") failed", name);
+      goto destroy;
+    }
+
+    for (port = 0; port < params_ptr->ports; port++)
+    {
+      i = module * params_ptr->ports + port;
+      sprintf(name, port < inputs ? "in %u" : "out %u", port);
+      if (!canvas_create_port(
+            canvas,
+            modules[module],
+            name,
+            port < inputs,
+            port % 4 == 3 ? MIDI_PORT_COLOR : AUDIO_PORT_COLOR,
+            (void *)(uintptr_t)(i + 1),
+            ports + i))
+      {
+        log_error("canvas_create_port(\"%s\") failed", name);
+        goto destroy;
+      }
+    }
+  }
+
+  result_ptr->connections = 0;
+  if (params_ptr->modules > 1)
+  {
+    for (i = 0; i < params_ptr->connections; i++)
+    {
+      /* output of one module to input of another */
+      module = rand() % params_ptr->modules;
+      src = module * params_ptr->ports + inputs + rand() % (params_ptr->ports - inputs);
+      module = (module + 1 + rand() % (params_ptr->modules - 1)) % params_ptr->modules;
+      dst = module * params_ptr->ports + rand() % inputs;
+
+      if (canvas_add_connection(canvas, ports[src], ports[dst], canvas_get_port_color(ports[src]) + 0x22222200))
+      {
+        result_ptr->connections++;
+      }
+    }
+  }
+
+  if (params_ptr->batch)
+  {
+    canvas_end_batch(canvas);
+  }
+
+  result_ptr->populate = now() - start;
+
+  start = now();
+  process_events();
+  gdk_window_process_all_updates();
+  result_ptr->render = now() - start;
+
+  start = now();
+  canvas_set_zoom_fit(canvas);
+  process_events();
+  gdk_window_process_all_updates();
+  result_ptr->zoom_full = now() - start;
+
+  canvas_set_zoom(canvas, 1.0);
+  process_events();
+
+  result_ptr->hits = 0;
+  start = now();
+  for (i = 0; i < params_ptr->hit_tests; i++)
+  {
+    if (canvas_get_port_at(canvas, random_range(width), random_range(height), &port_context))
+    {
+      result_ptr->hits++;
+    }
+  }
+  result_ptr->hit_test = now() - start;
+
+  /* includes the animation of modules to their new places */
+  result_ptr->arranged = false;
+  result_ptr->arrange = 0.0;
+  if (params_ptr->arrange)
+  {
+    start = now();
+    canvas_arrange(canvas);
+    result_ptr->arranged = canvas_is_arranging(canvas);
+    while (canvas_is_arranging(canvas))
+    {
+      gtk_main_iteration();
+    }
+    process_events();
+    result_ptr->arrange = now() - start;
+  }
+
+  ret = true;
+
+destroy:
+  start = now();
+
+  for (i = 0; i < params_ptr->modules * params_ptr->ports; i++)
+  {
+    if (ports[i] != NULL)
+    {
+      canvas_release_port(ports[i]);
+    }
+  }
+
+  for (module = 0; module < params_ptr->modules; module++)
+  {
+    if (modules[module] != NULL)
+    {
+      canvas_destroy_module(canvas, modules[module]);
+    }
+  }
+
+  gtk_container_remove(GTK_CONTAINER(window), canvas_get_widget(canvas));
+  canvas_destroy(canvas);
+  gtk_widget_destroy(window);
+  process_events();
+
+  result_ptr->teardown = now() - start;
+
+free:
+  free(ports);
+  free(modules);
+  return ret;
+}
+
+static
+void
+print_result(
+  FILE * file,
+  const struct bench_params * params_ptr,
+  unsigned int run_index,
+  const struct bench_result * result_ptr)
+{
+  fprintf(
+    file,
+    "{\"run\": %u, \"modules\": %u, \"ports_per_module\": %u, \"connections\": %u, "
+    "\"seed\": %u, \"batch\": %s, \"hit_tests\": %u, \"hits\": %u, \"arranged\": %s, "
+    "\"seconds\": {\"populate\": %.6f, \"render\": %.6f, \"zoom_full\": %.6f, "
+    "\"hit_test\": %.6f, \"arrange\": %.6f, \"teardown\": %.6f}}\n",
+    run_index,
+    params_ptr->modules,
+    params_ptr->ports,
+    result_ptr->connections,
+    params_ptr->seed,
+    params_ptr->batch ? "true" : "false",
+    params_ptr->hit_tests,
+    result_ptr->hits,
+    result_ptr->arranged ? "true" : "false",
+    result_ptr->populate,
+    result_ptr->render,
+    result_ptr->zoom_full,
+    result_ptr->hit_test,
+    result_ptr->arrange,
+    result_ptr->teardown);
+  fflush(file);
+}
+
+int main(int argc, char ** argv)
+{
+  struct bench_params params;
+  struct bench_result result;
+  const char * output;
+  FILE * file;
+  unsigned int i;
+  bool valid;
+  int opt;
+  int ret;
+
+  params.modules = 100;
+  params.ports = 8;
+  params.connections = 400;
+  params.hit_tests = 100000;
+  params.seed = 1;
+  params.repeat = 1;
+  params.batch = true;
+  params.arrange = true;
+  output = NULL;
+
+  gtk_init(&argc, &argv);
+
+  while ((opt = getopt_long(argc, argv, "m:p:c:t:s:r:o:h", g_long_options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+    case 'm':
+      valid = parse_uint(optarg, &params.modules);
+      break;
+    case 'p':
+      valid = parse_uint(optarg, &params.ports) && params.ports >= 2;
+      break;
+    case 'c':
+      valid = parse_uint(optarg, &params.connections);
+      break;
+    case 't':
+      valid = parse_uint(optarg, &params.hit_tests);
+      break;
+    case 's':
+      valid = parse_uint(optarg, &params.seed);
+      break;
+    case 'r':
+      valid = parse_uint(optarg, &params.repeat);
+      break;
+    case 'o':
+      output = optarg;
+      valid = true;
+      break;
+    case 'B':
+      params.batch = false;
+      valid = true;
+      break;
+    case 'A':
+      params.arrange = false;
+      valid = true;
+      break;
+    case 'h':
+      usage(argv[0]);
+      return 0;
+    default:
+      valid = false;
+    }
+
+    if (!valid)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!canvas_init())
+  {
+    log_error("Canvas initialization failed.");
+    return 1;
+  }
+
+  if (output != NULL)
+  {
+    file = fopen(output, "w");
+    if (file == NULL)
+    {
+      log_error("Cannot open \"%s\" for writing: %d (%s)", output, errno, strerror(errno));
+      return 1;
+    }
+  }
+  else
+  {
+    file = stdout;
+  }
+
+  srand(params.seed);
+
+  ret = 0;
+  for (i = 0; i < params.repeat; i++)
+  {
+    if (!run(&params, &result))
+    {
+      ret = 1;
+      break;
+    }
+
+    print_result(file, &params, i, &result);
+  }
+
+  if (file != stdout)
+  {
+    fclose(file);
+  }
+
+  return ret;
+}
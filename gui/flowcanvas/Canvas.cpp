@@ -16,13 +16,17 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <list>
+#include <locale>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <boost/enable_shared_from_this.hpp>
@@ -47,8 +51,31 @@ namespace FlowCanvas {
 sigc::signal<void, Gnome::Canvas::Item*> Canvas::signal_item_entered;
 sigc::signal<void, Gnome::Canvas::Item*> Canvas::signal_item_left;
 
+static const double ITEM_INDEX_CELL_SIZE = 128.0;
+
+#ifdef HAVE_AGRAPH
+/// Graphviz keeps global state, a cancelled arrange job may still be running
+static std::mutex graphviz_mutex;
+#endif
+
+static const unsigned ARRANGE_TICK_MS         = 30; ///< Poll and animation interval
+static const unsigned ARRANGE_ANIMATION_STEPS = 10;
+static const double   PLACEMENT_GAP           = 32.0;
+
+// Detail is reduced when zoomed out below these
+static const double DETAIL_LABELS_ZOOM  = 0.6;
+static const double DETAIL_SUMMARY_ZOOM = 0.35;
+
 Canvas::Canvas(double width, double height)
-	: _base_rect(*root(), 0, 0, width, height)
+	: _item_index(ITEM_INDEX_CELL_SIZE)
+	, _detail(DETAIL_FULL)
+	, _visible_x1(-HUGE_VAL)
+	, _visible_y1(-HUGE_VAL)
+	, _visible_x2(HUGE_VAL)
+	, _visible_y2(HUGE_VAL)
+	, _arrange_step(0)
+	, _batch_depth(0)
+	, _base_rect(*root(), 0, 0, width, height)
 	, _select_rect(NULL)
 	, _select_dash(NULL)
 	, _zoom(1.0)
@@ -58,6 +85,8 @@ Canvas::Canvas(double width, double height)
 	, _direction(HORIZONTAL)
 	, _remove_objects(true)
 	, _locked(false)
+	, _batch_flushing(false)
+	, _batch_resized(false)
 {
 	set_scroll_region(0.0, 0.0, width, height);
 	set_center_scroll_region(true);
@@ -117,6 +146,150 @@ Canvas::set_zoom(double pix_per_unit)
 
 	for (list<boost::shared_ptr<Connection> >::iterator c = _connections.begin(); c != _connections.end(); ++c)
 		(*c)->zoom(_zoom);
+
+	set_detail(_zoom < DETAIL_SUMMARY_ZOOM ? DETAIL_SUMMARY
+	           : _zoom < DETAIL_LABELS_ZOOM ? DETAIL_NO_LABELS
+	           : DETAIL_FULL);
+
+	if (_detail == DETAIL_SUMMARY)
+		update_culling();
+}
+
+
+/** Reduce what is drawn when zoomed out too far for it to be readable.
+ *
+ * At DETAIL_SUMMARY, all connections between the same two items are drawn as
+ * one thicker line with their count, and connections that are out of view
+ * are hidden and their paths are not updated as items move.
+ */
+void
+Canvas::set_detail(DetailLevel level)
+{
+	if (level == _detail)
+		return;
+
+	const bool was_summary = (_detail == DETAIL_SUMMARY);
+	_detail = level;
+
+	for (ItemList::iterator i = _items.begin(); i != _items.end(); ++i)
+		(*i)->set_detail(level);
+
+	if (level == DETAIL_SUMMARY && !was_summary) {
+		update_visible_area();
+
+		for (ConnectionRecords::const_iterator r = _connection_records.begin(); r != _connection_records.end(); ++r)
+			bundle_connection(r->second, true);
+
+		Gtk::Adjustment* adjustments[2] = { get_hadjustment(), get_vadjustment() };
+		for (size_t i = 0; i < 2; ++i)
+			if (adjustments[i])
+				_scroll_connections[i] = adjustments[i]->signal_value_changed().connect(
+					sigc::mem_fun(this, &Canvas::update_culling));
+
+	} else if (was_summary && level != DETAIL_SUMMARY) {
+		for (size_t i = 0; i < 2; ++i)
+			_scroll_connections[i].disconnect();
+
+		_bundles.clear();
+		for (ConnectionList::iterator c = _connections.begin(); c != _connections.end(); ++c)
+			(*c)->set_bundle_size(1);
+
+		// Nothing is culled at this level
+		update_culling();
+	}
+}
+
+
+void
+Canvas::bundle_connection(const ConnectionRecord& record, bool add)
+{
+	Connection* const c = record.position->get();
+	const ItemPair    key(record.tail_item, record.head_item);
+
+	if (add) {
+		std::vector<Connection*>& bundle = _bundles[key];
+		bundle.push_back(c);
+		if (bundle.size() > 1)
+			c->set_bundle_size(0);
+		bundle.front()->set_bundle_size(bundle.size());
+		return;
+	}
+
+	Bundles::iterator b = _bundles.find(key);
+	if (b == _bundles.end())
+		return;
+
+	std::vector<Connection*>::iterator i = std::find(b->second.begin(), b->second.end(), c);
+	if (i == b->second.end())
+		return;
+
+	b->second.erase(i);
+	if (b->second.empty())
+		_bundles.erase(b);
+	else
+		b->second.front()->set_bundle_size(b->second.size());
+}
+
+
+/** Get the part of the canvas that is in view, with half a window margin
+ * around it so that scrolling a bit does not reveal culled connections.
+ */
+void
+Canvas::update_visible_area()
+{
+	Glib::RefPtr<Gdk::Window> win = get_window();
+	if (!win) {
+		_visible_x1 = _visible_y1 = -HUGE_VAL;
+		_visible_x2 = _visible_y2 = HUGE_VAL;
+		return;
+	}
+
+	int scroll_x = 0, scroll_y = 0, win_width = 0, win_height = 0;
+	get_scroll_offsets(scroll_x, scroll_y);
+	win->get_size(win_width, win_height);
+
+	double x, y;
+	c2w(scroll_x, scroll_y, x, y);
+
+	const double width  = win_width / _zoom;
+	const double height = win_height / _zoom;
+
+	_visible_x1 = x - width / 2.0;
+	_visible_y1 = y - height / 2.0;
+	_visible_x2 = x + width * 1.5;
+	_visible_y2 = y + height * 1.5;
+}
+
+
+/** Return whether a connection with bounding box @a x1 @a y1 @a x2 @a y2
+ * is skipped because it is out of view. */
+bool
+Canvas::culls(double x1, double y1, double x2, double y2) const
+{
+	return _detail == DETAIL_SUMMARY
+		&& (x2 < _visible_x1 || x1 > _visible_x2 || y2 < _visible_y1 || y1 > _visible_y2);
+}
+
+
+void
+Canvas::connection_culled(Connection* c, bool culled)
+{
+	if (!culled)
+		_culled_connections.erase(c);
+	else if (_connection_records.find(c) != _connection_records.end())
+		_culled_connections.insert(c);
+}
+
+
+/** Draw culled connections that came into view. */
+void
+Canvas::update_culling()
+{
+	update_visible_area();
+
+	const std::vector<Connection*> culled(_culled_connections.begin(), _culled_connections.end());
+	for (std::vector<Connection*>::const_iterator c = culled.begin(); c != culled.end(); ++c)
+		(*c)->update_location();
 }
 
 
@@ -221,8 +394,14 @@ Canvas::select_item(boost::shared_ptr<Item> m)
 
 	_selected_items.push_back(m);
 
-	for (ConnectionList::iterator i = _connections.begin(); i != _connections.end(); ++i) {
-		const boost::shared_ptr<Connection>  c = (*i);
+	// Only connections of this module can become selected
+	static const std::unordered_set<const Connection*> no_connections;
+	ItemConnections::const_iterator adjacent = _item_connections.find(m.get());
+	const std::unordered_set<const Connection*>& connections
+		= (adjacent != _item_connections.end()) ? adjacent->second : no_connections;
+
+	for (std::unordered_set<const Connection*>::const_iterator i = connections.begin(); i != connections.end(); ++i) {
+		const boost::shared_ptr<Connection>  c = *_connection_records[*i].position;
 		const boost::shared_ptr<Connectable> src = c->source().lock();
 		const boost::shared_ptr<Connectable> dst = c->dest().lock();
 		if (!src || !dst)
@@ -305,17 +484,30 @@ Canvas::unselect_item(boost::shared_ptr<Item> m)
 void
 Canvas::destroy()
 {
+	_arrange_timeout.disconnect();
+	_arrange_job.reset();
+
+	_scroll_connections[0].disconnect();
+	_scroll_connections[1].disconnect();
+
 	_remove_objects = false;
 
 	_selected_items.clear();
 	_selected_connections.clear();
 
+	_connection_records.clear();
+	_connection_index.clear();
+	_item_connections.clear();
+	_bundles.clear();
+	_culled_connections.clear();
 	_connections.clear();
 
 	_selected_ports.clear();
 	_connect_port.reset();
 
+	_item_index.clear();
 	_items.clear();
+	_batch_dirty.clear();
 
 	_remove_objects = true;
 }
@@ -419,8 +611,20 @@ Canvas::set_default_placement(boost::shared_ptr<Module> m)
 void
 Canvas::add_item(boost::shared_ptr<Item> m)
 {
-	if (m)
+	if (m) {
+		m->set_detail(_detail);
 		_items.push_back(m);
+		_item_index.insert(m, m->property_x(), m->property_y(), m->width(), m->height());
+	}
+}
+
+
+/** Update the hit-testing bounding box of @a item after it moved or resized.
+ */
+void
+Canvas::item_moved(const Item* item)
+{
+	_item_index.update(item, item->property_x(), item->property_y(), item->width(), item->height());
 }
 
 
@@ -457,25 +661,19 @@ Canvas::remove_item(boost::shared_ptr<Item> item)
 		}
 	}
 
-	// Remove any connections adjacent to this item
-	boost::shared_ptr<Connection> c;
-	for (ConnectionList::iterator i = _connections.begin(); i != _connections.end() ; ) {
-		c = (*i);
-		ConnectionList::iterator next = i;
-		++next;
-
-		const boost::shared_ptr<Port> src_port
-			= boost::dynamic_pointer_cast<Port>(c->source().lock());
-		const boost::shared_ptr<Port> dst_port
-			= boost::dynamic_pointer_cast<Port>(c->dest().lock());
+	_item_index.remove(item.get());
+	_batch_dirty.erase(item.get());
 
-		if (boost::dynamic_pointer_cast<Item>(c->source().lock()) == item
-				|| boost::dynamic_pointer_cast<Item>(c->dest().lock()) == item
-				|| (src_port && src_port->module().lock() == item)
-				|| (dst_port && dst_port->module().lock() == item))
-			remove_connection(c);
+	// Remove any connections adjacent to this item or its ports
+	ItemConnections::iterator adjacent = _item_connections.find(item.get());
+	if (adjacent != _item_connections.end()) {
+		vector< boost::shared_ptr<Connection> > connections;
+		connections.reserve(adjacent->second.size());
+		for (std::unordered_set<const Connection*>::iterator i = adjacent->second.begin(); i != adjacent->second.end(); ++i)
+			connections.push_back(*_connection_records[*i].position);
 
-		i = next;
+		for (vector< boost::shared_ptr<Connection> >::iterator i = connections.begin(); i != connections.end(); ++i)
+			remove_connection(*i);
 	}
 
 	return ret;
@@ -514,15 +712,7 @@ bool
 Canvas::are_connected(boost::shared_ptr<const Connectable> tail,
                       boost::shared_ptr<const Connectable> head)
 {
-	for (ConnectionList::const_iterator c = _connections.begin(); c != _connections.end(); ++c) {
-		const boost::shared_ptr<Connectable> src = (*c)->source().lock();
-		const boost::shared_ptr<Connectable> dst = (*c)->dest().lock();
-
-		if (src == tail && dst == head)
-			return true;
-	}
-
-	return false;
+	return _connection_index.find(ConnectionEnds(tail.get(), head.get())) != _connection_index.end();
 }
 
 
@@ -535,15 +725,52 @@ boost::shared_ptr<Connection>
 Canvas::get_connection(boost::shared_ptr<Connectable> tail,
                            boost::shared_ptr<Connectable> head) const
 {
-	for (ConnectionList::const_iterator i = _connections.begin(); i != _connections.end(); ++i) {
-		const boost::shared_ptr<Connectable> src = (*i)->source().lock();
-		const boost::shared_ptr<Connectable> dst = (*i)->dest().lock();
+	ConnectionIndex::const_iterator i = _connection_index.find(ConnectionEnds(tail.get(), head.get()));
+	if (i == _connection_index.end())
+		return boost::shared_ptr<Connection>();
 
-		if (src == tail && dst == head)
-			return *i;
-	}
+	return *_connection_records.find(i->second)->second.position;
+}
+
+
+/** Get the item a connection end belongs to, for removing its connections with it.
+ */
+static const Item*
+connectable_item(boost::shared_ptr<Connectable> connectable)
+{
+	const boost::shared_ptr<Port> port = boost::dynamic_pointer_cast<Port>(connectable);
+	if (port)
+		return port->module().lock().get();
+
+	return dynamic_cast<const Item*>(connectable.get());
+}
+
+
+void
+Canvas::index_connection(ConnectionList::iterator       position,
+                         boost::shared_ptr<Connectable> tail,
+                         boost::shared_ptr<Connectable> head)
+{
+	const Connection* c = position->get();
+
+	ConnectionRecord& record = _connection_records[c];
+	record.position  = position;
+	record.ends      = ConnectionEnds(tail.get(), head.get());
+	record.tail_item = connectable_item(tail);
+	record.head_item = connectable_item(head);
+
+	_connection_index[record.ends] = c;
+
+	if (record.tail_item)
+		_item_connections[record.tail_item].insert(c);
+	if (record.head_item)
+		_item_connections[record.head_item].insert(c);
+
+	if (position->get()->_culled)
+		_culled_connections.insert(position->get());
 
-	return boost::shared_ptr<Connection>();
+	if (_detail == DETAIL_SUMMARY)
+		bundle_connection(record, true);
 }
 
 
@@ -552,11 +779,14 @@ Canvas::add_connection(boost::shared_ptr<Connectable> src,
                        boost::shared_ptr<Connectable> dst,
                        uint32_t                       color)
 {
+	if (are_connected(src, dst))
+		return false;
+
 	// Create (graphical) connection object
 	boost::shared_ptr<Connection> c(new Connection(shared_from_this(), src, dst, color));
 	src->add_connection(c);
 	dst->add_connection(c);
-	_connections.push_back(c);
+	index_connection(_connections.insert(_connections.end(), c), src, dst);
 
 	return true;
 }
@@ -568,10 +798,10 @@ Canvas::add_connection(boost::shared_ptr<Connection> c)
 	const boost::shared_ptr<Connectable> src = c->source().lock();
 	const boost::shared_ptr<Connectable> dst = c->dest().lock();
 
-	if (src && dst) {
+	if (src && dst && !are_connected(src, dst)) {
 		src->add_connection(c);
 		dst->add_connection(c);
-		_connections.push_back(c);
+		index_connection(_connections.insert(_connections.end(), c), src, dst);
 		return true;
 	} else {
 		return false;
@@ -587,10 +817,10 @@ Canvas::remove_connection(boost::shared_ptr<Connection> connection)
 
 	unselect_connection(connection.get());
 
-	ConnectionList::iterator i = find(_connections.begin(), _connections.end(), connection);
+	ConnectionRecords::iterator r = _connection_records.find(connection.get());
 
-	if (i != _connections.end()) {
-		const boost::shared_ptr<Connection> c = *i;
+	if (r != _connection_records.end()) {
+		const boost::shared_ptr<Connection> c = *r->second.position;
 
 		const boost::shared_ptr<Connectable> src = c->source().lock();
 		const boost::shared_ptr<Connectable> dst = c->dest().lock();
@@ -601,7 +831,24 @@ Canvas::remove_connection(boost::shared_ptr<Connection> connection)
 		if (dst)
 			dst->remove_connection(c);
 
-		_connections.erase(i);
+		_connection_index.erase(r->second.ends);
+		_culled_connections.erase(c.get());
+
+		if (_detail == DETAIL_SUMMARY)
+			bundle_connection(r->second, false);
+
+		const Item* items[2] = { r->second.tail_item, r->second.head_item };
+		for (size_t i = 0; i < 2; ++i) {
+			ItemConnections::iterator adjacent = _item_connections.find(items[i]);
+			if (adjacent != _item_connections.end()) {
+				adjacent->second.erase(c.get());
+				if (adjacent->second.empty())
+					_item_connections.erase(adjacent);
+			}
+		}
+
+		_connections.erase(r->second.position);
+		_connection_records.erase(r);
 	}
 }
 
@@ -966,7 +1213,13 @@ Canvas::select_drag_handler(GdkEvent* event)
 		return true;
 	} else if (event->type == GDK_BUTTON_RELEASE && _drag_state == SELECT) {
 		// Select all modules within rect
-		for (ItemList::iterator i = _items.begin(); i != _items.end(); ++i) {
+		SpatialIndex<Item>::Result candidates;
+		_item_index.query_rect(
+			_select_rect->property_x1(), _select_rect->property_y1(),
+			_select_rect->property_x2(), _select_rect->property_y2(),
+			candidates);
+
+		for (SpatialIndex<Item>::Result::iterator i = candidates.begin(); i != candidates.end(); ++i) {
 			module = (*i);
 			if (module->is_within(*_select_rect)) {
 				if (module->selected())
@@ -1205,9 +1458,11 @@ Canvas::connection_drag_handler(GdkEvent* event)
 boost::shared_ptr<Port>
 Canvas::get_port_at(double x, double y)
 {
-	// Loop through every port and see if the item at these coordinates is that port
-	// (if you're thinking this is slow, stupid, and disgusting, you're right)
-	for (ItemList::const_iterator i = _items.begin(); i != _items.end(); ++i) {
+	// Only modules with bounding box at these coordinates can have the port
+	SpatialIndex<Item>::Result candidates;
+	_item_index.query_point(x, y, candidates);
+
+	for (SpatialIndex<Item>::Result::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
 		const boost::shared_ptr<Module> m
 			= boost::dynamic_pointer_cast<Module>(*i);
 
@@ -1239,6 +1494,7 @@ class GVNodes : public std::map<boost::shared_ptr<Item>, void*> {};
 #endif
 
 
+/** Caller must hold graphviz_mutex until the returned nodes are cleaned up. */
 GVNodes
 Canvas::layout_dot(bool use_length_hints, const std::string& filename)
 {
@@ -1344,74 +1600,400 @@ void
 Canvas::render_to_dot(const string& dot_output_filename)
 {
 #ifdef HAVE_AGRAPH
+	std::lock_guard<std::mutex> lock(graphviz_mutex);
+
 	GVNodes nodes = layout_dot(false, dot_output_filename);
 	nodes.cleanup();
 #endif
 }
 
 
+/** Snapshot of the canvas graph for laying it out on a worker thread.
+ *
+ * The worker only touches the job, never the canvas, so the canvas can keep
+ * changing (or go away) while graphviz runs.
+ */
+class ArrangeJob : boost::noncopyable {
+public:
+	struct Node {
+		boost::weak_ptr<Item> item;
+		std::string           name;
+		double                width;
+		double                height;
+		bool                  is_module;
+		double                x, y;             ///< Centre, set by run()
+		double                from_x, from_y;   ///< Top left when animation started
+		double                to_x, to_y;       ///< Top left when animation ends
+	};
+
+	struct Edge {
+		size_t tail;
+		size_t head;
+		double minlen; ///< 0 for none
+	};
+
+	ArrangeJob() : cancelled(false), done(false), succeeded(false) {}
+
+	void run();
+
+	Canvas::FlowDirection direction;
+	bool                  center;
+	std::vector<Node>     nodes;
+	std::vector<Edge>     edges;
+
+	std::atomic<bool> cancelled;
+	std::atomic<bool> done;
+	bool              succeeded; ///< Valid once done is set
+};
+
+
+void
+ArrangeJob::run()
+{
+#ifdef HAVE_AGRAPH
+	std::lock_guard<std::mutex> lock(graphviz_mutex);
+
+	if (cancelled) {
+		done = true;
+		return;
+	}
+
+	GVC_t*    gvc = gvContext();
+	Agraph_t* G   = agopen((char*)"g", AGDIGRAPH);
+
+	agraphattr(G, (char*)"rankdir", (char*)(direction == Canvas::HORIZONTAL ? "LR" : "TD"));
+
+	// graphviz copies attribute values, and always wants them in the C locale
+	std::vector<Agnode_t*> gv_nodes(nodes.size());
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		std::ostringstream ss;
+		ss.imbue(std::locale::classic());
+		ss << "n" << i;
+		gv_nodes[i] = agnode(G, (char*)ss.str().c_str());
+
+		if (nodes[i].is_module) {
+			ss.str("");
+			ss << nodes[i].width / 96.0;
+			agsafeset(gv_nodes[i], (char*)"width", (char*)ss.str().c_str(), (char*)"");
+			ss.str("");
+			ss << nodes[i].height / 96.0;
+			agsafeset(gv_nodes[i], (char*)"height", (char*)ss.str().c_str(), (char*)"");
+			agsafeset(gv_nodes[i], (char*)"shape", (char*)"box", (char*)"");
+		} else {
+			agsafeset(gv_nodes[i], (char*)"width", (char*)"1.0", (char*)"");
+			agsafeset(gv_nodes[i], (char*)"height", (char*)"1.0", (char*)"");
+			agsafeset(gv_nodes[i], (char*)"shape", (char*)"ellipse", (char*)"");
+		}
+		agsafeset(gv_nodes[i], (char*)"label", (char*)nodes[i].name.c_str(), (char*)"");
+	}
+
+	for (std::vector<Edge>::const_iterator e = edges.begin(); e != edges.end(); ++e) {
+		Agedge_t* edge = agedge(G, gv_nodes[e->tail], gv_nodes[e->head]);
+		if (e->minlen != 0) {
+			std::ostringstream ss;
+			ss.imbue(std::locale::classic());
+			ss << e->minlen;
+			agsafeset(edge, (char*)"minlen", (char*)ss.str().c_str(), (char*)"1.0");
+		}
+	}
+
+	if (!cancelled) {
+		gvLayout(gvc, G, (char*)"dot");
+
+		FILE* null = fopen("/dev/null", "w");
+		gvRender(gvc, G, (char*)"dot", null); // sets the pos attributes
+		fclose(null);
+
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			std::istringstream ss(agget(gv_nodes[i], (char*)"pos"));
+			ss.imbue(std::locale::classic());
+			char comma;
+			ss >> nodes[i].x >> comma >> nodes[i].y;
+			nodes[i].x *= 1.25;
+			nodes[i].y *= -1.25;
+		}
+
+		gvFreeLayout(gvc, G);
+		succeeded = true;
+	}
+
+	agclose(G);
+	gvFreeContext(gvc);
+#endif
+
+	done = true;
+}
+
+
+/** Start laying out all items with graphviz.
+ *
+ * The layout runs on a worker thread from a snapshot of the items and
+ * connections.  When it is done the items are moved to their new places
+ * over a few frames, and their locations are stored.  A running arrange is
+ * replaced by the new one.
+ */
 void
 Canvas::arrange(bool use_length_hints, bool center)
 {
 #ifdef HAVE_AGRAPH
-	GVNodes nodes = layout_dot(use_length_hints, "");
+	cancel_arrange();
+
+	if (_items.empty())
+		return;
 
-	double least_x=HUGE_VAL, least_y=HUGE_VAL, most_x=0, most_y=0;
+	boost::shared_ptr<ArrangeJob> job(new ArrangeJob());
+	job->direction = _direction;
+	job->center    = center;
+	job->nodes.reserve(_items.size());
+	job->edges.reserve(_connections.size());
 
-	// Set numeric locale to POSIX for reading graphviz output with strtod
-	char* locale = strdup(setlocale(LC_NUMERIC, NULL));
-	setlocale(LC_NUMERIC, "POSIX");
+	std::unordered_map<const Item*, size_t> node_ids;
+	for (ItemList::const_iterator i = _items.begin(); i != _items.end(); ++i) {
+		ArrangeJob::Node node;
+		node.item      = *i;
+		node.name      = (*i)->name();
+		node.width     = (*i)->width();
+		node.height    = (*i)->height();
+		node.is_module = bool(boost::dynamic_pointer_cast<Module>(*i));
+		node.x = node.y = 0;
+		node_ids[i->get()] = job->nodes.size();
+		job->nodes.push_back(node);
+	}
 
-	// Arrange to graphviz coordinates
-	for (GVNodes::iterator i = nodes.begin(); i != nodes.end(); ++i) {
-		const string pos   = agget(i->second, (char*)"pos");
-		const string x_str = pos.substr(0, pos.find(","));
-		const string y_str = pos.substr(pos.find(",")+1);
-		const double x     = strtod(x_str.c_str(), NULL) * 1.25;
-		const double y     = -strtod(y_str.c_str(), NULL) * 1.25;
-
-		i->first->property_x() = x - i->first->width()/2.0;
-		i->first->property_y() = y - i->first->height()/2.0;
-
-		least_x = std::min(least_x, x);
-		least_y = std::min(least_y, y);
-		most_x  = std::max(most_x, x);
-		most_y  = std::max(most_y, y);
+	for (ConnectionRecords::const_iterator r = _connection_records.begin(); r != _connection_records.end(); ++r) {
+		std::unordered_map<const Item*, size_t>::const_iterator tail = node_ids.find(r->second.tail_item);
+		std::unordered_map<const Item*, size_t>::const_iterator head = node_ids.find(r->second.head_item);
+		if (tail == node_ids.end() || head == node_ids.end())
+			continue;
+
+		ArrangeJob::Edge edge;
+		edge.tail   = tail->second;
+		edge.head   = head->second;
+		edge.minlen = use_length_hints ? r->first->length_hint() : 0;
+		job->edges.push_back(edge);
+	}
+
+	// Add edges between partners to have them lined up as if they are connected
+	for (ItemList::const_iterator i = _items.begin(); i != _items.end(); ++i) {
+		boost::shared_ptr<Item> partner = (*i)->partner().lock();
+		if (partner) {
+			std::unordered_map<const Item*, size_t>::const_iterator p = node_ids.find(partner.get());
+			if (p != node_ids.end()) {
+				ArrangeJob::Edge edge = { node_ids[i->get()], p->second, 0 };
+				job->edges.push_back(edge);
+			}
+		}
 	}
 
-	// Reset numeric locale to original value
-	setlocale(LC_NUMERIC, locale);
-	free(locale);
+	_arrange_job  = job;
+	_arrange_step = 0;
+
+	std::thread(&ArrangeJob::run, job).detach();
+
+	_arrange_timeout = Glib::signal_timeout().connect(
+		sigc::mem_fun(this, &Canvas::arrange_tick), ARRANGE_TICK_MS);
+#endif
+}
+
+
+/** Stop a running arrange.
+ *
+ * If the layout is still running its result is dropped.  If it is already
+ * being applied, items stay where they are now and these locations are stored.
+ */
+void
+Canvas::cancel_arrange()
+{
+	if (!_arrange_job)
+		return;
+
+	boost::shared_ptr<ArrangeJob> job = _arrange_job;
+	_arrange_timeout.disconnect();
+	_arrange_job.reset();
+	job->cancelled = true;
+
+	if (_arrange_step == 0)
+		return;
+
+	for (std::vector<ArrangeJob::Node>::const_iterator n = job->nodes.begin(); n != job->nodes.end(); ++n) {
+		boost::shared_ptr<Item> item = n->item.lock();
+		if (item && _item_index.contains(item.get()))
+			item->store_location();
+	}
+}
+
+
+/** Compute where items go, from the finished layout and their current places. */
+void
+Canvas::arrange_targets()
+{
+	ArrangeJob& job = *_arrange_job;
+
+	double least_x=HUGE_VAL, least_y=HUGE_VAL, most_x=-HUGE_VAL, most_y=-HUGE_VAL;
+	for (std::vector<ArrangeJob::Node>::const_iterator n = job.nodes.begin(); n != job.nodes.end(); ++n) {
+		least_x = std::min(least_x, n->x);
+		least_y = std::min(least_y, n->y);
+		most_x  = std::max(most_x, n->x);
+		most_y  = std::max(most_y, n->y);
+	}
 
 	const double graph_width  = most_x - least_x;
 	const double graph_height = most_y - least_y;
 
-	//cerr << "CWH: " << _width << ", " << _height << endl;
-	//cerr << "GWH: " << graph_width << ", " << graph_height << endl;
-
 	if (graph_width + 10 > _width)
 		resize(graph_width + 10, _height);
 
 	if (graph_height + 10 > _height)
 		resize(_width, graph_height + 10);
 
-	nodes.cleanup();
-
-	if (center) {
-		move_contents_to_internal(
-				_width / 2.0 - (graph_width / 2.0),
-				_height / 2.0 - (graph_height / 2.0), least_x, least_y);
+	double dx, dy;
+	if (job.center) {
+		dx = _width / 2.0 - (graph_width / 2.0) - least_x;
+		dy = _height / 2.0 - (graph_height / 2.0) - least_y;
 		scroll_to_center();
 	} else {
 		static const double border_width = 64.0;
-		move_contents_to_internal(border_width, border_width, least_x, least_y);
+		dx = border_width - least_x;
+		dy = border_width - least_y;
 		scroll_to(0, 0);
 	}
 
-	for (ItemList::const_iterator i = _items.begin(); i != _items.end(); ++i)
-		(*i)->store_location();
+	for (std::vector<ArrangeJob::Node>::iterator n = job.nodes.begin(); n != job.nodes.end(); ++n) {
+		boost::shared_ptr<Item> item = n->item.lock();
+		if (!item)
+			continue;
 
-#endif
+		n->from_x = item->property_x();
+		n->from_y = item->property_y();
+		n->to_x   = n->x + dx - item->width() / 2.0;
+		n->to_y   = n->y + dy - item->height() / 2.0;
+	}
+}
+
+
+bool
+Canvas::arrange_tick()
+{
+	boost::shared_ptr<ArrangeJob> job = _arrange_job;
+
+	if (!job->done)
+		return true;
+
+	if (!job->succeeded) {
+		_arrange_job.reset();
+		return false;
+	}
+
+	if (_arrange_step == 0)
+		arrange_targets();
+
+	++_arrange_step;
+	const double t = (double)_arrange_step / ARRANGE_ANIMATION_STEPS;
+
+	for (std::vector<ArrangeJob::Node>::const_iterator n = job->nodes.begin(); n != job->nodes.end(); ++n) {
+		boost::shared_ptr<Item> item = n->item.lock();
+		if (!item || !_item_index.contains(item.get()))
+			continue; // removed while arranging
+
+		const double x = n->from_x + (n->to_x - n->from_x) * t;
+		const double y = n->from_y + (n->to_y - n->from_y) * t;
+		item->move(x - item->property_x(), y - item->property_y());
+
+		if (_arrange_step == ARRANGE_ANIMATION_STEPS)
+			item->store_location();
+	}
+
+	if (_arrange_step < ARRANGE_ANIMATION_STEPS)
+		return true;
+
+	_arrange_job.reset();
+	_arrange_step = 0;
+	return false;
+}
+
+
+/** Put @a item next to the items it is connected to.
+ *
+ * For a newly appeared item, to avoid arranging the whole canvas.  The item
+ * goes downstream of the items feeding it (or upstream of the items it feeds
+ * if there are none), at their average height, and is pushed along until it
+ * does not overlap anything.  Other items are not moved.
+ *
+ * Returns false, without moving @a item, if it has no connections.
+ */
+bool
+Canvas::place_near_neighbours(boost::shared_ptr<Item> item)
+{
+	ItemConnections::const_iterator adjacent = _item_connections.find(item.get());
+	if (adjacent == _item_connections.end())
+		return false;
+
+	const bool horizontal = (_direction == HORIZONTAL);
+
+	double   upstream_end     = -HUGE_VAL; // furthest edge of feeding items along the flow
+	double   downstream_start = HUGE_VAL;  // nearest edge of fed items along the flow
+	double   across_sum       = 0;         // sum of neighbour positions across the flow
+	unsigned neighbours       = 0;
+
+	for (std::unordered_set<const Connection*>::const_iterator c = adjacent->second.begin();
+			c != adjacent->second.end(); ++c) {
+		ConnectionRecords::const_iterator r = _connection_records.find(*c);
+		if (r == _connection_records.end())
+			continue;
+
+		const bool   is_tail = (r->second.tail_item == item.get());
+		const Item*  other   = is_tail ? r->second.head_item : r->second.tail_item;
+		double x1, y1, x2, y2;
+		if (other == item.get() || !_item_index.box(other, x1, y1, x2, y2))
+			continue;
+
+		if (is_tail)
+			downstream_start = std::min(downstream_start, horizontal ? x1 : y1);
+		else
+			upstream_end = std::max(upstream_end, horizontal ? x2 : y2);
+
+		across_sum += horizontal ? y1 : x1;
+		++neighbours;
+	}
+
+	if (neighbours == 0)
+		return false;
+
+	const double along_size  = horizontal ? item->width() : item->height();
+	const double across_size = horizontal ? item->height() : item->width();
+
+	const double along = (upstream_end != -HUGE_VAL)
+		? upstream_end + PLACEMENT_GAP
+		: downstream_start - PLACEMENT_GAP - along_size;
+	double across = across_sum / neighbours;
+
+	SpatialIndex<Item>::Result overlapping;
+	for (unsigned tries = 0; tries < _items.size(); ++tries) {
+		if (horizontal)
+			_item_index.query_rect(along, across, along + along_size, across + across_size, overlapping);
+		else
+			_item_index.query_rect(across, along, across + across_size, along + along_size, overlapping);
+
+		double next = across;
+		for (SpatialIndex<Item>::Result::const_iterator i = overlapping.begin(); i != overlapping.end(); ++i) {
+			double x1, y1, x2, y2;
+			if (i->get() != item.get() && _item_index.box(i->get(), x1, y1, x2, y2))
+				next = std::max(next, (horizontal ? y2 : x2) + PLACEMENT_GAP);
+		}
+
+		if (next == across)
+			break;
+
+		across = next;
+	}
+
+	const double x = horizontal ? along : across;
+	const double y = horizontal ? across : along;
+
+	item->move(x - item->property_x(), y - item->property_y());
+	item->store_location();
+
+	return true;
 }
 
 
@@ -1439,15 +2021,25 @@ void
 Canvas::resize(double width, double height)
 {
 	if (width != _width || height != _height) {
-		_base_rect.property_x2() = _base_rect.property_x1() + width;
-		_base_rect.property_y2() = _base_rect.property_y1() + height;
 		_width = width;
 		_height = height;
-		set_scroll_region(0.0, 0.0, width, height);
+		if (_batch_depth > 0 || _batch_flushing)
+			_batch_resized = true;
+		else
+			apply_size();
 	}
 }
 
 
+void
+Canvas::apply_size()
+{
+	_base_rect.property_x2() = _base_rect.property_x1() + _width;
+	_base_rect.property_y2() = _base_rect.property_y1() + _height;
+	set_scroll_region(0.0, 0.0, _width, _height);
+}
+
+
 void
 Canvas::resize_all_items()
 {
@@ -1456,4 +2048,44 @@ Canvas::resize_all_items()
 }
 
 
+/** Start adding or changing many items at once.
+ *
+ * Until the matching end_batch(), modules are not laid out as their ports
+ * change and the canvas scroll region is not updated.  Calls nest.
+ */
+void
+Canvas::begin_batch()
+{
+	++_batch_depth;
+}
+
+
+/** Lay out every module changed since begin_batch(), once, and apply the
+ * final canvas size.
+ */
+void
+Canvas::end_batch()
+{
+	assert(_batch_depth > 0);
+	if (--_batch_depth > 0)
+		return;
+
+	if (!_batch_dirty.empty()) {
+		std::unordered_set<const Item*> dirty;
+		dirty.swap(_batch_dirty);
+
+		_batch_flushing = true;
+		for (ItemList::const_iterator i = _items.begin(); i != _items.end(); ++i)
+			if (dirty.find(i->get()) != dirty.end())
+				(*i)->resize();
+		_batch_flushing = false;
+	}
+
+	if (_batch_resized) {
+		_batch_resized = false;
+		apply_size();
+	}
+}
+
+
 } // namespace FlowCanvas
@@ -20,6 +20,10 @@
 
 #include <list>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/utility.hpp>
@@ -29,6 +33,7 @@
 #include "Connection.hpp"
 #include "Item.hpp"
 #include "Module.hpp"
+#include "SpatialIndex.hpp"
 
 
 /** FlowCanvas namespace, everything is defined under this.
@@ -40,6 +45,7 @@ namespace FlowCanvas {
 class Port;
 class Module;
 class GVNodes;
+class ArrangeJob;
 
 
 /** \defgroup FlowCanvas FlowCanvas
@@ -101,8 +107,17 @@ public:
 	void   set_zoom(double pix_per_unit);
 	void   zoom_full();
 
+	DetailLevel detail() const { return _detail; }
+	bool        culls(double x1, double y1, double x2, double y2) const;
+
+	boost::shared_ptr<Port> get_port_at(double x, double y);
+
 	void render_to_dot(const std::string& filename);
 	virtual void arrange(bool use_length_hints=false, bool center=true);
+	void cancel_arrange();
+	bool arranging() const { return bool(_arrange_job); }
+
+	bool place_near_neighbours(boost::shared_ptr<Item> item);
 
 	void move_contents_to(double x, double y);
 
@@ -112,6 +127,10 @@ public:
 	void resize(double width, double height);
 	void resize_all_items();
 
+	void begin_batch();
+	void end_batch();
+	bool in_batch() const { return _batch_depth > 0; }
+
 	void scroll_to_center();
 
 	enum FlowDirection {
@@ -148,22 +167,37 @@ protected:
 
 private:
 	friend class Module;
+	friend class Ellipse;
+	friend class Connection;
 	bool port_event(GdkEvent* event, boost::weak_ptr<Port> port);
 
+	void item_moved(const Item* item);
+	void defer_resize(const Item* item) { _batch_dirty.insert(item); }
+	void apply_size();
+
+	void set_detail(DetailLevel level);
+	void update_visible_area();
+	void update_culling();
+
 	GVNodes layout_dot(bool use_length_hints, const std::string& filename);
 
+	bool arrange_tick();
+	void arrange_targets();
+
 	void remove_connection(boost::shared_ptr<Connection> c);
 	bool are_connected(boost::shared_ptr<const Connectable> tail,
 	                   boost::shared_ptr<const Connectable> head);
 
+	void index_connection(ConnectionList::iterator position,
+	                      boost::shared_ptr<Connectable> tail,
+	                      boost::shared_ptr<Connectable> head);
+
 	void select_port(boost::shared_ptr<Port> p, bool unique = false);
 	void select_port_toggle(boost::shared_ptr<Port> p, int mod_state);
 	void unselect_port(boost::shared_ptr<Port> p);
 	void selection_joined_with(boost::shared_ptr<Port> port);
 	void join_selection();
 
-	boost::shared_ptr<Port> get_port_at(double x, double y);
-
 	bool scroll_drag_handler(GdkEvent* event);
 	bool select_drag_handler(GdkEvent* event);
 	bool connection_drag_handler(GdkEvent* event);
@@ -178,6 +212,54 @@ private:
 
 	typedef std::list< boost::shared_ptr<Port> > SelectedPorts;
 
+	SpatialIndex<Item> _item_index; ///< Bounding boxes of _items, for hit-testing
+
+	typedef std::pair<const Connectable*, const Connectable*> ConnectionEnds;
+
+	struct ConnectionEndsHash {
+		template <typename A, typename B>
+		size_t operator()(const std::pair<A*, B*>& ends) const {
+			const size_t h = std::hash<A*>()(ends.first);
+			return h ^ (std::hash<B*>()(ends.second) + 0x9E3779B9 + (h << 6) + (h >> 2));
+		}
+	};
+
+	/** Where a connection is stored and what it is indexed by.
+	 * The ends are kept because the connection only has weak references to them. */
+	struct ConnectionRecord {
+		ConnectionList::iterator position;
+		ConnectionEnds           ends;
+		const Item*              tail_item;
+		const Item*              head_item;
+	};
+
+	typedef std::unordered_map<const Connection*, ConnectionRecord>                   ConnectionRecords;
+	typedef std::unordered_map<ConnectionEnds, const Connection*, ConnectionEndsHash> ConnectionIndex;
+	typedef std::unordered_map<const Item*, std::unordered_set<const Connection*> >  ItemConnections;
+
+	ConnectionRecords _connection_records; ///< All entries of _connections
+	ConnectionIndex   _connection_index;   ///< (tail, head) -> connection
+	ItemConnections   _item_connections;   ///< Connections of each item or its ports
+
+	void bundle_connection(const ConnectionRecord& record, bool add);
+	void connection_culled(Connection* c, bool culled);
+
+	typedef std::pair<const Item*, const Item*>                                          ItemPair;
+	typedef std::unordered_map<ItemPair, std::vector<Connection*>, ConnectionEndsHash> Bundles;
+
+	DetailLevel                      _detail;
+	Bundles                          _bundles; ///< Connections between two items, first one is drawn, at DETAIL_SUMMARY
+	std::unordered_set<Connection*>  _culled_connections;
+	double                           _visible_x1, _visible_y1, _visible_x2, _visible_y2; ///< Area not culled
+	sigc::connection                 _scroll_connections[2];
+
+	boost::shared_ptr<ArrangeJob> _arrange_job;     ///< Layout running or being applied
+	sigc::connection              _arrange_timeout; ///< Polls and animates _arrange_job
+	unsigned                      _arrange_step;    ///< Animation frame, 0 while layout runs
+
+	unsigned                        _batch_depth; ///< Nesting level of begin_batch()
+	std::unordered_set<const Item*> _batch_dirty; ///< Items to resize at end of batch
+
 	SelectedPorts           _selected_ports; ///< Selected ports (hilited red)
 	boost::shared_ptr<Port> _connect_port;  ///< Port for which a connection is being made
 	boost::shared_ptr<Port> _last_selected_port;
@@ -197,6 +279,8 @@ private:
 
 	bool _remove_objects :1; // flag to avoid removing objects from destructors when unnecessary
 	bool _locked         :1;
+	bool _batch_flushing :1; ///< Resizing dirty items in end_batch()
+	bool _batch_resized  :1; ///< Size changed while batching, not applied yet
 };
 
 
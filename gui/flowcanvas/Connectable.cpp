@@ -56,13 +56,10 @@ Connectable::add_connection(boost::shared_ptr<Connection> connection)
 	assert(connection->source().lock().get() == this
 		|| connection->dest().lock().get() == this);
 
-	for (list<boost::weak_ptr<Connection> >::iterator i = _connections.begin(); i != _connections.end(); i++) {
-		boost::shared_ptr<Connection> c = (*i).lock();
-		if (c && c == connection)
-			return;
-	}
+	if (_connection_positions.find(connection.get()) != _connection_positions.end())
+		return;
 
-	_connections.push_back(connection);
+	_connection_positions[connection.get()] = _connections.insert(_connections.end(), connection);
 }
 
 
@@ -73,12 +70,10 @@ Connectable::add_connection(boost::shared_ptr<Connection> connection)
 void
 Connectable::remove_connection(boost::shared_ptr<Connection> c)
 {
-	for (list<boost::weak_ptr<Connection> >::iterator i = _connections.begin(); i != _connections.end(); i++) {
-		boost::shared_ptr<Connection> connection = i->lock();
-		if (connection && connection == c) {
-			_connections.erase(i);
-			break;
-		}
+	std::unordered_map<const Connection*, Connections::iterator>::iterator i = _connection_positions.find(c.get());
+	if (i != _connection_positions.end()) {
+		_connections.erase(i->second);
+		_connection_positions.erase(i);
 	}
 }
 
@@ -19,6 +19,7 @@
 #define FLOWCANVAS_CONNECTABLE_HPP
 
 #include <list>
+#include <unordered_map>
 
 #include <boost/shared_ptr.hpp>
 
@@ -50,6 +51,9 @@ public:
 
 protected:
 	Connections _connections; ///< needed for dragging
+
+	/// Position of each connection in _connections, for constant time add/remove
+	std::unordered_map<const Connection*, Connections::iterator> _connection_positions;
 };
 
 
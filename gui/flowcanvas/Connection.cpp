@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <sstream>
 #include <string>
 
 #include <libgnomecanvasmm.h>
@@ -42,10 +43,15 @@ Connection::Connection(boost::shared_ptr<Canvas>      canvas,
 	, _bpath(*this)
 	, _path(gnome_canvas_path_def_new())
 	, _handle(NULL)
+	, _bundle_label(NULL)
 	, _color(color)
 	, _handle_style(HANDLE_NONE)
+	, _bundle_size(1)
+	, _mid_x(0)
+	, _mid_y(0)
 	, _selected(false)
 	, _show_arrowhead(show_arrowhead)
+	, _culled(false)
 {
 	_bpath.property_width_units() = 2.0;
 	set_color(color);
@@ -57,6 +63,7 @@ Connection::Connection(boost::shared_ptr<Canvas>      canvas,
 
 Connection::~Connection()
 {
+	delete _bundle_label;
 	gnome_canvas_path_def_unref(_path);
 }
 
@@ -89,6 +96,9 @@ Connection::update_location()
 	if (!src || !dst)
 		return;
 
+	if (_bundle_size == 0)
+		return; // drawn by another connection of the bundle
+
 	bool straight = (boost::dynamic_pointer_cast<Ellipse>(src)
 	              || boost::dynamic_pointer_cast<Ellipse>(dst));
 
@@ -100,6 +110,26 @@ Connection::update_location()
 	const double dst_x = dst_point.get_x();
 	const double dst_y = dst_point.get_y();
 
+	boost::shared_ptr<Canvas> canvas = _canvas.lock();
+	const bool culled = canvas && canvas->culls(std::min(src_x, dst_x), std::min(src_y, dst_y),
+	                                            std::max(src_x, dst_x), std::max(src_y, dst_y));
+	if (culled != _culled) {
+		_culled = culled;
+		if (canvas)
+			canvas->connection_culled(this, culled);
+		update_visibility();
+	}
+
+	if (culled)
+		return; // updated when it gets into view
+
+	_mid_x = (src_x + dst_x) / 2.0;
+	_mid_y = (src_y + dst_y) / 2.0;
+	if (_bundle_label) {
+		_bundle_label->property_x() = _mid_x;
+		_bundle_label->property_y() = _mid_y;
+	}
+
 	if (straight) {
 
 		gnome_canvas_path_def_reset(_path);
@@ -335,6 +365,49 @@ Connection::select_tick()
 }
 
 
+void
+Connection::set_bundle_size(unsigned n)
+{
+	if (n == _bundle_size)
+		return;
+
+	const bool was_hidden = (_bundle_size == 0);
+	_bundle_size = n;
+
+	if (n > 1) {
+		std::ostringstream ss;
+		ss << n;
+		if (!_bundle_label) {
+			_bundle_label = new Gnome::Canvas::Text(*this, _mid_x, _mid_y, ss.str());
+			_bundle_label->property_fill_color_rgba() = _color;
+		} else {
+			_bundle_label->property_text() = ss.str();
+		}
+		_bundle_label->show();
+	} else {
+		delete _bundle_label;
+		_bundle_label = NULL;
+	}
+
+	_bpath.property_width_units() = (n > 1) ? 4.0 : 2.0;
+
+	update_visibility();
+
+	if (was_hidden && n > 0)
+		update_location(); // was not updated while hidden
+}
+
+
+void
+Connection::update_visibility()
+{
+	if (_bundle_size > 0 && !_culled)
+		show();
+	else
+		hide();
+}
+
+
 void
 Connection::zoom(double z)
 {
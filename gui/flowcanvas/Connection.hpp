@@ -80,10 +80,16 @@ public:
 
 	void set_handle_style(HandleStyle s) { _handle_style = s; }
 
+	/** Number of connections this one is drawn for, see Canvas::set_zoom().
+	 * 0 hides the connection, more than 1 shows the count next to it. */
+	void     set_bundle_size(unsigned n);
+	unsigned bundle_size() const { return _bundle_size; }
+
 protected:
 	friend class Canvas;
 	friend class Connectable;
 	void update_location();
+	void update_visibility();
 
 	const boost::weak_ptr<Canvas>      _canvas;
 	const boost::weak_ptr<Connectable> _source;
@@ -101,11 +107,17 @@ protected:
 		Gnome::Canvas::Text*  text;
 	}* _handle;
 
+	Gnome::Canvas::Text* _bundle_label;
+
 	uint32_t    _color;
 	HandleStyle _handle_style;
+	unsigned    _bundle_size;
+	double      _mid_x; ///< Middle of the path, for the bundle label
+	double      _mid_y;
 
 	bool _selected       :1;
 	bool _show_arrowhead :1;
+	bool _culled         :1; ///< Offscreen, path not updated
 };
 
 typedef std::list<boost::shared_ptr<Connection> > ConnectionList;
@@ -217,6 +217,10 @@ Ellipse::set_width(double w)
 {
 	_width = w;
 //	_ellipse.property_x2() = _ellipse.property_x1() + w;
+
+	boost::shared_ptr<Canvas> canvas = _canvas.lock();
+	if (canvas)
+		canvas->item_moved(this);
 }
 
 
@@ -225,6 +229,10 @@ Ellipse::set_height(double h)
 {
 	_height = h;
 //	_ellipse.property_y2() = _ellipse.property_y1() + h;
+
+	boost::shared_ptr<Canvas> canvas = _canvas.lock();
+	if (canvas)
+		canvas->item_moved(this);
 }
 
 
@@ -256,6 +264,8 @@ Ellipse::move(double dx, double dy)
 	Gnome::Canvas::Group::move(dx, dy);
 
 	move_connections();
+
+	canvas->item_moved(this);
 }
 
 
@@ -289,6 +299,8 @@ Ellipse::move_to(double x, double y)
 	Gnome::Canvas::Group::move(0, 0);
 
 	move_connections();
+
+	canvas->item_moved(this);
 }
 
 
@@ -35,6 +35,17 @@ namespace FlowCanvas {
 class Canvas;
 
 
+/** How much of an item is drawn, depending on the zoom level.
+ *
+ * \ingroup FlowCanvas
+ */
+enum DetailLevel {
+	DETAIL_FULL,      ///< Everything
+	DETAIL_NO_LABELS, ///< Port labels are hidden
+	DETAIL_SUMMARY    ///< Ports of a module are drawn as one bar per side, connections are bundled
+};
+
+
 /** An item on a Canvas.
  *
  * \ingroup FlowCanvas
@@ -61,6 +72,7 @@ public:
 	virtual void move(double dx, double dy) = 0;
 
 	virtual void zoom(double z) {}
+	virtual void set_detail(DetailLevel level) {}
 	boost::weak_ptr<Canvas> canvas() const { return _canvas; }
 
 	bool popup_menu(guint button, guint32 activate_time) {
@@ -39,6 +39,7 @@ static const uint32_t MODULE_HILITE_OUTLINE_COLOUR = 0xEEEEECFF;
 static const uint32_t MODULE_TITLE_COLOUR          = 0xFFFFFFFF;
 static const double   MODULE_EMPTY_PORT_BREADTH    = 12.0;
 static const double   MODULE_EMPTY_PORT_DEPTH      = 6.0;
+static const double   MODULE_PORT_INDEX_CELL_SIZE  = 32.0;
 
 
 /** Construct a Module
@@ -56,12 +57,14 @@ Module::Module(
 		double x, double y,
 		bool show_title, bool show_port_labels)
 	: Item(canvas, name, x, y, MODULE_FILL_COLOUR)
+	, _port_index(MODULE_PORT_INDEX_CELL_SIZE)
 	, _module_box(*this, 0, 0, 0, 0) // w, h set later
 	, _canvas_title(*this, 0, 8, name) // x set later
 	, _stacked_border(NULL)
 	, _icon_box(NULL)
 	, _embed_container(NULL)
 	, _embed_item(NULL)
+	, _detail(DETAIL_FULL)
 	, _border_width(1.0)
 	, _embed_width(0)
 	, _embed_height(0)
@@ -73,6 +76,7 @@ Module::Module(
 	, _title_visible(show_title)
 	, _port_renamed(false)
 	, _show_port_labels(show_port_labels)
+	, _port_index_dirty(true)
 {
 	_module_box.property_fill_color_rgba() = MODULE_FILL_COLOUR;
 	_module_box.property_outline_color_rgba() = MODULE_OUTLINE_COLOUR;
@@ -95,6 +99,8 @@ Module::Module(
 		_canvas_title.hide();
 	}
 
+	_summary_bars[0] = _summary_bars[1] = NULL;
+
 	set_width(10.0);
 	set_height(10.0);
 }
@@ -104,6 +110,8 @@ Module::~Module()
 {
 	delete _stacked_border;
 	delete _icon_box;
+	delete _summary_bars[0];
+	delete _summary_bars[1];
 }
 
 
@@ -252,7 +260,13 @@ Module::port_at(double x, double y)
 	x -= property_x();
 	y -= property_y();
 
-	for (PortVector::iterator p = _ports.begin(); p != _ports.end(); ++p) {
+	if (_port_index_dirty)
+		index_ports();
+
+	SpatialIndex<Port>::Result candidates;
+	_port_index.query_point(x, y, candidates);
+
+	for (SpatialIndex<Port>::Result::iterator p = candidates.begin(); p != candidates.end(); ++p) {
 		boost::shared_ptr<Port> port = *p;
 		if (x > port->property_x() && x < port->property_x() + port->width()
 				&& y > port->property_y() && y < port->property_y() + port->height()) {
@@ -264,13 +278,58 @@ Module::port_at(double x, double y)
 }
 
 
+/** Rebuild the index of port locations.
+ *
+ * Ports only move relative to the module when it is resized, so this is
+ * done lazily on the first hit-test after that instead of on every change.
+ */
+void
+Module::index_ports()
+{
+	_port_index.clear();
+
+	for (PortVector::iterator p = _ports.begin(); p != _ports.end(); ++p)
+		_port_index.insert(*p, (*p)->property_x(), (*p)->property_y(), (*p)->width(), (*p)->height());
+
+	_port_index_dirty = false;
+}
+
+
+/** Update the canvas hit-testing index after the module moved or resized.
+ */
+void
+Module::moved()
+{
+	boost::shared_ptr<Canvas> canvas = _canvas.lock();
+	if (canvas)
+		canvas->item_moved(this);
+}
+
+
 void
 Module::remove_port(boost::shared_ptr<Port> port)
 {
 	PortVector::iterator i = std::find(_ports.begin(), _ports.end(), port);
 
 	if (i != _ports.end()) {
+		// Remove the port's connections, the canvas indexes them by port address
+		boost::shared_ptr<Canvas> canvas = _canvas.lock();
+		if (canvas) {
+			const Port::Connections connections = port->connections(); // copy
+			for (Port::Connections::const_iterator c = connections.begin(); c != connections.end(); ++c) {
+				const boost::shared_ptr<Connection> connection = c->lock();
+				if (!connection)
+					continue;
+
+				const boost::shared_ptr<Connectable> src = connection->source().lock();
+				const boost::shared_ptr<Connectable> dst = connection->dest().lock();
+				if (src && dst)
+					canvas->remove_connection(src, dst);
+			}
+		}
+
 		_ports.erase(i);
+		_port_index.remove(port.get());
 
 		// Find new widest input or output, if necessary
 		if (port->is_input() && port->width() >= _widest_input) {
@@ -311,6 +370,8 @@ Module::set_width(double w)
 
 	if (growing)
 		fit_canvas();
+
+	moved();
 }
 
 
@@ -326,6 +387,8 @@ Module::set_height(double h)
 
 	if (growing)
 		fit_canvas();
+
+	moved();
 }
 
 
@@ -359,6 +422,8 @@ Module::move(double dx, double dy)
 	// Deal with moving the connection lines
 	for (PortVector::iterator p = _ports.begin(); p != _ports.end(); ++p)
 		(*p)->move_connections();
+
+	canvas->item_moved(this);
 }
 
 
@@ -438,6 +503,12 @@ Module::add_port(boost::shared_ptr<Port> p)
 		_widest_output = p->width();
 
 	_ports.push_back(p);
+	_port_index_dirty = true;
+
+	if (_detail == DETAIL_SUMMARY)
+		p->hide();
+	else if (_detail == DETAIL_NO_LABELS)
+		p->set_label_visible(false);
 
 	boost::shared_ptr<Canvas> canvas = _canvas.lock();
 	if (canvas)
@@ -529,6 +600,9 @@ Module::measure_ports()
 
 
 /** Resize the module to fit its contents best.
+ *
+ * While the canvas is batching this only marks the module for layout
+ * at Canvas::end_batch().
  */
 void
 Module::resize()
@@ -537,6 +611,13 @@ Module::resize()
 	if (!canvas)
 		return;
 
+	if (canvas->in_batch()) {
+		canvas->defer_resize(this);
+		return;
+	}
+
+	_port_index_dirty = true;
+
 	switch (canvas->direction()) {
 	case Canvas::HORIZONTAL:
 		resize_horiz();
@@ -545,6 +626,85 @@ Module::resize()
 		resize_vert();
 		break;
 	}
+
+	// Labels may have been recreated and ports moved
+	if (_detail != DETAIL_FULL)
+		apply_detail();
+}
+
+
+/** Set how much of the module is drawn, see Canvas::set_zoom().
+ *
+ * Only visibility changes, the module keeps its size, so that switching
+ * levels does not require relayout.
+ */
+void
+Module::set_detail(DetailLevel level)
+{
+	if (level == _detail)
+		return;
+
+	_detail = level;
+	apply_detail();
+}
+
+
+void
+Module::apply_detail()
+{
+	for (PortVector::iterator p = _ports.begin(); p != _ports.end(); ++p) {
+		if (_detail == DETAIL_SUMMARY) {
+			(*p)->hide();
+		} else {
+			(*p)->show();
+			(*p)->set_label_visible(_detail == DETAIL_FULL);
+		}
+	}
+
+	if (_detail != DETAIL_SUMMARY) {
+		for (size_t i = 0; i < 2; ++i) {
+			delete _summary_bars[i];
+			_summary_bars[i] = NULL;
+		}
+		return;
+	}
+
+	// One bar covering the ports of each side
+	for (size_t i = 0; i < 2; ++i) {
+		const bool inputs = (i == 0);
+		double   x1 = HUGE_VAL, y1 = HUGE_VAL, x2 = -HUGE_VAL, y2 = -HUGE_VAL;
+		uint32_t color = 0;
+		for (PortVector::const_iterator p = _ports.begin(); p != _ports.end(); ++p) {
+			if ((*p)->is_input() != inputs)
+				continue;
+
+			const double px = (*p)->property_x();
+			const double py = (*p)->property_y();
+			x1 = std::min(x1, px);
+			y1 = std::min(y1, py);
+			x2 = std::max(x2, px + (*p)->width());
+			y2 = std::max(y2, py + (*p)->height());
+			if (!color)
+				color = (*p)->color();
+		}
+
+		if (x1 == HUGE_VAL) {
+			delete _summary_bars[i];
+			_summary_bars[i] = NULL;
+			continue;
+		}
+
+		if (!_summary_bars[i])
+			_summary_bars[i] = new Gnome::Canvas::Rect(*this, x1, y1, x2, y2);
+
+		_summary_bars[i]->property_x1() = x1;
+		_summary_bars[i]->property_y1() = y1;
+		_summary_bars[i]->property_x2() = x2;
+		_summary_bars[i]->property_y2() = y2;
+		_summary_bars[i]->property_fill_color_rgba() = color;
+		_summary_bars[i]->property_outline_color_rgba() = color;
+		_summary_bars[i]->show();
+	}
 }
 
 
@@ -24,6 +24,7 @@
 #include <libgnomecanvasmm.h>
 #include "Port.hpp"
 #include "Item.hpp"
+#include "SpatialIndex.hpp"
 
 namespace FlowCanvas {
 
@@ -58,6 +59,8 @@ public:
 	void zoom(double z);
 	void resize();
 
+	void set_detail(DetailLevel level);
+
 	bool show_port_labels(bool b) { return _show_port_labels; }
 	void set_show_port_labels(bool b);
 
@@ -99,7 +102,12 @@ protected:
 
 	void embed(Gtk::Container* widget);
 
+	void moved();
+	void index_ports();
+	void apply_detail();
+
 	PortVector _ports;
+	SpatialIndex<Port> _port_index; ///< Port boxes relative to the module, rebuilt when dirty
 
 	Gnome::Canvas::Rect    _module_box;
 	Gnome::Canvas::Text    _canvas_title;
@@ -107,6 +115,9 @@ protected:
 	Gnome::Canvas::Pixbuf* _icon_box;
 	Gtk::Container*        _embed_container;
 	Gnome::Canvas::Widget* _embed_item;
+	Gnome::Canvas::Rect*   _summary_bars[2]; ///< Inputs and outputs, at DETAIL_SUMMARY
+
+	DetailLevel _detail;
 
 	double _border_width;
 	double _embed_width;
@@ -119,6 +130,7 @@ protected:
 	bool   _title_visible    :1;
 	bool   _port_renamed     :1;
 	bool   _show_port_labels :1;
+	bool   _port_index_dirty :1;
 
 private:
 	friend class Canvas;
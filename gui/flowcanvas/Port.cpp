@@ -304,6 +304,7 @@ Port::disconnect_all()
 	}
 
 	_connections.clear();
+	_connection_positions.clear();
 }
 
 
@@ -0,0 +1,296 @@
+/* This file is part of FlowCanvas.
+ * Copyright (C) 2026 Nedko Arnaudov <nedko@arnaudov.name>
+ *
+ * FlowCanvas is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * FlowCanvas is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef FLOWCANVAS_SPATIALINDEX_HPP
+#define FLOWCANVAS_SPATIALINDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+namespace FlowCanvas {
+
+
+/** Uniform grid of bounding boxes, for hit-testing without scanning every object.
+ *
+ * Objects are keyed by their address and kept alive by the index until they
+ * are removed.  Query results are in insertion order, so when boxes overlap
+ * the result matches a linear scan of a list the objects were appended to.
+ *
+ * \ingroup FlowCanvas
+ */
+template <typename T>
+class SpatialIndex : boost::noncopyable
+{
+public:
+	explicit SpatialIndex(double cell_size) : _cell_size(cell_size), _next_order(0) {}
+
+	/** Add @a object, or update its bounding box if it is already indexed. */
+	void insert(boost::shared_ptr<T> object, double x, double y, double w, double h);
+
+	/** Update bounding box of @a object.  Does nothing if it is not indexed. */
+	void update(const T* object, double x, double y, double w, double h);
+
+	void remove(const T* object);
+	void clear() { _entries.clear(); _cells.clear(); }
+
+	bool   contains(const T* object) const { return _entries.find(object) != _entries.end(); }
+	size_t size() const                    { return _entries.size(); }
+
+	/** Get bounding box of @a object.  Returns false if it is not indexed. */
+	bool box(const T* object, double& x1, double& y1, double& x2, double& y2) const;
+
+	typedef std::vector< boost::shared_ptr<T> > Result;
+
+	/** Get objects whose bounding box contains point @a x @a y. */
+	void query_point(double x, double y, Result& result) const;
+
+	/** Get objects whose bounding box intersects the rectangle (in any corner order). */
+	void query_rect(double x1, double y1, double x2, double y2, Result& result) const;
+
+private:
+	struct Entry {
+		boost::shared_ptr<T> object;
+		unsigned long        order;
+		double               x1, y1, x2, y2;
+		int                  cx1, cy1, cx2, cy2;
+	};
+
+	typedef std::unordered_map<const T*, Entry>               Entries;
+	typedef std::unordered_map< uint64_t, std::vector<T*> > Cells;
+	typedef std::vector< std::pair<unsigned long, T*> >     Hits;
+
+	int cell(double v) const { return (int)std::floor(v / _cell_size); }
+
+	static uint64_t cell_key(int cx, int cy)
+		{ return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy; }
+
+	void link(T* object, const Entry& e);
+	void unlink(const T* object, const Entry& e);
+	void set_box(Entry& e, double x, double y, double w, double h) const;
+	void collect(const Hits& hits, Result& result) const;
+
+	double        _cell_size;
+	unsigned long _next_order;
+	Entries       _entries;
+	Cells         _cells;
+};
+
+
+template <typename T>
+void
+SpatialIndex<T>::set_box(Entry& e, double x, double y, double w, double h) const
+{
+	e.x1  = x;
+	e.y1  = y;
+	e.x2  = x + w;
+	e.y2  = y + h;
+	e.cx1 = cell(e.x1);
+	e.cy1 = cell(e.y1);
+	e.cx2 = cell(e.x2);
+	e.cy2 = cell(e.y2);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::link(T* object, const Entry& e)
+{
+	for (int cx = e.cx1; cx <= e.cx2; ++cx)
+		for (int cy = e.cy1; cy <= e.cy2; ++cy)
+			_cells[cell_key(cx, cy)].push_back(object);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::unlink(const T* object, const Entry& e)
+{
+	for (int cx = e.cx1; cx <= e.cx2; ++cx) {
+		for (int cy = e.cy1; cy <= e.cy2; ++cy) {
+			typename Cells::iterator c = _cells.find(cell_key(cx, cy));
+			if (c == _cells.end())
+				continue;
+
+			typename std::vector<T*>::iterator i = std::find(c->second.begin(), c->second.end(), object);
+			if (i != c->second.end()) {
+				*i = c->second.back();
+				c->second.pop_back();
+			}
+
+			if (c->second.empty())
+				_cells.erase(c);
+		}
+	}
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::insert(boost::shared_ptr<T> object, double x, double y, double w, double h)
+{
+	if (contains(object.get())) {
+		update(object.get(), x, y, w, h);
+		return;
+	}
+
+	Entry& e = _entries[object.get()];
+	e.object = object;
+	e.order  = _next_order++;
+	set_box(e, x, y, w, h);
+	link(object.get(), e);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::update(const T* object, double x, double y, double w, double h)
+{
+	typename Entries::iterator i = _entries.find(object);
+	if (i == _entries.end())
+		return;
+
+	Entry& e = i->second;
+	const int cx1 = e.cx1, cy1 = e.cy1, cx2 = e.cx2, cy2 = e.cy2;
+	set_box(e, x, y, w, h);
+
+	// Most moves stay within the same cells, only the box changes
+	if (e.cx1 == cx1 && e.cy1 == cy1 && e.cx2 == cx2 && e.cy2 == cy2)
+		return;
+
+	Entry old = e;
+	old.cx1 = cx1; old.cy1 = cy1; old.cx2 = cx2; old.cy2 = cy2;
+	unlink(object, old);
+	link(e.object.get(), e);
+}
+
+
+template <typename T>
+bool
+SpatialIndex<T>::box(const T* object, double& x1, double& y1, double& x2, double& y2) const
+{
+	typename Entries::const_iterator i = _entries.find(object);
+	if (i == _entries.end())
+		return false;
+
+	x1 = i->second.x1;
+	y1 = i->second.y1;
+	x2 = i->second.x2;
+	y2 = i->second.y2;
+	return true;
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::remove(const T* object)
+{
+	typename Entries::iterator i = _entries.find(object);
+	if (i == _entries.end())
+		return;
+
+	unlink(object, i->second);
+	_entries.erase(i);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::collect(const Hits& hits, Result& result) const
+{
+	Hits sorted(hits);
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+	result.clear();
+	result.reserve(sorted.size());
+	for (typename Hits::const_iterator i = sorted.begin(); i != sorted.end(); ++i)
+		result.push_back(_entries.find(i->second)->second.object);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::query_point(double x, double y, Result& result) const
+{
+	Hits hits;
+
+	typename Cells::const_iterator c = _cells.find(cell_key(cell(x), cell(y)));
+	if (c != _cells.end()) {
+		for (typename std::vector<T*>::const_iterator i = c->second.begin(); i != c->second.end(); ++i) {
+			const Entry& e = _entries.find(*i)->second;
+			if (x >= e.x1 && x <= e.x2 && y >= e.y1 && y <= e.y2)
+				hits.push_back(std::make_pair(e.order, *i));
+		}
+	}
+
+	collect(hits, result);
+}
+
+
+template <typename T>
+void
+SpatialIndex<T>::query_rect(double x1, double y1, double x2, double y2, Result& result) const
+{
+	if (x1 > x2)
+		std::swap(x1, x2);
+	if (y1 > y2)
+		std::swap(y1, y2);
+
+	Hits hits;
+
+	const int cx1 = cell(x1), cy1 = cell(y1), cx2 = cell(x2), cy2 = cell(y2);
+
+	// A selection rectangle much larger than the populated area would visit
+	// mostly empty cells, test every entry instead
+	const bool scan_entries = (double)(cx2 - cx1 + 1) * (double)(cy2 - cy1 + 1) > (double)_cells.size();
+
+	if (scan_entries) {
+		for (typename Entries::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+			const Entry& e = i->second;
+			if (e.x2 >= x1 && e.x1 <= x2 && e.y2 >= y1 && e.y1 <= y2)
+				hits.push_back(std::make_pair(e.order, e.object.get()));
+		}
+	} else {
+		for (int cx = cx1; cx <= cx2; ++cx) {
+			for (int cy = cy1; cy <= cy2; ++cy) {
+				typename Cells::const_iterator c = _cells.find(cell_key(cx, cy));
+				if (c == _cells.end())
+					continue;
+
+				for (typename std::vector<T*>::const_iterator i = c->second.begin(); i != c->second.end(); ++i) {
+					const Entry& e = _entries.find(*i)->second;
+					if (e.x2 >= x1 && e.x1 <= x2 && e.y2 >= y1 && e.y1 <= y2)
+						hits.push_back(std::make_pair(e.order, *i));
+				}
+			}
+		}
+	}
+
+	collect(hits, result);
+}
+
+
+} // namespace FlowCanvas
+
+#endif // FLOWCANVAS_SPATIALINDEX_HPP
@@ -29,23 +29,41 @@
 #include "graph_canvas.h"
 #include "../dbus_constants.h"
 #include "../common/catdup.h"
+#include "../common/hash.h"
 #include "internal.h"
 
+/* module locations are sent to the daemon when the user stops dragging for this long */
+#define LOCATION_FLUSH_DELAY_MS 300
+
+/* canvas changes are batched until the main loop is idle, ahead of the gnome canvas redraw */
+#define BATCH_END_PRIORITY G_PRIORITY_HIGH_IDLE
+
+/* must be power of two */
+#define CLIENT_HASH_BUCKETS 256
+#define PORT_HASH_BUCKETS 1024
+
 struct graph_canvas
 {
   graph_proxy_handle graph;
   canvas_handle canvas;
   void (* fill_menu)(GtkMenu * menu);
   struct list_head clients;
+  guint location_flush_source_tag;
+  guint batch_source_tag;
+  unsigned int port_count;
+  struct hlist_head client_buckets[CLIENT_HASH_BUCKETS]; /* clients by id */
+  struct hlist_head port_buckets[PORT_HASH_BUCKETS];     /* ports of all clients, by id */
 };
 
 struct client
 {
   struct list_head siblings;
+  struct hlist_node hash_siblings;
   uint64_t id;
   canvas_module_handle canvas_module;
   struct list_head ports;
   struct graph_canvas * owner_ptr;
+  bool placed;                  /* false while at random location, until connected */
   unsigned int inport_count;
   unsigned int outport_count;
 };
@@ -53,10 +71,12 @@ struct client
 struct port
 {
   struct list_head siblings;
+  struct hlist_node hash_siblings;
   uint64_t id;
   bool is_input;
   canvas_port_handle canvas_port;
   struct graph_canvas * graph_canvas;
+  struct client * client_ptr;
 };
 
 static
@@ -65,12 +85,14 @@ find_client(
   struct graph_canvas * graph_canvas_ptr,
   uint64_t id)
 {
-  struct list_head * node_ptr;
+  struct hlist_head * bucket_ptr;
+  struct hlist_node * node_ptr;
   struct client * client_ptr;
 
-  list_for_each(node_ptr, &graph_canvas_ptr->clients)
+  bucket_ptr = graph_canvas_ptr->client_buckets + ladish_hash_bucket(ladish_hash_uint64(id), CLIENT_HASH_BUCKETS);
+  hlist_for_each(node_ptr, bucket_ptr)
   {
-    client_ptr = list_entry(node_ptr, struct client, siblings);
+    client_ptr = hlist_entry(node_ptr, struct client, hash_siblings);
     if (client_ptr->id == id)
     {
       return client_ptr;
@@ -86,21 +108,61 @@ find_port(
   struct client * client_ptr,
   uint64_t id)
 {
-  struct list_head * node_ptr;
+  struct hlist_head * bucket_ptr;
+  struct hlist_node * node_ptr;
   struct port * port_ptr;
 
-  list_for_each(node_ptr, &client_ptr->ports)
+  bucket_ptr = client_ptr->owner_ptr->port_buckets + ladish_hash_bucket(ladish_hash_uint64(id), PORT_HASH_BUCKETS);
+  hlist_for_each(node_ptr, bucket_ptr)
   {
-    port_ptr = list_entry(node_ptr, struct port, siblings);
+    port_ptr = hlist_entry(node_ptr, struct port, hash_siblings);
     if (port_ptr->id == id)
     {
-      return port_ptr;
+      /* port ids are unique within the graph, but the port must belong to the client too */
+      return port_ptr->client_ptr == client_ptr ? port_ptr : NULL;
     }
   }
 
   return NULL;
 }
 
+/* the canvas module of the client, with its ports, is destroyed by the caller */
+static void destroy_client(struct client * client_ptr)
+{
+  struct port * port_ptr;
+
+  while (!list_empty(&client_ptr->ports))
+  {
+    port_ptr = list_entry(client_ptr->ports.next, struct port, siblings);
+    list_del(&port_ptr->siblings);
+    hlist_del(&port_ptr->hash_siblings);
+    client_ptr->owner_ptr->port_count--;
+    free(port_ptr);
+  }
+
+  list_del(&client_ptr->siblings);
+  hlist_del(&client_ptr->hash_siblings);
+  free(client_ptr);
+}
+
+/* destroy all clients, releasing their canvas handles too, else they keep canvas objects alive */
+static void destroy_clients(struct graph_canvas * graph_canvas_ptr)
+{
+  struct client * client_ptr;
+  struct list_head * node_ptr;
+
+  while (!list_empty(&graph_canvas_ptr->clients))
+  {
+    client_ptr = list_entry(graph_canvas_ptr->clients.next, struct client, siblings);
+    list_for_each(node_ptr, &client_ptr->ports)
+    {
+      canvas_release_port(list_entry(node_ptr, struct port, siblings)->canvas_port);
+    }
+    canvas_destroy_module(graph_canvas_ptr->canvas, client_ptr->canvas_module);
+    destroy_client(client_ptr);
+  }
+}
+
 #define port1_ptr ((struct port *)port1_context)
 #define port2_ptr ((struct port *)port2_context)
 
@@ -132,6 +194,69 @@ disconnect_request(
 #undef port1_ptr
 #undef port2_ptr
 
+static gboolean flush_locations(gpointer graph_canvas)
+{
+  struct graph_canvas * graph_canvas_ptr;
+
+  graph_canvas_ptr = graph_canvas;
+  graph_canvas_ptr->location_flush_source_tag = 0;
+  graph_proxy_dict_flush(graph_canvas_ptr->graph);
+
+  return FALSE;
+}
+
+/* Clients without stored location were put at random place when they appeared.
+ * Once they get connected, move them next to their peers. Other clients are left alone. */
+static void place_new_clients(struct graph_canvas * graph_canvas_ptr)
+{
+  struct list_head * node_ptr;
+  struct client * client_ptr;
+
+  list_for_each(node_ptr, &graph_canvas_ptr->clients)
+  {
+    client_ptr = list_entry(node_ptr, struct client, siblings);
+    if (!client_ptr->placed)
+    {
+      /* on success, the new location is stored through module_location_changed() */
+      canvas_place_module(graph_canvas_ptr->canvas, client_ptr->canvas_module);
+    }
+  }
+}
+
+static gboolean end_batch(gpointer graph_canvas)
+{
+  struct graph_canvas * graph_canvas_ptr;
+
+  graph_canvas_ptr = graph_canvas;
+  graph_canvas_ptr->batch_source_tag = 0;
+  canvas_end_batch(graph_canvas_ptr->canvas);
+  place_new_clients(graph_canvas_ptr);
+
+  return FALSE;
+}
+
+/* Graph signals come in bursts (attach, refresh, clients with many ports).
+ * Instead of relayouting modules after each of them, lay out once when the burst is over. */
+static void begin_batch(struct graph_canvas * graph_canvas_ptr)
+{
+  if (graph_canvas_ptr->batch_source_tag != 0)
+  {
+    return;
+  }
+
+  canvas_begin_batch(graph_canvas_ptr->canvas);
+  graph_canvas_ptr->batch_source_tag = g_idle_add_full(BATCH_END_PRIORITY, end_batch, graph_canvas_ptr, NULL);
+}
+
+static void flush_batch(struct graph_canvas * graph_canvas_ptr)
+{
+  if (graph_canvas_ptr->batch_source_tag != 0)
+  {
+    g_source_remove(graph_canvas_ptr->batch_source_tag);
+    end_batch(graph_canvas_ptr);
+  }
+}
+
 #define client_ptr ((struct client *)module_context)
 
 void
@@ -146,6 +271,9 @@ module_location_changed(
 
   log_info("module_location_changed(id = %3llu, x = %6.1f, y = %6.1f)", (unsigned long long)client_ptr->id, x, y);
 
+  /* moved by user, arranged or placed next to its peers */
+  client_ptr->placed = true;
+
   locale = strdup(setlocale(LC_NUMERIC, NULL));
   if (locale == NULL)
   {
@@ -159,19 +287,27 @@ module_location_changed(
   setlocale(LC_NUMERIC, locale);
   free(locale);
 
-  graph_proxy_dict_entry_set(
+  graph_proxy_dict_entry_set_deferred(
     client_ptr->owner_ptr->graph,
     GRAPH_DICT_OBJECT_TYPE_CLIENT,
     client_ptr->id,
     URI_CANVAS_X,
     x_str);
 
-  graph_proxy_dict_entry_set(
+  graph_proxy_dict_entry_set_deferred(
     client_ptr->owner_ptr->graph,
     GRAPH_DICT_OBJECT_TYPE_CLIENT,
     client_ptr->id,
     URI_CANVAS_Y,
     y_str);
+
+  /* restart the timer, so a drag ends up as single SetDicts() call */
+  if (client_ptr->owner_ptr->location_flush_source_tag != 0)
+  {
+    g_source_remove(client_ptr->owner_ptr->location_flush_source_tag);
+  }
+
+  client_ptr->owner_ptr->location_flush_source_tag = g_timeout_add(LOCATION_FLUSH_DELAY_MS, flush_locations, client_ptr->owner_ptr);
 }
 
 static void on_popup_menu_action_client_rename(GtkWidget * UNUSED(menuitem), gpointer module_context)
@@ -355,6 +491,7 @@ graph_canvas_create(
   graph_canvas_handle * graph_canvas_handle_ptr)
 {
   struct graph_canvas * graph_canvas_ptr;
+  unsigned int i;
 
   graph_canvas_ptr = malloc(sizeof(struct graph_canvas));
   if (graph_canvas_ptr == NULL)
@@ -382,6 +519,19 @@ graph_canvas_create(
 
   graph_canvas_ptr->graph = NULL;
   INIT_LIST_HEAD(&graph_canvas_ptr->clients);
+  graph_canvas_ptr->location_flush_source_tag = 0;
+  graph_canvas_ptr->batch_source_tag = 0;
+  graph_canvas_ptr->port_count = 0;
+
+  for (i = 0; i < CLIENT_HASH_BUCKETS; i++)
+  {
+    INIT_HLIST_HEAD(graph_canvas_ptr->client_buckets + i);
+  }
+
+  for (i = 0; i < PORT_HASH_BUCKETS; i++)
+  {
+    INIT_HLIST_HEAD(graph_canvas_ptr->port_buckets + i);
+  }
 
   *graph_canvas_handle_ptr = (graph_canvas_handle)graph_canvas_ptr;
 
@@ -396,7 +546,9 @@ clear(
   void * graph_canvas)
 {
   log_info("canvas::clear()");
+  begin_batch(graph_canvas_ptr);
   canvas_clear(graph_canvas_ptr->canvas);
+  destroy_clients(graph_canvas_ptr);
 }
 
 static
@@ -416,6 +568,7 @@ client_appeared(
   double height;
 
   log_info("canvas::client_appeared(%"PRIu64", \"%s\")", id, name);
+  begin_batch(graph_canvas_ptr);
 
   canvas_get_size(graph_canvas_ptr->canvas, &width, &height);
   //log_debug("width %f, height %f", width, height);
@@ -432,6 +585,7 @@ client_appeared(
   client_ptr->outport_count = 0;
   INIT_LIST_HEAD(&client_ptr->ports);
   client_ptr->owner_ptr = graph_canvas_ptr;
+  client_ptr->placed = true;
 
   x = 0;
   y = 0;
@@ -503,9 +657,13 @@ client_appeared(
   if (x_str == NULL || y_str == NULL)
   { /* we have generated random value, store it */
     module_location_changed(client_ptr, x, y);
+    client_ptr->placed = false;
   }
 
   list_add_tail(&client_ptr->siblings, &graph_canvas_ptr->clients);
+  hlist_add_head(
+    &client_ptr->hash_siblings,
+    graph_canvas_ptr->client_buckets + ladish_hash_bucket(ladish_hash_uint64(id), CLIENT_HASH_BUCKETS));
 }
 
 static
@@ -517,6 +675,7 @@ client_disappeared(
   struct client * client_ptr;
 
   log_info("canvas::client_disappeared(%"PRIu64")", id);
+  begin_batch(graph_canvas_ptr);
 
   client_ptr = find_client(graph_canvas_ptr, id);
   if (client_ptr == NULL)
@@ -525,9 +684,8 @@ client_disappeared(
     return;
   }
 
-  list_del(&client_ptr->siblings);
   canvas_destroy_module(graph_canvas_ptr->canvas, client_ptr->canvas_module);
-  free(client_ptr);
+  destroy_client(client_ptr);
 }
 
 static void client_renamed(void * graph_canvas, uint64_t id, const char * old_name, const char * new_name)
@@ -535,6 +693,7 @@ static void client_renamed(void * graph_canvas, uint64_t id, const char * old_na
   struct client * client_ptr;
 
   log_info("canvas::client_renamed(%"PRIu64", '%s', '%s')", id, old_name, new_name);
+  begin_batch(graph_canvas_ptr);
 
   client_ptr = find_client(graph_canvas_ptr, id);
   if (client_ptr == NULL)
@@ -564,6 +723,7 @@ port_appeared(
   char * name_override;
 
   log_info("canvas::port_appeared(%"PRIu64", %"PRIu64", \"%s\")", client_id, port_id, port_name);
+  begin_batch(graph_canvas_ptr);
 
   client_ptr = find_client(graph_canvas_ptr, client_id);
   if (client_ptr == NULL)
@@ -582,6 +742,7 @@ port_appeared(
   port_ptr->id = port_id;
   port_ptr->is_input = is_input;
   port_ptr->graph_canvas = graph_canvas_ptr;
+  port_ptr->client_ptr = client_ptr;
 
   // Darkest tango palette colour, with S -= 6, V -= 6, w/ transparency
   if (is_midi)
@@ -629,6 +790,10 @@ port_appeared(
   }
 
   list_add_tail(&port_ptr->siblings, &client_ptr->ports);
+  hlist_add_head(
+    &port_ptr->hash_siblings,
+    graph_canvas_ptr->port_buckets + ladish_hash_bucket(ladish_hash_uint64(port_id), PORT_HASH_BUCKETS));
+  graph_canvas_ptr->port_count++;
 
   free(name_override);
 
@@ -653,6 +818,7 @@ port_disappeared(
   struct port * port_ptr;
 
   log_info("canvas::port_disappeared(%"PRIu64", %"PRIu64")", client_id, port_id);
+  begin_batch(graph_canvas_ptr);
 
   client_ptr = find_client(graph_canvas_ptr, client_id);
   if (client_ptr == NULL)
@@ -669,6 +835,8 @@ port_disappeared(
   }
 
   list_del(&port_ptr->siblings);
+  hlist_del(&port_ptr->hash_siblings);
+  graph_canvas_ptr->port_count--;
   canvas_destroy_port(graph_canvas_ptr->canvas, port_ptr->canvas_port);
 
   if (port_ptr->is_input)
@@ -696,6 +864,7 @@ port_renamed(
   struct port * port_ptr;
 
   log_info("canvas::port_renamed(%"PRIu64", %"PRIu64", '%s', '%s')", client_id, port_id, old_port_name, new_port_name);
+  begin_batch(graph_canvas_ptr);
 
   client_ptr = find_client(graph_canvas_ptr, client_id);
   if (client_ptr == NULL)
@@ -824,6 +993,9 @@ graph_canvas_destroy(
     graph_canvas_detach(graph_canvas);
   }
 
+  destroy_clients(graph_canvas_ptr);
+
+  canvas_destroy(graph_canvas_ptr->canvas);
   free(graph_canvas_ptr);
 }
 
@@ -834,6 +1006,14 @@ graph_canvas_attach(
 {
   ASSERT(graph_canvas_ptr->graph == NULL);
 
+  /* fetch all values needed for building the canvas with single call */
+  if (!graph_proxy_dict_prefetch(graph, GRAPH_DICT_OBJECT_TYPE_CLIENT, URI_CANVAS_X) ||
+      !graph_proxy_dict_prefetch(graph, GRAPH_DICT_OBJECT_TYPE_CLIENT, URI_CANVAS_Y) ||
+      !graph_proxy_dict_prefetch(graph, GRAPH_DICT_OBJECT_TYPE_PORT, URI_A2J_PORT))
+  {
+    return false;
+  }
+
   if (!graph_proxy_attach(
         graph,
         graph_canvas,
@@ -860,6 +1040,16 @@ graph_canvas_detach(
   graph_canvas_handle graph_canvas)
 {
   ASSERT(graph_canvas_ptr->graph != NULL);
+
+  flush_batch(graph_canvas_ptr);
+
+  if (graph_canvas_ptr->location_flush_source_tag != 0)
+  {
+    g_source_remove(graph_canvas_ptr->location_flush_source_tag);
+    graph_canvas_ptr->location_flush_source_tag = 0;
+  }
+
+  graph_proxy_dict_flush(graph_canvas_ptr->graph);
   graph_proxy_detach(graph_canvas_ptr->graph, graph_canvas);
   graph_canvas_ptr->graph = NULL;
 }
@@ -870,3 +1060,10 @@ graph_canvas_get_canvas(
 {
   return graph_canvas_ptr->canvas;
 }
+
+unsigned int
+graph_canvas_get_port_count(
+  graph_canvas_handle graph_canvas)
+{
+  return graph_canvas_ptr->port_count;
+}
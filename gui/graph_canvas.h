@@ -56,4 +56,8 @@ canvas_handle
 graph_canvas_get_canvas(
   graph_canvas_handle graph_canvas);
 
+unsigned int
+graph_canvas_get_port_count(
+  graph_canvas_handle graph_canvas);
+
 #endif /* #ifndef GRAPH_CANVAS_H__F145C6FA_633C_4E64_9117_ED301618B587__INCLUDED */
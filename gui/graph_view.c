@@ -32,6 +32,11 @@
 #include "../proxies/room_proxy.h"
 #include "../common/catdup.h"
 
+/* Hidden views keep their canvas populated and attached, so switching views does not replay the graph.
+ * When canvases of hidden views have more ports than this, the least recently shown ones
+ * are destroyed and rebuilt when shown again. */
+#define HIDDEN_CANVASES_MAX_PORTS 4096
+
 struct graph_view
 {
   struct list_head siblings;
@@ -43,9 +48,11 @@ struct graph_view
   GtkWidget * canvas_widget;
   ladish_app_supervisor_proxy_handle app_supervisor;
   ladish_room_proxy_handle room;
+  uint64_t shown_serial;
 };
 
 struct list_head g_views;
+static uint64_t g_shown_serial;
 
 GtkScrolledWindow * g_main_scrolledwin;
 static struct graph_view * g_current_view;
@@ -92,7 +99,7 @@ static void detach_canvas(struct graph_view * view_ptr)
   GtkWidget * child;
 
   child = gtk_bin_get_child(GTK_BIN(g_main_scrolledwin));
-  if (child == view_ptr->canvas_widget)
+  if (view_ptr->canvas_widget != NULL && child == view_ptr->canvas_widget)
   {
     gtk_container_remove(GTK_CONTAINER(g_main_scrolledwin), view_ptr->canvas_widget);
     g_current_view = NULL;
@@ -192,6 +199,79 @@ static void fill_canvas_menu(GtkMenu * menu)
   fill_view_popup_menu(menu, (graph_view_handle)g_current_view);
 }
 
+static bool create_canvas(struct graph_view * view_ptr)
+{
+  if (!graph_canvas_create(1600 * 2, 1200 * 2, fill_canvas_menu, &view_ptr->graph_canvas))
+  {
+    goto fail;
+  }
+
+  /* when graph is already active (rebuild of evicted canvas), this populates the canvas */
+  if (!graph_canvas_attach(view_ptr->graph_canvas, view_ptr->graph))
+  {
+    goto destroy_graph_canvas;
+  }
+
+  view_ptr->canvas_widget = canvas_get_widget(graph_canvas_get_canvas(view_ptr->graph_canvas));
+  gtk_widget_show(view_ptr->canvas_widget);
+
+  return true;
+
+destroy_graph_canvas:
+  graph_canvas_destroy(view_ptr->graph_canvas);
+fail:
+  view_ptr->graph_canvas = NULL;
+  view_ptr->canvas_widget = NULL;
+  return false;
+}
+
+static void destroy_canvas(struct graph_view * view_ptr)
+{
+  if (view_ptr->graph_canvas != NULL)
+  {
+    graph_canvas_destroy(view_ptr->graph_canvas);
+    view_ptr->graph_canvas = NULL;
+    view_ptr->canvas_widget = NULL;
+  }
+}
+
+static void evict_hidden_canvases(void)
+{
+  struct list_head * node_ptr;
+  struct graph_view * view_ptr;
+  struct graph_view * lru_view_ptr;
+  unsigned int port_count;
+
+  while (true)
+  {
+    port_count = 0;
+    lru_view_ptr = NULL;
+
+    list_for_each(node_ptr, &g_views)
+    {
+      view_ptr = list_entry(node_ptr, struct graph_view, siblings);
+      if (view_ptr == g_current_view || view_ptr->graph_canvas == NULL)
+      {
+        continue;
+      }
+
+      port_count += graph_canvas_get_port_count(view_ptr->graph_canvas);
+      if (lru_view_ptr == NULL || view_ptr->shown_serial < lru_view_ptr->shown_serial)
+      {
+        lru_view_ptr = view_ptr;
+      }
+    }
+
+    if (lru_view_ptr == NULL || port_count <= HIDDEN_CANVASES_MAX_PORTS)
+    {
+      return;
+    }
+
+    log_info("Destroying canvas of hidden view '%s' (%u ports on hidden canvases)", lru_view_ptr->full_name, port_count);
+    destroy_canvas(lru_view_ptr);
+  }
+}
+
 bool
 create_view(
   const char * name,
@@ -223,28 +303,20 @@ create_view(
   view_ptr->room = NULL;
   view_ptr->full_name = view_ptr->view_name;
   view_ptr->project_name = NULL;
+  view_ptr->shown_serial = 0;
 
   if (!graph_proxy_create(service, object, graph_dict_supported, graph_manager_supported, &view_ptr->graph))
   {
     goto free_name;
   }
 
-  if (!graph_canvas_create(1600 * 2, 1200 * 2, fill_canvas_menu, &view_ptr->graph_canvas))
+  if (!create_canvas(view_ptr))
   {
     goto destroy_graph;
   }
 
-  if (!graph_canvas_attach(view_ptr->graph_canvas, view_ptr->graph))
-  {
-    goto destroy_graph_canvas;
-  }
-
-  view_ptr->canvas_widget = canvas_get_widget(graph_canvas_get_canvas(view_ptr->graph_canvas));
-
   list_add_tail(&view_ptr->siblings, &g_views);
 
-  gtk_widget_show(view_ptr->canvas_widget);
-
   world_tree_add((graph_view_handle)view_ptr, force_activate);
 
   if (app_supervisor_supported)
@@ -298,8 +370,7 @@ remove_from_world_tree:
   detach_canvas(view_ptr);
 
   world_tree_remove((graph_view_handle)view_ptr);
-destroy_graph_canvas:
-  graph_canvas_destroy(view_ptr->graph_canvas);
+  destroy_canvas(view_ptr);
 destroy_graph:
   graph_proxy_destroy(view_ptr->graph);
 free_name:
@@ -322,6 +393,18 @@ static void attach_canvas(struct graph_view * view_ptr)
 {
   GtkWidget * child;
 
+  view_ptr->shown_serial = ++g_shown_serial;
+
+  if (view_ptr->graph_canvas == NULL)
+  {
+    log_info("Rebuilding canvas of view '%s'", view_ptr->full_name);
+    if (!create_canvas(view_ptr))
+    {
+      log_error("Cannot create canvas for view '%s'", view_ptr->full_name);
+      return;
+    }
+  }
+
   child = gtk_bin_get_child(GTK_BIN(g_main_scrolledwin));
 
   if (child == view_ptr->canvas_widget)
@@ -337,6 +420,8 @@ static void attach_canvas(struct graph_view * view_ptr)
   g_current_view = view_ptr;
   gtk_container_add(GTK_CONTAINER(g_main_scrolledwin), view_ptr->canvas_widget);
 
+  evict_hidden_canvases();
+
   //_main_scrolledwin->property_hadjustment().get_value()->set_step_increment(10);
   //_main_scrolledwin->property_vadjustment().get_value()->set_step_increment(10);
 }
@@ -359,8 +444,7 @@ void destroy_view(graph_view_handle view)
 
   world_tree_remove(view);
 
-  graph_canvas_detach(view_ptr->graph_canvas);
-  graph_canvas_destroy(view_ptr->graph_canvas);
+  destroy_canvas(view_ptr);
   graph_proxy_destroy(view_ptr->graph);
 
   if (view_ptr->app_supervisor != NULL)
@@ -76,12 +76,33 @@ void arrange(void)
   log_info("arrange request");
 
   canvas = get_current_canvas();
-  if (canvas != NULL)
+  if (canvas == NULL)
   {
-    canvas_arrange(canvas);
+    return;
   }
+
+  /* arrange request while layout is still running cancels it */
+  if (canvas_is_arranging(canvas))
+  {
+    log_info("cancelling arrange");
+    canvas_cancel_arrange(canvas);
+    return;
+  }
+
+  canvas_arrange(canvas);
 }
 
+static const char * const g_conf_keys[] =
+{
+  LADISH_CONF_KEY_DAEMON_NOTIFY,
+  LADISH_CONF_KEY_DAEMON_SHELL,
+  LADISH_CONF_KEY_DAEMON_TERMINAL,
+  LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART,
+  LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY,
+  LADISH_CONF_KEY_JACK_CONF_TOOL,
+  NULL
+};
+
 int main(int argc, char** argv)
 {
   #if ENABLE_NLS
@@ -102,6 +123,8 @@ int main(int argc, char** argv)
     return 1;
   }
 
+  conf_prefetch(g_conf_keys);
+
   if (!canvas_init())
   {
     log_error("Canvas initialization failed.");
@@ -45,6 +45,7 @@ void menu_request_settings(void)
   const char * terminal;
   unsigned int js_delay;
   const char * jack_conf_tool;
+  bool stored;
 
   autostart_studio_button = GTK_TOGGLE_BUTTON(get_gtk_builder_widget("settings_studio_autostart_checkbutton"));
   send_notifications_button = GTK_TOGGLE_BUTTON(get_gtk_builder_widget("settings_send_notifications_checkbutton"));
@@ -111,12 +112,15 @@ void menu_request_settings(void)
   js_delay = gtk_spin_button_get_value(js_delay_spin);
   jack_conf_tool = gtk_entry_get_text(jack_conf_tool_entry);
 
-  if (!conf_set_bool(LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART, autostart) ||
-      !conf_set_bool(LADISH_CONF_KEY_DAEMON_NOTIFY, notify) ||
-      !conf_set(LADISH_CONF_KEY_DAEMON_SHELL, shell) ||
-      !conf_set(LADISH_CONF_KEY_DAEMON_TERMINAL, terminal) ||
-      !conf_set_uint(LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY, js_delay) ||
-      !conf_set(LADISH_CONF_KEY_JACK_CONF_TOOL, jack_conf_tool))
+  conf_set_batch_begin();
+  stored =
+    conf_set_bool(LADISH_CONF_KEY_DAEMON_STUDIO_AUTOSTART, autostart) &&
+    conf_set_bool(LADISH_CONF_KEY_DAEMON_NOTIFY, notify) &&
+    conf_set(LADISH_CONF_KEY_DAEMON_SHELL, shell) &&
+    conf_set(LADISH_CONF_KEY_DAEMON_TERMINAL, terminal) &&
+    conf_set_uint(LADISH_CONF_KEY_DAEMON_JS_SAVE_DELAY, js_delay) &&
+    conf_set(LADISH_CONF_KEY_JACK_CONF_TOOL, jack_conf_tool);
+  if (!conf_set_batch_end() || !stored)
   {
     error_message_box(_("Storing settings"));
   }
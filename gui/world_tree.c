@@ -28,6 +28,7 @@
 #include "world_tree.h"
 #include "gtk_builder.h"
 #include "../common/catdup.h"
+#include "../common/hash.h"
 #include "menu.h"
 
 #include <libintl.h>
@@ -50,9 +51,189 @@ enum
   NUM_COLS
 };
 
+#define VIEW_HASH_BUCKETS 16
+#define APP_HASH_BUCKETS 256
+
+struct world_tree_view
+{
+  struct hlist_node hash_siblings;
+  struct list_head apps;        /* world_tree_app objects of this view */
+  graph_view_handle view;
+  GtkTreeRowReference * row;
+  bool expand;                  /* expand the row on next flush */
+};
+
+struct world_tree_app
+{
+  struct hlist_node hash_siblings;
+  struct list_head siblings;            /* in world_tree_view::apps */
+  struct list_head pending_siblings;    /* in g_pending_apps, only when pending_name is not NULL */
+  struct world_tree_view * view_ptr;
+  uint64_t id;
+  GtkTreeRowReference * row;
+
+  /* state to store in the row on next flush */
+  char * pending_name;
+  bool pending_running;
+  bool pending_terminal;
+  const char * pending_level;
+};
+
 GtkWidget * g_world_tree_widget;
 GtkTreeStore * g_treestore;
 
+/* rows by view and by (view, app id), so lookups don't walk the tree store */
+static struct hlist_head g_view_buckets[VIEW_HASH_BUCKETS];
+static struct hlist_head g_app_buckets[APP_HASH_BUCKETS];
+
+/* app state changes arrive in bursts, the tree store is updated once per main loop idle */
+static LIST_HEAD(g_pending_apps);
+static guint g_flush_source_tag;
+
+#define view_hash(view) ladish_hash_uint64((uintptr_t)(view))
+#define app_hash(view, id) ladish_hash_uint64((uintptr_t)(view) ^ (id))
+
+static struct world_tree_view * find_view(graph_view_handle view)
+{
+  struct hlist_node * node_ptr;
+  struct world_tree_view * view_ptr;
+
+  hlist_for_each(node_ptr, g_view_buckets + ladish_hash_bucket(view_hash(view), VIEW_HASH_BUCKETS))
+  {
+    view_ptr = hlist_entry(node_ptr, struct world_tree_view, hash_siblings);
+    if (view_ptr->view == view)
+    {
+      return view_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static struct world_tree_app * find_app(graph_view_handle view, uint64_t id)
+{
+  struct hlist_node * node_ptr;
+  struct world_tree_app * app_ptr;
+
+  hlist_for_each(node_ptr, g_app_buckets + ladish_hash_bucket(app_hash(view, id), APP_HASH_BUCKETS))
+  {
+    app_ptr = hlist_entry(node_ptr, struct world_tree_app, hash_siblings);
+    if (app_ptr->id == id && app_ptr->view_ptr->view == view)
+    {
+      return app_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static bool get_row_iter(GtkTreeRowReference * row, GtkTreeIter * iter_ptr)
+{
+  GtkTreePath * path;
+  bool found;
+
+  path = gtk_tree_row_reference_get_path(row);
+  if (path == NULL)
+  {
+    ASSERT_NO_PASS;
+    return false;
+  }
+
+  found = gtk_tree_model_get_iter(GTK_TREE_MODEL(g_treestore), iter_ptr, path);
+  gtk_tree_path_free(path);
+  return found;
+}
+
+static GtkTreeRowReference * create_row_reference(GtkTreeIter * iter_ptr)
+{
+  GtkTreePath * path;
+  GtkTreeRowReference * row;
+
+  path = gtk_tree_model_get_path(GTK_TREE_MODEL(g_treestore), iter_ptr);
+  row = gtk_tree_row_reference_new(GTK_TREE_MODEL(g_treestore), path);
+  gtk_tree_path_free(path);
+  return row;
+}
+
+static void expand_view(struct world_tree_view * view_ptr)
+{
+  GtkTreePath * path;
+
+  view_ptr->expand = false;
+
+  path = gtk_tree_row_reference_get_path(view_ptr->row);
+  if (path != NULL)
+  {
+    gtk_tree_view_expand_row(GTK_TREE_VIEW(g_world_tree_widget), path, false);
+    gtk_tree_path_free(path);
+  }
+}
+
+static void drop_pending_state(struct world_tree_app * app_ptr)
+{
+  if (app_ptr->pending_name != NULL)
+  {
+    list_del(&app_ptr->pending_siblings);
+    free(app_ptr->pending_name);
+    app_ptr->pending_name = NULL;
+  }
+}
+
+static void destroy_app(struct world_tree_app * app_ptr)
+{
+  drop_pending_state(app_ptr);
+  hlist_del(&app_ptr->hash_siblings);
+  list_del(&app_ptr->siblings);
+  gtk_tree_row_reference_free(app_ptr->row);
+  free(app_ptr);
+}
+
+static void destroy_view_entry(struct world_tree_view * view_ptr)
+{
+  while (!list_empty(&view_ptr->apps))
+  {
+    destroy_app(list_entry(view_ptr->apps.next, struct world_tree_app, siblings));
+  }
+
+  hlist_del(&view_ptr->hash_siblings);
+  gtk_tree_row_reference_free(view_ptr->row);
+  free(view_ptr);
+}
+
+static gboolean flush_pending(gpointer UNUSED(data))
+{
+  struct world_tree_app * app_ptr;
+  GtkTreeIter iter;
+
+  g_flush_source_tag = 0;
+
+  while (!list_empty(&g_pending_apps))
+  {
+    app_ptr = list_entry(g_pending_apps.next, struct world_tree_app, pending_siblings);
+
+    if (app_ptr->view_ptr->expand)
+    {
+      expand_view(app_ptr->view_ptr);
+    }
+
+    if (get_row_iter(app_ptr->row, &iter))
+    {
+      gtk_tree_store_set(
+        g_treestore,
+        &iter,
+        COL_NAME, app_ptr->pending_name,
+        COL_RUNNING, app_ptr->pending_running,
+        COL_TERMINAL, app_ptr->pending_terminal,
+        COL_LEVEL, app_ptr->pending_level,
+        -1);
+    }
+
+    drop_pending_state(app_ptr);
+  }
+
+  return FALSE;
+}
+
 bool get_app_view(GtkTreeIter * app_iter_ptr, graph_view_handle * view_ptr)
 {
   GtkTreeIter view_iter;
@@ -499,6 +680,7 @@ void world_tree_init(void)
   GtkTreeViewColumn * col;
   GtkCellRenderer * renderer;
   GtkTreeSelection * selection;
+  unsigned int i;
 
   g_world_tree_widget = get_gtk_builder_widget("world_tree");
   gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(g_world_tree_widget), FALSE);
@@ -527,15 +709,39 @@ void world_tree_init(void)
   g_signal_connect(g_world_tree_widget, "button-press-event", (GCallback)on_button_pressed, NULL);
   g_signal_connect(g_world_tree_widget, "popup-menu", (GCallback)on_popup_menu, NULL);
   g_signal_connect(g_world_tree_widget, "row-activated", (GCallback)on_row_activated, NULL);
+
+  for (i = 0; i < VIEW_HASH_BUCKETS; i++)
+  {
+    INIT_HLIST_HEAD(g_view_buckets + i);
+  }
+
+  for (i = 0; i < APP_HASH_BUCKETS; i++)
+  {
+    INIT_HLIST_HEAD(g_app_buckets + i);
+  }
 }
 
 void world_tree_add(graph_view_handle view, bool force_activate)
 {
   GtkTreeIter iter;
+  struct world_tree_view * view_ptr;
+
+  view_ptr = malloc(sizeof(struct world_tree_view));
+  if (view_ptr == NULL)
+  {
+    log_error("malloc() failed for struct world_tree_view");
+    return;
+  }
 
   gtk_tree_store_append(g_treestore, &iter, NULL);
   gtk_tree_store_set(g_treestore, &iter, COL_TYPE, entry_type_view, COL_VIEW, view, COL_NAME, get_view_name(view), -1);
 
+  view_ptr->view = view;
+  view_ptr->row = create_row_reference(&iter);
+  view_ptr->expand = false;
+  INIT_LIST_HEAD(&view_ptr->apps);
+  hlist_add_head(&view_ptr->hash_siblings, g_view_buckets + ladish_hash_bucket(view_hash(view), VIEW_HASH_BUCKETS));
+
   /* select the first top level item */
   if (force_activate || gtk_tree_model_iter_n_children(GTK_TREE_MODEL(g_treestore), NULL) == 1)
   {
@@ -568,70 +774,32 @@ graph_view_handle world_tree_find_by_opath(const char * opath)
   return NULL;
 }
 
-static bool find_view(graph_view_handle view, GtkTreeIter * iter_ptr)
-{
-  gint type;
-  graph_view_handle view2;
-
-  if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(g_treestore), iter_ptr))
-  {
-    do
-    {
-      gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), iter_ptr, COL_TYPE, &type, COL_VIEW, &view2, -1);
-      if (type == entry_type_view && view == view2)
-      {
-        return true;
-      }
-    }
-    while (gtk_tree_model_iter_next(GTK_TREE_MODEL(g_treestore), iter_ptr));
-  }
-
-  return false;
-}
-
-static bool find_app(graph_view_handle view, uint64_t id, GtkTreeIter * view_iter_ptr, GtkTreeIter * app_iter_ptr)
+void world_tree_remove(graph_view_handle view)
 {
-  gint type;
-  uint64_t id2;
-
-  if (!find_view(view, view_iter_ptr))
-  {
-    return false;
-  }
-
-  if (!gtk_tree_model_iter_children(GTK_TREE_MODEL(g_treestore), app_iter_ptr, view_iter_ptr))
-  {
-    return false;
-  }
+  struct world_tree_view * view_ptr;
+  GtkTreeIter iter;
 
-  do
+  view_ptr = find_view(view);
+  if (view_ptr == NULL)
   {
-    gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), app_iter_ptr, COL_TYPE, &type, COL_ID, &id2, -1);
-    if (type == entry_type_app && id == id2)
-    {
-      return true;
-    }
+    return;
   }
-  while (gtk_tree_model_iter_next(GTK_TREE_MODEL(g_treestore), app_iter_ptr));
 
-  return false;
-}
-
-void world_tree_remove(graph_view_handle view)
-{
-  GtkTreeIter iter;
-
-  if (find_view(view, &iter))
+  if (get_row_iter(view_ptr->row, &iter))
   {
     gtk_tree_store_remove(g_treestore, &iter);
   }
+
+  destroy_view_entry(view_ptr);
 }
 
 void world_tree_activate(graph_view_handle view)
 {
+  struct world_tree_view * view_ptr;
   GtkTreeIter iter;
 
-  if (find_view(view, &iter))
+  view_ptr = find_view(view);
+  if (view_ptr != NULL && get_row_iter(view_ptr->row, &iter))
   {
     gtk_tree_selection_select_iter(gtk_tree_view_get_selection(GTK_TREE_VIEW(g_world_tree_widget)), &iter);
   }
@@ -639,9 +807,11 @@ void world_tree_activate(graph_view_handle view)
 
 void world_tree_name_changed(graph_view_handle view)
 {
+  struct world_tree_view * view_ptr;
   GtkTreeIter iter;
 
-  if (find_view(view, &iter))
+  view_ptr = find_view(view);
+  if (view_ptr != NULL && get_row_iter(view_ptr->row, &iter))
   {
     gtk_tree_store_set(g_treestore, &iter, COL_NAME, get_view_name(view), -1);
   }
@@ -687,28 +857,32 @@ static char * get_app_name_string(const char * app_name, bool running, bool UNUS
 
 void world_tree_add_app(graph_view_handle view, uint64_t id, const char * app_name, bool running, bool terminal, const char * level)
 {
+  struct world_tree_view * view_ptr;
+  struct world_tree_app * app_ptr;
   GtkTreeIter iter;
-  const char * view_name;
   GtkTreeIter child;
-  GtkTreePath * path;
   char * app_name_with_status;
 
-  if (!find_view(view, &iter))
+  view_ptr = find_view(view);
+  if (view_ptr == NULL || !get_row_iter(view_ptr->row, &iter))
   {
     ASSERT_NO_PASS;
     return;
   }
 
-  path = gtk_tree_model_get_path(GTK_TREE_MODEL(g_treestore), &iter);
-
-  gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), &iter, COL_NAME, &view_name, -1);
-
-  log_info("adding app '%s' to '%s'", app_name, view_name);
+  log_info("adding app '%s' to '%s'", app_name, get_view_name(view));
 
   app_name_with_status = get_app_name_string(app_name, running, terminal, level);
   if (app_name_with_status == NULL)
   {
-    goto free_path;
+    return;
+  }
+
+  app_ptr = malloc(sizeof(struct world_tree_app));
+  if (app_ptr == NULL)
+  {
+    log_error("malloc() failed for struct world_tree_app");
+    goto free_name;
   }
 
   gtk_tree_store_append(g_treestore, &child, &iter);
@@ -722,85 +896,93 @@ void world_tree_add_app(graph_view_handle view, uint64_t id, const char * app_na
     COL_TERMINAL, terminal,
     COL_LEVEL, level,
     -1);
-  gtk_tree_view_expand_row(GTK_TREE_VIEW(g_world_tree_widget), path, false);
 
+  app_ptr->view_ptr = view_ptr;
+  app_ptr->id = id;
+  app_ptr->row = create_row_reference(&child);
+  app_ptr->pending_name = NULL;
+  list_add_tail(&app_ptr->siblings, &view_ptr->apps);
+  hlist_add_head(&app_ptr->hash_siblings, g_app_buckets + ladish_hash_bucket(app_hash(view, id), APP_HASH_BUCKETS));
+
+  expand_view(view_ptr);
+
+free_name:
   free(app_name_with_status);
-free_path:
-  gtk_tree_path_free(path);
 }
 
 void world_tree_app_state_changed(graph_view_handle view, uint64_t id, const char * app_name, bool running, bool terminal, const char * level)
 {
-  GtkTreeIter view_iter;
-  GtkTreeIter app_iter;
-  const char * view_name;
-  GtkTreePath * path;
+  struct world_tree_app * app_ptr;
   char * app_name_with_status;
 
-  if (!find_app(view, id, &view_iter, &app_iter))
+  app_ptr = find_app(view, id);
+  if (app_ptr == NULL)
   {
-    log_error("removed app not found");
+    log_error("changed app not found");
     return;
   }
 
-  path = gtk_tree_model_get_path(GTK_TREE_MODEL(g_treestore), &view_iter);
-
-  gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), &view_iter, COL_NAME, &view_name, -1);
-
-  log_info("changing app state '%s':'%s'", view_name, app_name);
+  log_info("changing app state '%s':'%s'", get_view_name(view), app_name);
 
   app_name_with_status = get_app_name_string(app_name, running, terminal, level);
   if (app_name_with_status == NULL)
   {
-    goto free_path;
+    return;
   }
 
-  gtk_tree_view_expand_row(GTK_TREE_VIEW(g_world_tree_widget), path, false);
-  gtk_tree_store_set(
-    g_treestore,
-    &app_iter,
-    COL_NAME, app_name_with_status,
-    COL_RUNNING, running,
-    COL_TERMINAL, terminal,
-    COL_LEVEL, level,
-    -1);
+  if (app_ptr->pending_name != NULL)
+  {
+    /* previous state was not flushed yet, only the last one matters */
+    free(app_ptr->pending_name);
+  }
+  else
+  {
+    list_add_tail(&app_ptr->pending_siblings, &g_pending_apps);
+  }
 
-  free(app_name_with_status);
-free_path:
-  gtk_tree_path_free(path);
+  app_ptr->pending_name = app_name_with_status;
+  app_ptr->pending_running = running;
+  app_ptr->pending_terminal = terminal;
+  app_ptr->pending_level = ladish_map_app_level_constant(level);
+  app_ptr->view_ptr->expand = true;
+
+  if (g_flush_source_tag == 0)
+  {
+    g_flush_source_tag = g_idle_add(flush_pending, NULL);
+  }
 }
 
 void world_tree_remove_app(graph_view_handle view, uint64_t id)
 {
-  GtkTreeIter view_iter;
+  struct world_tree_app * app_ptr;
   GtkTreeIter app_iter;
-  const char * view_name;
-  const char * app_name;
-  GtkTreePath * path;
+  char * app_name;
 
-  if (!find_app(view, id, &view_iter, &app_iter))
+  app_ptr = find_app(view, id);
+  if (app_ptr == NULL)
   {
     log_error("removed app not found");
     return;
   }
 
-  path = gtk_tree_model_get_path(GTK_TREE_MODEL(g_treestore), &view_iter);
-
-  gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), &view_iter, COL_NAME, &view_name, -1);
-  gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), &app_iter, COL_NAME, &app_name, -1);
-
-  log_info("removing app '%s' from '%s'", app_name, view_name);
+  if (get_row_iter(app_ptr->row, &app_iter))
+  {
+    gtk_tree_model_get(GTK_TREE_MODEL(g_treestore), &app_iter, COL_NAME, &app_name, -1);
+    log_info("removing app '%s' from '%s'", app_name, get_view_name(view));
+    g_free(app_name);
 
-  gtk_tree_view_expand_row(GTK_TREE_VIEW(g_world_tree_widget), path, false);
-  gtk_tree_store_remove(g_treestore, &app_iter);
+    expand_view(app_ptr->view_ptr);
+    gtk_tree_store_remove(g_treestore, &app_iter);
+  }
 
-  gtk_tree_path_free(path);
+  destroy_app(app_ptr);
 }
 
 void world_tree_destroy_room_views(void)
 {
   gint type;
   graph_view_handle view;
+  struct world_tree_view * view_ptr;
   GtkTreeIter iter;
   bool valid;
 
@@ -816,6 +998,13 @@ loop:
     //log_info("removing view for room %s", get_view_opath(view));
     valid = gtk_tree_store_remove(g_treestore, &iter);
 
+    /* before destroy_view(), it calls world_tree_remove() for the already removed row */
+    view_ptr = find_view(view);
+    if (view_ptr != NULL)
+    {
+      destroy_view_entry(view_ptr);
+    }
+
     destroy_view(view);
 
     if (!valid)
@@ -27,6 +27,7 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -38,11 +39,34 @@
 #include "../../common/catdup.h"
 #include "../../common/dirhelpers.h"
 #include "../../common/file.h"
+#include "../../common/hash.h"
 #include "../../log.h"
 #include <cdbus/cdbus.h>
 #include "../../dbus_constants.h"
 
-#define LASH_CONFIG_SUBDIR "/.ladish_lash_dict/"
+#define LASH_CONFIG_SUBDIR "/.ladish_lash_dict/" /* one file per key, written by older liblash */
+#define LASH_CONFIG_PACK "/.ladish_lash_dict.pack"
+#define LASH_CONFIG_PACK_SIGNATURE "LASHDICT"
+#define LASH_CONFIG_PACK_VERSION 1
+
+/* The dict pack is a header, followed by array of index entries, followed by keys and values.
+ * Keys are NUL terminated. Integers are in network byte order, offsets are from the start of the file. */
+struct lash_config_pack_header
+{
+  char signature[8];
+  uint32_t version;
+  uint32_t count;               /* number of index entries */
+  uint32_t size;                /* size of the whole file */
+  uint32_t reserved;
+};
+
+struct lash_config_pack_entry
+{
+  uint32_t key_offset;
+  uint32_t key_size;            /* without the terminating NUL */
+  uint32_t value_offset;
+  uint32_t value_size;
+};
 
 static cdbus_object_path g_object;
 extern const struct cdbus_interface_descriptor g_interface __attribute__((visibility("hidden")));
@@ -86,72 +110,445 @@ static void clean_pending_configs(void)
   }
 }
 
-static void save_config(const char * dir,  struct _lash_config * config_ptr)
+static void save_config(char * buffer, struct lash_config_pack_entry * entry_ptr, uint32_t * offset_ptr, struct _lash_config * config_ptr)
 {
-  char * path;
-  int fd;
-	ssize_t written;
+  size_t key_size;
 
   log_debug("saving dict key '%s'", config_ptr->key);
 
-  path = catdup3(dir, LASH_CONFIG_SUBDIR, config_ptr->key);
-  if (path == NULL)
+  key_size = strlen(config_ptr->key);
+
+  entry_ptr->key_offset = htonl(*offset_ptr);
+  entry_ptr->key_size = htonl((uint32_t)key_size);
+  memcpy(buffer + *offset_ptr, config_ptr->key, key_size + 1);
+  *offset_ptr += (uint32_t)key_size + 1;
+
+  entry_ptr->value_offset = htonl(*offset_ptr);
+  entry_ptr->value_size = htonl((uint32_t)config_ptr->size);
+  if (config_ptr->size > 0)
   {
-    goto exit;
+    memcpy(buffer + *offset_ptr, config_ptr->value, config_ptr->size);
+    *offset_ptr += (uint32_t)config_ptr->size;
+  }
+}
+
+/* When app sends same key more than once, the last value wins, like it did when each key was a separate file */
+static void drop_duplicate_configs(struct _lash_config ** configs, size_t count)
+{
+  size_t buckets_count;
+  struct _lash_config ** buckets;
+  size_t i;
+  size_t bucket;
+
+  buckets_count = 16;
+  while (buckets_count < count * 2)
+  {
+    buckets_count *= 2;
   }
 
-  fd = creat(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+  buckets = calloc(buckets_count, sizeof(struct _lash_config *));
+  if (buckets == NULL)
+  {
+    log_error("calloc() failed to allocate %zu dict buckets", buckets_count);
+    return;
+  }
 
-	if (fd == -1)
+  i = count;
+  while (i > 0)
   {
-    log_error("error creating config file '%s' (%s)", path, strerror(errno));
+    i--;
+
+    bucket = ladish_hash_bucket(ladish_hash_string(configs[i]->key), buckets_count);
+    while (buckets[bucket] != NULL)
+    {
+      if (strcmp(buckets[bucket]->key, configs[i]->key) == 0)
+      {
+        log_debug("dropping overwritten dict key '%s'", configs[i]->key);
+        configs[i] = NULL;
+        break;
+      }
+
+      bucket = ladish_hash_bucket(bucket + 1, buckets_count);
+    }
+
+    if (configs[i] != NULL)
+    {
+      buckets[bucket] = configs[i];
+    }
+  }
+
+  free(buckets);
+}
+
+static bool write_pack(const char * path, const char * buffer, size_t size)
+{
+  char * tmp_path;
+  int fd;
+  ssize_t written;
+  bool ret;
+
+  ret = false;
+
+  tmp_path = catdup(path, ".tmp");
+  if (tmp_path == NULL)
+  {
+    goto exit;
+  }
+
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+  if (fd == -1)
+  {
+    log_error("error creating config file '%s' (%s)", tmp_path, strerror(errno));
     goto free;
-	}
+  }
 
-	written = write(fd, config_ptr->value, config_ptr->size);
-	if (written == -1)
+  while (size > 0)
   {
-    log_error("error writing config file '%s' (%s)", path, strerror(errno));
-    goto close;
-	}
+    written = write(fd, buffer, size);
+    if (written == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      log_error("error writing config file '%s' (%s)", tmp_path, strerror(errno));
+      goto close;
+    }
+
+    buffer += written;
+    size -= (size_t)written;
+  }
 
-  if ((size_t)written < config_ptr->size)
+  if (fsync(fd) != 0)
   {
-    log_error("error writing config file '%s' (%zd instead of %zu)", path, written, config_ptr->size);
+    log_error("fsync() failed for config file '%s' (%s)", tmp_path, strerror(errno));
     goto close;
   }
 
-  log_debug("saved dict key '%s'", config_ptr->key);
+  if (close(fd) != 0)
+  {
+    log_error("close() failed for config file '%s' (%s)", tmp_path, strerror(errno));
+    goto unlink;
+  }
+
+  if (rename(tmp_path, path) != 0)
+  {
+    log_error("rename('%s', '%s') failed (%s)", tmp_path, path, strerror(errno));
+    goto unlink;
+  }
+
+  ret = true;
+  goto free;
 
 close:
   close(fd);
+unlink:
+  unlink(tmp_path);
 free:
-  free(path);
+  free(tmp_path);
 exit:
-  return;
+  return ret;
 }
 
-static void save_pending_configs(const char * dir)
+/* The pack supersedes the one file per key layout, remove files left by older liblash */
+static void remove_legacy_configs(const char * appdir)
 {
-  struct _lash_config * config_ptr;
+  char * dirpath;
+  char * filepath;
+  DIR * dir;
+  struct dirent * dentry;
 
-  if (!ensure_dir_exist_varg(S_IRWXU | S_IRWXG | S_IRWXO, dir, LASH_CONFIG_SUBDIR, NULL))
+  dirpath = catdup(appdir, LASH_CONFIG_SUBDIR);
+  if (dirpath == NULL)
   {
-    log_error("ensure_dir_exist_varg() failed for %s%s", dir, LASH_CONFIG_SUBDIR);
-    clean_pending_configs();
     return;
   }
 
-  while (!list_empty(&g_pending_configs))
+  dir = opendir(dirpath);
+  if (dir == NULL)
   {
-    config_ptr = list_entry(g_pending_configs.next, struct _lash_config, siblings);
-    list_del(g_pending_configs.next);
-    save_config(dir, config_ptr);
-    lash_config_destroy(config_ptr);
+    if (errno != ENOENT)
+    {
+      log_error("Cannot open directory '%s': %d (%s)", dirpath, errno, strerror(errno));
+    }
+
+    goto free;
   }
+
+  log_info("Removing legacy dict files in '%s'", dirpath);
+
+  while ((dentry = readdir(dir)) != NULL)
+  {
+    if (strcmp(dentry->d_name, ".") == 0 ||
+        strcmp(dentry->d_name, "..") == 0)
+    {
+      continue;
+    }
+
+    filepath = catdup(dirpath, dentry->d_name);
+    if (filepath == NULL)
+    {
+      break;
+    }
+
+    if (unlink(filepath) != 0)
+    {
+      log_error("unlink('%s') failed: %d (%s)", filepath, errno, strerror(errno));
+    }
+
+    free(filepath);
+  }
+
+  closedir(dir);
+
+  if (rmdir(dirpath) != 0)
+  {
+    log_error("rmdir('%s') failed: %d (%s)", dirpath, errno, strerror(errno));
+  }
+
+free:
+  free(dirpath);
 }
 
-static void load_configs(const char * appdir)
+static void load_stored_configs(const char * appdir);
+
+static void save_pending_configs(const char * dir)
+{
+  LIST_HEAD(sent_configs);
+  struct list_head * node_ptr;
+  struct _lash_config ** configs;
+  struct lash_config_pack_header * header_ptr;
+  struct lash_config_pack_entry * entry_ptr;
+  size_t count;
+  size_t saved;
+  size_t size;
+  size_t i;
+  char * buffer;
+  char * path;
+  uint32_t offset;
+
+  /* Keys that were stored before but are not sent now are kept, like they
+   * were when each key was a separate file that was only overwritten.
+   * Stored keys go first, so the sent values win in drop_duplicate_configs() */
+  list_splice_init(&g_pending_configs, &sent_configs);
+  load_stored_configs(dir);
+  list_splice(&sent_configs, g_pending_configs.prev);
+
+  count = 0;
+  list_for_each(node_ptr, &g_pending_configs)
+  {
+    count++;
+  }
+
+  configs = malloc((count + 1) * sizeof(struct _lash_config *));
+  if (configs == NULL)
+  {
+    log_error("malloc() failed to allocate array of %zu dict keys", count);
+    goto clean;
+  }
+
+  i = 0;
+  list_for_each(node_ptr, &g_pending_configs)
+  {
+    configs[i++] = list_entry(node_ptr, struct _lash_config, siblings);
+  }
+
+  drop_duplicate_configs(configs, count);
+
+  saved = 0;
+  size = sizeof(struct lash_config_pack_header);
+  for (i = 0; i < count; i++)
+  {
+    if (configs[i] != NULL)
+    {
+      saved++;
+      size += sizeof(struct lash_config_pack_entry) + strlen(configs[i]->key) + 1 + configs[i]->size;
+    }
+  }
+
+  if (size > UINT32_MAX)
+  {
+    log_error("dict of %zu keys is too big (%zu bytes)", saved, size);
+    goto free_configs;
+  }
+
+  buffer = malloc(size);
+  if (buffer == NULL)
+  {
+    log_error("malloc() failed to allocate %zu bytes for dict pack", size);
+    goto free_configs;
+  }
+
+  header_ptr = (struct lash_config_pack_header *)buffer;
+  memcpy(header_ptr->signature, LASH_CONFIG_PACK_SIGNATURE, sizeof(header_ptr->signature));
+  header_ptr->version = htonl(LASH_CONFIG_PACK_VERSION);
+  header_ptr->count = htonl((uint32_t)saved);
+  header_ptr->size = htonl((uint32_t)size);
+  header_ptr->reserved = 0;
+
+  entry_ptr = (struct lash_config_pack_entry *)(header_ptr + 1);
+  offset = (uint32_t)(sizeof(struct lash_config_pack_header) + saved * sizeof(struct lash_config_pack_entry));
+  for (i = 0; i < count; i++)
+  {
+    if (configs[i] != NULL)
+    {
+      save_config(buffer, entry_ptr++, &offset, configs[i]);
+    }
+  }
+
+  ASSERT(offset == size);
+
+  path = catdup(dir, LASH_CONFIG_PACK);
+  if (path == NULL)
+  {
+    goto free_buffer;
+  }
+
+  if (write_pack(path, buffer, size))
+  {
+    log_debug("saved %zu dict keys (%zu bytes) to '%s'", saved, size, path);
+    remove_legacy_configs(dir);
+  }
+
+  free(path);
+free_buffer:
+  free(buffer);
+free_configs:
+  free(configs);
+clean:
+  clean_pending_configs();
+}
+
+static bool load_packed_configs(const char * appdir)
+{
+  char * path;
+  int fd;
+  struct stat st;
+  const char * data;
+  const struct lash_config_pack_header * header_ptr;
+  const struct lash_config_pack_entry * entries;
+  uint32_t count;
+  uint32_t i;
+  uint32_t key_offset;
+  uint32_t key_size;
+  uint32_t value_offset;
+  uint32_t value_size;
+  lash_config_t * config_ptr;
+  bool ret;
+
+  ret = false;
+
+  path = catdup(appdir, LASH_CONFIG_PACK);
+  if (path == NULL)
+  {
+    goto exit;
+  }
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    if (errno != ENOENT)
+    {
+      log_error("Cannot open '%s': %d (%s)", path, errno, strerror(errno));
+    }
+
+    goto free;
+  }
+
+  if (fstat(fd, &st) != 0)
+  {
+    log_error("failed to stat '%s': %d (%s)", path, errno, strerror(errno));
+    goto close;
+  }
+
+  if ((size_t)st.st_size < sizeof(struct lash_config_pack_header))
+  {
+    log_error("dict pack '%s' is truncated (%llu bytes)", path, (unsigned long long)st.st_size);
+    goto close;
+  }
+
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+  {
+    log_error("mmap() failed for '%s': %d (%s)", path, errno, strerror(errno));
+    goto close;
+  }
+
+  header_ptr = (const struct lash_config_pack_header *)data;
+  if (memcmp(header_ptr->signature, LASH_CONFIG_PACK_SIGNATURE, sizeof(header_ptr->signature)) != 0 ||
+      ntohl(header_ptr->version) != LASH_CONFIG_PACK_VERSION ||
+      ntohl(header_ptr->size) != (uint64_t)st.st_size)
+  {
+    log_error("dict pack '%s' is invalid or has unsupported version", path);
+    goto unmap;
+  }
+
+  count = ntohl(header_ptr->count);
+  if (count > ((size_t)st.st_size - sizeof(struct lash_config_pack_header)) / sizeof(struct lash_config_pack_entry))
+  {
+    log_error("dict pack '%s' has invalid index", path);
+    goto unmap;
+  }
+
+  /* validate the whole index before loading anything */
+  entries = (const struct lash_config_pack_entry *)(header_ptr + 1);
+  for (i = 0; i < count; i++)
+  {
+    key_offset = ntohl(entries[i].key_offset);
+    key_size = ntohl(entries[i].key_size);
+    value_offset = ntohl(entries[i].value_offset);
+    value_size = ntohl(entries[i].value_size);
+
+    if ((uint64_t)key_offset + key_size >= (uint64_t)st.st_size ||
+        data[key_offset + key_size] != 0 ||
+        strlen(data + key_offset) != key_size ||
+        (uint64_t)value_offset + value_size > (uint64_t)st.st_size)
+    {
+      log_error("dict pack '%s' has invalid entry #%"PRIu32, path, i);
+      goto unmap;
+    }
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    key_offset = ntohl(entries[i].key_offset);
+    value_offset = ntohl(entries[i].value_offset);
+    value_size = ntohl(entries[i].value_size);
+
+    config_ptr = lash_config_new_with_key(data + key_offset);
+    if (config_ptr == NULL)
+    {
+      continue;
+    }
+
+    if (value_size > 0)
+    {
+      lash_config_set_value(config_ptr, data + value_offset, value_size);
+      if (config_ptr->value == NULL)
+      {
+        lash_config_destroy(config_ptr);
+        continue;
+      }
+    }
+
+    list_add_tail(&config_ptr->siblings, &g_pending_configs);
+  }
+
+  log_debug("loaded %"PRIu32" dict keys from '%s'", count, path);
+  ret = true;
+
+unmap:
+  munmap((void *)data, (size_t)st.st_size);
+close:
+  close(fd);
+free:
+  free(path);
+exit:
+  return ret;
+}
+
+static void load_legacy_configs(const char * appdir)
 {
   char * dirpath;
   char * filepath;
@@ -160,11 +557,6 @@ static void load_configs(const char * appdir)
   struct stat st;
   lash_config_t * config_ptr;
 
-  clean_pending_configs();
-  ASSERT(list_empty(&g_pending_configs));
-
-  log_debug("Loading configs from '%s'", appdir);
-
   dirpath = catdup(appdir, LASH_CONFIG_SUBDIR);
   if (dirpath == NULL)
   {
@@ -174,10 +566,16 @@ static void load_configs(const char * appdir)
   dir = opendir(dirpath);
   if (dir == NULL)
   {
-    log_error("Cannot open directory '%s': %d (%s)", dirpath, errno, strerror(errno));
+    if (errno != ENOENT)
+    {
+      log_error("Cannot open directory '%s': %d (%s)", dirpath, errno, strerror(errno));
+    }
+
     goto free;
   }
 
+  log_info("Loading legacy dict files from '%s'", dirpath);
+
   while ((dentry = readdir(dir)) != NULL)
   {
     if (strcmp(dentry->d_name, ".") == 0 ||
@@ -236,6 +634,26 @@ exit:
   return;
 }
 
+/* append the stored keys to g_pending_configs */
+static void load_stored_configs(const char * appdir)
+{
+  if (!load_packed_configs(appdir))
+  {
+    /* no pack, the state was saved by older liblash */
+    load_legacy_configs(appdir);
+  }
+}
+
+static void load_configs(const char * appdir)
+{
+  clean_pending_configs();
+  ASSERT(list_empty(&g_pending_configs));
+
+  log_debug("Loading configs from '%s'", appdir);
+
+  load_stored_configs(appdir);
+}
+
 LADISH_PUBLIC
 const char * lash_protocol_string(lash_protocol_t UNUSED(protocol))
 {
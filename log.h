@@ -36,6 +36,8 @@
 #define ANSI_RESET      "\033[0m"
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <cdbus/log.h>
 
 #include "config.h"
@@ -66,10 +68,98 @@ ladish_log(
 #endif
   ;
 
-#define log_debug(fmt, args...)       ladish_log(CDBUS_LOG_LEVEL_DEBUG,       __FILE__, __LINE__, __func__, fmt, ## args)
-#define log_info(fmt, args...)        ladish_log(CDBUS_LOG_LEVEL_INFO,        __FILE__, __LINE__, __func__, fmt, ## args)
-#define log_warn(fmt, args...)        ladish_log(CDBUS_LOG_LEVEL_WARN,        __FILE__, __LINE__, __func__, fmt, ## args)
-#define log_error(fmt, args...)       ladish_log(CDBUS_LOG_LEVEL_ERROR,       __FILE__, __LINE__, __func__, fmt, ## args)
-#define log_error_plain(fmt, args...) ladish_log(CDBUS_LOG_LEVEL_ERROR_PLAIN, __FILE__, __LINE__, __func__, fmt, ## args)
+/* number of log lines written since start, for the metrics interface */
+#ifdef __cplusplus
+extern "C"
+#endif
+uint64_t ladish_log_get_line_count(void);
+
+/* open the log file and start the writer thread, for ladishd;
+   other programs log to stdout and stderr */
+#ifdef __cplusplus
+extern "C"
+#endif
+void ladish_log_init(void);
+
+/* write out queued log records and log synchronously from now on, for crash handlers */
+#ifdef __cplusplus
+extern "C"
+#endif
+void ladish_log_flush_sync(void);
+
+/*
+ * Each log macro expansion has a static callsite that caches whether the
+ * filter enables it, so disabled lines cost one compare and their arguments
+ * are not evaluated. The cache is recomputed when the filter generation changes.
+ */
+struct ladish_log_callsite
+{
+  unsigned int generation;      /* filter generation the enabled flag is valid for */
+  bool enabled;
+  unsigned int level;
+  const char * file;
+  unsigned int line;
+  const char * func;
+  unsigned int window;          /* rate limiter, second the count is for */
+  unsigned int count;           /* lines logged in the window */
+  unsigned int suppressed;      /* lines dropped by the rate limiter, not reported yet */
+  int pending;                  /* on the list of callsites with suppressed lines */
+  struct ladish_log_callsite * next_pending;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile unsigned int g_ladish_log_filter_generation;
+
+void ladish_log_callsite_update(struct ladish_log_callsite * callsite_ptr);
+
+void
+ladish_log_callsite(
+  struct ladish_log_callsite * callsite_ptr,
+  const char * format,
+  ...)
+#if defined (__GNUC__)
+  __attribute__((format(printf, 2, 3)))
+#endif
+  ;
+
+/* filter is comma separated list of "level", "module=level" and "rate=lines_per_second",
+   level is one of debug, info, warn, error and off, module is source file name without extension;
+   rate limits debug and info lines of each callsite, warnings and errors are never dropped */
+bool ladish_log_set_filter(const char * filter);
+const char * ladish_log_get_filter(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline bool ladish_log_callsite_enabled(struct ladish_log_callsite * callsite_ptr)
+{
+  if (callsite_ptr->generation != g_ladish_log_filter_generation)
+  {
+    ladish_log_callsite_update(callsite_ptr);
+  }
+
+  return callsite_ptr->enabled;
+}
+
+#define LADISH_LOG(level, fmt, args...)                                                 \
+  do                                                                                    \
+  {                                                                                     \
+    static struct ladish_log_callsite ladish_log_callsite_ =                            \
+      {0, false, (level), __FILE__, __LINE__, __func__, 0, 0, 0, 0, NULL};              \
+    if (ladish_log_callsite_enabled(&ladish_log_callsite_))                             \
+    {                                                                                   \
+      ladish_log_callsite(&ladish_log_callsite_, fmt, ## args);                         \
+    }                                                                                   \
+  } while (0)
+
+#define log_debug(fmt, args...)       LADISH_LOG(CDBUS_LOG_LEVEL_DEBUG,       fmt, ## args)
+#define log_info(fmt, args...)        LADISH_LOG(CDBUS_LOG_LEVEL_INFO,        fmt, ## args)
+#define log_warn(fmt, args...)        LADISH_LOG(CDBUS_LOG_LEVEL_WARN,        fmt, ## args)
+#define log_error(fmt, args...)       LADISH_LOG(CDBUS_LOG_LEVEL_ERROR,       fmt, ## args)
+#define log_error_plain(fmt, args...) LADISH_LOG(CDBUS_LOG_LEVEL_ERROR_PLAIN, fmt, ## args)
 
 #endif /* __LADISH_LOG__ */
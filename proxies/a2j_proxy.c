@@ -26,7 +26,7 @@
 
 #include "a2j_proxy.h"
 
-#define A2J_SERVICE       "org.gna.home.a2jmidid"
+#define A2J_SERVICE       A2J_SERVICE_NAME
 #define A2J_OBJECT        "/"
 #define A2J_IFACE_CONTROL "org.gna.home.a2jmidid.control"
 
@@ -139,7 +139,7 @@ bool a2j_proxy_get_jack_client_name_noncached(char ** client_name_ptr_ptr)
   DBusMessage * reply_ptr;
   const char * name;
 
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "get_jack_client_name", "", NULL, &reply_ptr))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "get_jack_client_name", "", NULL, &reply_ptr))
   {
     //log_error("a2j::get_jack_client_name() failed.");
     return false;
@@ -179,7 +179,7 @@ a2j_proxy_map_jack_port(
   const char * alsa_client_name;
   const char * alsa_port_name;
 
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "map_jack_port_to_alsa", "s", &jack_port_name, NULL, &reply_ptr))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "map_jack_port_to_alsa", "s", &jack_port_name, NULL, &reply_ptr))
   {
     log_error("a2j::map_jack_port_to_alsa() failed.");
     return false;
@@ -232,7 +232,7 @@ bool a2j_proxy_is_started(void)
 {
   dbus_bool_t started;
 
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "is_started", "", "b", &started))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "is_started", "", "b", &started))
   {
     log_error("a2j::is_started() failed.");
     return false;
@@ -243,7 +243,7 @@ bool a2j_proxy_is_started(void)
 
 bool a2j_proxy_start_bridge(void)
 {
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "start", "", ""))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "start", "", ""))
   {
     log_error("a2j::start() failed.");
     return false;
@@ -254,7 +254,7 @@ bool a2j_proxy_start_bridge(void)
 
 bool a2j_proxy_stop_bridge(void)
 {
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "stop", "", ""))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "stop", "", ""))
   {
     log_error("a2j::stop() failed.");
     return false;
@@ -265,7 +265,7 @@ bool a2j_proxy_stop_bridge(void)
 
 bool a2j_proxy_exit(void)
 {
-  if (!cdbus_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "exit", "", ""))
+  if (!proxy_call(0, A2J_SERVICE, A2J_OBJECT, A2J_IFACE_CONTROL, "exit", "", ""))
   {
     log_error("exit() failed.");
     return false;
@@ -197,7 +197,7 @@ static void refresh_internal(struct ladish_app_supervisor_proxy * proxy_ptr, boo
 
   version = proxy_ptr->version;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "GetAll2", "t", &version, NULL, &reply_ptr))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "GetAll2", "t", &version, NULL, &reply_ptr))
   {
     log_error("GetAll2() failed.");
     return;
@@ -355,7 +355,7 @@ ladish_app_supervisor_proxy_run_custom(
 
   terminal = run_in_terminal;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "RunCustom2", "bsss", &terminal, &command, &name, &level, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "RunCustom2", "bsss", &terminal, &command, &name, &level, ""))
   {
     log_error("RunCustom2() failed.");
     return false;
@@ -366,7 +366,7 @@ ladish_app_supervisor_proxy_run_custom(
 
 bool ladish_app_supervisor_proxy_start_app(ladish_app_supervisor_proxy_handle proxy, uint64_t id)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "StartApp", "t", &id, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "StartApp", "t", &id, ""))
   {
     log_error("StartApp() failed.");
     return false;
@@ -377,7 +377,7 @@ bool ladish_app_supervisor_proxy_start_app(ladish_app_supervisor_proxy_handle pr
 
 bool ladish_app_supervisor_proxy_stop_app(ladish_app_supervisor_proxy_handle proxy, uint64_t id)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "StopApp", "t", &id, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "StopApp", "t", &id, ""))
   {
     log_error("StopApp() failed.");
     return false;
@@ -388,7 +388,7 @@ bool ladish_app_supervisor_proxy_stop_app(ladish_app_supervisor_proxy_handle pro
 
 bool ladish_app_supervisor_proxy_kill_app(ladish_app_supervisor_proxy_handle proxy, uint64_t id)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "KillApp", "t", &id, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "KillApp", "t", &id, ""))
   {
     log_error("KillApp() failed.");
     return false;
@@ -399,7 +399,7 @@ bool ladish_app_supervisor_proxy_kill_app(ladish_app_supervisor_proxy_handle pro
 
 bool ladish_app_supervisor_proxy_remove_app(ladish_app_supervisor_proxy_handle proxy, uint64_t id)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "RemoveApp", "t", &id, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "RemoveApp", "t", &id, ""))
   {
     log_error("RemoveApp() failed.");
     return false;
@@ -427,7 +427,7 @@ ladish_app_supervisor_get_app_properties(
   char * name_buffer;
   char * commandline_buffer;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "GetAppProperties2", "t", &id, NULL, &reply_ptr))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_APP_SUPERVISOR, "GetAppProperties2", "t", &id, NULL, &reply_ptr))
   {
     log_error("GetAppProperties2() failed.");
     return false;
@@ -498,7 +498,7 @@ ladish_app_supervisor_set_app_properties(
 
   terminal = run_in_terminal;
 
-  if (!cdbus_call(
+  if (!proxy_call(
         0,
         proxy_ptr->service,
         proxy_ptr->object,
@@ -30,5 +30,23 @@
 #include "../common.h"
 #include <cdbus/cdbus.h>
 #include "../dbus_constants.h"
+#include "../common/metrics.h"
+
+/* cdbus_call() that accounts the call latency to the peer service */
+#define proxy_call(timeout, service, ...)                               \
+  (ladish_metrics_dbus_call_begin(),                                    \
+   ladish_metrics_dbus_call_end(service, cdbus_call(timeout, service, __VA_ARGS__)))
+
+/* cdbus_call_raw() that accounts the call latency to the destination service */
+static inline DBusMessage * proxy_call_raw(unsigned int timeout, DBusMessage * request_ptr)
+{
+  DBusMessage * reply_ptr;
+
+  ladish_metrics_dbus_call_begin();
+  reply_ptr = cdbus_call_raw(timeout, request_ptr);
+  ladish_metrics_dbus_call_end(dbus_message_get_destination(request_ptr), reply_ptr != NULL);
+
+  return reply_ptr;
+}
 
 #endif /* #ifndef COMMON_H__0710E3D5_9B69_4C10_BDDB_80E0D92F44AF__INCLUDED */
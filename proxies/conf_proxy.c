@@ -47,7 +47,27 @@ struct pair
   void * callback_context;
 };
 
+/* values fetched by conf_prefetch() and not yet consumed by conf_register() */
+struct prefetched
+{
+  struct list_head siblings;
+  char * key;
+  char * value;                 /* NULL if the key does not exist */
+  uint64_t version;
+};
+
+/* values set by conf_set() between conf_set_batch_begin() and conf_set_batch_end() */
+struct pending
+{
+  struct list_head siblings;
+  char * key;
+  char * value;
+};
+
 static struct list_head g_pairs;
+static struct list_head g_prefetched;
+static struct list_head g_pending;
+static bool g_batch;
 
 static struct pair * find_pair(const char * key)
 {
@@ -96,6 +116,10 @@ static void on_value_changed(struct pair * pair_ptr, const char * value, uint64_
   }
 }
 
+static void free_prefetched(struct prefetched * prefetched_ptr);
+static struct prefetched * find_prefetched(const char * key);
+static bool add_prefetched(const char * key, const char * value, uint64_t version);
+
 static void on_life_status_changed(bool appeared)
 {
   struct list_head * node_ptr;
@@ -114,6 +138,12 @@ static void on_life_status_changed(bool appeared)
       pair_ptr = list_entry(node_ptr, struct pair, siblings);
       pair_ptr->version = 0;
     }
+
+    /* versions of the new instance are not comparable, query the keys again on register */
+    while (!list_empty(&g_prefetched))
+    {
+      free_prefetched(list_entry(g_prefetched.next, struct prefetched, siblings));
+    }
   }
 }
 
@@ -123,6 +153,7 @@ static void on_conf_changed(void * UNUSED(context), DBusMessage * message_ptr)
   const char * value;
   dbus_uint64_t version;
   struct pair * pair_ptr;
+  struct prefetched * prefetched_ptr;
 
   if (!dbus_message_get_args(
         message_ptr,
@@ -140,7 +171,13 @@ static void on_conf_changed(void * UNUSED(context), DBusMessage * message_ptr)
   pair_ptr = find_pair(key);
   if (pair_ptr == NULL)
   {
-    /* we dont care about this key */
+    /* keep the value prefetched for a not yet registered key current */
+    prefetched_ptr = find_prefetched(key);
+    if (prefetched_ptr != NULL && prefetched_ptr->version < version)
+    {
+      add_prefetched(key, value, version);
+    }
+
     return;
   }
 
@@ -171,6 +208,9 @@ static struct cdbus_signal_hook g_signal_hooks[] =
 bool conf_proxy_init(void)
 {
   INIT_LIST_HEAD(&g_pairs);
+  INIT_LIST_HEAD(&g_prefetched);
+  INIT_LIST_HEAD(&g_pending);
+  g_batch = false;
 
   if (!cdbus_register_service_lifetime_hook(cdbus_g_dbus_connection, CONF_SERVICE_NAME, on_life_status_changed))
   {
@@ -194,10 +234,188 @@ bool conf_proxy_init(void)
   return true;
 }
 
+static void free_prefetched(struct prefetched * prefetched_ptr)
+{
+  list_del(&prefetched_ptr->siblings);
+  free(prefetched_ptr->key);
+  free(prefetched_ptr->value);
+  free(prefetched_ptr);
+}
+
+static void free_pending(struct pending * pending_ptr)
+{
+  list_del(&pending_ptr->siblings);
+  free(pending_ptr->key);
+  free(pending_ptr->value);
+  free(pending_ptr);
+}
+
 void conf_proxy_uninit(void)
 {
   cdbus_unregister_object_signal_hooks(cdbus_g_dbus_connection, CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE);
   cdbus_unregister_service_lifetime_hook(cdbus_g_dbus_connection, CONF_SERVICE_NAME);
+
+  while (!list_empty(&g_prefetched))
+  {
+    free_prefetched(list_entry(g_prefetched.next, struct prefetched, siblings));
+  }
+
+  while (!list_empty(&g_pending))
+  {
+    free_pending(list_entry(g_pending.next, struct pending, siblings));
+  }
+}
+
+static struct prefetched * find_prefetched(const char * key)
+{
+  struct list_head * node_ptr;
+  struct prefetched * prefetched_ptr;
+
+  list_for_each(node_ptr, &g_prefetched)
+  {
+    prefetched_ptr = list_entry(node_ptr, struct prefetched, siblings);
+    if (strcmp(prefetched_ptr->key, key) == 0)
+    {
+      return prefetched_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static bool add_prefetched(const char * key, const char * value, uint64_t version)
+{
+  struct prefetched * prefetched_ptr;
+
+  prefetched_ptr = find_prefetched(key);
+  if (prefetched_ptr == NULL)
+  {
+    prefetched_ptr = malloc(sizeof(struct prefetched));
+    if (prefetched_ptr == NULL)
+    {
+      log_error("malloc() failed to allocate memory for prefetched struct");
+      return false;
+    }
+
+    prefetched_ptr->key = strdup(key);
+    if (prefetched_ptr->key == NULL)
+    {
+      log_error("strdup(\"%s\") failed for key", key);
+      free(prefetched_ptr);
+      return false;
+    }
+
+    prefetched_ptr->value = NULL;
+    list_add_tail(&prefetched_ptr->siblings, &g_prefetched);
+  }
+
+  free(prefetched_ptr->value);
+  prefetched_ptr->value = NULL;
+  prefetched_ptr->version = version;
+
+  if (value != NULL)
+  {
+    prefetched_ptr->value = strdup(value);
+    if (prefetched_ptr->value == NULL)
+    {
+      log_error("strdup(\"%s\") failed for value", value);
+      free_prefetched(prefetched_ptr);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Fetch values of multiple keys with single D-Bus call.
+ * Subsequent conf_register() calls for these keys will not query the conf service. */
+bool conf_prefetch(const char * const * keys)
+{
+  DBusMessage * request_ptr;
+  DBusMessage * reply_ptr;
+  DBusMessageIter iter;
+  DBusMessageIter array_iter;
+  DBusMessageIter struct_iter;
+  const char * const * key_ptr;
+  const char * key;
+  const char * value;
+  dbus_uint64_t version;
+  const char * reply_signature;
+
+  request_ptr = dbus_message_new_method_call(CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "GetMany");
+  if (request_ptr == NULL)
+  {
+    log_error("dbus_message_new_method_call() failed.");
+    return false;
+  }
+
+  dbus_message_iter_init_append(request_ptr, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &array_iter))
+  {
+    log_error("dbus_message_iter_open_container() failed.");
+    dbus_message_unref(request_ptr);
+    return false;
+  }
+
+  for (key_ptr = keys; *key_ptr != NULL; key_ptr++)
+  {
+    if (!dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_STRING, key_ptr))
+    {
+      log_error("dbus_message_iter_append_basic() failed.");
+      dbus_message_unref(request_ptr);
+      return false;
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &array_iter))
+  {
+    log_error("dbus_message_iter_close_container() failed.");
+    dbus_message_unref(request_ptr);
+    return false;
+  }
+
+  reply_ptr = proxy_call_raw(0, request_ptr);
+  dbus_message_unref(request_ptr);
+  if (reply_ptr == NULL)
+  {
+    /* older conf service, conf_register() will query keys one by one */
+    return false;
+  }
+
+  reply_signature = dbus_message_get_signature(reply_ptr);
+  if (strcmp(reply_signature, "a(sst)") != 0)
+  {
+    log_error("GetMany() reply signature mismatch. '%s'", reply_signature);
+    dbus_message_unref(reply_ptr);
+    return false;
+  }
+
+  /* keys not present in the reply do not exist */
+  for (key_ptr = keys; *key_ptr != NULL; key_ptr++)
+  {
+    add_prefetched(*key_ptr, NULL, 0);
+  }
+
+  dbus_message_iter_init(reply_ptr, &iter);
+  dbus_message_iter_recurse(&iter, &array_iter);
+
+  while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_STRUCT)
+  {
+    dbus_message_iter_recurse(&array_iter, &struct_iter);
+    dbus_message_iter_get_basic(&struct_iter, &key);
+    dbus_message_iter_next(&struct_iter);
+    dbus_message_iter_get_basic(&struct_iter, &value);
+    dbus_message_iter_next(&struct_iter);
+    dbus_message_iter_get_basic(&struct_iter, &version);
+
+    add_prefetched(key, value, version);
+
+    dbus_message_iter_next(&array_iter);
+  }
+
+  dbus_message_unref(reply_ptr);
+  return true;
 }
 
 bool
@@ -209,6 +427,7 @@ conf_register(
   const char * value;
   uint64_t version;
   struct pair * pair_ptr;
+  struct prefetched * prefetched_ptr;
 
   pair_ptr = find_pair(key);
   if (pair_ptr != NULL)
@@ -218,7 +437,13 @@ conf_register(
     return false;
   }
 
-  if (!cdbus_call(0, CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "get", "s", &key, "st", &value, &version))
+  prefetched_ptr = find_prefetched(key);
+  if (prefetched_ptr != NULL)
+  {
+    value = prefetched_ptr->value;
+    version = prefetched_ptr->version;
+  }
+  else if (!proxy_call(0, CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "get", "s", &key, "st", &value, &version))
   {
     //log_error("conf::get() failed.");
     version = 0;
@@ -260,6 +485,12 @@ conf_register(
     pair_ptr->value_buffer_size = 0;
   }
 
+  if (prefetched_ptr != NULL)
+  {
+    free_prefetched(prefetched_ptr); /* value was copied, it is safe to free it now */
+    value = pair_ptr->value;
+  }
+
   pair_ptr->version = version;
   pair_ptr->callback = callback;
   pair_ptr->callback_context = callback_context;
@@ -274,6 +505,64 @@ conf_register(
   return true;
 }
 
+static void on_value_set(const char * key, const char * value, uint64_t version)
+{
+  struct pair * pair_ptr;
+
+  pair_ptr = find_pair(key);
+  if (pair_ptr != NULL && pair_ptr->value != NULL && strcmp(value, pair_ptr->value) != 0)
+  {
+    /* record the new version and dont call the callback */
+    on_value_changed(pair_ptr, value, version, false);
+  }
+}
+
+static bool queue_pending(const char * key, const char * value)
+{
+  struct list_head * node_ptr;
+  struct pending * pending_ptr;
+  char * value_buffer;
+
+  value_buffer = strdup(value);
+  if (value_buffer == NULL)
+  {
+    log_error("strdup(\"%s\") failed for value", value);
+    return false;
+  }
+
+  list_for_each(node_ptr, &g_pending)
+  {
+    pending_ptr = list_entry(node_ptr, struct pending, siblings);
+    if (strcmp(pending_ptr->key, key) == 0)
+    {
+      free(pending_ptr->value);
+      pending_ptr->value = value_buffer;
+      return true;
+    }
+  }
+
+  pending_ptr = malloc(sizeof(struct pending));
+  if (pending_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate memory for pending struct");
+    free(value_buffer);
+    return false;
+  }
+
+  pending_ptr->key = strdup(key);
+  if (pending_ptr->key == NULL)
+  {
+    log_error("strdup(\"%s\") failed for key", key);
+    free(value_buffer);
+    free(pending_ptr);
+    return false;
+  }
+
+  pending_ptr->value = value_buffer;
+  list_add_tail(&pending_ptr->siblings, &g_pending);
+  return true;
+}
+
 bool conf_set(const char * key, const char * value)
 {
   uint64_t version;
@@ -285,19 +574,141 @@ bool conf_set(const char * key, const char * value)
     return true;                /* not changed */
   }
 
-  if (!cdbus_call(0, CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "set", "ss", &key, &value, "t", &version))
+  if (g_batch)
+  {
+    return queue_pending(key, value);
+  }
+
+  if (!proxy_call(0, CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "set", "ss", &key, &value, "t", &version))
   {
     log_error("conf::set() failed.");
     return false;
   }
 
-  if (pair_ptr != NULL && pair_ptr->value != NULL && strcmp(value, pair_ptr->value) != 0)
+  on_value_set(key, value, version);
+
+  return true;
+}
+
+/* conf_set() calls until conf_set_batch_end() are sent to the conf service with single D-Bus call */
+void conf_set_batch_begin(void)
+{
+  ASSERT(!g_batch);
+  g_batch = true;
+}
+
+static bool conf_set_many(void)
+{
+  DBusMessage * request_ptr;
+  DBusMessage * reply_ptr;
+  DBusMessageIter iter;
+  DBusMessageIter array_iter;
+  DBusMessageIter struct_iter;
+  struct list_head * node_ptr;
+  struct pending * pending_ptr;
+  dbus_uint64_t version;
+  const char * reply_signature;
+
+  request_ptr = dbus_message_new_method_call(CONF_SERVICE_NAME, CONF_OBJECT_PATH, CONF_IFACE, "SetMany");
+  if (request_ptr == NULL)
   {
-    /* record the new version and dont call the callback */
-    on_value_changed(pair_ptr, value, version, false);
+    log_error("dbus_message_new_method_call() failed.");
+    return false;
+  }
+
+  dbus_message_iter_init_append(request_ptr, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(ss)", &array_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  list_for_each(node_ptr, &g_pending)
+  {
+    pending_ptr = list_entry(node_ptr, struct pending, siblings);
+
+    if (!dbus_message_iter_open_container(&array_iter, DBUS_TYPE_STRUCT, NULL, &struct_iter) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &pending_ptr->key) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &pending_ptr->value) ||
+        !dbus_message_iter_close_container(&array_iter, &struct_iter))
+    {
+      goto fail_unref_request;
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &array_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  reply_ptr = proxy_call_raw(0, request_ptr);
+  dbus_message_unref(request_ptr);
+  if (reply_ptr == NULL)
+  {
+    return false;
   }
 
+  reply_signature = dbus_message_get_signature(reply_ptr);
+  if (strcmp(reply_signature, "at") != 0)
+  {
+    log_error("SetMany() reply signature mismatch. '%s'", reply_signature);
+    dbus_message_unref(reply_ptr);
+    return false;
+  }
+
+  dbus_message_iter_init(reply_ptr, &iter);
+  dbus_message_iter_recurse(&iter, &array_iter);
+
+  while (!list_empty(&g_pending) && dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_UINT64)
+  {
+    pending_ptr = list_entry(g_pending.next, struct pending, siblings);
+    dbus_message_iter_get_basic(&array_iter, &version);
+    on_value_set(pending_ptr->key, pending_ptr->value, version);
+    free_pending(pending_ptr);
+    dbus_message_iter_next(&array_iter);
+  }
+
+  dbus_message_unref(reply_ptr);
   return true;
+
+fail_unref_request:
+  log_error("Ran out of memory trying to construct SetMany() call");
+  dbus_message_unref(request_ptr);
+  return false;
+}
+
+bool conf_set_batch_end(void)
+{
+  struct pending * pending_ptr;
+  bool ret;
+
+  ASSERT(g_batch);
+  g_batch = false;
+
+  if (list_empty(&g_pending))
+  {
+    return true;
+  }
+
+  if (conf_set_many())
+  {
+    return list_empty(&g_pending);
+  }
+
+  /* older conf service, set values one by one */
+  ret = true;
+  while (!list_empty(&g_pending))
+  {
+    pending_ptr = list_entry(g_pending.next, struct pending, siblings);
+    if (!conf_set(pending_ptr->key, pending_ptr->value))
+    {
+      ret = false;
+    }
+
+    free_pending(pending_ptr);
+  }
+
+  return ret;
 }
 
 bool conf_get(const char * key, const char ** value_ptr)
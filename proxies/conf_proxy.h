@@ -38,7 +38,11 @@ conf_register(
   void (* callback)(void * context, const char * key, const char * value),
   void * callback_context);
 
+bool conf_prefetch(const char * const * keys);
+
 bool conf_set(const char * key, const char * value);
+void conf_set_batch_begin(void);
+bool conf_set_batch_end(void);
 bool conf_get(const char * key, const char ** value_ptr);
 
 bool conf_string2bool(const char * value);
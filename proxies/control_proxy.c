@@ -60,7 +60,7 @@ static bool control_proxy_is_studio_loaded(bool * present_ptr)
 {
   dbus_bool_t present;
 
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "IsStudioLoaded", "", "b", &present))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "IsStudioLoaded", "", "b", &present))
   {
     return false;
   }
@@ -146,7 +146,7 @@ bool control_proxy_get_studio_list(void (* callback)(void * context, const char
   DBusMessageIter array_iter;
   const char * studio_name;
 
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "GetStudioList", "", NULL, &reply_ptr))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "GetStudioList", "", NULL, &reply_ptr))
   {
     log_error("GetStudioList() failed.");
     return false;
@@ -183,7 +183,7 @@ bool control_proxy_new_studio(const char * studio_name)
     studio_name = "";
   }
 
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "NewStudio", "s", &studio_name, ""))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "NewStudio", "s", &studio_name, ""))
   {
     log_error("NewStudio() failed.");
     return false;
@@ -194,7 +194,7 @@ bool control_proxy_new_studio(const char * studio_name)
 
 bool control_proxy_load_studio(const char * studio_name)
 {
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "LoadStudio", "s", &studio_name, ""))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "LoadStudio", "s", &studio_name, ""))
   {
     log_error("LoadStudio() failed.");
     return false;
@@ -205,7 +205,7 @@ bool control_proxy_load_studio(const char * studio_name)
 
 bool control_proxy_delete_studio(const char * studio_name)
 {
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "DeleteStudio", "s", &studio_name, ""))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "DeleteStudio", "s", &studio_name, ""))
   {
     log_error("DeleteStudio() failed.");
     return false;
@@ -216,7 +216,7 @@ bool control_proxy_delete_studio(const char * studio_name)
 
 bool control_proxy_exit(void)
 {
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "Exit", "", ""))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "Exit", "", ""))
   {
     log_error("Exit() failed.");
     return false;
@@ -234,7 +234,7 @@ bool control_proxy_get_room_template_list(void (* callback)(void * context, cons
   DBusMessageIter array_iter;
   const char * name;
 
-  if (!cdbus_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "GetRoomTemplateList", "", NULL, &reply_ptr))
+  if (!proxy_call(0, SERVICE_NAME, CONTROL_OBJECT_PATH, IFACE_CONTROL, "GetRoomTemplateList", "", NULL, &reply_ptr))
   {
     log_error("GetRoomTemplateList() failed.");
     return false;
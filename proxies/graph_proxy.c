@@ -25,6 +25,9 @@
  */
 
 #include "graph_proxy.h"
+#include "../common/hash.h"
+
+#define DICT_HASH_BUCKETS 1024  /* must be power of two */
 
 struct monitor
 {
@@ -39,6 +42,62 @@ struct monitor
   void (* port_disappeared)(void * context, uint64_t client_id, uint64_t port_id);
   void (* ports_connected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id);
   void (* ports_disconnected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id);
+  uint64_t first_version;       /* older versions are in the graph dispatched on attach, 0 if attached before activation */
+};
+
+/* dict value that is either prefetched or waiting to be sent */
+struct dict_entry
+{
+  struct hlist_node hash_siblings;
+  struct list_head siblings;
+  uint32_t object_type;
+  uint64_t object_id;
+  uint32_t hash;
+  char * key;
+  char * value;
+};
+
+struct dict_table
+{
+  struct list_head entries;
+  struct hlist_head buckets[DICT_HASH_BUCKETS];
+};
+
+struct dict_prefetch_key
+{
+  struct list_head siblings;
+  uint32_t object_type;
+  char * key;
+};
+
+/* connect or disconnect request waiting to be sent */
+struct connection_request
+{
+  struct list_head siblings;
+  void * context;               /* of the flush that sends it */
+  bool connect;
+  uint64_t port1_id;
+  uint64_t port2_id;
+};
+
+/* requests sent by one graph_proxy_connections_flush() call */
+struct connection_batch
+{
+  struct list_head siblings;    /* in graph::connection_batches, empty when cancelled */
+  unsigned int outstanding;     /* replies not received yet */
+  unsigned int count;
+  unsigned int failed_count;
+  void * context;
+  void (* request_failed)(void * context, bool connect, uint64_t port1_id, uint64_t port2_id);
+  void (* completed)(void * context, unsigned int count, unsigned int failed_count);
+};
+
+struct connection_reply_cookie
+{
+  struct connection_batch * batch_ptr;
+  bool connect;
+  uint64_t port1_id;
+  uint64_t port2_id;
 };
 
 struct graph
@@ -49,7 +108,14 @@ struct graph
   uint64_t version;
   bool active;
   bool graph_dict_supported;
+  bool graph_dict_bulk_supported;
   bool graph_manager_supported;
+  struct list_head dict_prefetch_keys;
+  bool dict_prefetched; /* dict_cache is valid, while refresh is dispatched to monitors */
+  struct dict_table dict_cache;
+  struct dict_table dict_pending;
+  struct list_head connection_requests;
+  struct list_head connection_batches;
 };
 
 static struct cdbus_signal_hook g_signal_hooks[];
@@ -66,6 +132,12 @@ static void clear(struct graph * graph_ptr)
   }
 }
 
+/* signals already included in the graph that was dispatched on attach are not dispatched again */
+static bool monitor_is_behind(struct graph * graph_ptr, struct monitor * monitor_ptr)
+{
+  return graph_ptr->version >= monitor_ptr->first_version;
+}
+
 static void client_appeared(struct graph * graph_ptr, uint64_t id, const char * name)
 {
   struct list_head * node_ptr;
@@ -74,6 +146,11 @@ static void client_appeared(struct graph * graph_ptr, uint64_t id, const char *
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->client_appeared(monitor_ptr->context, id, name);
   }
 }
@@ -92,6 +169,11 @@ client_renamed(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     if (monitor_ptr->client_renamed != NULL)
     {
       monitor_ptr->client_renamed(monitor_ptr->context, client_id, old_client_name, new_client_name);
@@ -107,6 +189,11 @@ static void client_disappeared(struct graph * graph_ptr, uint64_t id)
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->client_disappeared(monitor_ptr->context, id);
   }
 }
@@ -140,6 +227,11 @@ port_appeared(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->port_appeared(monitor_ptr->context, client_id, port_id, port_name, is_input, is_terminal, is_midi);
   }
 }
@@ -157,6 +249,11 @@ port_disappeared(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->port_disappeared(monitor_ptr->context, client_id, port_id);
   }
 }
@@ -176,6 +273,11 @@ port_renamed(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->port_renamed(monitor_ptr->context, client_id, port_id, old_port_name, new_port_name);
   }
 }
@@ -195,6 +297,11 @@ ports_connected(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->ports_connected(monitor_ptr->context, client1_id, port1_id, client2_id, port2_id);
   }
 }
@@ -214,12 +321,328 @@ ports_disconnected(
   list_for_each(node_ptr, &graph_ptr->monitors)
   {
     monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+    if (!monitor_is_behind(graph_ptr, monitor_ptr))
+    {
+      continue;
+    }
+
     monitor_ptr->ports_disconnected(monitor_ptr->context, client1_id, port1_id, client2_id, port2_id);
   }
 }
 
-static void refresh_internal(struct graph * graph_ptr, bool force)
+static void dict_table_init(struct dict_table * table_ptr)
+{
+  unsigned int i;
+
+  INIT_LIST_HEAD(&table_ptr->entries);
+
+  for (i = 0; i < DICT_HASH_BUCKETS; i++)
+  {
+    INIT_HLIST_HEAD(table_ptr->buckets + i);
+  }
+}
+
+static uint32_t dict_entry_hash(uint32_t object_type, uint64_t object_id, const char * key)
+{
+  return ladish_hash_string(key) ^ ladish_hash_uint64(object_id ^ ((uint64_t)object_type << 56));
+}
+
+static
+struct dict_entry *
+dict_table_find(
+  struct dict_table * table_ptr,
+  uint32_t object_type,
+  uint64_t object_id,
+  const char * key)
+{
+  uint32_t hash;
+  struct hlist_node * node_ptr;
+  struct dict_entry * entry_ptr;
+
+  hash = dict_entry_hash(object_type, object_id, key);
+
+  hlist_for_each(node_ptr, table_ptr->buckets + ladish_hash_bucket(hash, DICT_HASH_BUCKETS))
+  {
+    entry_ptr = hlist_entry(node_ptr, struct dict_entry, hash_siblings);
+    if (entry_ptr->hash == hash &&
+        entry_ptr->object_type == object_type &&
+        entry_ptr->object_id == object_id &&
+        strcmp(entry_ptr->key, key) == 0)
+    {
+      return entry_ptr;
+    }
+  }
+
+  return NULL;
+}
+
+static
+bool
+dict_table_set(
+  struct dict_table * table_ptr,
+  uint32_t object_type,
+  uint64_t object_id,
+  const char * key,
+  const char * value)
+{
+  struct dict_entry * entry_ptr;
+  char * value_dup;
+
+  value_dup = strdup(value);
+  if (value_dup == NULL)
+  {
+    log_error("strdup() failed for dict value");
+    return false;
+  }
+
+  entry_ptr = dict_table_find(table_ptr, object_type, object_id, key);
+  if (entry_ptr != NULL)
+  {
+    free(entry_ptr->value);
+    entry_ptr->value = value_dup;
+    return true;
+  }
+
+  entry_ptr = malloc(sizeof(struct dict_entry));
+  if (entry_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate struct dict_entry");
+    free(value_dup);
+    return false;
+  }
+
+  entry_ptr->key = strdup(key);
+  if (entry_ptr->key == NULL)
+  {
+    log_error("strdup() failed for dict key");
+    free(entry_ptr);
+    free(value_dup);
+    return false;
+  }
+
+  entry_ptr->object_type = object_type;
+  entry_ptr->object_id = object_id;
+  entry_ptr->hash = dict_entry_hash(object_type, object_id, key);
+  entry_ptr->value = value_dup;
+
+  hlist_add_head(&entry_ptr->hash_siblings, table_ptr->buckets + ladish_hash_bucket(entry_ptr->hash, DICT_HASH_BUCKETS));
+  list_add_tail(&entry_ptr->siblings, &table_ptr->entries);
+
+  return true;
+}
+
+static void dict_entry_unlink(struct dict_entry * entry_ptr)
+{
+  hlist_del(&entry_ptr->hash_siblings);
+  list_del(&entry_ptr->siblings);
+}
+
+static void dict_entry_free(struct dict_entry * entry_ptr)
+{
+  free(entry_ptr->key);
+  free(entry_ptr->value);
+  free(entry_ptr);
+}
+
+static void dict_table_remove(struct dict_entry * entry_ptr)
+{
+  dict_entry_unlink(entry_ptr);
+  dict_entry_free(entry_ptr);
+}
+
+static void dict_table_clear(struct dict_table * table_ptr)
+{
+  while (!list_empty(&table_ptr->entries))
+  {
+    dict_table_remove(list_entry(table_ptr->entries.next, struct dict_entry, siblings));
+  }
+}
+
+static bool is_dict_key_prefetched(struct graph * graph_ptr, uint32_t object_type, const char * key)
+{
+  struct list_head * node_ptr;
+  struct dict_prefetch_key * key_ptr;
+
+  list_for_each(node_ptr, &graph_ptr->dict_prefetch_keys)
+  {
+    key_ptr = list_entry(node_ptr, struct dict_prefetch_key, siblings);
+    if (key_ptr->object_type == object_type && strcmp(key_ptr->key, key) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static
+bool
+append_dict_object(
+  DBusMessageIter * array_iter_ptr,
+  dbus_uint32_t object_type,
+  dbus_uint64_t object_id)
+{
+  DBusMessageIter struct_iter;
+
+  return
+    dbus_message_iter_open_container(array_iter_ptr, DBUS_TYPE_STRUCT, NULL, &struct_iter) &&
+    dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &object_type) &&
+    dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &object_id) &&
+    dbus_message_iter_close_container(array_iter_ptr, &struct_iter);
+}
+
+/* Fetch the prefetch keys of all clients and ports in a GetGraph() reply
+ * with single GetDicts() call, instead of one Get() call per object and key */
+static bool dict_prefetch(struct graph * graph_ptr, DBusMessageIter * clients_iter_ptr)
+{
+  DBusMessage * request_ptr;
+  DBusMessage * reply_ptr;
+  DBusMessageIter iter;
+  DBusMessageIter objects_iter;
+  DBusMessageIter keys_iter;
+  DBusMessageIter clients_array_iter;
+  DBusMessageIter client_struct_iter;
+  DBusMessageIter ports_array_iter;
+  DBusMessageIter port_struct_iter;
+  DBusMessageIter entry_iter;
+  struct list_head * node_ptr;
+  struct dict_prefetch_key * key_ptr;
+  dbus_uint32_t object_type;
+  dbus_uint64_t object_id;
+  const char * key;
+  const char * value;
+  const char * reply_signature;
+
+  request_ptr = dbus_message_new_method_call(graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "GetDicts");
+  if (request_ptr == NULL)
+  {
+    log_error("dbus_message_new_method_call() failed.");
+    return false;
+  }
+
+  dbus_message_iter_init_append(request_ptr, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(ut)", &objects_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  for (dbus_message_iter_recurse(clients_iter_ptr, &clients_array_iter);
+       dbus_message_iter_get_arg_type(&clients_array_iter) != DBUS_TYPE_INVALID;
+       dbus_message_iter_next(&clients_array_iter))
+  {
+    dbus_message_iter_recurse(&clients_array_iter, &client_struct_iter);
+
+    dbus_message_iter_get_basic(&client_struct_iter, &object_id);
+    if (!append_dict_object(&objects_iter, GRAPH_DICT_OBJECT_TYPE_CLIENT, object_id))
+    {
+      goto fail_unref_request;
+    }
+
+    dbus_message_iter_next(&client_struct_iter);
+    dbus_message_iter_next(&client_struct_iter);
+
+    for (dbus_message_iter_recurse(&client_struct_iter, &ports_array_iter);
+         dbus_message_iter_get_arg_type(&ports_array_iter) != DBUS_TYPE_INVALID;
+         dbus_message_iter_next(&ports_array_iter))
+    {
+      dbus_message_iter_recurse(&ports_array_iter, &port_struct_iter);
+
+      dbus_message_iter_get_basic(&port_struct_iter, &object_id);
+      if (!append_dict_object(&objects_iter, GRAPH_DICT_OBJECT_TYPE_PORT, object_id))
+      {
+        goto fail_unref_request;
+      }
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &objects_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &keys_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  list_for_each(node_ptr, &graph_ptr->dict_prefetch_keys)
+  {
+    key_ptr = list_entry(node_ptr, struct dict_prefetch_key, siblings);
+    if (!dbus_message_iter_append_basic(&keys_iter, DBUS_TYPE_STRING, &key_ptr->key))
+    {
+      goto fail_unref_request;
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &keys_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  reply_ptr = proxy_call_raw(0, request_ptr);
+  dbus_message_unref(request_ptr);
+  if (reply_ptr == NULL)
+  {
+    /* older ladishd, values will be queried one by one */
+    log_info("GetDicts() failed, dict values will not be prefetched");
+    graph_ptr->graph_dict_bulk_supported = false;
+    return false;
+  }
+
+  reply_signature = dbus_message_get_signature(reply_ptr);
+  if (strcmp(reply_signature, "a(utss)") != 0)
+  {
+    log_error("GetDicts() reply signature mismatch. '%s'", reply_signature);
+    dbus_message_unref(reply_ptr);
+    return false;
+  }
+
+  dbus_message_iter_init(reply_ptr, &iter);
+  for (dbus_message_iter_recurse(&iter, &objects_iter);
+       dbus_message_iter_get_arg_type(&objects_iter) != DBUS_TYPE_INVALID;
+       dbus_message_iter_next(&objects_iter))
+  {
+    dbus_message_iter_recurse(&objects_iter, &entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &object_type);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &object_id);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &key);
+    dbus_message_iter_next(&entry_iter);
+
+    dbus_message_iter_get_basic(&entry_iter, &value);
+
+    if (!dict_table_set(&graph_ptr->dict_cache, object_type, object_id, key, value))
+    {
+      dict_table_clear(&graph_ptr->dict_cache);
+      dbus_message_unref(reply_ptr);
+      return false;
+    }
+  }
+
+  dbus_message_unref(reply_ptr);
+  return true;
+
+fail_unref_request:
+  log_error("Ran out of memory trying to construct GetDicts() call");
+  dbus_message_unref(request_ptr);
+  return false;
+}
+
+/*
+ * When attached_monitor_ptr is not NULL, the graph is dispatched to the only
+ * monitor in the list, a monitor attached to an active graph. The graph
+ * version is then left alone, so the other monitors still get the signals
+ * that are older than the fetched graph.
+ */
+static void refresh_internal(struct graph * graph_ptr, bool force, struct monitor * attached_monitor_ptr)
 {
+  struct list_head * node_ptr;
+  struct monitor * monitor_ptr;
   DBusMessage* reply_ptr;
   DBusMessageIter iter;
   dbus_uint64_t version;
@@ -244,7 +667,7 @@ static void refresh_internal(struct graph * graph_ptr, bool force)
 
   log_info("refresh_internal() called");
 
-  if (force)
+  if (force || attached_monitor_ptr != NULL)
   {
     version = 0; // workaround module split/join stupidity
   }
@@ -253,7 +676,7 @@ static void refresh_internal(struct graph * graph_ptr, bool force)
     version = graph_ptr->version;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "GetGraph", "t", &version, NULL, &reply_ptr))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "GetGraph", "t", &version, NULL, &reply_ptr))
   {
     log_error("GetGraph() failed.");
     return;
@@ -273,15 +696,32 @@ static void refresh_internal(struct graph * graph_ptr, bool force)
   dbus_message_iter_get_basic(&iter, &version);
   dbus_message_iter_next(&iter);
 
-  if (!force && version <= graph_ptr->version)
+  if (attached_monitor_ptr == NULL)
   {
-    goto unref;
+    if (!force && version <= graph_ptr->version)
+    {
+      goto unref;
+    }
+
+    /* all monitors get the new graph */
+    list_for_each(node_ptr, &graph_ptr->monitors)
+    {
+      monitor_ptr = list_entry(node_ptr, struct monitor, siblings);
+      monitor_ptr->first_version = 0;
+    }
+
+    //log_info("got new graph version %llu", (unsigned long long)version);
+    graph_ptr->version = version;
   }
 
   clear(graph_ptr);
 
-  //log_info("got new graph version %llu", (unsigned long long)version);
-  graph_ptr->version = version;
+  if (graph_ptr->graph_dict_supported &&
+      graph_ptr->graph_dict_bulk_supported &&
+      !list_empty(&graph_ptr->dict_prefetch_keys))
+  {
+    graph_ptr->dict_prefetched = dict_prefetch(graph_ptr, &iter);
+  }
 
   //info_msg((std::string)"clients " + (char)dbus_message_iter_get_arg_type(&iter));
 
@@ -379,6 +819,14 @@ static void refresh_internal(struct graph * graph_ptr, bool force)
     ports_connected(graph_ptr, client_id, port_id, client2_id, port2_id);
   }
 
+  graph_ptr->dict_prefetched = false;
+  dict_table_clear(&graph_ptr->dict_cache);
+
+  if (attached_monitor_ptr != NULL)
+  {
+    attached_monitor_ptr->first_version = version + 1;
+  }
+
 unref:
   dbus_message_unref(reply_ptr);
 }
@@ -420,8 +868,17 @@ graph_proxy_create(
   graph_ptr->active = false;
 
   graph_ptr->graph_dict_supported = graph_dict_supported;
+  graph_ptr->graph_dict_bulk_supported = true;
   graph_ptr->graph_manager_supported = graph_manager_supported;
 
+  INIT_LIST_HEAD(&graph_ptr->dict_prefetch_keys);
+  graph_ptr->dict_prefetched = false;
+  dict_table_init(&graph_ptr->dict_cache);
+  dict_table_init(&graph_ptr->dict_pending);
+
+  INIT_LIST_HEAD(&graph_ptr->connection_requests);
+  INIT_LIST_HEAD(&graph_ptr->connection_batches);
+
   *graph_proxy_handle_ptr = (graph_proxy_handle)graph_ptr;
 
   return true;
@@ -452,6 +909,8 @@ void
 graph_proxy_destroy(
   graph_proxy_handle graph)
 {
+  struct dict_prefetch_key * key_ptr;
+
   ASSERT(list_empty(&graph_ptr->monitors));
 
   if (graph_ptr->active)
@@ -463,6 +922,20 @@ graph_proxy_destroy(
       JACKDBUS_IFACE_PATCHBAY);
   }
 
+  graph_proxy_dict_flush(graph);
+  dict_table_clear(&graph_ptr->dict_pending);
+
+  /* replies of already sent requests free the batches */
+  graph_proxy_connections_cancel(graph, NULL);
+
+  while (!list_empty(&graph_ptr->dict_prefetch_keys))
+  {
+    key_ptr = list_entry(graph_ptr->dict_prefetch_keys.next, struct dict_prefetch_key, siblings);
+    list_del(&key_ptr->siblings);
+    free(key_ptr->key);
+    free(key_ptr);
+  }
+
   free(graph_ptr->object);
   free(graph_ptr->service);
   free(graph_ptr);
@@ -497,7 +970,7 @@ graph_proxy_activate(
 
   graph_ptr->active = true;
 
-  refresh_internal(graph_ptr, true);
+  refresh_internal(graph_ptr, true, NULL);
 
   return true;
 }
@@ -517,11 +990,7 @@ graph_proxy_attach(
   void (* ports_disconnected)(void * context, uint64_t client1_id, uint64_t port1_id, uint64_t client2_id, uint64_t port2_id))
 {
   struct monitor * monitor_ptr;
-
-  if (graph_ptr->active)
-  {
-    return false;
-  }
+  struct list_head other_monitors;
 
   monitor_ptr = malloc(sizeof(struct monitor));
   if (monitor_ptr == NULL)
@@ -540,9 +1009,23 @@ graph_proxy_attach(
   monitor_ptr->port_disappeared = port_disappeared;
   monitor_ptr->ports_connected = ports_connected;
   monitor_ptr->ports_disconnected = ports_disconnected;
+  monitor_ptr->first_version = 0;
 
+  if (!graph_ptr->active)
+  {
+    list_add_tail(&monitor_ptr->siblings, &graph_ptr->monitors);
+    return true;
+  }
+
+  /* the other monitors already have the current graph, dispatch it to the new monitor only */
+  INIT_LIST_HEAD(&other_monitors);
+  list_splice_init(&graph_ptr->monitors, &other_monitors);
   list_add_tail(&monitor_ptr->siblings, &graph_ptr->monitors);
 
+  refresh_internal(graph_ptr, false, monitor_ptr);
+
+  list_splice(&other_monitors, &graph_ptr->monitors);
+
   return true;
 }
 
@@ -574,7 +1057,7 @@ graph_proxy_connect_ports(
   uint64_t port1_id,
   uint64_t port2_id)
 {
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "ConnectPortsByID", "tt", &port1_id, &port2_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "ConnectPortsByID", "tt", &port1_id, &port2_id, ""))
   {
     log_error("ConnectPortsByID() failed.");
     return false;
@@ -589,7 +1072,7 @@ graph_proxy_disconnect_ports(
   uint64_t port1_id,
   uint64_t port2_id)
 {
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "DisconnectPortsByID", "tt", &port1_id, &port2_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "DisconnectPortsByID", "tt", &port1_id, &port2_id, ""))
   {
     log_error("DisconnectPortsByID() failed.");
     return false;
@@ -598,6 +1081,233 @@ graph_proxy_disconnect_ports(
   return true;
 }
 
+static
+bool
+queue_connection_request(
+  graph_proxy_handle graph,
+  void * context,
+  bool connect,
+  uint64_t port1_id,
+  uint64_t port2_id)
+{
+  struct connection_request * request_ptr;
+
+  request_ptr = malloc(sizeof(struct connection_request));
+  if (request_ptr == NULL)
+  {
+    log_error("malloc() failed for struct connection_request");
+    return false;
+  }
+
+  request_ptr->context = context;
+  request_ptr->connect = connect;
+  request_ptr->port1_id = port1_id;
+  request_ptr->port2_id = port2_id;
+  list_add_tail(&request_ptr->siblings, &graph_ptr->connection_requests);
+  return true;
+}
+
+bool
+graph_proxy_connect_ports_deferred(
+  graph_proxy_handle graph,
+  void * context,
+  uint64_t port1_id,
+  uint64_t port2_id)
+{
+  return queue_connection_request(graph, context, true, port1_id, port2_id);
+}
+
+bool
+graph_proxy_disconnect_ports_deferred(
+  graph_proxy_handle graph,
+  void * context,
+  uint64_t port1_id,
+  uint64_t port2_id)
+{
+  return queue_connection_request(graph, context, false, port1_id, port2_id);
+}
+
+static void connection_batch_release(struct connection_batch * batch_ptr)
+{
+  ASSERT(batch_ptr->outstanding > 0);
+  batch_ptr->outstanding--;
+  if (batch_ptr->outstanding > 0)
+  {
+    return;
+  }
+
+  if (batch_ptr->completed != NULL)
+  {
+    batch_ptr->completed(batch_ptr->context, batch_ptr->count, batch_ptr->failed_count);
+  }
+
+  list_del(&batch_ptr->siblings);
+  free(batch_ptr);
+}
+
+static
+void
+connection_request_failed(
+  struct connection_batch * batch_ptr,
+  bool connect,
+  uint64_t port1_id,
+  uint64_t port2_id)
+{
+  log_error("%s() failed for ports %"PRIu64" and %"PRIu64, connect ? "ConnectPortsByID" : "DisconnectPortsByID", port1_id, port2_id);
+
+  batch_ptr->failed_count++;
+  if (batch_ptr->request_failed != NULL)
+  {
+    batch_ptr->request_failed(batch_ptr->context, connect, port1_id, port2_id);
+  }
+}
+
+#define cookie_ptr ((struct connection_reply_cookie *)void_cookie)
+
+static void connection_request_handle_reply(void * UNUSED(context), void * void_cookie, DBusMessage * reply_ptr)
+{
+  if (reply_ptr == NULL || dbus_message_get_type(reply_ptr) == DBUS_MESSAGE_TYPE_ERROR)
+  {
+    connection_request_failed(cookie_ptr->batch_ptr, cookie_ptr->connect, cookie_ptr->port1_id, cookie_ptr->port2_id);
+  }
+
+  connection_batch_release(cookie_ptr->batch_ptr);
+}
+
+#undef cookie_ptr
+
+bool
+graph_proxy_connections_flush(
+  graph_proxy_handle graph,
+  void * context,
+  void (* request_failed)(void * context, bool connect, uint64_t port1_id, uint64_t port2_id),
+  void (* completed)(void * context, unsigned int count, unsigned int failed_count))
+{
+  struct list_head * node_ptr;
+  struct list_head * temp_node_ptr;
+  struct connection_request * request_ptr;
+  struct connection_batch * batch_ptr;
+  struct connection_reply_cookie cookie;
+  DBusMessage * message_ptr;
+  bool ret;
+
+  list_for_each(node_ptr, &graph_ptr->connection_requests)
+  {
+    request_ptr = list_entry(node_ptr, struct connection_request, siblings);
+    if (request_ptr->context == context)
+    {
+      break;
+    }
+  }
+
+  if (node_ptr == &graph_ptr->connection_requests)
+  {
+    return true;
+  }
+
+  batch_ptr = malloc(sizeof(struct connection_batch));
+  if (batch_ptr == NULL)
+  {
+    log_error("malloc() failed for struct connection_batch");
+    return false;
+  }
+
+  /* one extra reference until all requests are sent, so completion is reported once, after the last reply */
+  batch_ptr->outstanding = 1;
+  batch_ptr->count = 0;
+  batch_ptr->failed_count = 0;
+  batch_ptr->context = context;
+  batch_ptr->request_failed = request_failed;
+  batch_ptr->completed = completed;
+  list_add_tail(&batch_ptr->siblings, &graph_ptr->connection_batches);
+
+  cookie.batch_ptr = batch_ptr;
+
+  /* jackdbus has no method for many connections, so requests are pipelined and replies are handled as they come */
+  ret = true;
+  list_for_each_safe(node_ptr, temp_node_ptr, &graph_ptr->connection_requests)
+  {
+    request_ptr = list_entry(node_ptr, struct connection_request, siblings);
+    if (request_ptr->context != context)
+    {
+      continue;
+    }
+
+    list_del(&request_ptr->siblings);
+    batch_ptr->count++;
+
+    message_ptr = cdbus_new_method_call_message(
+      graph_ptr->service,
+      graph_ptr->object,
+      JACKDBUS_IFACE_PATCHBAY,
+      request_ptr->connect ? "ConnectPortsByID" : "DisconnectPortsByID",
+      "tt",
+      &request_ptr->port1_id,
+      &request_ptr->port2_id,
+      NULL);
+    if (message_ptr == NULL)
+    {
+      connection_request_failed(batch_ptr, request_ptr->connect, request_ptr->port1_id, request_ptr->port2_id);
+      ret = false;
+      free(request_ptr);
+      continue;
+    }
+
+    cookie.connect = request_ptr->connect;
+    cookie.port1_id = request_ptr->port1_id;
+    cookie.port2_id = request_ptr->port2_id;
+
+    if (cdbus_call_async(message_ptr, NULL, &cookie, sizeof(cookie), connection_request_handle_reply))
+    {
+      batch_ptr->outstanding++;
+    }
+    else
+    {
+      connection_request_failed(batch_ptr, request_ptr->connect, request_ptr->port1_id, request_ptr->port2_id);
+      ret = false;
+    }
+
+    dbus_message_unref(message_ptr);
+    free(request_ptr);
+  }
+
+  connection_batch_release(batch_ptr);
+
+  return ret;
+}
+
+void
+graph_proxy_connections_cancel(
+  graph_proxy_handle graph,
+  void * context)
+{
+  struct connection_request * request_ptr;
+  struct list_head * node_ptr;
+  struct list_head * temp_node_ptr;
+  struct connection_batch * batch_ptr;
+
+  list_for_each_safe(node_ptr, temp_node_ptr, &graph_ptr->connection_requests)
+  {
+    request_ptr = list_entry(node_ptr, struct connection_request, siblings);
+    if (context == NULL || request_ptr->context == context)
+    {
+      list_del(&request_ptr->siblings);
+      free(request_ptr);
+    }
+  }
+
+  list_for_each_safe(node_ptr, temp_node_ptr, &graph_ptr->connection_batches)
+  {
+    batch_ptr = list_entry(node_ptr, struct connection_batch, siblings);
+    if (context == NULL || batch_ptr->context == context)
+    {
+      batch_ptr->request_failed = NULL;
+      batch_ptr->completed = NULL;
+      list_del_init(&batch_ptr->siblings);
+    }
+  }
+}
+
 static void on_client_appeared(void * graph, DBusMessage * message_ptr)
 {
   dbus_uint64_t new_graph_version;
@@ -878,12 +1588,21 @@ graph_proxy_dict_entry_set(
   const char * key,
   const char * value)
 {
+  struct dict_entry * entry_ptr;
+
   if (!graph_ptr->graph_dict_supported)
   {
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Set", "utss", &object_type, &object_id, &key, &value, ""))
+  /* a deferred older value must not overwrite this one later */
+  entry_ptr = dict_table_find(&graph_ptr->dict_pending, object_type, object_id, key);
+  if (entry_ptr != NULL)
+  {
+    dict_table_remove(entry_ptr);
+  }
+
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Set", "utss", &object_type, &object_id, &key, &value, ""))
   {
     log_error(IFACE_GRAPH_DICT ".Set() failed.");
     return false;
@@ -905,13 +1624,40 @@ graph_proxy_dict_entry_get(
   DBusMessageIter iter;
   const char * cvalue_ptr;
   char * value_ptr;
+  struct dict_entry * entry_ptr;
 
   if (!graph_ptr->graph_dict_supported)
   {
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Get", "uts", &object_type, &object_id, &key, NULL, &reply_ptr))
+  entry_ptr = dict_table_find(&graph_ptr->dict_pending, object_type, object_id, key);
+  if (entry_ptr == NULL &&
+      graph_ptr->dict_prefetched &&
+      is_dict_key_prefetched(graph_ptr, object_type, key))
+  {
+    entry_ptr = dict_table_find(&graph_ptr->dict_cache, object_type, object_id, key);
+    if (entry_ptr == NULL)
+    {
+      /* not in GetDicts() reply, the object has no value for this key */
+      return false;
+    }
+  }
+
+  if (entry_ptr != NULL)
+  {
+    value_ptr = strdup(entry_ptr->value);
+    if (value_ptr == NULL)
+    {
+      log_error("strdup() failed for dict value");
+      return false;
+    }
+
+    *value_ptr_ptr = value_ptr;
+    return true;
+  }
+
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Get", "uts", &object_type, &object_id, &key, NULL, &reply_ptr))
   {
     log_error(IFACE_GRAPH_DICT ".Get() failed.");
     return false;
@@ -946,12 +1692,20 @@ graph_proxy_dict_entry_drop(
   uint64_t object_id,
   const char * key)
 {
+  struct dict_entry * entry_ptr;
+
   if (!graph_ptr->graph_dict_supported)
   {
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Drop", "uts", &object_type, &object_id, &key, ""))
+  entry_ptr = dict_table_find(&graph_ptr->dict_pending, object_type, object_id, key);
+  if (entry_ptr != NULL)
+  {
+    dict_table_remove(entry_ptr);
+  }
+
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "Drop", "uts", &object_type, &object_id, &key, ""))
   {
     log_error(IFACE_GRAPH_DICT ".Drop() failed.");
     return false;
@@ -960,11 +1714,159 @@ graph_proxy_dict_entry_drop(
   return true;
 }
 
+bool
+graph_proxy_dict_prefetch(
+  graph_proxy_handle graph,
+  uint32_t object_type,
+  const char * key)
+{
+  struct dict_prefetch_key * key_ptr;
+
+  ASSERT(object_type == GRAPH_DICT_OBJECT_TYPE_CLIENT || object_type == GRAPH_DICT_OBJECT_TYPE_PORT);
+
+  if (is_dict_key_prefetched(graph_ptr, object_type, key))
+  {
+    return true;
+  }
+
+  key_ptr = malloc(sizeof(struct dict_prefetch_key));
+  if (key_ptr == NULL)
+  {
+    log_error("malloc() failed to allocate struct dict_prefetch_key");
+    return false;
+  }
+
+  key_ptr->key = strdup(key);
+  if (key_ptr->key == NULL)
+  {
+    log_error("strdup() failed for dict key");
+    free(key_ptr);
+    return false;
+  }
+
+  key_ptr->object_type = object_type;
+  list_add_tail(&key_ptr->siblings, &graph_ptr->dict_prefetch_keys);
+
+  return true;
+}
+
+bool
+graph_proxy_dict_entry_set_deferred(
+  graph_proxy_handle graph,
+  uint32_t object_type,
+  uint64_t object_id,
+  const char * key,
+  const char * value)
+{
+  if (!graph_ptr->graph_dict_supported)
+  {
+    return false;
+  }
+
+  return dict_table_set(&graph_ptr->dict_pending, object_type, object_id, key, value);
+}
+
+static bool dict_flush_many(graph_proxy_handle graph)
+{
+  DBusMessage * request_ptr;
+  DBusMessage * reply_ptr;
+  DBusMessageIter iter;
+  DBusMessageIter array_iter;
+  DBusMessageIter struct_iter;
+  struct list_head * node_ptr;
+  struct dict_entry * entry_ptr;
+
+  request_ptr = dbus_message_new_method_call(graph_ptr->service, graph_ptr->object, IFACE_GRAPH_DICT, "SetDicts");
+  if (request_ptr == NULL)
+  {
+    log_error("dbus_message_new_method_call() failed.");
+    return false;
+  }
+
+  dbus_message_iter_init_append(request_ptr, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(utss)", &array_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  list_for_each(node_ptr, &graph_ptr->dict_pending.entries)
+  {
+    entry_ptr = list_entry(node_ptr, struct dict_entry, siblings);
+
+    if (!dbus_message_iter_open_container(&array_iter, DBUS_TYPE_STRUCT, NULL, &struct_iter) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT32, &entry_ptr->object_type) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_UINT64, &entry_ptr->object_id) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &entry_ptr->key) ||
+        !dbus_message_iter_append_basic(&struct_iter, DBUS_TYPE_STRING, &entry_ptr->value) ||
+        !dbus_message_iter_close_container(&array_iter, &struct_iter))
+    {
+      goto fail_unref_request;
+    }
+  }
+
+  if (!dbus_message_iter_close_container(&iter, &array_iter))
+  {
+    goto fail_unref_request;
+  }
+
+  reply_ptr = proxy_call_raw(0, request_ptr);
+  dbus_message_unref(request_ptr);
+  if (reply_ptr == NULL)
+  {
+    return false;
+  }
+
+  dbus_message_unref(reply_ptr);
+  dict_table_clear(&graph_ptr->dict_pending);
+  return true;
+
+fail_unref_request:
+  log_error("Ran out of memory trying to construct SetDicts() call");
+  dbus_message_unref(request_ptr);
+  return false;
+}
+
+bool
+graph_proxy_dict_flush(
+  graph_proxy_handle graph)
+{
+  struct dict_entry * entry_ptr;
+  bool ret;
+
+  if (list_empty(&graph_ptr->dict_pending.entries))
+  {
+    return true;
+  }
+
+  if (graph_ptr->graph_dict_bulk_supported && dict_flush_many(graph))
+  {
+    return true;
+  }
+
+  /* older ladishd, send values one by one */
+  ret = true;
+  while (!list_empty(&graph_ptr->dict_pending.entries))
+  {
+    entry_ptr = list_entry(graph_ptr->dict_pending.entries.next, struct dict_entry, siblings);
+    dict_entry_unlink(entry_ptr);
+
+    if (!graph_proxy_dict_entry_set(graph, entry_ptr->object_type, entry_ptr->object_id, entry_ptr->key, entry_ptr->value))
+    {
+      ret = false;
+    }
+
+    dict_entry_free(entry_ptr);
+  }
+
+  return ret;
+}
+
 bool graph_proxy_get_client_pid(graph_proxy_handle graph, uint64_t client_id, pid_t * pid_ptr)
 {
   int64_t pid;
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "GetClientPID", "t", &client_id, "x", &pid))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, JACKDBUS_IFACE_PATCHBAY, "GetClientPID", "t", &client_id, "x", &pid))
   {
     log_error("GetClientPID() failed.");
     return false;
@@ -985,7 +1887,7 @@ graph_proxy_split(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "Split", "t", &client_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "Split", "t", &client_id, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".Split() failed.");
     return false;
@@ -1005,7 +1907,7 @@ graph_proxy_join(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "Join", "tt", &client1_id, &client2_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "Join", "tt", &client1_id, &client2_id, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".Join() failed.");
     return false;
@@ -1025,7 +1927,7 @@ graph_proxy_rename_client(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RenameClient", "ts", &client_id, &newname, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RenameClient", "ts", &client_id, &newname, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".RenameClient() failed.");
     return false;
@@ -1045,7 +1947,7 @@ graph_proxy_rename_port(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RenamePort", "ts", &port_id, &newname, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RenamePort", "ts", &port_id, &newname, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".RenamePort() failed.");
     return false;
@@ -1065,7 +1967,7 @@ graph_proxy_move_port(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "MovePort", "tt", &port_id, &client_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "MovePort", "tt", &port_id, &client_id, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".MovePort() failed.");
     return false;
@@ -1085,7 +1987,7 @@ graph_proxy_new_client(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "NewClient", "s", &name, "t", client_id_ptr))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "NewClient", "s", &name, "t", client_id_ptr))
   {
     log_error(IFACE_GRAPH_MANAGER ".NewClient() failed.");
     return false;
@@ -1104,7 +2006,7 @@ graph_proxy_remove_client(
     return false;
   }
 
-  if (!cdbus_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RemoveClient", "t", &client_id, ""))
+  if (!proxy_call(0, graph_ptr->service, graph_ptr->object, IFACE_GRAPH_MANAGER, "RemoveClient", "t", &client_id, ""))
   {
     log_error(IFACE_GRAPH_MANAGER ".RemoveClient() failed.");
     return false;
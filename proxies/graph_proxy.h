@@ -58,6 +58,7 @@ bool
 graph_proxy_activate(
   graph_proxy_handle graph);
 
+/* When the graph is already active, its current state is dispatched to the new monitor */
 bool
 graph_proxy_attach(
   graph_proxy_handle graph,
@@ -89,6 +90,36 @@ graph_proxy_disconnect_ports(
   uint64_t port1_id,
   uint64_t port2_id);
 
+/* Queue the request, it is sent by graph_proxy_connections_flush() with the same context */
+bool
+graph_proxy_connect_ports_deferred(
+  graph_proxy_handle graph,
+  void * context,
+  uint64_t port1_id,
+  uint64_t port2_id);
+
+bool
+graph_proxy_disconnect_ports_deferred(
+  graph_proxy_handle graph,
+  void * context,
+  uint64_t port1_id,
+  uint64_t port2_id);
+
+/* Send the requests queued with the context without waiting for replies.
+ * request_failed is called for each failed request, completed once after the last reply */
+bool
+graph_proxy_connections_flush(
+  graph_proxy_handle graph,
+  void * context,
+  void (* request_failed)(void * context, bool connect, uint64_t port1_id, uint64_t port2_id),
+  void (* completed)(void * context, unsigned int count, unsigned int failed_count));
+
+/* Drop queued requests and stop callbacks for sent ones, NULL context matches all */
+void
+graph_proxy_connections_cancel(
+  graph_proxy_handle graph,
+  void * context);
+
 bool
 graph_proxy_dict_entry_set(
   graph_proxy_handle graph,
@@ -112,6 +143,26 @@ graph_proxy_dict_entry_drop(
   uint64_t object_id,
   const char * key);
 
+/* Fetch the key for all clients or ports with single call when graph is refreshed */
+bool
+graph_proxy_dict_prefetch(
+  graph_proxy_handle graph,
+  uint32_t object_type,
+  const char * key);
+
+/* Queue the value, it is sent by graph_proxy_dict_flush() */
+bool
+graph_proxy_dict_entry_set_deferred(
+  graph_proxy_handle graph,
+  uint32_t object_type,
+  uint64_t object_id,
+  const char * key,
+  const char * value);
+
+bool
+graph_proxy_dict_flush(
+  graph_proxy_handle graph);
+
 bool graph_proxy_get_client_pid(graph_proxy_handle graph, uint64_t client_id, pid_t * pid_ptr);
 
 bool
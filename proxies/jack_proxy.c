@@ -151,7 +151,7 @@ jack_proxy_is_started(
 {
   dbus_bool_t started;
 
-  if (!cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "IsStarted", "", "b", &started))
+  if (!proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "IsStarted", "", "b", &started))
   {
     return false;
   }
@@ -233,7 +233,7 @@ jack_proxy_read_conf_container(
     return false;
   }
 
-  reply_ptr = cdbus_call_raw(0, request_ptr);
+  reply_ptr = proxy_call_raw(0, request_ptr);
   dbus_message_unref(request_ptr);
   if (reply_ptr == NULL)
   {
@@ -356,7 +356,7 @@ jack_proxy_get_parameter_value(
     return false;
   }
 
-  reply_ptr = cdbus_call_raw(0, request_ptr);
+  reply_ptr = proxy_call_raw(0, request_ptr);
   dbus_message_unref(request_ptr);
   if (reply_ptr == NULL)
   {
@@ -465,7 +465,7 @@ jack_proxy_set_parameter_value(
     return false;
   }
 
-  reply_ptr = cdbus_call_raw(0, request_ptr);
+  reply_ptr = proxy_call_raw(0, request_ptr);
   dbus_message_unref(request_ptr);
   if (reply_ptr == NULL)
   {
@@ -509,7 +509,7 @@ jack_proxy_reset_parameter_value(
     return false;
   }
 
-  reply_ptr = cdbus_call_raw(0, request_ptr);
+  reply_ptr = proxy_call_raw(0, request_ptr);
   dbus_message_unref(request_ptr);
   if (reply_ptr == NULL)
   {
@@ -531,19 +531,19 @@ jack_proxy_reset_parameter_value(
 
 bool jack_proxy_start_server(void)
 {
-  return cdbus_call(7000, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "StartServer", "", "");
+  return proxy_call(7000, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "StartServer", "", "");
 }
 
 bool jack_proxy_stop_server(void)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "StopServer", "", "");
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "StopServer", "", "");
 }
 
 bool jack_proxy_is_realtime(bool * realtime_ptr)
 {
   dbus_bool_t realtime;
 
-  if (!cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "IsStarted", "", "b", &realtime))
+  if (!proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "IsStarted", "", "b", &realtime))
   {
     return false;
   }
@@ -554,32 +554,32 @@ bool jack_proxy_is_realtime(bool * realtime_ptr)
 
 bool jack_proxy_sample_rate(uint32_t * sample_rate_ptr)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetSampleRate", "", "u", sample_rate_ptr);
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetSampleRate", "", "u", sample_rate_ptr);
 }
 
 bool jack_proxy_get_xruns(uint32_t * xruns_ptr)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetXruns", "", "u", xruns_ptr);
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetXruns", "", "u", xruns_ptr);
 }
 
 bool jack_proxy_get_dsp_load(double * dsp_load_ptr)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetLoad", "", "d", dsp_load_ptr);
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetLoad", "", "d", dsp_load_ptr);
 }
 
 bool jack_proxy_get_buffer_size(uint32_t * size_ptr)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetBufferSize", "", "u", size_ptr);
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "GetBufferSize", "", "u", size_ptr);
 }
 
 bool jack_proxy_set_buffer_size(uint32_t size)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "SetBufferSize", "u", &size, "");
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "SetBufferSize", "u", &size, "");
 }
 
 bool jack_proxy_reset_xruns(void)
 {
-  return cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "ResetXruns", "", "");
+  return proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "ResetXruns", "", "");
 }
 
 static
@@ -765,7 +765,7 @@ jack_proxy_session_has_callback(
 {
   dbus_bool_t has_callback;
 
-  if (!cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_SESSMGR, "HasSessionCallback", "s", &client, "b", &has_callback))
+  if (!proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_SESSMGR, "HasSessionCallback", "s", &client, "b", &has_callback))
   {
     return false;
   }
@@ -776,7 +776,7 @@ jack_proxy_session_has_callback(
 
 bool jack_proxy_exit(void)
 {
-  if (!cdbus_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "Exit", "", ""))
+  if (!proxy_call(0, JACKDBUS_SERVICE_NAME, JACKDBUS_OBJECT_PATH, JACKDBUS_IFACE_CONTROL, "Exit", "", ""))
   {
     log_error("Exit() failed.");
     return false;
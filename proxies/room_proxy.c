@@ -188,7 +188,7 @@ bool ladish_room_proxy_get_project_properties_internal(struct ladish_room_proxy
 {
   DBusMessage * reply_ptr;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "GetProjectProperties", "", NULL, &reply_ptr))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "GetProjectProperties", "", NULL, &reply_ptr))
   {
     log_error("GetProjectProperties() failed.");
     return false;
@@ -337,7 +337,7 @@ char * ladish_room_proxy_get_name(ladish_room_proxy_handle proxy)
   const char * name;
   char * name_buffer;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "GetName", "", NULL, &reply_ptr))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "GetName", "", NULL, &reply_ptr))
   {
     log_error("GetName() failed.");
     return NULL;
@@ -366,7 +366,7 @@ char * ladish_room_proxy_get_name(ladish_room_proxy_handle proxy)
 
 bool ladish_room_proxy_load_project(ladish_room_proxy_handle proxy, const char * project_dir)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "LoadProject", "s", &project_dir, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "LoadProject", "s", &project_dir, ""))
   {
     log_error("LoadProject() failed.");
     return false;
@@ -377,7 +377,7 @@ bool ladish_room_proxy_load_project(ladish_room_proxy_handle proxy, const char *
 
 bool ladish_room_proxy_save_project(ladish_room_proxy_handle proxy, const char * project_dir, const char * project_name)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SaveProject", "ss", &project_dir, &project_name, ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SaveProject", "ss", &project_dir, &project_name, ""))
   {
     log_error("SaveProject() failed.");
     return false;
@@ -388,7 +388,7 @@ bool ladish_room_proxy_save_project(ladish_room_proxy_handle proxy, const char *
 
 bool ladish_room_proxy_unload_project(ladish_room_proxy_handle proxy)
 {
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "UnloadProject", "", ""))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "UnloadProject", "", ""))
   {
     log_error("UnloadProject() failed.");
     return false;
@@ -435,7 +435,7 @@ ladish_room_proxy_set_project_description(
 {
   uint64_t new_version;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SetProjectDescription", "s", &description, "t", &new_version))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SetProjectDescription", "s", &description, "t", &new_version))
   {
     log_error("SetProjectDescription() failed.");
     return false;
@@ -451,7 +451,7 @@ ladish_room_proxy_set_project_notes(
 {
   uint64_t new_version;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SetProjectNotes", "s", &notes, "t", &new_version))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_ROOM, "SetProjectNotes", "s", &notes, "t", &new_version))
   {
     log_error("SetProjectNotes(%s) failed.", notes);
     return false;
@@ -478,7 +478,7 @@ ladish_room_proxy_get_recent_projects(
   const char * project_dir;
   const char * project_name;
 
-  if (!cdbus_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_RECENT_ITEMS, "get", "q", &max_items, NULL, &reply_ptr))
+  if (!proxy_call(0, proxy_ptr->service, proxy_ptr->object, IFACE_RECENT_ITEMS, "get", "q", &max_items, NULL, &reply_ptr))
   {
     log_error("GetStudioList() failed.");
     return false;